@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+// Forward declare web server class
+class AsyncWebServer;
+
+// MQTT broker settings
+struct BridgeConfig {
+  char uri[64];         // Broker URI (e.g. mqtt://host:1883), empty = disabled
+  char user[32];        // Username (may be empty)
+  char password[32];    // Password (may be empty)
+};
+
+// Topics (<id> = last 3 bytes of MAC in hex)
+//   autoblinds/<id>/state         open|opening|closed|closing|stopped (retained)
+//   autoblinds/<id>/position      Percent open 0-100 (retained)
+//   autoblinds/<id>/availability  online|offline (retained, last will)
+//   autoblinds/<id>/set           OPEN|CLOSE|STOP
+//   autoblinds/<id>/set_position  Percent open 0-100
+//   homeassistant/cover/<id>/config  Discovery payload (retained)
+
+// Attach MQTT settings routes to web server and load settings
+void setupBridge(AsyncWebServer &server);
+
+// Apply commands and hand state changes to the bridge task (never blocks)
+void updateBridge();
+
+#endif // BRIDGE_H
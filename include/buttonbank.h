@@ -0,0 +1,127 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef BUTTONBANK_H
+#define BUTTONBANK_H
+
+#include <cstdint>
+
+// Compile-time button description (times in ms)
+template <uint8_t Pin, uint32_t HoldTime, uint32_t Debounce>
+struct ButtonSpec {
+  static constexpr uint8_t pin = Pin;
+  static constexpr uint32_t holdTime = HoldTime;
+  static constexpr uint32_t debounce = Debounce;
+};
+
+// Debounced buttons with all state in bitmasks (bit i = i-th button)
+// A button goes down once its raw level has been stable for longer than its debounce, is held once
+// it has been down for its hold time, and goes up after a stable release. Each update reports at
+// most one edge per button.
+template <typename... Buttons>
+class ButtonBank {
+ public:
+  using Mask = uint8_t;
+  static constexpr uint8_t count = sizeof...(Buttons);
+  static_assert(count > 0 && count <= 8, "ButtonBank holds 1 to 8 buttons");
+  static_assert(((Buttons::pin < 32) && ...), "Button pins must be in the first GPIO input register");
+
+  // Bit of the button on a pin (0 if not in the bank)
+  static constexpr Mask maskOf(uint8_t pin) {
+    for (uint8_t i = 0; i < count; i++) {
+      if (pins[i] == pin) {
+        return (Mask)(1 << i);
+      }
+    }
+    return 0;
+  }
+
+  // Pin of the i-th button
+  static constexpr uint8_t pinOf(uint8_t index) {
+    return pins[index];
+  }
+
+  // Advance debounce and hold timing from one read of the GPIO input register
+  void update(uint32_t levels, uint32_t time) {
+    Mask reading = gather(levels);
+    changed_ = reading ^ raw_;
+    raw_ = reading;
+    pressed_ = 0;
+    heldEdge_ = 0;
+    released_ = 0;
+
+    // Only buttons that are bouncing or waiting for their hold need timing
+    settling_ |= changed_;
+    Mask pending = settling_ | (down_ & ~held_);
+    for (uint8_t i = 0; pending != 0; i++, pending >>= 1) {
+      if ((pending & 1) == 0) {
+        continue;
+      }
+      Mask bit = (Mask)(1 << i);
+      if (changed_ & bit) {
+        changeTime_[i] = time;
+      }
+      if (time - changeTime_[i] <= debounces[i]) {
+        continue;
+      }
+      settling_ &= ~bit;
+      // Stable level differs from debounced state
+      if ((reading ^ down_) & bit) {
+        if (reading & bit) {
+          down_ |= bit;
+          pressTime_[i] = time;
+          pressed_ |= bit;
+        } else {
+          down_ &= ~bit;
+          released_ |= bit;
+        }
+        held_ &= ~bit;
+      } else if ((down_ & ~held_ & bit) && time - pressTime_[i] >= holdTimes[i]) {
+        held_ |= bit;
+        heldEdge_ |= bit;
+      }
+    }
+  }
+
+  // Debounced state
+  Mask down() const { return down_; }
+  Mask held() const { return held_; }
+
+  // Raw levels at the last update and the ones that changed with it
+  Mask raw() const { return raw_; }
+  Mask changed() const { return changed_; }
+
+  // Edges reported by the last update
+  Mask pressed() const { return pressed_; }
+  Mask heldEdge() const { return heldEdge_; }
+  Mask released() const { return released_; }
+
+ private:
+  static constexpr uint8_t pins[count] = {Buttons::pin...};
+  static constexpr uint32_t holdTimes[count] = {Buttons::holdTime...};
+  static constexpr uint32_t debounces[count] = {Buttons::debounce...};
+
+  // Pack button pin levels into bank bits
+  static Mask gather(uint32_t levels) {
+    Mask reading = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      reading |= (Mask)(((levels >> pins[i]) & 1) << i);
+    }
+    return reading;
+  }
+
+  Mask raw_ = 0;
+  Mask changed_ = 0;
+  Mask down_ = 0;
+  Mask held_ = 0;
+  Mask pressed_ = 0;
+  Mask heldEdge_ = 0;
+  Mask released_ = 0;
+  Mask settling_ = 0;     // Level changed, not yet stable for the debounce
+  uint32_t changeTime_[count] = {};
+  uint32_t pressTime_[count] = {};
+};
+
+#endif // BUTTONBANK_H
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef BUTTONGESTURE_H
+#define BUTTONGESTURE_H
+
+#include <cstdint>
+#include "config.h"
+
+// Buttons tracked by a recognizer (bit i of the masks)
+constexpr uint8_t BUTTON_GESTURE_MAX_BUTTONS = 8;
+
+// Events one update can report (one per button plus a chord)
+constexpr uint8_t BUTTON_GESTURE_MAX_EVENTS = BUTTON_GESTURE_MAX_BUTTONS + 1;
+
+// Recognized button gestures
+enum class ButtonGesture : uint8_t {
+  NONE,
+  TAP,        // Sequence of short presses (count = taps)
+  LONG,       // Press held past a long-press tier (count = tier, 1 = shortest, 0 = slower than a tap)
+  CHORD       // Two or more buttons pressed together (count = buttons)
+};
+
+// Gesture event (buttons = mask of the buttons involved)
+struct ButtonGestureEvent {
+  ButtonGesture gesture;
+  uint8_t buttons;
+  uint8_t count;
+};
+
+// Gesture recognizer state over debounced button masks
+struct ButtonGestureRecognizer {
+  uint8_t down;               // Buttons down at the last update
+  uint8_t chord;              // Buttons of the active chord (ignored until all are up)
+  uint8_t cancelled;          // Buttons whose current press reports nothing (ignored until pressed again)
+  uint8_t taps[BUTTON_GESTURE_MAX_BUTTONS];     // Taps in the pending sequence
+  uint8_t tier[BUTTON_GESTURE_MAX_BUTTONS];     // Long-press tier reached by the current press
+  uint32_t pressTime[BUTTON_GESTURE_MAX_BUTTONS];   // Times in ms
+  uint32_t releaseTime[BUTTON_GESTURE_MAX_BUTTONS];
+};
+
+// Clear recognizer (all buttons up)
+void resetButtonGestures(ButtonGestureRecognizer &recognizer);
+
+// Drop pending taps and the rest of the current press of buttons that are down
+void cancelButtonGestures(ButtonGestureRecognizer &recognizer, uint8_t buttons);
+
+// Feed timestamped debounced button mask, returns number of events written
+uint8_t updateButtonGestures(ButtonGestureRecognizer &recognizer, uint32_t time, uint8_t down,
+                             ButtonGestureEvent events[BUTTON_GESTURE_MAX_EVENTS]);
+
+#endif // BUTTONGESTURE_H
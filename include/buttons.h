@@ -7,20 +7,45 @@
 #define BUTTONS_H
 
 #include <cstdint>
+#include "buttongesture.h"
+
+// Button bits of state masks (order matches state machine event groups)
+constexpr uint8_t BTN_MASK_OPEN = 0x01;
+constexpr uint8_t BTN_MASK_CLOSE = 0x02;
+constexpr uint8_t BTN_MASK_MODE = 0x04;
+
+// Debounced button edge types
+enum class ButtonEdge : uint8_t {
+  PRESS,
+  HOLD,
+  RELEASE
+};
+
+// Button event produced by the input layer
+struct ButtonEvent {
+  uint8_t pin;
+  ButtonEdge edge;
+};
 
 // Initialize button pins
 void setupButtons();
 
-// Handle button state transitions from readings
+// Handle button state transitions from readings and queue events
 void updateButtonStates();
 
-// Check if the button was just pressed (debounced)
-bool isButtonPressed(uint8_t pin);
+// Get the next queued button event (oldest first)
+bool pollButtonEvent(ButtonEvent &event);
 
-// Check if the button is currently held (debounced)
-bool isButtonHeld(uint8_t pin);
+// Get the next queued button gesture (oldest first, buttons as BTN_MASK_* bits)
+bool pollButtonGesture(ButtonGestureEvent &gesture);
 
-// Check if the button was just released (debounced)
-bool isButtonReleased(uint8_t pin);
+// Drop the gestures of the current presses of buttons (BTN_MASK_* bits)
+void cancelButtonGestures(uint8_t buttons);
+
+// Get buttons currently down (debounced, BTN_MASK_* bits)
+uint8_t buttonsDown();
+
+// Get buttons currently held (debounced, BTN_MASK_* bits)
+uint8_t buttonsHeld();
 
 #endif // BUTTONS_H
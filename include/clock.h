@@ -0,0 +1,51 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <cstdint>
+
+// Time source behind the clock functions
+struct ClockSource {
+  int64_t (*monotonic)();       // Microseconds since boot
+  int64_t (*wall)();            // System time in microseconds since the epoch (uncorrected)
+  bool (*skip)(int64_t span);   // Let idle time pass at once (false = caller has to wait it out)
+};
+
+// Hardware timer and system time
+extern const ClockSource hardwareClock;
+
+// Time that only moves when advanced (or skipped through idle time in fast mode)
+extern const ClockSource virtualClock;
+
+// Select time source for all modules (call before any module is set up)
+void setClockSource(const ClockSource &source);
+
+// Check if the virtual clock is in use
+bool isVirtualClock();
+
+// Get monotonic time in milliseconds (wraps like millis())
+uint32_t clockMillis();
+
+// Get monotonic time in microseconds (wraps like micros())
+uint32_t clockMicros();
+
+// Get monotonic time in microseconds since boot
+int64_t clockMonotonic();
+
+// Get system wall time in microseconds since the epoch
+int64_t clockWall();
+
+// Skip idle time (us) on a virtual clock in fast mode, false if the caller has to wait
+bool clockSkip(int64_t span);
+
+// Start virtual clock at a wall time (us since the epoch), fast mode skips idle time at once
+void startVirtualClock(int64_t wall, bool fast);
+
+// Advance virtual clock (us)
+void advanceVirtualClock(int64_t span);
+
+#endif // CLOCK_H
@@ -13,22 +13,146 @@ constexpr uint16_t WEB_SERVER_PORT = 80;
 constexpr char WIFI_AP_NAME[] = "AutoBlinds";
 constexpr char NTP_SERVER[] = "pool.ntp.org";
 constexpr char TIME_ZONE[] = "EST5EDT,M3.2.0/2,M11.1.0/2";
+constexpr int32_t DEFAULT_LATITUDE = 407128;      // 1e-4 degrees north
+constexpr int32_t DEFAULT_LONGITUDE = -740060;    // 1e-4 degrees east
+constexpr int16_t SOLAR_MAX_OFFSET = 720;
+constexpr uint32_t SCHEDULE_CATCHUP_GRACE = 2 * 3600;    // Seconds a missed event stays applicable
 constexpr unsigned long NTP_SYNC_INTERVAL = 12 * 3600 * 1000;
-constexpr unsigned long WIFI_CHECK_INTERVAL = 15000;
-constexpr unsigned long SCHEDULE_CHECK_INTERVAL = 30000;
+constexpr unsigned long NTP_STALE_INTERVAL = 2 * NTP_SYNC_INTERVAL;
+constexpr unsigned long NTP_RETRY_INTERVAL = 5 * 60 * 1000;
+constexpr uint8_t TIME_DRIFT_SAMPLES = 8;
+constexpr uint32_t TIME_MIN_SYNC_SPACING = 15 * 60;    // Seconds between fitted sync points
+constexpr int32_t TIME_MAX_DRIFT_PPB = 500000;
+constexpr uint32_t NETWORK_BACKOFF_MIN = 1000;
+constexpr uint32_t NETWORK_BACKOFF_MAX = 5 * 60 * 1000;
+constexpr uint32_t NETWORK_PROCESS_INTERVAL = 10;
+constexpr uint32_t NETWORK_TASK_STACK = 8192;
+constexpr uint8_t SCHEDULE_MAX_ENTRIES = 8;
+constexpr uint8_t PRESET_COUNT = 4;
+constexpr uint8_t VACATION_MAX_OFFSET = 120;
+constexpr int16_t VACATION_PARTIAL_START = 11 * 60;
+constexpr int16_t VACATION_PARTIAL_WINDOW = 6 * 60;
+constexpr uint8_t VACATION_PARTIAL_MIN = 20;
+constexpr uint8_t VACATION_PARTIAL_MAX = 80;
+constexpr unsigned long REMOTE_BROADCAST_INTERVAL = 100;
+constexpr unsigned long REMOTE_CLEANUP_INTERVAL = 1000;
+constexpr int MQTT_OUTBOX_LIMIT = 2048;
+constexpr unsigned long MQTT_PUBLISH_INTERVAL = 500;
+constexpr uint32_t MQTT_BACKOFF_MIN = 1000;
+constexpr uint32_t MQTT_BACKOFF_MAX = 5 * 60 * 1000;
+constexpr int MQTT_KEEPALIVE = 30;
+constexpr uint32_t MQTT_TASK_STACK = 4096;
+constexpr uint8_t GROUP_MULTICAST_ADDR[4] = {239, 255, 42, 99};
+constexpr uint16_t GROUP_PORT = 4210;
+constexpr uint32_t GROUP_LEAD_TIME = 500;
+constexpr uint32_t GROUP_MAX_LEAD = 10000;
+constexpr uint32_t GROUP_LATE_TOLERANCE = 250;
+constexpr uint8_t GROUP_SEND_REPEATS = 3;
+constexpr uint8_t GROUP_MAX_MEMBERS = 8;
+constexpr char OTA_USERNAME[] = "admin";
+#ifndef OTA_PASSWORD
+#define OTA_PASSWORD ""    // Set with build_flags -D OTA_PASSWORD=\"...\" (empty disables updates)
+#endif
+constexpr uint32_t OTA_RESTART_DELAY = 1000;
+
+// Clock constants (virtual clock runs timeouts, tasks, and schedules without real time passing)
+constexpr bool CLOCK_VIRTUAL = false;
+constexpr bool CLOCK_VIRTUAL_FAST = true;              // Skip idle time at once instead of stepping by hand
+constexpr int64_t CLOCK_VIRTUAL_START = 1735689600;    // Wall time the virtual clock starts at (s)
+
+// Trace constants
+constexpr uint8_t TRACE_BLOCK_COUNT = 24;
+constexpr uint16_t TRACE_BLOCK_SIZE = 1024;
+constexpr uint32_t TRACE_POSITION_INTERVAL = 20;
+
+// Logging constants
+constexpr uint32_t LOG_BUFFER_SIZE = 128;
+constexpr uint32_t LOG_LINE_LENGTH = 160;
+constexpr uint32_t LOG_DRAIN_INTERVAL = 20;
+constexpr uint32_t LOG_TASK_STACK = 3072;
+
+// I2C constants
+constexpr uint32_t I2C_FREQUENCY = 400000;
+constexpr uint16_t I2C_TIMEOUT = 10;            // Per-transfer timeout (ms)
+constexpr uint8_t I2C_QUEUE_SIZE = 8;
+constexpr uint32_t I2C_TASK_STACK = 4096;
+constexpr uint8_t I2C_CLEAR_PULSES = 9;
+constexpr uint32_t I2C_BACKOFF_MIN = 10;
+constexpr uint32_t I2C_BACKOFF_MAX = 10000;
+
+// Task constants (periods in microseconds)
+constexpr uint8_t TASK_MAX_COUNT = 12;
+constexpr uint32_t TASK_MIN_SLEEP = 100;
+constexpr uint32_t TASK_MAX_SLEEP = 100000;
+constexpr uint32_t TASK_LOAD_WINDOW = 1000000;
+constexpr uint32_t CONTROL_PERIOD = 1000;
+constexpr uint32_t GROUP_PERIOD = 2000;
+constexpr uint32_t BUTTON_PERIOD = 5000;
+constexpr uint32_t TOF_PERIOD = 20000;
+constexpr uint32_t LED_PERIOD = 20000;
+constexpr uint32_t REMOTE_PERIOD = 10000;
+constexpr uint32_t BRIDGE_PERIOD = 50000;
+constexpr uint32_t OTA_PERIOD = 50000;
+constexpr uint32_t SCHEDULE_PERIOD = 1000000;
+constexpr uint32_t LIGHT_PERIOD = 1000000;
 
 // System constants
 constexpr uint32_t BTN_DEBOUNCE = 50;
+constexpr uint32_t BTN_HOLD_TIME = 500;
+constexpr uint8_t BTN_EVENT_QUEUE_SIZE = 8;
 constexpr uint32_t CONFIG_HOLD_TIME = 2000;
+constexpr uint32_t BTN_TAP_TIME = 300;        // Longest press counted as a tap
+constexpr uint32_t BTN_TAP_GAP = 300;         // Tap sequence ends after this long released
+constexpr uint8_t BTN_TAP_MAX = 3;            // Sequence ends at once on this many taps
+constexpr uint32_t BTN_CHORD_WINDOW = 150;    // Presses this close together form a chord
+constexpr uint8_t BTN_LONG_TIERS = 2;
+constexpr uint32_t BTN_LONG_TIME[BTN_LONG_TIERS] = {5000, 10000};   // Long-press tiers, ascending
+constexpr uint8_t BTN_GESTURE_QUEUE_SIZE = 4;
 constexpr uint32_t MANUAL_TIMEOUT = 15000;
 constexpr uint32_t CONFIG_TIMEOUT = 30000;
 
 constexpr int MOTOR_DEFAULT_SPEED = 150;
 constexpr int MOTOR_CONFIG_SPEED = 75;
 constexpr int64_t POS_TOLERANCE = 42;
+constexpr uint32_t MOVE_SETTLE_TIME = 250;
+constexpr uint8_t WAKE_MAX_MINUTES = 60;
+constexpr int WAKE_MIN_SPEED = 40;
+constexpr int WAKE_KICK_STEP = 5;
+constexpr int64_t WAKE_LAG_PER_STEP = 4;
+constexpr uint32_t WAKE_STALL_TIME = 100;
 
-constexpr uint16_t TOF_THRESHOLD = 25;
-constexpr uint32_t TOF_DEBOUNCE = 400;
+constexpr uint16_t TOF_THRESHOLD = 25;       // Tap must come this close (mm)
+constexpr uint16_t GESTURE_RANGE = 300;      // Target enters below this distance (mm)
+constexpr uint16_t GESTURE_EXIT_MARGIN = 40; // Target leaves above range plus margin (mm)
+constexpr uint8_t GESTURE_HISTORY = 16;
+constexpr uint8_t GESTURE_FILTER_SHIFT = 1;
+constexpr uint32_t GESTURE_EXIT_TIME = 150;
+constexpr uint32_t GESTURE_GAP_RESET = 500;
+constexpr uint32_t GESTURE_TAP_TIME = 400;
+constexpr uint16_t GESTURE_SWIPE_DISTANCE = 80;
+constexpr uint32_t GESTURE_SWIPE_TIME = 400;
+constexpr uint16_t GESTURE_HOLD_BAND = 15;
+constexpr uint32_t GESTURE_HOLD_TIME = 800;
+constexpr uint32_t GESTURE_HOLD_SETTLE = 300;
+constexpr uint16_t GESTURE_HOLD_NEAR = 50;
+constexpr uint16_t GESTURE_HOLD_FAR = 250;
+constexpr uint16_t TOF_INTEREST_RANGE = 600;    // Switch to fast ranging below this distance (mm)
+constexpr uint32_t TOF_IDLE_PERIOD = 200;
+constexpr uint32_t TOF_IDLE_BUDGET = 20000;     // Timing budgets (us)
+constexpr uint32_t TOF_ACTIVE_BUDGET = 33000;
+constexpr uint32_t TOF_ACTIVE_HOLD = 3000;
+constexpr uint32_t TOF_POLL_MARGIN = 5;
+constexpr bool TOF_SUSPEND_WHILE_MOVING = false;
+constexpr uint8_t TOF_RANGE_VALID = 11;         // Device range status for a good measurement
+constexpr uint16_t TOF_MIN_SIGNAL_RATE = 32;    // Return signal rate (MCPS, 9.7 fixed point)
+constexpr uint8_t TOF_MAX_SENSORS = 4;
+constexpr uint8_t TOF_BASE_ADDRESS = 0x30;      // Sensor i is moved to base + i during bring-up
+constexpr uint32_t TOF_BOOT_TIME = 2;           // XSHUT release until the sensor answers (ms)
+constexpr uint32_t TOF_FUSION_WINDOW = 300;     // Other sensors ignored after a gesture (ms)
+constexpr uint8_t LIGHT_FILTER_SHIFT = 5;       // Light level EMA over ~32 periods
+constexpr uint32_t LIGHT_STALE_TIME = 60000;    // Level forgotten after this long without samples (ms)
+constexpr uint8_t LIGHT_OVERRIDE_TOLERANCE = 2; // Glare position still counts as untouched (percent)
+constexpr uint8_t LIGHT_MAX_DELAY = 120;        // Longest glare hold time (min)
 
 // Pin definitions
 constexpr uint8_t PIN_BTN_OPEN = 19;
@@ -45,5 +169,13 @@ constexpr uint8_t ENC_PCNT = 0;
 
 constexpr uint8_t PIN_I2C_SDA = 6;
 constexpr uint8_t PIN_I2C_SCL = 7;
+// ToF shutdown pins in bring-up order, one per sensor (build flag for more, e.g. -D TOF_XSHUT_PINS=2,3).
+// Only a lone sensor may be unwired (stays at the default address, where a second sensor would collide)
+#ifndef TOF_XSHUT_PINS
+#define TOF_XSHUT_PINS PIN_NONE
+#endif
+constexpr uint8_t PIN_NONE = 0xFF;
+constexpr uint8_t PIN_TOF_XSHUT[] = {TOF_XSHUT_PINS};
+constexpr uint8_t TOF_SENSOR_COUNT = sizeof(PIN_TOF_XSHUT);
 
 #endif // CONFIG_H
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <cstdint>
+#include "config.h"
+
+// Recognized ToF gestures
+enum class TofGesture : uint8_t {
+  NONE,
+  TAP,        // Quick pass close to the sensor
+  APPROACH,   // Fast move toward the sensor
+  RETREAT,    // Fast move away from the sensor
+  HOLD        // Hand held still in range (percent from distance)
+};
+
+// Recognizer phases
+enum class GesturePhase : uint8_t {
+  IDLE,       // Nothing in range
+  PRESENT,    // Target in range, no gesture yet
+  HOLDING,    // Target held, reporting positions
+  DONE        // Swipe seen, waiting for target to leave
+};
+
+// Gesture recognizer state (fixed size, one per sensor)
+struct GestureRecognizer {
+  GesturePhase phase;
+  uint16_t recent[2];         // Last two valid raw distances for the median (mm, newest first)
+  uint32_t filtered;          // EMA of distance (mm, Q4)
+  uint16_t nearest;           // Closest raw distance since entry (mm)
+  uint16_t holdAnchor;        // Distance the target is held around (mm)
+  uint8_t lastPercent;        // Last reported hold position (0xFF = none)
+  TofGesture pendingSwipe;    // Swipe held back while the target could still be a tap
+  uint32_t entryTime;         // Times in ms
+  uint32_t lastSeenTime;
+  uint32_t lastSampleTime;
+  uint32_t holdStartTime;
+  uint8_t historyHead;        // Ring of recent filtered samples for swipe detection
+  uint8_t historyCount;
+  uint32_t historyTime[GESTURE_HISTORY];
+  uint16_t historyDistance[GESTURE_HISTORY];
+};
+
+// Clear recognizer to idle
+void resetGesture(GestureRecognizer &recognizer);
+
+// Feed timestamped distance sample (0 = no target or rejected), percent is set for HOLD
+TofGesture updateGesture(GestureRecognizer &recognizer, uint32_t time, uint16_t distance, uint8_t &percent);
+
+#endif // GESTURE_H
@@ -0,0 +1,34 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef GROUP_H
+#define GROUP_H
+
+#include <cstdint>
+
+// Forward declare web server class
+class AsyncWebServer;
+
+// Multicast datagram types (little-endian, 20 bytes)
+//   [0:1]   Magic "AB"
+//   [2]     Protocol version
+//   [3]     Type
+//   [4]     Group ID (1-255, 0 = not in a group)
+//   [5]     Percent open (0-100)
+//   [6:7]   Sequence number (per sender)
+//   [8:11]  Sender ID
+//   [12:19] Start time (us since epoch, NTP time)
+enum GroupMessage : uint8_t {
+  GROUP_MOVE = 0x01,    // Start moving to percent at start time
+  GROUP_DONE = 0x02     // Member finished move (start time = finish time)
+};
+
+// Attach group routes to web server and load group settings
+void setupGroup(AsyncWebServer &server);
+
+// Join multicast group, start due moves, and report completion
+void updateGroup();
+
+#endif // GROUP_H
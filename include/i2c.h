@@ -0,0 +1,43 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef I2C_H
+#define I2C_H
+
+#include <atomic>
+#include <cstdint>
+
+// Bus job run on the I2C task, returns false on a bus error
+using I2cJob = bool (*)(void *context);
+
+// Transaction progress
+enum class I2cState : uint8_t {
+  IDLE,
+  QUEUED,   // Waiting for or running on the I2C task
+  DONE,
+  FAILED    // Bus error, or skipped while the transaction is backing off
+};
+
+// Transaction slot owned by the submitter (must stay valid until no longer QUEUED)
+struct I2cTransaction {
+  I2cJob job;
+  void *context;
+  std::atomic<I2cState> state;
+  uint32_t queuedTime;   // Submit time (us)
+  uint32_t latency;      // Submit to completion (us)
+  uint8_t failureStreak; // Failed runs in a row (written by the I2C task)
+  uint32_t retryTime;    // Earliest run after the last failure (ms)
+};
+
+// Start shared bus in fast mode and the I2C task (bus may be used directly until jobs are queued)
+bool setupI2c();
+
+// Queue job on the I2C task without waiting, false if the slot is busy or the queue is full
+bool i2cSubmit(I2cTransaction &transaction, I2cJob job, void *context);
+
+// Check if a transaction is out of its backoff after it failed (others on the bus are not held back)
+bool i2cAvailable(const I2cTransaction &transaction);
+
+#endif // I2C_H
@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef LIGHT_H
+#define LIGHT_H
+
+#include <cstdint>
+
+// Forward declare web server class
+class AsyncWebServer;
+
+// Glare rule settings (levels are smoothed ambient rates in kcps)
+struct LightConfig {
+  bool enabled;
+  uint8_t percent;        // Close to this position (percent open) during glare
+  uint16_t closeLevel;    // Glare starts above this level...
+  uint8_t closeDelay;     // ...held for this many minutes
+  uint16_t openLevel;     // Glare ends below this level (less than closeLevel)...
+  uint8_t openDelay;      // ...held for this many minutes
+};
+
+// Attach light routes to web server and load rule settings
+void setupLight(AsyncWebServer &server);
+
+// Feed ambient rate of a ToF sample (MCPS, 9.7 fixed point)
+void lightSample(uint16_t ambientRate);
+
+// Smooth light level and evaluate glare rule (low rate)
+void updateLight();
+
+#endif // LIGHT_H
@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <cstdint>
+
+// Forward declare web request class
+class AsyncWebServerRequest;
+
+// Log severity levels
+enum class LogLevel : uint8_t {
+  DEBUG,    // 0
+  INFO,     // 1
+  WARN,     // 2
+  ERROR     // 3
+};
+
+// Minimum compiled log level (override with -D LOG_LEVEL=n)
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 1
+#endif
+
+// Initialize log buffer drain task
+void setupLog();
+
+// Record log entry in constant time (safe from any task or ISR)
+// The format string is stored by pointer and must be a string literal. Arguments are
+// stored as int64_t and formatted later, so every conversion must be %lld/%llu/%llx.
+void logWrite(LogLevel level, const char *format, int64_t arg0 = 0, int64_t arg1 = 0, int64_t arg2 = 0,
+              int64_t arg3 = 0);
+
+// Send recent log entries as plain text
+void handleLogRequest(AsyncWebServerRequest *request);
+
+// Compile-time filtered logging macros
+#if LOG_LEVEL <= 0
+#define LOG_DEBUG(...) logWrite(LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_LEVEL <= 1
+#define LOG_INFO(...) logWrite(LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_LEVEL <= 2
+#define LOG_WARN(...) logWrite(LogLevel::WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if LOG_LEVEL <= 3
+#define LOG_ERROR(...) logWrite(LogLevel::ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif // LOG_H
@@ -8,8 +8,11 @@
 
 #include <cstdint>
 
-// Forward declare scheduler struct
-struct ScheduleTime;
+// Forward declare scheduler structs
+struct ScheduleEntry;
+struct VacationConfig;
+struct BridgeConfig;
+struct LightConfig;
 
 // Initialize nonvolatile memory
 bool setupMemory();
@@ -26,10 +29,64 @@ int64_t loadLastPosition();
 // Save last position to memory
 bool saveLastPosition(int64_t lastPos);
 
-// Load schedule times from memory
-void loadSchedule(ScheduleTime &openSched, ScheduleTime &closeSched);
+// Load schedule entries from memory (returns number loaded)
+uint8_t loadSchedule(ScheduleEntry *entries, uint8_t maxEntries);
 
-// Save schedule times to memory
-bool saveSchedule(ScheduleTime openSched, ScheduleTime closeSched);
+// Save schedule entries to memory
+bool saveSchedule(const ScheduleEntry *entries, uint8_t count);
+
+// Load preset positions (percent open) from memory
+void loadPresets(uint8_t *presets, uint8_t count);
+
+// Save preset positions (percent open) to memory
+bool savePresets(const uint8_t *presets, uint8_t count);
+
+// Load vacation mode settings from memory
+void loadVacation(VacationConfig &config);
+
+// Save vacation mode settings to memory
+bool saveVacation(const VacationConfig &config);
+
+// Load MQTT broker settings from memory
+void loadBridgeConfig(BridgeConfig &config);
+
+// Save MQTT broker settings to memory
+bool saveBridgeConfig(const BridgeConfig &config);
+
+// Load group ID (0 = none) from memory
+uint8_t loadGroup();
+
+// Save group ID (0 = none) to memory
+bool saveGroup(uint8_t group);
+
+// Load glare rule settings from memory
+void loadLight(LightConfig &config);
+
+// Save glare rule settings to memory
+bool saveLight(const LightConfig &config);
+
+// Load last applied schedule event time from memory
+uint32_t loadLastEvent();
+
+// Save last applied schedule event time to memory
+bool saveLastEvent(uint32_t eventTime);
+
+// Load learned clock drift (ppb) from memory
+int32_t loadClockDrift();
+
+// Save learned clock drift (ppb) to memory
+bool saveClockDrift(int32_t drift);
+
+// Load location (1e-4 degrees) from memory
+void loadLocation(int32_t &latitude, int32_t &longitude);
+
+// Save location (1e-4 degrees) to memory
+bool saveLocation(int32_t latitude, int32_t longitude);
+
+// Load pending Wi-Fi provisioning request from memory
+bool loadProvisionRequest();
+
+// Save pending Wi-Fi provisioning request to memory
+bool saveProvisionRequest(bool requested);
 
 #endif // MEMORY_H
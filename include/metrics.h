@@ -0,0 +1,86 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+
+// Forward declare web request class
+class AsyncWebServerRequest;
+
+// Monotonic event counters
+enum class Counter : uint8_t {
+  STATE_TRANSITIONS,
+  MOVES_COMPLETED,
+  MOVES_INTERRUPTED,
+  MOVE_OVERSHOOTS,
+  TOF_READS,
+  TOF_TIMEOUTS,
+  TOF_REJECTED,
+  TOF_TAPS,
+  TOF_APPROACHES,
+  TOF_RETREATS,
+  TOF_HOLDS,
+  TOF_I2C_TRANSACTIONS,
+  I2C_RECOVERIES,
+  LIGHT_MOVES,
+  NVS_WRITES,
+  NVS_WRITE_ERRORS,
+  WIFI_DISCONNECTS,
+  WIFI_RECONNECTS,
+  NTP_SYNCS,
+  MQTT_PUBLISHES,
+  MQTT_DROPS,
+  MQTT_COMMANDS,
+  TASK_OVERRUNS,
+  OTA_UPDATES,
+  OTA_FAILURES,
+  HTTP_ROOT,
+  HTTP_OPEN,
+  HTTP_CLOSE,
+  HTTP_SCHEDULE,
+  HTTP_METRICS,
+  HTTP_NOT_FOUND,
+  COUNT
+};
+
+// Last-value gauges
+enum class Gauge : uint8_t {
+  STATE,
+  POSITION,
+  CLOCK_DRIFT_PPB,
+  CLOCK_DEGRADED,
+  TASK_LOAD,
+  TOF_DUTY_PERMILLE,
+  TOF_SENSORS,
+  LIGHT_LEVEL,
+  COUNT
+};
+
+// Fixed-bucket histograms
+enum class Histogram : uint8_t {
+  LOOP_PERIOD_US,
+  MOVE_DURATION_MS,
+  MOVE_ERROR,
+  TOF_READ_US,
+  I2C_JOB_US,
+  NVS_WRITE_US,
+  COUNT
+};
+
+// Increment counter (safe from any task)
+void metricIncrement(Counter counter, uint32_t amount = 1);
+
+// Set gauge value (safe from any task)
+void metricSet(Gauge gauge, int32_t value);
+
+// Record histogram observation (safe from any task)
+void metricObserve(Histogram histogram, uint32_t value);
+
+// Stream all metrics in Prometheus text format
+void handleMetricsRequest(AsyncWebServerRequest *request);
+
+#endif // METRICS_H
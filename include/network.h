@@ -0,0 +1,21 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef NETWORK_H
+#define NETWORK_H
+
+// Start Wi-Fi provisioning and reconnection task
+bool setupNetwork();
+
+// Check if station is connected with an IP address
+bool isNetworkConnected();
+
+// Check and clear connection change flag
+bool networkChanged();
+
+// Restart into the captive portal to provision new credentials
+void restartIntoProvisioning();
+
+#endif // NETWORK_H
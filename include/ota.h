@@ -0,0 +1,21 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef OTA_H
+#define OTA_H
+
+// Forward declare web server class
+class AsyncWebServer;
+
+// Firmware update (basic auth, multipart POST)
+//   /update?sha256=<64 hex>  Stream image into the inactive OTA partition and boot it if the hash matches
+
+// Attach update endpoint to web server
+void setupOta(AsyncWebServer &server);
+
+// Hold motor during updates, confirm a new image, and restart after success
+void updateOta();
+
+#endif // OTA_H
@@ -0,0 +1,39 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include <cstdint>
+
+// Forward declare web server class
+class AsyncWebServer;
+
+// Binary WebSocket frame opcodes (first byte of each frame)
+//   MOVE:  [0x01, percent]            Move to percent open (0-100)
+//   STOP:  [0x02]                     Stop current movement
+//   NUDGE: [0x03, int8 percent]       Move relative to current target
+//   OPEN:  [0x04]                     Move to open position
+//   CLOSE: [0x05]                     Move to close position
+//   STATE: [0x80, state, percent]     Broadcast from device on change
+enum RemoteOpcode : uint8_t {
+  REMOTE_MOVE = 0x01,
+  REMOTE_STOP = 0x02,
+  REMOTE_NUDGE = 0x03,
+  REMOTE_OPEN = 0x04,
+  REMOTE_CLOSE = 0x05,
+  REMOTE_STATE = 0x80
+};
+
+// Attach WebSocket control endpoint to web server
+void setupRemote(AsyncWebServer &server);
+
+// Queue command for the loop from any task, replacing any older command (newest wins)
+void postRemoteCommand(uint8_t opcode, uint8_t arg = 0);
+
+// Apply latest remote command and broadcast state changes
+void updateRemote();
+
+#endif // REMOTE_H
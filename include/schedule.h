@@ -8,18 +8,56 @@
 
 #include <cstdint>
 
-// Scheduler time information
-struct ScheduleTime {
-  uint8_t hour;
-  uint8_t minute;
+// Scheduled action types
+enum class ScheduleAction : uint8_t {
+  OPEN,       // 0 - Move to open position
+  CLOSE,      // 1 - Move to close position
+  PERCENT,    // 2 - Move to percent open (arg)
+  PRESET,     // 3 - Move to preset position (arg = index)
+  WAKE        // 4 - Open slowly (arg = duration in minutes)
 };
 
+// Scheduled time reference
+enum class ScheduleBase : uint8_t {
+  TIME,       // 0 - Fixed local time
+  SUNRISE,    // 1 - Offset from sunrise
+  SUNSET,     // 2 - Offset from sunset
+  DAWN,       // 3 - Offset from civil dawn
+  DUSK        // 4 - Offset from civil dusk
+};
+
+// Scheduler entry (stored packed into 32 bits)
+struct ScheduleEntry {
+  uint8_t days;             // Weekday bitmask (bit 0 = Sunday), 0 = unused
+  int16_t minute;           // Minute of day (0-1439), or offset in minutes for solar bases
+  ScheduleAction action;    // Action to perform
+  uint8_t arg;              // Action argument (0-127)
+  ScheduleBase base;        // Time reference
+};
+
+// Vacation mode settings
+struct VacationConfig {
+  bool enabled;           // Shift entries by a random offset each day
+  bool partialMoves;      // Add one random partial move each day
+  uint8_t maxOffset;      // Maximum shift in minutes (either direction)
+  uint32_t seed;          // PRNG seed (same seed repeats the same days)
+};
+
+// Pack entry for storage
+uint32_t packScheduleEntry(const ScheduleEntry &entry);
+
+// Unpack entry from storage
+ScheduleEntry unpackScheduleEntry(uint32_t packed);
+
 // Initialize scheduler, Wi-Fi, NTP, and web server
 bool setupScheduler();
 
-// Check scheduled times for action triggers
+// Run due scheduled actions and re-arm the next event timer
 void checkSchedule();
 
+// Get preset position in percent open (false if index is out of range)
+bool getPresetPercent(uint8_t index, uint8_t &percent);
+
 // Sync RTC with NTP server
 void syncRTC();
 
@@ -0,0 +1,24 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef SOLAR_H
+#define SOLAR_H
+
+#include <cstdint>
+#include <ctime>
+
+// Solar event times for one day (0 if the event does not occur)
+struct SolarTimes {
+  time_t dawn;      // Civil twilight start (sun 6 deg below horizon)
+  time_t sunrise;
+  time_t sunset;
+  time_t dusk;      // Civil twilight end
+};
+
+// Compute solar event times for a calendar date using fixed-point math
+// Latitude/longitude in 1e-4 degrees (north/east positive)
+SolarTimes computeSolarTimes(int year, int month, int day, int32_t latitude, int32_t longitude);
+
+#endif // SOLAR_H
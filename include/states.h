@@ -21,12 +21,49 @@ enum class SystemState {
   ERROR           // 8
 };
 
+// State machine input events
+enum class StateEvent : uint8_t {
+  OPEN_PRESS,     // Button events grouped per button (PRESS, HOLD, RELEASE)
+  OPEN_HOLD,
+  OPEN_RELEASE,
+  CLOSE_PRESS,
+  CLOSE_HOLD,
+  CLOSE_RELEASE,
+  MODE_PRESS,
+  MODE_HOLD,
+  MODE_RELEASE,
+  TOF_TAP,        // ToF gestures
+  TOF_APPROACH,
+  TOF_RETREAT,
+  TOF_HOLD,
+  OPEN_CLICK,     // Single press once no further tap can follow
+  CLOSE_CLICK,
+  GESTURE_STOP,   // Bound button gestures
+  GESTURE_PRESET,
+  GESTURE_CALIBRATE,
+  GESTURE_PROVISION,
+  TICK,           // Dispatched once per update for timeouts and arrival
+  COUNT
+};
+
 // Initialize state machine
 void setupStates();
 
-// Handle system state transitions and logic
+// Dispatch debounced button events
+void updateButtonInput();
+
+// Dispatch ToF trigger in states that handle it
+void updateTofInput();
+
+// Check arrival, timeouts, and move statistics
 void updateStateMachine();
 
+// Animate LED for the current state
+void updateStatusLed();
+
+// Look up and execute transition for event in current state
+void dispatchStateEvent(StateEvent event);
+
 // Transition to a new state and update LED
 void enterState(SystemState newState);
 
@@ -36,4 +73,25 @@ void triggerOpen();
 // Start moving to close position
 void triggerClose();
 
+// Start moving to a position in percent open (0-100)
+void triggerMoveTo(uint8_t percent);
+
+// Start slow open over a duration (ms) from idle
+void triggerWake(uint32_t duration);
+
+// Start moving relative to the current target in percent
+void triggerNudge(int8_t percent);
+
+// Stop current movement
+void triggerStop();
+
+// Stop and hold motor, ignoring all move inputs while locked
+void setMotionLock(bool locked);
+
+// Get current system state
+SystemState getState();
+
+// Get current position in percent open (0-100)
+uint8_t getPositionPercent();
+
 #endif // STATES_H
@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <cstdint>
+
+// Forward declare web request class
+class AsyncWebServerRequest;
+
+// Periodic task entry point
+using TaskFunction = void (*)();
+
+// Task priorities (lower value runs first when several are due)
+enum class TaskPriority : uint8_t {
+  CONTROL,      // Motor control and timing critical work
+  SENSOR,       // Buttons and sensors
+  DISPLAY,      // LED animation
+  BACKGROUND    // Network, schedule, and housekeeping
+};
+
+// Initialize scheduler (call from the loop task before adding tasks)
+void setupTasks();
+
+// Register periodic task, first run is due immediately
+bool addTask(const char *name, TaskFunction function, uint32_t periodUs, TaskPriority priority);
+
+// Run the most urgent due task, or sleep until the next deadline
+void runTasks();
+
+// Send per-task timing statistics as JSON
+void handleTasksRequest(AsyncWebServerRequest *request);
+
+#endif // TASKS_H
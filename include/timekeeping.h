@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef TIMEKEEPING_H
+#define TIMEKEEPING_H
+
+#include <cstdint>
+#include <ctime>
+
+// Load learned clock drift and reset sync history
+void setupTimekeeping();
+
+// Record NTP sync point and refit drift (safe from SNTP task)
+void recordTimeSync(const struct timeval &tv);
+
+// Persist drift estimate after it changes
+void updateTimekeeping();
+
+// Get drift-corrected wall clock time
+time_t timeNow();
+
+// Get drift-corrected wall clock time in microseconds
+int64_t timeNowMicros();
+
+// Get monotonic timer delay (us) until a wall clock time
+uint64_t delayUntil(time_t target);
+
+// Check if clock is running without a recent NTP sync
+bool isTimeDegraded();
+
+// Get estimated clock drift (parts per billion, positive = local clock slow)
+int32_t getClockDrift();
+
+#endif // TIMEKEEPING_H
@@ -6,10 +6,26 @@
 #ifndef TOF_H
 #define TOF_H
 
-// Initialize ToF sensor
+#include <cstdint>
+#include "gesture.h"
+
+// Initialize ToF sensors (true if at least one is up)
 bool setupTof();
 
-// Detect object presence
-bool isTofTriggered();
+// Sensor acquisition modes
+enum class TofMode : uint8_t {
+  IDLE,       // Slow, short-budget ranging until something comes near
+  ACTIVE,     // Back-to-back ranging for gestures
+  SUSPENDED   // Ranging stopped
+};
+
+// Service next sensor in turn and recognize gestures (percent set for HOLD, nothing while suspended)
+TofGesture pollTofGesture(uint8_t &percent);
+
+// Stop ranging while gestures are not needed, resume in idle mode
+void setTofSuspended(bool suspended);
+
+// Get current acquisition mode
+TofMode getTofMode();
 
 #endif // TOF_H
@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+
+// Forward declare web server class
+class AsyncWebServer;
+
+// Trace record types
+enum class TraceType : uint8_t {
+  TOF = 1,        // Range in mm (0 = no target or rejected) << 2 | sensor index, delta coded
+  BUTTON = 2,     // Raw button level change (pin << 1 | level)
+  POSITION = 3,   // Encoder position, delta coded
+  STATE = 4,      // System state entered
+  COUNT
+};
+
+// Binary trace format ("/trace", little-endian)
+//   File:    "ABTR", version, block count, block size (uint16), then blocks oldest first
+//   Block:   start time (uint32, ms since boot), records, zero padding
+//   Record:  type (1 byte), time since previous record in block (varint, ms), value (varint)
+//   Values of delta coded types are zigzag deltas from the previous value of that type in the
+//   block, other values are stored as is. Delta state restarts with each block, so the oldest
+//   block can be dropped when the ring is full and every remaining block still decodes.
+
+// Attach trace routes to web server
+void setupTrace(AsyncWebServer &server);
+
+// Append record to the trace ring (loop task only)
+void traceRecord(TraceType type, int32_t value);
+
+#endif // TRACE_H
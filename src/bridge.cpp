@@ -0,0 +1,407 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "bridge.h"
+#include <Arduino.h>
+#include <esp_mac.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <mqtt_client.h>
+#include <atomic>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "network.h"
+#include "states.h"
+#include "metrics.h"
+#include "log.h"
+
+// Command opcodes for the pending slot (opcode << 8 | argument)
+enum BridgeCommand : uint8_t {
+  BRIDGE_OPEN = 0x01,
+  BRIDGE_CLOSE = 0x02,
+  BRIDGE_STOP = 0x03,
+  BRIDGE_POSITION = 0x04
+};
+
+// Snapshot slot value before the loop posts the first state
+static constexpr uint16_t SNAPSHOT_NONE = 0xFFFF;
+
+// Client variables (owned by the bridge task, client calls can wait on the client lock)
+static TaskHandle_t bridgeTaskHandle = nullptr;
+static esp_mqtt_client_handle_t client = nullptr;
+static BridgeConfig config;
+static char deviceId[8];
+static char topicBase[24];
+static std::atomic<bool> brokerConnected(false);
+static std::atomic<bool> disconnected(false);
+static std::atomic<bool> resendAll(false);
+static std::atomic<bool> reconfigure(false);
+static std::atomic<uint16_t> pendingCommand(0);
+static std::atomic<uint16_t> stateSnapshot(SNAPSHOT_NONE);
+static portMUX_TYPE configLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Reconnect variables (bridge task)
+static unsigned long nextAttemptTime = 0;
+static uint32_t backoff = MQTT_BACKOFF_MIN;
+static bool retryPending = false;
+
+// Publish variables (bridge task, retained state and position are tracked apart)
+static const char *lastSentCover = nullptr;
+static int16_t lastSentPercent = -1;
+static unsigned long lastPublishTime = 0;
+
+// Loop variables (last snapshot handed to the bridge task)
+static uint16_t postedSnapshot = SNAPSHOT_NONE;
+static bool postedOnline = false;
+
+// Build full topic from base and suffix
+static const char *buildTopic(char *buffer, size_t size, const char *suffix) {
+  snprintf(buffer, size, "%s/%s", topicBase, suffix);
+  return buffer;
+}
+
+// Queue message in client outbox, refusing when outbox is over limit
+static bool enqueue(const char *topicName, const char *payload, bool retain) {
+  if (esp_mqtt_client_get_outbox_size(client) > MQTT_OUTBOX_LIMIT) {
+    return false;
+  }
+  if (esp_mqtt_client_enqueue(client, topicName, payload, 0, 1, retain, true) < 0) {
+    return false;
+  }
+  metricIncrement(Counter::MQTT_PUBLISHES);
+  return true;
+}
+
+// Publish Home Assistant cover discovery config
+static void publishDiscovery() {
+  char discoveryTopic[48];
+  char payload[512];
+
+  snprintf(discoveryTopic, sizeof(discoveryTopic), "homeassistant/cover/%s/config", deviceId);
+  snprintf(payload, sizeof(payload),
+           "{\"name\":null,\"unique_id\":\"autoblinds_%s\",\"device_class\":\"blind\","
+           "\"~\":\"%s\",\"cmd_t\":\"~/set\",\"stat_t\":\"~/state\",\"pos_t\":\"~/position\","
+           "\"set_pos_t\":\"~/set_position\",\"avty_t\":\"~/availability\",\"qos\":1,"
+           "\"dev\":{\"ids\":[\"autoblinds_%s\"],\"name\":\"AutoBlinds %s\",\"mf\":\"AutoBlinds\"}}",
+           deviceId, topicBase, deviceId, deviceId);
+  esp_mqtt_client_enqueue(client, discoveryTopic, payload, 0, 1, 1, true);
+}
+
+// Parse command topic/payload into pending slot
+static void handleMessage(const char *topicName, int topicLength, const char *data, int dataLength) {
+  char payload[8];
+  int length = min(dataLength, (int)sizeof(payload) - 1);
+  memcpy(payload, data, length);
+  payload[length] = '\0';
+
+  int baseLength = strlen(topicBase);
+  if (topicLength <= baseLength + 1 || strncmp(topicName, topicBase, baseLength) != 0) {
+    return;
+  }
+  const char *suffix = topicName + baseLength + 1;
+  int suffixLength = topicLength - baseLength - 1;
+
+  uint16_t command = 0;
+  if (suffixLength == 3 && strncmp(suffix, "set", 3) == 0) {
+    if (strcmp(payload, "OPEN") == 0) {
+      command = BRIDGE_OPEN << 8;
+    } else if (strcmp(payload, "CLOSE") == 0) {
+      command = BRIDGE_CLOSE << 8;
+    } else if (strcmp(payload, "STOP") == 0) {
+      command = BRIDGE_STOP << 8;
+    }
+  } else if (suffixLength == 12 && strncmp(suffix, "set_position", 12) == 0) {
+    command = (BRIDGE_POSITION << 8) | (uint8_t)constrain(atoi(payload), 0, 100);
+  }
+  if (command != 0) {
+    metricIncrement(Counter::MQTT_COMMANDS);
+    pendingCommand.store(command);
+  }
+}
+
+// Wake bridge task
+static void wakeBridge() {
+  if (bridgeTaskHandle != nullptr) {
+    xTaskNotifyGive(bridgeTaskHandle);
+  }
+}
+
+// Client event handler (runs in MQTT task, only touches atomics and the outbox)
+static void onMqttEvent(void *arg, esp_event_base_t base, int32_t eventId, void *eventData) {
+  esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)eventData;
+  char topicName[48];
+
+  switch ((esp_mqtt_event_id_t)eventId) {
+    case MQTT_EVENT_CONNECTED:
+      LOG_INFO("MQTT Connected\n");
+      esp_mqtt_client_subscribe(client, buildTopic(topicName, sizeof(topicName), "set"), 1);
+      esp_mqtt_client_subscribe(client, buildTopic(topicName, sizeof(topicName), "set_position"), 1);
+      esp_mqtt_client_enqueue(client, buildTopic(topicName, sizeof(topicName), "availability"), "online", 0, 1, 1,
+                              true);
+      publishDiscovery();
+      brokerConnected.store(true);
+      resendAll.store(true);
+      wakeBridge();
+      break;
+    case MQTT_EVENT_DISCONNECTED:
+      // Also posted after each failed connect attempt
+      if (brokerConnected.exchange(false)) {
+        LOG_WARN("MQTT Disconnected\n");
+      }
+      disconnected.store(true);
+      wakeBridge();
+      break;
+    case MQTT_EVENT_DATA:
+      // Ignore fragmented messages (commands are tiny)
+      if (event->current_data_offset == 0 && event->data_len == event->total_data_len) {
+        handleMessage(event->topic, event->topic_len, event->data, event->data_len);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// Create and start client from current settings
+static void startClient(const BridgeConfig &settings) {
+  char lastWill[40];
+  esp_mqtt_client_config_t clientConfig = {};
+
+  // Client copies all strings during init
+  buildTopic(lastWill, sizeof(lastWill), "availability");
+  clientConfig.broker.address.uri = settings.uri;
+  clientConfig.credentials.client_id = topicBase;
+  clientConfig.credentials.username = settings.user[0] ? settings.user : nullptr;
+  clientConfig.credentials.authentication.password = settings.password[0] ? settings.password : nullptr;
+  clientConfig.session.keepalive = MQTT_KEEPALIVE;
+  clientConfig.session.last_will.topic = lastWill;
+  clientConfig.session.last_will.msg = "offline";
+  clientConfig.session.last_will.qos = 1;
+  clientConfig.session.last_will.retain = 1;
+  // Reconnects are paced by the bridge task with backoff
+  clientConfig.network.disable_auto_reconnect = true;
+
+  client = esp_mqtt_client_init(&clientConfig);
+  if (client == nullptr) {
+    LOG_ERROR("MQTT Client Init Failed\n");
+    return;
+  }
+  esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, onMqttEvent, nullptr);
+  esp_mqtt_client_start(client);
+  backoff = MQTT_BACKOFF_MIN;
+  retryPending = false;
+}
+
+// Get Home Assistant cover state string
+static const char *coverState(SystemState state, uint8_t percent) {
+  switch (state) {
+    case SystemState::TOGGLE_OPEN:
+      return "opening";
+    case SystemState::TOGGLE_CLOSE:
+      return "closing";
+    default:
+      break;
+  }
+  if (percent >= 100) {
+    return "open";
+  }
+  return (percent == 0) ? "closed" : "stopped";
+}
+
+// Apply latest command from the pending slot
+static void applyCommand() {
+  uint16_t command = pendingCommand.exchange(0);
+
+  switch (command >> 8) {
+    case BRIDGE_OPEN:
+      triggerOpen();
+      break;
+    case BRIDGE_CLOSE:
+      triggerClose();
+      break;
+    case BRIDGE_STOP:
+      triggerStop();
+      break;
+    case BRIDGE_POSITION:
+      triggerMoveTo(command & 0xFF);
+      break;
+    default:
+      break;
+  }
+}
+
+// Publish state and position when changed (returns ticks until an unsent value is due again)
+static TickType_t publishState() {
+  uint16_t snapshot = stateSnapshot.load();
+  unsigned long currentTime = clockMillis();
+  char topicName[48];
+  char payload[4];
+
+  if (snapshot == SNAPSHOT_NONE) {
+    return portMAX_DELAY;
+  }
+  SystemState state = (SystemState)(snapshot >> 8);
+  uint8_t percent = snapshot & 0xFF;
+  const char *cover = coverState(state, percent);
+
+  if (resendAll.exchange(false)) {
+    lastSentCover = nullptr;
+    lastSentPercent = -1;
+    lastPublishTime = currentTime - MQTT_PUBLISH_INTERVAL;
+  }
+
+  // Slots keep only the newest value, a full outbox retries later with fresh data
+  TickType_t wait = portMAX_DELAY;
+  if (cover != lastSentCover) {
+    if (enqueue(buildTopic(topicName, sizeof(topicName), "state"), cover, true)) {
+      lastSentCover = cover;
+    } else {
+      metricIncrement(Counter::MQTT_DROPS);
+      wait = pdMS_TO_TICKS(MQTT_PUBLISH_INTERVAL);
+    }
+  }
+  if (percent != lastSentPercent) {
+    unsigned long elapsed = currentTime - lastPublishTime;
+    if (elapsed < MQTT_PUBLISH_INTERVAL) {
+      return min(wait, pdMS_TO_TICKS(MQTT_PUBLISH_INTERVAL - elapsed));
+    }
+    snprintf(payload, sizeof(payload), "%u", percent);
+    lastPublishTime = currentTime;
+    if (enqueue(buildTopic(topicName, sizeof(topicName), "position"), payload, true)) {
+      lastSentPercent = percent;
+    } else {
+      metricIncrement(Counter::MQTT_DROPS);
+      wait = pdMS_TO_TICKS(MQTT_PUBLISH_INTERVAL);
+    }
+  }
+  return wait;
+}
+
+// Restart, reconnect, and publish (returns ticks until it needs to run without a wake)
+static TickType_t serviceClient() {
+  // Restart client after settings change (destroy waits for the client task to end)
+  if (reconfigure.exchange(false) && client != nullptr) {
+    esp_mqtt_client_destroy(client);
+    client = nullptr;
+    brokerConnected.store(false);
+  }
+
+  if (client == nullptr) {
+    if (!isNetworkConnected()) {
+      return portMAX_DELAY;
+    }
+    portENTER_CRITICAL(&configLock);
+    BridgeConfig settings = config;
+    portEXIT_CRITICAL(&configLock);
+    if (settings.uri[0] != '\0') {
+      startClient(settings);
+    }
+    return portMAX_DELAY;
+  }
+
+  if (!brokerConnected.load()) {
+    unsigned long currentTime = clockMillis();
+    // Schedule retry one backoff after each disconnect
+    if (disconnected.exchange(false)) {
+      nextAttemptTime = currentTime + backoff;
+      retryPending = true;
+    }
+    if (!retryPending || !isNetworkConnected()) {
+      return portMAX_DELAY;
+    }
+    long remaining = (long)(nextAttemptTime - currentTime);
+    if (remaining > 0) {
+      return pdMS_TO_TICKS(remaining);
+    }
+    LOG_DEBUG("MQTT Reconnect Attempt (Backoff: %lld ms)\n", backoff);
+    retryPending = false;
+    backoff = min(backoff * 2, MQTT_BACKOFF_MAX);
+    esp_mqtt_client_reconnect(client);
+    return portMAX_DELAY;
+  }
+  backoff = MQTT_BACKOFF_MIN;
+
+  return publishState();
+}
+
+// Own the client, woken by the loop, settings changes, and client events
+static void bridgeTask(void *arg) {
+  while (true) {
+    TickType_t wait = serviceClient();
+    ulTaskNotifyTake(pdTRUE, wait);
+  }
+}
+
+// Attach MQTT settings routes to web server and load settings
+void setupBridge(AsyncWebServer &server) {
+  uint8_t mac[6];
+
+  loadBridgeConfig(config);
+  esp_read_mac(mac, ESP_MAC_WIFI_STA);
+  snprintf(deviceId, sizeof(deviceId), "%02x%02x%02x", mac[3], mac[4], mac[5]);
+  snprintf(topicBase, sizeof(topicBase), "autoblinds/%s", deviceId);
+
+  // Current settings as JSON (password omitted)
+  server.on("/mqtt", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    portENTER_CRITICAL(&configLock);
+    BridgeConfig current = config;
+    portEXIT_CRITICAL(&configLock);
+    response->printf("{\"uri\":\"%s\",\"user\":\"%s\",\"connected\":%u,\"base\":\"%s\"}", current.uri,
+                     current.user, brokerConnected.load(), topicBase);
+    request->send(response);
+  });
+
+  // Handle settings form submission
+  server.on("/setMqtt", HTTP_GET, [](AsyncWebServerRequest *request) {
+    BridgeConfig newConfig = {};
+
+    if (request->hasParam("uri")) {
+      strlcpy(newConfig.uri, request->getParam("uri")->value().c_str(), sizeof(newConfig.uri));
+    }
+    if (request->hasParam("user")) {
+      strlcpy(newConfig.user, request->getParam("user")->value().c_str(), sizeof(newConfig.user));
+    }
+    // Keep stored password when field is left empty
+    if (request->hasParam("password") && request->getParam("password")->value().length() > 0) {
+      strlcpy(newConfig.password, request->getParam("password")->value().c_str(), sizeof(newConfig.password));
+    } else {
+      portENTER_CRITICAL(&configLock);
+      memcpy(newConfig.password, config.password, sizeof(newConfig.password));
+      portEXIT_CRITICAL(&configLock);
+    }
+
+    if (saveBridgeConfig(newConfig)) {
+      portENTER_CRITICAL(&configLock);
+      config = newConfig;
+      portEXIT_CRITICAL(&configLock);
+      reconfigure.store(true);
+      wakeBridge();
+    } else {
+      LOG_ERROR("Failed to Save MQTT Settings\n");
+    }
+    request->redirect("/");
+  });
+
+  if (xTaskCreate(bridgeTask, "bridge", MQTT_TASK_STACK, nullptr, 1, &bridgeTaskHandle) != pdPASS) {
+    LOG_ERROR("MQTT Task Create Failed\n");
+  }
+}
+
+// Apply commands and hand state changes to the bridge task (never blocks)
+void updateBridge() {
+  applyCommand();
+
+  // Post newest state, the bridge task decides what to publish
+  uint16_t snapshot = ((uint16_t)getState() << 8) | getPositionPercent();
+  bool online = isNetworkConnected();
+  if (snapshot != postedSnapshot || online != postedOnline) {
+    postedSnapshot = snapshot;
+    postedOnline = online;
+    stateSnapshot.store(snapshot);
+    wakeBridge();
+  }
+}
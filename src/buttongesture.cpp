@@ -0,0 +1,128 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "buttongesture.h"
+#include "config.h"
+
+static_assert(BTN_TAP_MAX > 0 && BTN_LONG_TIERS > 0, "Button gestures need taps and long-press tiers");
+static_assert(BTN_TAP_TIME < BTN_LONG_TIME[0], "Taps must be shorter than the first long-press tier");
+
+// Clear recognizer (all buttons up)
+void resetButtonGestures(ButtonGestureRecognizer &recognizer) {
+  recognizer = {};
+}
+
+// Drop pending taps and the rest of the current press of buttons that are down
+void cancelButtonGestures(ButtonGestureRecognizer &recognizer, uint8_t buttons) {
+  buttons &= recognizer.down;
+  recognizer.cancelled |= buttons;
+  for (uint8_t i = 0; i < BUTTON_GESTURE_MAX_BUTTONS; i++) {
+    if (buttons & (1 << i)) {
+      recognizer.taps[i] = 0;
+    }
+  }
+}
+
+// Count set bits of a button mask
+static uint8_t countButtons(uint8_t mask) {
+  uint8_t count = 0;
+  for (; mask != 0; mask &= mask - 1) {
+    count++;
+  }
+  return count;
+}
+
+// Feed timestamped debounced button mask, returns number of events written
+uint8_t updateButtonGestures(ButtonGestureRecognizer &recognizer, uint32_t time, uint8_t down,
+                             ButtonGestureEvent events[BUTTON_GESTURE_MAX_EVENTS]) {
+  uint8_t count = 0;
+  uint8_t wasUp = ~recognizer.down;
+  uint8_t pressed = down & ~recognizer.down;
+  uint8_t released = recognizer.down & ~down;
+  recognizer.down = down;
+
+  for (uint8_t i = 0; i < BUTTON_GESTURE_MAX_BUTTONS; i++) {
+    uint8_t bit = 1 << i;
+    // Finish tap sequences that stayed released for the gap (before a new press can extend them)
+    if ((wasUp & bit) && recognizer.taps[i] > 0 && time - recognizer.releaseTime[i] > BTN_TAP_GAP) {
+      events[count++] = {ButtonGesture::TAP, bit, recognizer.taps[i]};
+      recognizer.taps[i] = 0;
+    }
+    if (pressed & bit) {
+      recognizer.pressTime[i] = time;
+      recognizer.tier[i] = 0;
+      recognizer.cancelled &= ~bit;
+    }
+  }
+
+  // Presses close together form a chord, later presses join it silently
+  if (pressed != 0) {
+    if (recognizer.chord != 0) {
+      recognizer.chord |= pressed;
+    } else {
+      uint8_t recent = 0;
+      for (uint8_t i = 0; i < BUTTON_GESTURE_MAX_BUTTONS; i++) {
+        if ((down & (1 << i)) && time - recognizer.pressTime[i] <= BTN_CHORD_WINDOW) {
+          recent |= 1 << i;
+        }
+      }
+      if (countButtons(recent) >= 2) {
+        recognizer.chord = recent;
+        events[count++] = {ButtonGesture::CHORD, recent, (uint8_t)countButtons(recent)};
+      }
+    }
+  }
+  // A chord ends once all of its buttons are up (their releases are still its own)
+  uint8_t chord = recognizer.chord;
+  if ((chord & down) == 0) {
+    recognizer.chord = 0;
+  }
+
+  for (uint8_t i = 0; i < BUTTON_GESTURE_MAX_BUTTONS; i++) {
+    uint8_t bit = 1 << i;
+    if (chord & bit) {
+      // Chord buttons drop any sequence they were part of
+      recognizer.taps[i] = 0;
+      continue;
+    }
+    if (recognizer.cancelled & bit) {
+      continue;
+    }
+
+    if (down & bit) {
+      // Long press breaks the tap sequence, the top tier is reported immediately
+      uint32_t heldTime = time - recognizer.pressTime[i];
+      uint8_t tier = recognizer.tier[i];
+      while (tier < BTN_LONG_TIERS && heldTime >= BTN_LONG_TIME[tier]) {
+        tier++;
+      }
+      if (tier > recognizer.tier[i]) {
+        recognizer.tier[i] = tier;
+        recognizer.taps[i] = 0;
+        if (tier == BTN_LONG_TIERS) {
+          events[count++] = {ButtonGesture::LONG, bit, tier};
+        }
+      }
+    } else if (released & bit) {
+      if (recognizer.tier[i] > 0) {
+        // Lower tiers are decided on release
+        if (recognizer.tier[i] < BTN_LONG_TIERS) {
+          events[count++] = {ButtonGesture::LONG, bit, recognizer.tier[i]};
+        }
+      } else if (time - recognizer.pressTime[i] <= BTN_TAP_TIME) {
+        recognizer.releaseTime[i] = time;
+        if (++recognizer.taps[i] >= BTN_TAP_MAX) {
+          events[count++] = {ButtonGesture::TAP, bit, recognizer.taps[i]};
+          recognizer.taps[i] = 0;
+        }
+      } else {
+        // A press between a tap and a long press ends the sequence as a slow press of its own
+        recognizer.taps[i] = 0;
+        events[count++] = {ButtonGesture::LONG, bit, 0};
+      }
+    }
+  }
+  return count;
+}
@@ -5,119 +5,132 @@
 
 #include "buttons.h"
 #include <Arduino.h>
+#include <soc/gpio_reg.h>
+#include "buttonbank.h"
+#include "buttongesture.h"
 #include "config.h"
+#include "clock.h"
+#include "trace.h"
+
+// Buttons in event group order (bit 0 = open, 1 = close, 2 = mode)
+using Buttons = ButtonBank<ButtonSpec<PIN_BTN_OPEN, BTN_HOLD_TIME, BTN_DEBOUNCE>,
+                           ButtonSpec<PIN_BTN_CLOSE, BTN_HOLD_TIME, BTN_DEBOUNCE>,
+                           ButtonSpec<PIN_BTN_MODE, CONFIG_HOLD_TIME, BTN_DEBOUNCE>>;
+static_assert(Buttons::maskOf(PIN_BTN_OPEN) == BTN_MASK_OPEN && Buttons::maskOf(PIN_BTN_CLOSE) == BTN_MASK_CLOSE &&
+              Buttons::maskOf(PIN_BTN_MODE) == BTN_MASK_MODE, "Button bits out of order");
+
+static Buttons buttons;
+static ButtonGestureRecognizer recognizer;
+
+// Button event queue (overwrites oldest when full)
+static ButtonEvent eventQueue[BTN_EVENT_QUEUE_SIZE];
+static uint8_t eventHead = 0;
+static uint8_t eventCount = 0;
+
+// Button gesture queue (overwrites oldest when full)
+static ButtonGestureEvent gestureQueue[BTN_GESTURE_QUEUE_SIZE];
+static uint8_t gestureHead = 0;
+static uint8_t gestureCount = 0;
+
+// Add event to queue
+static void pushEvent(uint8_t pin, ButtonEdge edge) {
+  eventQueue[(eventHead + eventCount) % BTN_EVENT_QUEUE_SIZE] = {pin, edge};
+  if (eventCount < BTN_EVENT_QUEUE_SIZE) {
+    eventCount++;
+  } else {
+    eventHead = (eventHead + 1) % BTN_EVENT_QUEUE_SIZE;
+  }
+}
 
-// Button states
-enum class ButtonState {
-  IDLE,      // Default
-  PRESSED,
-  HELD,
-  RELEASED
-};
-
-// Button state information
-struct ButtonInfo {
-  const uint8_t pin;              // GPIO pin number
-  ButtonState state;              // Current debounced state
-  bool lastReading;               // Last raw reading
-  unsigned long lastStateTime;    // Time of last state change
-  unsigned long pressStartTime;   // Time of initial press
-  bool holdTriggered;             // Flag indicating if button is held
-};
-
-// Button state array with initial values
-static ButtonInfo buttons[] = {
-  {PIN_BTN_OPEN, ButtonState::IDLE, LOW, 0, 0, false},
-  {PIN_BTN_CLOSE, ButtonState::IDLE, LOW, 0, 0, false},
-  {PIN_BTN_MODE, ButtonState::IDLE, LOW, 0, 0, false}
-};
-static constexpr uint8_t numButtons = sizeof(buttons) / sizeof(ButtonInfo);
+// Add gesture to queue
+static void pushGesture(const ButtonGestureEvent &gesture) {
+  gestureQueue[(gestureHead + gestureCount) % BTN_GESTURE_QUEUE_SIZE] = gesture;
+  if (gestureCount < BTN_GESTURE_QUEUE_SIZE) {
+    gestureCount++;
+  } else {
+    gestureHead = (gestureHead + 1) % BTN_GESTURE_QUEUE_SIZE;
+  }
+}
 
 // Initialize button GPIO with internal pull-down resistors
 void setupButtons() {
   Serial.print("Initializing Buttons...");
 
-  for (int i = 0; i < numButtons; ++i) {
-    pinMode(buttons[i].pin, INPUT_PULLDOWN);
+  for (uint8_t i = 0; i < Buttons::count; ++i) {
+    pinMode(Buttons::pinOf(i), INPUT_PULLDOWN);
   }
+  resetButtonGestures(recognizer);
 
   Serial.print("Done\n");
 }
 
-// Handle button state transitions from debounced readings
+// Handle button state transitions from debounced readings and queue events
 void updateButtonStates() {
-  unsigned long currentTime = millis();
-
-  for (int i = 0; i < numButtons; ++i) {
-    bool reading = digitalRead(buttons[i].pin);
+  // All button levels come from one register read
+  uint32_t time = clockMillis();
+  buttons.update(REG_READ(GPIO_IN_REG), time);
+
+  // Gestures also resolve on timeouts, so the recognizer runs every update
+  ButtonGestureEvent gestures[BUTTON_GESTURE_MAX_EVENTS];
+  uint8_t gestureEvents = updateButtonGestures(recognizer, time, buttons.down(), gestures);
+  for (uint8_t i = 0; i < gestureEvents; ++i) {
+    pushGesture(gestures[i]);
+  }
 
-    // Debounce button reading
-    if (reading != buttons[i].lastReading) {
-      buttons[i].lastStateTime = currentTime;
+  uint8_t changed = buttons.changed();
+  uint8_t edges = buttons.pressed() | buttons.heldEdge() | buttons.released();
+  if ((changed | edges) == 0) {
+    return;
+  }
+  for (uint8_t i = 0; i < Buttons::count; ++i) {
+    uint8_t bit = 1 << i;
+    uint8_t pin = Buttons::pinOf(i);
+    if (changed & bit) {
+      traceRecord(TraceType::BUTTON, (pin << 1) | ((buttons.raw() & bit) ? 1 : 0));
     }
-    if ((currentTime - buttons[i].lastStateTime) > BTN_DEBOUNCE) {
-      bool isPressed = (reading == HIGH);
-
-      // Compare debounced reading with current state
-      if (isPressed != (buttons[i].state == ButtonState::PRESSED || buttons[i].state == ButtonState::HELD)) {
-        // Button state changed from IDLE/RELEASED
-        if (isPressed) {
-          buttons[i].state = ButtonState::PRESSED;
-          buttons[i].pressStartTime = currentTime;
-          buttons[i].holdTriggered = false;
-        } else {
-          buttons[i].state = ButtonState::RELEASED;
-        }
-      }
-      // Check if the button is being held
-      else if (buttons[i].state == ButtonState::PRESSED && !buttons[i].holdTriggered) {
-        // Determine hold duration based on button type (open/close default to 500ms)
-        unsigned long holdDuration = (buttons[i].pin == PIN_BTN_MODE) ? CONFIG_HOLD_TIME : 500;
-
-        // Check if the hold duration has been met
-        if ((currentTime - buttons[i].pressStartTime) >= holdDuration) {
-          buttons[i].state = ButtonState::HELD;
-          buttons[i].holdTriggered = true;
-        }
-      }
+    if (buttons.pressed() & bit) {
+      pushEvent(pin, ButtonEdge::PRESS);
+    } else if (buttons.heldEdge() & bit) {
+      pushEvent(pin, ButtonEdge::HOLD);
+    } else if (buttons.released() & bit) {
+      pushEvent(pin, ButtonEdge::RELEASE);
     }
-
-    // Store current reading for next call
-    buttons[i].lastReading = reading;
   }
 }
 
-// Check if the button was just pressed (debounced)
-bool isButtonPressed(uint8_t pin) {
-  for (int i = 0; i < numButtons; ++i) {
-    if (buttons[i].pin == pin) {
-      return buttons[i].state == ButtonState::PRESSED;
-    }
+// Get the next queued button event (oldest first)
+bool pollButtonEvent(ButtonEvent &event) {
+  if (eventCount == 0) {
+    return false;
   }
-  return false;
+  event = eventQueue[eventHead];
+  eventHead = (eventHead + 1) % BTN_EVENT_QUEUE_SIZE;
+  eventCount--;
+  return true;
 }
 
-// Check if the button is currently held (debounced)
-bool isButtonHeld(uint8_t pin) {
-  for (int i = 0; i < numButtons; ++i) {
-    if (buttons[i].pin == pin) {
-      return buttons[i].state == ButtonState::HELD;
-    }
+// Get the next queued button gesture (oldest first)
+bool pollButtonGesture(ButtonGestureEvent &gesture) {
+  if (gestureCount == 0) {
+    return false;
   }
-  return false;
+  gesture = gestureQueue[gestureHead];
+  gestureHead = (gestureHead + 1) % BTN_GESTURE_QUEUE_SIZE;
+  gestureCount--;
+  return true;
 }
 
-// Check if the button was just released (debounced)
-bool isButtonReleased(uint8_t pin) {
-  for (int i = 0; i < numButtons; ++i) {
-    if (buttons[i].pin == pin) {
-      if (buttons[i].state == ButtonState::RELEASED) {
-        // Transition RELEASED state to IDLE
-        buttons[i].state = ButtonState::IDLE;
-        return true;
-      }
-      break;
-    }
-  }
-  return false;
+// Drop the gestures of the current presses of buttons
+void cancelButtonGestures(uint8_t buttons) {
+  cancelButtonGestures(recognizer, buttons);
+}
+
+// Get buttons currently down (debounced)
+uint8_t buttonsDown() {
+  return buttons.down();
+}
+
+// Get buttons currently held (debounced)
+uint8_t buttonsHeld() {
+  return buttons.held();
 }
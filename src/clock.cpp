@@ -0,0 +1,121 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "clock.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+// Virtual clock state (shared between tasks)
+static int64_t virtualMonotonic = 0;
+static int64_t virtualWall = 0;
+static bool virtualFast = false;
+static portMUX_TYPE virtualLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Hardware monotonic time
+static int64_t hardwareMonotonic() {
+  return esp_timer_get_time();
+}
+
+// Hardware system time
+static int64_t hardwareWall() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+// Hardware time cannot skip
+static bool hardwareSkip(int64_t span) {
+  return false;
+}
+
+// Virtual monotonic time
+static int64_t readVirtualMonotonic() {
+  portENTER_CRITICAL(&virtualLock);
+  int64_t now = virtualMonotonic;
+  portEXIT_CRITICAL(&virtualLock);
+  return now;
+}
+
+// Virtual wall time (advances with monotonic time)
+static int64_t readVirtualWall() {
+  portENTER_CRITICAL(&virtualLock);
+  int64_t now = virtualWall + virtualMonotonic;
+  portEXIT_CRITICAL(&virtualLock);
+  return now;
+}
+
+// Skip idle time in fast mode
+static bool virtualSkip(int64_t span) {
+  portENTER_CRITICAL(&virtualLock);
+  bool fast = virtualFast;
+  portEXIT_CRITICAL(&virtualLock);
+  if (fast) {
+    advanceVirtualClock(span);
+  }
+  return fast;
+}
+
+const ClockSource hardwareClock = {hardwareMonotonic, hardwareWall, hardwareSkip};
+const ClockSource virtualClock = {readVirtualMonotonic, readVirtualWall, virtualSkip};
+
+// Selected source (set once before tasks start)
+static const ClockSource *source = &hardwareClock;
+
+// Select time source for all modules
+void setClockSource(const ClockSource &newSource) {
+  source = &newSource;
+}
+
+// Check if the virtual clock is in use
+bool isVirtualClock() {
+  return source == &virtualClock;
+}
+
+// Get monotonic time in milliseconds
+uint32_t clockMillis() {
+  return (uint32_t)(source->monotonic() / 1000);
+}
+
+// Get monotonic time in microseconds
+uint32_t clockMicros() {
+  return (uint32_t)source->monotonic();
+}
+
+// Get monotonic time in microseconds since boot
+int64_t clockMonotonic() {
+  return source->monotonic();
+}
+
+// Get system wall time in microseconds since the epoch
+int64_t clockWall() {
+  return source->wall();
+}
+
+// Skip idle time on a virtual clock in fast mode
+bool clockSkip(int64_t span) {
+  return span > 0 && source->skip(span);
+}
+
+// Start virtual clock at a wall time, continuing from current monotonic time
+void startVirtualClock(int64_t wall, bool fast) {
+  int64_t monotonic = esp_timer_get_time();
+  portENTER_CRITICAL(&virtualLock);
+  virtualMonotonic = monotonic;
+  virtualWall = wall - monotonic;
+  virtualFast = fast;
+  portEXIT_CRITICAL(&virtualLock);
+  setClockSource(virtualClock);
+}
+
+// Advance virtual clock
+void advanceVirtualClock(int64_t span) {
+  if (span <= 0) {
+    return;
+  }
+  portENTER_CRITICAL(&virtualLock);
+  virtualMonotonic += span;
+  portEXIT_CRITICAL(&virtualLock);
+}
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "gesture.h"
+#include <algorithm>
+#include <cstdlib>
+#include "config.h"
+
+// Clear recognizer to idle
+void resetGesture(GestureRecognizer &recognizer) {
+  uint32_t lastSampleTime = recognizer.lastSampleTime;
+  recognizer = {};
+  recognizer.phase = GesturePhase::IDLE;
+  recognizer.lastSampleTime = lastSampleTime;
+  recognizer.lastPercent = 0xFF;
+  // Missing samples count as far so one close outlier cannot enter
+  recognizer.recent[0] = UINT16_MAX;
+  recognizer.recent[1] = UINT16_MAX;
+}
+
+// Median of the sample and the last two valid samples
+static uint16_t medianFilter(GestureRecognizer &recognizer, uint16_t distance) {
+  uint16_t a = recognizer.recent[1];
+  uint16_t b = recognizer.recent[0];
+  recognizer.recent[1] = b;
+  recognizer.recent[0] = distance;
+  return std::max(std::min(a, b), std::min(std::max(a, b), distance));
+}
+
+// Start tracking a target that entered range
+static void beginTracking(GestureRecognizer &recognizer, uint32_t time, uint16_t distance) {
+  recognizer.phase = GesturePhase::PRESENT;
+  recognizer.filtered = (uint32_t)distance << 4;
+  recognizer.nearest = distance;
+  recognizer.holdAnchor = distance;
+  recognizer.entryTime = time;
+  recognizer.holdStartTime = time;
+  recognizer.historyHead = 0;
+  recognizer.historyCount = 0;
+}
+
+// Map held distance to percent open (closer is more open)
+static uint8_t holdPercent(uint16_t distance) {
+  if (distance <= GESTURE_HOLD_NEAR) {
+    return 100;
+  }
+  if (distance >= GESTURE_HOLD_FAR) {
+    return 0;
+  }
+  return (uint8_t)((uint32_t)(GESTURE_HOLD_FAR - distance) * 100 / (GESTURE_HOLD_FAR - GESTURE_HOLD_NEAR));
+}
+
+// Check recent samples for a fast distance change
+static TofGesture detectSwipe(const GestureRecognizer &recognizer, uint32_t time, uint16_t distance) {
+  uint16_t lowest = distance;
+  uint16_t highest = distance;
+  for (uint8_t i = 0; i < recognizer.historyCount; i++) {
+    if (time - recognizer.historyTime[i] > GESTURE_SWIPE_TIME) {
+      continue;
+    }
+    lowest = std::min(lowest, recognizer.historyDistance[i]);
+    highest = std::max(highest, recognizer.historyDistance[i]);
+  }
+  if (highest - distance >= GESTURE_SWIPE_DISTANCE) {
+    return TofGesture::APPROACH;
+  }
+  if (distance - lowest >= GESTURE_SWIPE_DISTANCE) {
+    return TofGesture::RETREAT;
+  }
+  return TofGesture::NONE;
+}
+
+// Feed timestamped distance sample (0 = no target), percent is set for HOLD
+TofGesture updateGesture(GestureRecognizer &recognizer, uint32_t time, uint16_t distance, uint8_t &percent) {
+  // Samples were paused, whatever was in range is stale
+  if (time - recognizer.lastSampleTime > GESTURE_GAP_RESET) {
+    resetGesture(recognizer);
+  }
+  recognizer.lastSampleTime = time;
+
+  // Rejected samples are dropouts, valid ones pass the median
+  bool present = false;
+  if (distance > 0) {
+    distance = medianFilter(recognizer, distance);
+    // Enter below range, stay until past range plus margin
+    uint16_t limit = (recognizer.phase == GesturePhase::IDLE) ? GESTURE_RANGE : GESTURE_RANGE + GESTURE_EXIT_MARGIN;
+    present = distance < limit;
+  } else if (recognizer.phase == GesturePhase::IDLE) {
+    // Entry needs consecutive valid samples
+    recognizer.recent[0] = UINT16_MAX;
+    recognizer.recent[1] = UINT16_MAX;
+  }
+
+  if (!present) {
+    // Ride out short dropouts before deciding the target left
+    if (recognizer.phase == GesturePhase::IDLE || time - recognizer.lastSeenTime < GESTURE_EXIT_TIME) {
+      return TofGesture::NONE;
+    }
+    // A quick pass close to the sensor is a tap even if it looked like a swipe on the way in
+    bool tap = (recognizer.phase == GesturePhase::PRESENT || recognizer.pendingSwipe != TofGesture::NONE) &&
+               recognizer.lastSeenTime - recognizer.entryTime <= GESTURE_TAP_TIME &&
+               recognizer.nearest < TOF_THRESHOLD;
+    TofGesture swipe = recognizer.pendingSwipe;
+    resetGesture(recognizer);
+    return tap ? TofGesture::TAP : swipe;
+  }
+
+  recognizer.lastSeenTime = time;
+  if (recognizer.phase == GesturePhase::IDLE) {
+    beginTracking(recognizer, time, distance);
+  } else {
+    // EMA in Q4, alpha = 1 / 2^GESTURE_FILTER_SHIFT
+    int32_t error = ((int32_t)distance << 4) - (int32_t)recognizer.filtered;
+    recognizer.filtered = (uint32_t)((int32_t)recognizer.filtered + (error >> GESTURE_FILTER_SHIFT));
+    recognizer.nearest = std::min(recognizer.nearest, distance);
+  }
+  uint16_t smoothed = (uint16_t)((recognizer.filtered + 8) >> 4);
+
+  TofGesture gesture = TofGesture::NONE;
+  if (recognizer.phase == GesturePhase::PRESENT) {
+    gesture = detectSwipe(recognizer, time, smoothed);
+  }
+
+  // Remember sample for later swipe checks
+  recognizer.historyTime[recognizer.historyHead] = time;
+  recognizer.historyDistance[recognizer.historyHead] = smoothed;
+  recognizer.historyHead = (recognizer.historyHead + 1) % GESTURE_HISTORY;
+  if (recognizer.historyCount < GESTURE_HISTORY) {
+    recognizer.historyCount++;
+  }
+
+  // Hold the swipe back until the tap window has passed or the target leaves
+  if (gesture != TofGesture::NONE) {
+    recognizer.phase = GesturePhase::DONE;
+    recognizer.pendingSwipe = gesture;
+  }
+  if (recognizer.phase == GesturePhase::DONE) {
+    gesture = TofGesture::NONE;
+    if (recognizer.pendingSwipe != TofGesture::NONE && time - recognizer.entryTime > GESTURE_TAP_TIME) {
+      gesture = recognizer.pendingSwipe;
+      recognizer.pendingSwipe = TofGesture::NONE;
+    }
+    return gesture;
+  }
+
+  // Restart hold timer whenever the target leaves the band
+  if (std::abs((int32_t)smoothed - (int32_t)recognizer.holdAnchor) > GESTURE_HOLD_BAND) {
+    recognizer.holdAnchor = smoothed;
+    recognizer.holdStartTime = time;
+    return TofGesture::NONE;
+  }
+  uint32_t heldTime = time - recognizer.holdStartTime;
+  if (recognizer.phase == GesturePhase::PRESENT && heldTime >= GESTURE_HOLD_TIME &&
+      recognizer.holdAnchor >= GESTURE_HOLD_NEAR && recognizer.holdAnchor <= GESTURE_HOLD_FAR) {
+    recognizer.phase = GesturePhase::HOLDING;
+  }
+
+  // Report each new resting position once it settles
+  if (recognizer.phase == GesturePhase::HOLDING && heldTime >= GESTURE_HOLD_SETTLE) {
+    uint8_t newPercent = holdPercent(recognizer.holdAnchor);
+    if (newPercent != recognizer.lastPercent) {
+      recognizer.lastPercent = newPercent;
+      percent = newPercent;
+      return TofGesture::HOLD;
+    }
+  }
+  return TofGesture::NONE;
+}
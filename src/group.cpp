@@ -0,0 +1,283 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "group.h"
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_timer.h>
+#include <esp_mac.h>
+#include <atomic>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "network.h"
+#include "states.h"
+#include "timekeeping.h"
+#include "log.h"
+
+static constexpr uint8_t GROUP_PACKET_SIZE = 20;
+static constexpr uint8_t GROUP_VERSION = 1;
+
+// Decoded datagram
+struct GroupPacket {
+  uint8_t type;
+  uint8_t group;
+  uint8_t percent;
+  uint16_t sequence;
+  uint32_t sender;
+  int64_t time;
+};
+
+// Reported member status
+struct GroupMember {
+  uint32_t id;
+  uint8_t percent;
+  unsigned long lastSeen;
+};
+
+// Group variables
+static AsyncUDP udp;
+static bool listening = false;
+static std::atomic<uint8_t> groupId(0);
+static uint32_t memberId = 0;
+static std::atomic<uint16_t> sequence(0);
+static GroupMember members[GROUP_MAX_MEMBERS];
+static portMUX_TYPE groupLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Scheduled move variables
+static esp_timer_handle_t groupTimer = nullptr;
+static uint32_t lastSender = 0;
+static uint16_t lastSequence = 0;
+static int64_t lastTime = 0;
+static std::atomic<uint8_t> pendingPercent(0);
+static std::atomic<bool> moveDue(false);
+static bool reportPending = false;
+
+// Get multicast group address
+static IPAddress groupAddress() {
+  return IPAddress(GROUP_MULTICAST_ADDR[0], GROUP_MULTICAST_ADDR[1], GROUP_MULTICAST_ADDR[2], GROUP_MULTICAST_ADDR[3]);
+}
+
+// Encode packet into buffer
+static void encodePacket(const GroupPacket &packet, uint8_t *buffer) {
+  buffer[0] = 'A';
+  buffer[1] = 'B';
+  buffer[2] = GROUP_VERSION;
+  buffer[3] = packet.type;
+  buffer[4] = packet.group;
+  buffer[5] = packet.percent;
+  buffer[6] = packet.sequence & 0xFF;
+  buffer[7] = packet.sequence >> 8;
+  for (uint8_t i = 0; i < 4; ++i) {
+    buffer[8 + i] = (packet.sender >> (8 * i)) & 0xFF;
+  }
+  for (uint8_t i = 0; i < 8; ++i) {
+    buffer[12 + i] = ((uint64_t)packet.time >> (8 * i)) & 0xFF;
+  }
+}
+
+// Decode packet from buffer (returns false if malformed)
+static bool decodePacket(const uint8_t *buffer, size_t length, GroupPacket &packet) {
+  if (length != GROUP_PACKET_SIZE || buffer[0] != 'A' || buffer[1] != 'B' || buffer[2] != GROUP_VERSION) {
+    return false;
+  }
+  packet.type = buffer[3];
+  packet.group = buffer[4];
+  packet.percent = min(buffer[5], (uint8_t)100);
+  packet.sequence = buffer[6] | (buffer[7] << 8);
+  packet.sender = 0;
+  for (uint8_t i = 0; i < 4; ++i) {
+    packet.sender |= (uint32_t)buffer[8 + i] << (8 * i);
+  }
+  uint64_t time = 0;
+  for (uint8_t i = 0; i < 8; ++i) {
+    time |= (uint64_t)buffer[12 + i] << (8 * i);
+  }
+  packet.time = (int64_t)time;
+  return true;
+}
+
+// Multicast packet from this device
+static void sendPacket(uint8_t type, uint8_t percent, int64_t time, uint16_t packetSequence, uint8_t repeats) {
+  GroupPacket packet = {type, groupId.load(), percent, packetSequence, memberId, time};
+  uint8_t buffer[GROUP_PACKET_SIZE];
+
+  encodePacket(packet, buffer);
+  // Repeat with the same sequence, receivers drop duplicates
+  for (uint8_t i = 0; i < repeats; ++i) {
+    udp.writeTo(buffer, sizeof(buffer), groupAddress(), GROUP_PORT);
+  }
+}
+
+// Arm the local start timer for a move (safe from any task)
+static void scheduleMove(const GroupPacket &packet) {
+  int64_t delay = packet.time - timeNowMicros();
+
+  // Reject stale or implausibly distant start times
+  if (delay < -(int64_t)GROUP_LATE_TOLERANCE * 1000 || delay > (int64_t)GROUP_MAX_LEAD * 1000) {
+    LOG_WARN("Group: Rejected Move (Start in %lld ms)\n", delay / 1000);
+    return;
+  }
+  // Repeats share sender, sequence and start time (a rebooted sender restarts its sequence with a new time)
+  portENTER_CRITICAL(&groupLock);
+  bool duplicate = (packet.sender == lastSender && packet.sequence == lastSequence && packet.time == lastTime);
+  lastSender = packet.sender;
+  lastSequence = packet.sequence;
+  lastTime = packet.time;
+  portEXIT_CRITICAL(&groupLock);
+  if (duplicate) {
+    return;
+  }
+
+  pendingPercent.store(packet.percent);
+  esp_timer_stop(groupTimer);
+  esp_timer_start_once(groupTimer, (uint64_t)max(delay, (int64_t)0));
+}
+
+// Record member completion report
+static void recordMember(const GroupPacket &packet) {
+  portENTER_CRITICAL(&groupLock);
+  // Update existing slot, else take an empty or the oldest one
+  uint8_t slot = 0;
+  for (uint8_t i = 0; i < GROUP_MAX_MEMBERS; ++i) {
+    if (members[i].id == packet.sender) {
+      slot = i;
+      break;
+    }
+    if (members[i].id == 0 || members[i].lastSeen < members[slot].lastSeen) {
+      slot = i;
+    }
+  }
+  members[slot] = {packet.sender, packet.percent, clockMillis()};
+  portEXIT_CRITICAL(&groupLock);
+}
+
+// Handle datagram (runs in UDP task)
+static void onGroupPacket(AsyncUDPPacket &udpPacket) {
+  GroupPacket packet;
+
+  if (!decodePacket(udpPacket.data(), udpPacket.length(), packet) || groupId.load() == 0 || packet.group != groupId.load() ||
+      packet.sender == memberId) {
+    return;
+  }
+  switch (packet.type) {
+    case GROUP_MOVE:
+      scheduleMove(packet);
+      break;
+    case GROUP_DONE:
+      recordMember(packet);
+      break;
+    default:
+      break;
+  }
+}
+
+// Start timer callback (runs in timer task, only flags the loop)
+static void onGroupTimer(void *arg) {
+  moveDue.store(true);
+}
+
+// Attach group routes to web server and load group settings
+void setupGroup(AsyncWebServer &server) {
+  uint8_t mac[6];
+
+  groupId = loadGroup();
+  esp_read_mac(mac, ESP_MAC_WIFI_STA);
+  memberId = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = onGroupTimer;
+  timerArgs.name = "group";
+  esp_timer_create(&timerArgs, &groupTimer);
+
+  // Group settings and last reported member positions as JSON
+  server.on("/group", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    GroupMember snapshot[GROUP_MAX_MEMBERS];
+    unsigned long currentTime = clockMillis();
+
+    portENTER_CRITICAL(&groupLock);
+    memcpy(snapshot, members, sizeof(snapshot));
+    portEXIT_CRITICAL(&groupLock);
+
+    response->printf("{\"group\":%u,\"id\":\"%08lx\",\"members\":[", groupId.load(), (unsigned long)memberId);
+    bool first = true;
+    for (uint8_t i = 0; i < GROUP_MAX_MEMBERS; ++i) {
+      if (snapshot[i].id == 0) {
+        continue;
+      }
+      response->printf("%s{\"id\":\"%08lx\",\"percent\":%u,\"age\":%lu}", first ? "" : ",",
+                       (unsigned long)snapshot[i].id, snapshot[i].percent, (currentTime - snapshot[i].lastSeen) / 1000);
+      first = false;
+    }
+    response->print("]}");
+    request->send(response);
+  });
+
+  // Handle group settings form submission
+  server.on("/setGroup", HTTP_GET, [](AsyncWebServerRequest *request) {
+    if (request->hasParam("group")) {
+      uint8_t newGroup = constrain(request->getParam("group")->value().toInt(), 0, 255);
+      if (saveGroup(newGroup)) {
+        groupId.store(newGroup);
+        portENTER_CRITICAL(&groupLock);
+        memset(members, 0, sizeof(members));
+        portEXIT_CRITICAL(&groupLock);
+      } else {
+        LOG_ERROR("Failed to Save Group\n");
+      }
+    }
+    request->redirect("/");
+  });
+
+  // Start a synchronized move of the whole group including this device
+  server.on("/groupMove", HTTP_GET, [](AsyncWebServerRequest *request) {
+    if (groupId.load() == 0 || !request->hasParam("percent")) {
+      request->send(400, "text/plain", "Error 400: No group or percent");
+      return;
+    }
+    GroupPacket packet;
+    packet.type = GROUP_MOVE;
+    packet.group = groupId.load();
+    packet.percent = constrain(request->getParam("percent")->value().toInt(), 0, 100);
+    packet.sequence = sequence.fetch_add(1) + 1;
+    packet.sender = memberId;
+    packet.time = timeNowMicros() + (int64_t)GROUP_LEAD_TIME * 1000;
+    sendPacket(packet.type, packet.percent, packet.time, packet.sequence, GROUP_SEND_REPEATS);
+    scheduleMove(packet);
+    request->send(200, "text/plain", "OK");
+  });
+}
+
+// Join multicast group, start due moves, and report completion
+void updateGroup() {
+  // (Re)join multicast after each connection, membership does not survive reconnects
+  bool connected = isNetworkConnected();
+  if (connected && !listening) {
+    if (udp.listenMulticast(groupAddress(), GROUP_PORT)) {
+      udp.onPacket(onGroupPacket);
+      listening = true;
+    }
+  } else if (!connected && listening) {
+    udp.close();
+    listening = false;
+  }
+
+  if (moveDue.exchange(false)) {
+    LOG_INFO("Group: Move to %lld%%\n", pendingPercent.load());
+    triggerMoveTo(pendingPercent.load());
+    reportPending = true;
+  }
+
+  // Report once the move finished or was interrupted
+  if (reportPending && getState() == SystemState::TOGGLE_IDLE) {
+    reportPending = false;
+    if (listening && groupId.load() != 0) {
+      sendPacket(GROUP_DONE, getPositionPercent(), timeNowMicros(), sequence.fetch_add(1) + 1, 1);
+    }
+  }
+}
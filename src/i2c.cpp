@@ -0,0 +1,117 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "i2c.h"
+#include <Arduino.h>
+#include <Wire.h>
+#include "config.h"
+#include "clock.h"
+#include "metrics.h"
+#include "log.h"
+
+// Bus task variables
+static QueueHandle_t jobQueue = nullptr;
+
+// Start driver at fast-mode speed with a short transfer timeout
+static void beginBus() {
+  Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL, I2C_FREQUENCY);
+  Wire.setTimeOut(I2C_TIMEOUT);
+}
+
+// Release a device holding SDA low by clocking out its byte, then send STOP
+static bool clearBus() {
+  Wire.end();
+  pinMode(PIN_I2C_SDA, INPUT_PULLUP);
+  pinMode(PIN_I2C_SCL, OUTPUT_OPEN_DRAIN);
+  digitalWrite(PIN_I2C_SCL, HIGH);
+  delayMicroseconds(5);
+  for (uint8_t i = 0; i < I2C_CLEAR_PULSES && digitalRead(PIN_I2C_SDA) == LOW; i++) {
+    digitalWrite(PIN_I2C_SCL, LOW);
+    delayMicroseconds(5);
+    digitalWrite(PIN_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+  }
+  // STOP is SDA rising while SCL is high
+  pinMode(PIN_I2C_SDA, OUTPUT_OPEN_DRAIN);
+  digitalWrite(PIN_I2C_SDA, LOW);
+  delayMicroseconds(5);
+  digitalWrite(PIN_I2C_SDA, HIGH);
+  delayMicroseconds(5);
+  bool released = digitalRead(PIN_I2C_SDA) == HIGH && digitalRead(PIN_I2C_SCL) == HIGH;
+  beginBus();
+  return released;
+}
+
+// Clear bus after a failed job and back off that job exponentially
+static void recoverBus(I2cTransaction &transaction) {
+  bool released = clearBus();
+  uint32_t backoff = I2C_BACKOFF_MAX;
+  if (transaction.failureStreak < 16) {
+    backoff = min(I2C_BACKOFF_MIN << transaction.failureStreak, I2C_BACKOFF_MAX);
+    transaction.failureStreak++;
+  }
+  transaction.retryTime = clockMillis() + backoff;
+  metricIncrement(Counter::I2C_RECOVERIES);
+  LOG_WARN("I2C Bus Recovered (Released: %lld, Backoff: %lld ms)\n", released ? 1 : 0, backoff);
+}
+
+// Run queued jobs in order
+static void busTask(void *arg) {
+  I2cTransaction *transaction = nullptr;
+  for (;;) {
+    if (xQueueReceive(jobQueue, &transaction, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    bool succeeded = false;
+    if (i2cAvailable(*transaction)) {
+      uint32_t startTime = micros();
+      succeeded = transaction->job(transaction->context);
+      metricObserve(Histogram::I2C_JOB_US, micros() - startTime);
+      if (succeeded) {
+        transaction->failureStreak = 0;
+      } else {
+        recoverBus(*transaction);
+      }
+    }
+    transaction->latency = micros() - transaction->queuedTime;
+    transaction->state.store(succeeded ? I2cState::DONE : I2cState::FAILED, std::memory_order_release);
+  }
+}
+
+// Start shared bus in fast mode and the I2C task
+bool setupI2c() {
+  Serial.print("Initializing I2C...");
+  beginBus();
+  jobQueue = xQueueCreate(I2C_QUEUE_SIZE, sizeof(I2cTransaction *));
+  // Above the loop task so a queued transfer starts as soon as it is submitted
+  if (jobQueue == nullptr || xTaskCreate(busTask, "i2c", I2C_TASK_STACK, nullptr, 2, nullptr) != pdPASS) {
+    Serial.print("Failed\n");
+    return false;
+  }
+  Serial.print("Done\n");
+  return true;
+}
+
+// Queue job on the I2C task without waiting
+bool i2cSubmit(I2cTransaction &transaction, I2cJob job, void *context) {
+  if (jobQueue == nullptr || transaction.state.load(std::memory_order_acquire) == I2cState::QUEUED) {
+    return false;
+  }
+  transaction.job = job;
+  transaction.context = context;
+  transaction.queuedTime = micros();
+  transaction.state.store(I2cState::QUEUED, std::memory_order_release);
+  I2cTransaction *pointer = &transaction;
+  if (xQueueSend(jobQueue, &pointer, 0) != pdTRUE) {
+    transaction.state.store(I2cState::IDLE);
+    return false;
+  }
+  return true;
+}
+
+// Check if a transaction is out of its backoff after it failed
+bool i2cAvailable(const I2cTransaction &transaction) {
+  return transaction.failureStreak == 0 || (int32_t)(clockMillis() - transaction.retryTime) >= 0;
+}
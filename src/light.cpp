@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "light.h"
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "states.h"
+#include "metrics.h"
+#include "log.h"
+
+// Rule settings (shared with web server task)
+static LightConfig config = {false, 60, 2000, 10, 1000, 10};
+static portMUX_TYPE configLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Sample accumulator for the current period (loop task)
+static uint32_t sampleSum = 0;
+static uint16_t sampleCount = 0;
+static unsigned long lastSampleTime = 0;
+
+// Smoothed level in kcps, Q4
+static bool seeded = false;
+static uint32_t filtered = 0;
+static std::atomic<uint32_t> level(0);
+
+// Rule state
+static std::atomic<bool> glare(false);
+static uint32_t conditionTime = 0;       // Seconds the pending transition condition has held
+static uint8_t restorePercent = 0xFF;   // Position before glare closed the blinds (0xFF = none)
+static uint8_t glarePercent = 0xFF;     // Where the glare move stopped (0xFF = still moving)
+
+// Feed ambient rate of a ToF sample (MCPS, 9.7 fixed point)
+void lightSample(uint16_t ambientRate) {
+  // kcps = MCPS * 1000 = rate * 1000 / 128
+  sampleSum += ((uint32_t)ambientRate * 1000) >> 7;
+  sampleCount++;
+  lastSampleTime = clockMillis();
+}
+
+// Step glare rule once per period
+static void evaluateRule(const LightConfig &rule, uint32_t current) {
+  uint32_t periodSeconds = LIGHT_PERIOD / 1000000;
+  bool active = glare.load();
+
+  // Count how long the condition for leaving the current state has held
+  bool condition = active ? current < rule.openLevel : current > rule.closeLevel;
+  uint32_t holdTime = (uint32_t)(active ? rule.openDelay : rule.closeDelay) * 60;
+  conditionTime = condition ? conditionTime + periodSeconds : 0;
+  if (!condition || conditionTime < holdTime) {
+    return;
+  }
+  conditionTime = 0;
+
+  uint8_t percent = getPositionPercent();
+  if (!active) {
+    // Only ever close further, remember where to return to
+    restorePercent = 0xFF;
+    if (percent > rule.percent) {
+      restorePercent = percent;
+      glarePercent = 0xFF;
+      triggerMoveTo(rule.percent);
+      metricIncrement(Counter::LIGHT_MOVES);
+    }
+    glare.store(true);
+    LOG_INFO("Glare Started: %lld kcps (Position: %lld)\n", current, percent);
+  } else {
+    // A manual move during glare wins over reopening
+    if (restorePercent != 0xFF && glarePercent != 0xFF &&
+        abs((int)percent - (int)glarePercent) <= LIGHT_OVERRIDE_TOLERANCE) {
+      triggerMoveTo(restorePercent);
+      metricIncrement(Counter::LIGHT_MOVES);
+    }
+    restorePercent = 0xFF;
+    glare.store(false);
+    LOG_INFO("Glare Ended: %lld kcps\n", current);
+  }
+}
+
+// Smooth light level and evaluate glare rule (low rate)
+void updateLight() {
+  // Hold level through short gaps (ToF suspended), forget it after a long one
+  if (sampleCount == 0) {
+    if (seeded && clockMillis() - lastSampleTime > LIGHT_STALE_TIME) {
+      seeded = false;
+      level.store(0);
+      conditionTime = 0;
+    }
+    return;
+  }
+  uint32_t mean = sampleSum / sampleCount;
+  sampleSum = 0;
+  sampleCount = 0;
+
+  // EMA in Q4, alpha = 1 / 2^LIGHT_FILTER_SHIFT (first period seeds it)
+  if (!seeded) {
+    filtered = mean << 4;
+    seeded = true;
+  } else {
+    int32_t error = (int32_t)(mean << 4) - (int32_t)filtered;
+    filtered = (uint32_t)((int32_t)filtered + (error >> LIGHT_FILTER_SHIFT));
+  }
+  uint32_t current = (filtered + 8) >> 4;
+
+  // Glare move stops within the motor tolerance of its target, take where it settled as untouched
+  if (restorePercent != 0xFF && glarePercent == 0xFF && getState() == SystemState::TOGGLE_IDLE) {
+    glarePercent = getPositionPercent();
+  }
+  level.store(current);
+  metricSet(Gauge::LIGHT_LEVEL, (int32_t)current);
+
+  portENTER_CRITICAL(&configLock);
+  LightConfig rule = config;
+  portEXIT_CRITICAL(&configLock);
+  if (!rule.enabled) {
+    // Disabling ends glare where the blinds are
+    conditionTime = 0;
+    restorePercent = 0xFF;
+    glare.store(false);
+    return;
+  }
+  evaluateRule(rule, current);
+}
+
+// Attach light routes to web server and load rule settings
+void setupLight(AsyncWebServer &server) {
+  loadLight(config);
+
+  // Rule settings and current level as JSON
+  server.on("/light", HTTP_GET, [](AsyncWebServerRequest *request) {
+    portENTER_CRITICAL(&configLock);
+    LightConfig rule = config;
+    portEXIT_CRITICAL(&configLock);
+
+    char json[192];
+    snprintf(json, sizeof(json),
+             "{\"enabled\":%u,\"percent\":%u,\"close\":%u,\"closeDelay\":%u,\"open\":%u,\"openDelay\":%u,"
+             "\"level\":%lu,\"glare\":%u}",
+             rule.enabled, rule.percent, rule.closeLevel, rule.closeDelay, rule.openLevel, rule.openDelay,
+             (unsigned long)level.load(), glare.load());
+    request->send(200, "application/json", json);
+  });
+
+  // Handle glare rule form submission
+  server.on("/setLight", HTTP_GET, [](AsyncWebServerRequest *request) {
+    portENTER_CRITICAL(&configLock);
+    LightConfig rule = config;
+    portEXIT_CRITICAL(&configLock);
+
+    rule.enabled = request->hasParam("enabled");
+    if (request->hasParam("percent")) {
+      rule.percent = constrain(request->getParam("percent")->value().toInt(), 0, 100);
+    }
+    if (request->hasParam("close")) {
+      rule.closeLevel = constrain(request->getParam("close")->value().toInt(), 1, UINT16_MAX);
+    }
+    if (request->hasParam("open")) {
+      rule.openLevel = constrain(request->getParam("open")->value().toInt(), 0, UINT16_MAX);
+    }
+    if (request->hasParam("closeDelay")) {
+      rule.closeDelay = constrain(request->getParam("closeDelay")->value().toInt(), 0, LIGHT_MAX_DELAY);
+    }
+    if (request->hasParam("openDelay")) {
+      rule.openDelay = constrain(request->getParam("openDelay")->value().toInt(), 0, LIGHT_MAX_DELAY);
+    }
+    // Levels must leave a gap or the rule would chatter
+    if (rule.openLevel >= rule.closeLevel) {
+      request->send(400, "text/plain", "Error 400: Open level must be below close level");
+      return;
+    }
+
+    if (saveLight(rule)) {
+      portENTER_CRITICAL(&configLock);
+      config = rule;
+      portEXIT_CRITICAL(&configLock);
+      LOG_INFO("Saved Light Rule: %lld (Close: %lld kcps, Open: %lld kcps)\n", rule.enabled, rule.closeLevel,
+               rule.openLevel);
+    } else {
+      LOG_ERROR("Failed to Save Light Rule\n");
+    }
+    request->redirect("/");
+  });
+}
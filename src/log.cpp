@@ -0,0 +1,157 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "log.h"
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "config.h"
+
+static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0, "LOG_BUFFER_SIZE must be a power of two");
+static constexpr uint32_t LOG_INDEX_MASK = LOG_BUFFER_SIZE - 1;
+
+// Log ring buffer entry
+struct LogEntry {
+  std::atomic<uint32_t> sequence;   // Entry index + 1 when complete, 0 while writing
+  uint32_t timestamp;               // Time of entry (ms)
+  const char *format;               // Format string (acts as message ID)
+  LogLevel level;                   // Severity level
+  int64_t args[4];                  // Raw arguments
+};
+
+// Plain copy of a completed entry
+struct LogRecord {
+  uint32_t timestamp;
+  const char *format;
+  LogLevel level;
+  int64_t args[4];
+};
+
+// Ring buffer overwritten oldest first when full
+static LogEntry logBuffer[LOG_BUFFER_SIZE];
+static std::atomic<uint32_t> writeIndex(0);
+static uint32_t drainIndex = 0;
+static uint32_t droppedEntries = 0;
+
+static const char levelChars[] = {'D', 'I', 'W', 'E'};
+
+// Forward declarations
+static void drainTask(void *param);
+
+// Initialize log buffer drain task
+void setupLog() {
+  xTaskCreate(drainTask, "log", LOG_TASK_STACK, nullptr, tskIDLE_PRIORITY, nullptr);
+}
+
+// Record log entry in constant time (safe from any task or ISR)
+void IRAM_ATTR logWrite(LogLevel level, const char *format, int64_t arg0, int64_t arg1, int64_t arg2,
+                        int64_t arg3) {
+  // Reserve slot, then publish with sequence number once written
+  uint32_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+  LogEntry &entry = logBuffer[index & LOG_INDEX_MASK];
+
+  entry.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  // The hardware timer is ISR safe, the clock interface may take a lock or read flash
+  entry.timestamp = (uint32_t)(esp_timer_get_time() / 1000);
+  entry.format = format;
+  entry.level = level;
+  entry.args[0] = arg0;
+  entry.args[1] = arg1;
+  entry.args[2] = arg2;
+  entry.args[3] = arg3;
+  entry.sequence.store(index + 1, std::memory_order_release);
+}
+
+// Copy entry at index if it is complete and not overwritten
+static bool readEntry(uint32_t index, LogRecord &record) {
+  const LogEntry &entry = logBuffer[index & LOG_INDEX_MASK];
+
+  if (entry.sequence.load(std::memory_order_acquire) != index + 1) {
+    return false;
+  }
+  record.timestamp = entry.timestamp;
+  record.format = entry.format;
+  record.level = entry.level;
+  record.args[0] = entry.args[0];
+  record.args[1] = entry.args[1];
+  record.args[2] = entry.args[2];
+  record.args[3] = entry.args[3];
+  // Discard if a writer reused the slot while copying
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return entry.sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+// Format record as a single text line
+static size_t formatRecord(const LogRecord &record, char *buf, size_t size) {
+  int len = snprintf(buf, size, "[%lu.%03lu] %c ", (unsigned long)(record.timestamp / 1000),
+                     (unsigned long)(record.timestamp % 1000), levelChars[(uint8_t)record.level & 3]);
+  if (len < 0 || (size_t)len >= size) {
+    return 0;
+  }
+  int msgLen = snprintf(buf + len, size - len, record.format, record.args[0], record.args[1], record.args[2],
+                        record.args[3]);
+  if (msgLen < 0) {
+    return len;
+  }
+  return min((size_t)(len + msgLen), size - 1);
+}
+
+// Format and drain log entries to serial at low priority
+static void drainTask(void *param) {
+  char line[LOG_LINE_LENGTH];
+  LogRecord record;
+
+  while (true) {
+    uint32_t head = writeIndex.load(std::memory_order_acquire);
+
+    // Skip entries overwritten before they were drained
+    if (head - drainIndex > LOG_BUFFER_SIZE) {
+      droppedEntries += head - drainIndex - LOG_BUFFER_SIZE;
+      drainIndex = head - LOG_BUFFER_SIZE;
+    }
+
+    if (drainIndex == head) {
+      vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+      continue;
+    }
+
+    if (readEntry(drainIndex, record)) {
+      formatRecord(record, line, sizeof(line));
+      Serial.print(line);
+      drainIndex++;
+    } else if (writeIndex.load(std::memory_order_acquire) - drainIndex > LOG_BUFFER_SIZE) {
+      // Overwritten while reading
+      continue;
+    } else {
+      // Writer still filling entry
+      vTaskDelay(1);
+    }
+
+    if (droppedEntries > 0) {
+      Serial.printf("[log] %lu entries dropped\n", (unsigned long)droppedEntries);
+      droppedEntries = 0;
+    }
+  }
+}
+
+// Send recent log entries as plain text
+void handleLogRequest(AsyncWebServerRequest *request) {
+  AsyncResponseStream *response = request->beginResponseStream("text/plain");
+  char line[LOG_LINE_LENGTH];
+  LogRecord record;
+
+  // Walk the buffer oldest to newest without consuming entries
+  uint32_t head = writeIndex.load(std::memory_order_acquire);
+  uint32_t index = (head > LOG_BUFFER_SIZE) ? head - LOG_BUFFER_SIZE : 0;
+  for (; index != head; ++index) {
+    if (readEntry(index, record) && formatRecord(record, line, sizeof(line)) > 0) {
+      response->print(line);
+    }
+  }
+  request->send(response);
+}
@@ -4,21 +4,62 @@
  */
 
 #include <Arduino.h>
+#include "config.h"
+#include "clock.h"
 #include "memory.h"
 #include "buttons.h"
 #include "motor.h"
+#include "i2c.h"
 #include "tof.h"
 #include "states.h"
 #include "schedule.h"
+#include "remote.h"
+#include "bridge.h"
+#include "group.h"
+#include "light.h"
+#include "ota.h"
+#include "tasks.h"
+#include "metrics.h"
+#include "log.h"
+
+static unsigned long lastControlTime = 0;
+
+// Motor control, arrival, and timeouts
+static void controlTask() {
+  unsigned long currentTime = clockMicros();
+
+  // Record control period
+  if (lastControlTime != 0) {
+    metricObserve(Histogram::LOOP_PERIOD_US, currentTime - lastControlTime);
+  }
+  lastControlTime = currentTime;
+
+  updateStateMachine();
+}
+
+// Clock upkeep and schedule events
+static void scheduleTask() {
+  // Periodically resync RTC
+  syncRTC();
+
+  // Fire due schedule events
+  checkSchedule();
+}
 
 void setup() {
+  // Time source must be chosen before any module reads it
+  if (CLOCK_VIRTUAL) {
+    startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, CLOCK_VIRTUAL_FAST);
+  }
+
   // Sold blue
   rgbLedWrite(RGB_BUILTIN, 0, 0, 255);
   Serial.begin(115200);
+  setupLog();
   Serial.print("\n--- Setup ---\n");
 
   // Initialize external components
-  if (!setupMemory() || !setupMotor() || !setupTof()) {
+  if (!setupMemory() || !setupMotor() || !setupI2c() || !setupTof()) {
     Serial.print("ERROR: Initialization Failed\n");
     while (true) {
       // Blink red on error
@@ -38,20 +79,24 @@ void setup() {
   setupButtons();
   setupStates();
 
+  // Register periodic tasks
+  setupTasks();
+  addTask("control", controlTask, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("group", updateGroup, GROUP_PERIOD, TaskPriority::CONTROL);
+  addTask("buttons", updateButtonInput, BUTTON_PERIOD, TaskPriority::SENSOR);
+  // Each ToF poll services one sensor, so every sensor is still visited once per period
+  addTask("tof", updateTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  addTask("led", updateStatusLed, LED_PERIOD, TaskPriority::DISPLAY);
+  addTask("remote", updateRemote, REMOTE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("bridge", updateBridge, BRIDGE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("ota", updateOta, OTA_PERIOD, TaskPriority::BACKGROUND);
+  addTask("schedule", scheduleTask, SCHEDULE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("light", updateLight, LIGHT_PERIOD, TaskPriority::BACKGROUND);
+
   Serial.printf("\n--- Loop ---\n");
 }
 
 void loop() {
-  unsigned long currentTime = millis();
-
-  // Continuously update system state machine
-  updateStateMachine();
-
-  // Periodically resync RTC
-  syncRTC();
-
-  // Periodically check schedule
-  checkSchedule();
-
-  delay(2);
+  // Run due tasks, sleeping until the next deadline
+  runTasks();
 }
@@ -6,10 +6,24 @@
 #include "memory.h"
 #include <Arduino.h>
 #include <Preferences.h>
+#include "config.h"
 #include "schedule.h"
+#include "bridge.h"
+#include "light.h"
+#include "metrics.h"
 
 static Preferences memory;
 
+// Record write count and latency, passing through result
+static bool recordWrite(unsigned long startTime, bool success) {
+  metricObserve(Histogram::NVS_WRITE_US, micros() - startTime);
+  metricIncrement(Counter::NVS_WRITES);
+  if (!success) {
+    metricIncrement(Counter::NVS_WRITE_ERRORS);
+  }
+  return success;
+}
+
 // Initialize nonvolatile flash memory
 bool setupMemory() {
   Serial.print("Initializing Memory...");
@@ -32,10 +46,11 @@ void loadPositions(int64_t &openPos, int64_t &closePos) {
 
 // Save open and close positions to flash memory
 bool savePositions(int64_t openPos, int64_t closePos) {
+  unsigned long startTime = micros();
   if (memory.putLong64("openPos", openPos) == 0 || memory.putLong64("closePos", closePos) == 0) {
-    return false;
+    return recordWrite(startTime, false);
   }
-  return true;
+  return recordWrite(startTime, true);
 }
 
 // Load last encoder position from flash memory
@@ -46,28 +61,216 @@ int64_t loadLastPosition() {
 
 // Save last encoder position to flash memory
 bool saveLastPosition(int64_t lastPos) {
+  unsigned long startTime = micros();
   if (memory.putLong64("lastPos", lastPos) == 0) {
-    return false;
+    return recordWrite(startTime, false);
   }
-  return true;
+  return recordWrite(startTime, true);
 }
 
-// Load open and close schedule times from flash memory
-void loadSchedule(ScheduleTime &openSched, ScheduleTime &closeSched) {
-  // Defaults to 99 if not present
-  openSched.hour = memory.getUChar("openSchedH", 99);
-  openSched.minute = memory.getUChar("openSchedM", 99);
-  closeSched.hour = memory.getUChar("closeSchedH", 99);
-  closeSched.minute = memory.getUChar("closeSchedM", 99);
+// Load schedule entries from flash memory
+uint8_t loadSchedule(ScheduleEntry *entries, uint8_t maxEntries) {
+  uint32_t packed[SCHEDULE_MAX_ENTRIES];
+  size_t length = memory.getBytesLength("sched");
+
+  // Migrate single open/close times from older firmware
+  if (length == 0) {
+    uint8_t count = 0;
+    uint8_t openH = memory.getUChar("openSchedH", 99);
+    uint8_t openM = memory.getUChar("openSchedM", 99);
+    uint8_t closeH = memory.getUChar("closeSchedH", 99);
+    uint8_t closeM = memory.getUChar("closeSchedM", 99);
+    if (openH < 24 && count < maxEntries) {
+      entries[count++] = {0x7F, (int16_t)(openH * 60 + openM), ScheduleAction::OPEN, 0, ScheduleBase::TIME};
+    }
+    if (closeH < 24 && count < maxEntries) {
+      entries[count++] = {0x7F, (int16_t)(closeH * 60 + closeM), ScheduleAction::CLOSE, 0, ScheduleBase::TIME};
+    }
+    return count;
+  }
+
+  uint8_t count = min(length / sizeof(uint32_t), (size_t)min(maxEntries, SCHEDULE_MAX_ENTRIES));
+  memory.getBytes("sched", packed, count * sizeof(uint32_t));
+  for (uint8_t i = 0; i < count; ++i) {
+    entries[i] = unpackScheduleEntry(packed[i]);
+  }
+  return count;
 }
 
-// Save open and close schedule times to flash memory
-bool saveSchedule(ScheduleTime openSched, ScheduleTime closeSched) {
-  if (memory.putUChar("openSchedH", openSched.hour) == 0 ||
-      memory.putUChar("openSchedM", openSched.minute) == 0 ||
-      memory.putUChar("closeSchedH", closeSched.hour) == 0 ||
-      memory.putUChar("closeSchedM", closeSched.minute) == 0) {
-    return false;
+// Save schedule entries to flash memory
+bool saveSchedule(const ScheduleEntry *entries, uint8_t count) {
+  uint32_t packed[SCHEDULE_MAX_ENTRIES];
+  unsigned long startTime = micros();
+
+  count = min(count, SCHEDULE_MAX_ENTRIES);
+  for (uint8_t i = 0; i < count; ++i) {
+    packed[i] = packScheduleEntry(entries[i]);
   }
-  return true;
+  // Store an unused entry rather than a zero length blob
+  if (count == 0) {
+    packed[count++] = 0;
+  }
+  if (memory.putBytes("sched", packed, count * sizeof(uint32_t)) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load preset positions from flash memory
+void loadPresets(uint8_t *presets, uint8_t count) {
+  // Defaults to evenly spaced positions if not present
+  for (uint8_t i = 0; i < count; ++i) {
+    presets[i] = (uint8_t)((i + 1) * 100 / (count + 1));
+  }
+  if (memory.getBytesLength("presets") == count) {
+    memory.getBytes("presets", presets, count);
+  }
+}
+
+// Save preset positions to flash memory
+bool savePresets(const uint8_t *presets, uint8_t count) {
+  unsigned long startTime = micros();
+  if (memory.putBytes("presets", presets, count) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load vacation settings from flash memory
+void loadVacation(VacationConfig &config) {
+  // Defaults to disabled if not present
+  uint32_t packed = memory.getUInt("vacCfg", 0);
+  config.enabled = packed & 0x01;
+  config.partialMoves = packed & 0x02;
+  config.maxOffset = min((uint8_t)(packed >> 8), VACATION_MAX_OFFSET);
+  config.seed = memory.getUInt("vacSeed", 1);
+}
+
+// Save vacation settings to flash memory
+bool saveVacation(const VacationConfig &config) {
+  unsigned long startTime = micros();
+  uint32_t packed = (config.enabled ? 0x01 : 0) | (config.partialMoves ? 0x02 : 0) | ((uint32_t)config.maxOffset << 8);
+  if (memory.putUInt("vacCfg", packed) == 0 || memory.putUInt("vacSeed", config.seed) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load MQTT settings from flash memory
+void loadBridgeConfig(BridgeConfig &config) {
+  // Defaults to empty (disabled) if not present
+  memset(&config, 0, sizeof(config));
+  if (memory.getBytesLength("mqtt") == sizeof(config)) {
+    memory.getBytes("mqtt", &config, sizeof(config));
+  }
+  // Guarantee termination of stored strings
+  config.uri[sizeof(config.uri) - 1] = '\0';
+  config.user[sizeof(config.user) - 1] = '\0';
+  config.password[sizeof(config.password) - 1] = '\0';
+}
+
+// Save MQTT settings to flash memory
+bool saveBridgeConfig(const BridgeConfig &config) {
+  unsigned long startTime = micros();
+  if (memory.putBytes("mqtt", &config, sizeof(config)) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load group ID from flash memory
+uint8_t loadGroup() {
+  // Defaults to 0 (no group) if not present
+  return memory.getUChar("group", 0);
+}
+
+// Save group ID to flash memory
+bool saveGroup(uint8_t group) {
+  unsigned long startTime = micros();
+  if (memory.putUChar("group", group) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load glare rule settings from flash memory
+void loadLight(LightConfig &config) {
+  // Keeps defaults (disabled) if not present or inconsistent
+  LightConfig stored;
+  if (memory.getBytesLength("light") == sizeof(stored)) {
+    memory.getBytes("light", &stored, sizeof(stored));
+    if (stored.openLevel < stored.closeLevel) {
+      config = stored;
+    }
+  }
+}
+
+// Save glare rule settings to flash memory
+bool saveLight(const LightConfig &config) {
+  unsigned long startTime = micros();
+  if (memory.putBytes("light", &config, sizeof(config)) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load last applied event time from flash memory
+uint32_t loadLastEvent() {
+  // Defaults to 0 (nothing applied) if not present
+  return memory.getUInt("lastEvt", 0);
+}
+
+// Save last applied event time to flash memory
+bool saveLastEvent(uint32_t eventTime) {
+  unsigned long startTime = micros();
+  if (memory.putUInt("lastEvt", eventTime) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load clock drift from flash memory
+int32_t loadClockDrift() {
+  // Defaults to 0 (uncorrected) if not present
+  return memory.getInt("drift", 0);
+}
+
+// Save clock drift to flash memory
+bool saveClockDrift(int32_t drift) {
+  unsigned long startTime = micros();
+  if (memory.putInt("drift", drift) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load location from flash memory
+void loadLocation(int32_t &latitude, int32_t &longitude) {
+  // Defaults to configured location if not present
+  latitude = memory.getInt("lat", DEFAULT_LATITUDE);
+  longitude = memory.getInt("lon", DEFAULT_LONGITUDE);
+}
+
+// Save location to flash memory
+bool saveLocation(int32_t latitude, int32_t longitude) {
+  unsigned long startTime = micros();
+  if (memory.putInt("lat", latitude) == 0 || memory.putInt("lon", longitude) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
+}
+
+// Load provisioning request from flash memory
+bool loadProvisionRequest() {
+  // Defaults to none if not present
+  return memory.getBool("provision", false);
+}
+
+// Save provisioning request to flash memory
+bool saveProvisionRequest(bool requested) {
+  unsigned long startTime = micros();
+  if (memory.putBool("provision", requested) == 0) {
+    return recordWrite(startTime, false);
+  }
+  return recordWrite(startTime, true);
 }
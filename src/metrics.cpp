@@ -0,0 +1,227 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "metrics.h"
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <memory>
+#include <stdarg.h>
+
+static constexpr uint8_t HISTOGRAM_BUCKETS = 8;
+static constexpr size_t NUM_COUNTERS = (size_t)Counter::COUNT;
+static constexpr size_t NUM_GAUGES = (size_t)Gauge::COUNT;
+static constexpr size_t NUM_HISTOGRAMS = (size_t)Histogram::COUNT;
+
+// Metric export descriptions
+struct MetricInfo {
+  const char *name;     // Prometheus metric family name
+  const char *help;     // Description line
+  const char *labels;   // Label set without braces (may be empty)
+};
+
+struct HistogramInfo {
+  const char *name;
+  const char *help;
+  uint32_t bounds[HISTOGRAM_BUCKETS];   // Inclusive upper bounds (+Inf implied)
+};
+
+// Counter descriptions (same order as Counter enum, families kept adjacent)
+static constexpr MetricInfo counterInfo[] = {
+  {"autoblinds_state_transitions_total", "State machine transitions", ""},
+  {"autoblinds_moves_total", "Toggle moves by outcome", "outcome=\"completed\""},
+  {"autoblinds_moves_total", "Toggle moves by outcome", "outcome=\"interrupted\""},
+  {"autoblinds_move_overshoots_total", "Moves that settled past target beyond tolerance", ""},
+  {"autoblinds_tof_reads_total", "ToF range reads", ""},
+  {"autoblinds_tof_timeouts_total", "ToF range read timeouts and bus errors", ""},
+  {"autoblinds_tof_rejected_total", "ToF samples rejected for range status or low signal", ""},
+  {"autoblinds_tof_gestures_total", "ToF gestures recognized by type", "type=\"tap\""},
+  {"autoblinds_tof_gestures_total", "ToF gestures recognized by type", "type=\"approach\""},
+  {"autoblinds_tof_gestures_total", "ToF gestures recognized by type", "type=\"retreat\""},
+  {"autoblinds_tof_gestures_total", "ToF gestures recognized by type", "type=\"hold\""},
+  {"autoblinds_tof_i2c_transactions_total", "ToF I2C transactions for status checks and reads", ""},
+  {"autoblinds_i2c_recoveries_total", "I2C bus clears after failed transactions", ""},
+  {"autoblinds_light_moves_total", "Moves started by the glare rule", ""},
+  {"autoblinds_nvs_writes_total", "Nonvolatile memory writes", ""},
+  {"autoblinds_nvs_write_errors_total", "Failed nonvolatile memory writes", ""},
+  {"autoblinds_wifi_disconnects_total", "Wi-Fi disconnects detected", ""},
+  {"autoblinds_wifi_reconnects_total", "Wi-Fi reconnects", ""},
+  {"autoblinds_ntp_syncs_total", "NTP time syncs", ""},
+  {"autoblinds_mqtt_publishes_total", "MQTT messages queued for publish", ""},
+  {"autoblinds_mqtt_drops_total", "MQTT updates deferred by a full outbox", ""},
+  {"autoblinds_mqtt_commands_total", "MQTT commands received", ""},
+  {"autoblinds_task_overruns_total", "Task periods skipped because a run started late", ""},
+  {"autoblinds_ota_updates_total", "Firmware updates written and verified", ""},
+  {"autoblinds_ota_failures_total", "Firmware updates rejected or interrupted", ""},
+  {"autoblinds_http_requests_total", "HTTP requests by route", "route=\"/\""},
+  {"autoblinds_http_requests_total", "HTTP requests by route", "route=\"/open\""},
+  {"autoblinds_http_requests_total", "HTTP requests by route", "route=\"/close\""},
+  {"autoblinds_http_requests_total", "HTTP requests by route", "route=\"/setSchedule\""},
+  {"autoblinds_http_requests_total", "HTTP requests by route", "route=\"/metrics\""},
+  {"autoblinds_http_requests_total", "HTTP requests by route", "route=\"not_found\""},
+};
+static_assert(sizeof(counterInfo) / sizeof(counterInfo[0]) == NUM_COUNTERS, "Counter descriptions out of sync");
+
+// Gauge descriptions (same order as Gauge enum)
+static constexpr MetricInfo gaugeInfo[] = {
+  {"autoblinds_state", "Current system state", ""},
+  {"autoblinds_position", "Current encoder position", ""},
+  {"autoblinds_clock_drift_ppb", "Learned clock drift in parts per billion", ""},
+  {"autoblinds_clock_degraded", "Clock running without recent NTP sync", ""},
+  {"autoblinds_task_load_permille", "Loop task CPU load over the last second in permille", ""},
+  {"autoblinds_tof_duty_permille", "Share of time each ToF sensor spends ranging in permille", ""},
+  {"autoblinds_tof_sensors", "ToF sensors brought up and ranging", ""},
+  {"autoblinds_light_level_kcps", "Smoothed ambient light rate from the ToF sensors in kcps", ""},
+};
+static_assert(sizeof(gaugeInfo) / sizeof(gaugeInfo[0]) == NUM_GAUGES, "Gauge descriptions out of sync");
+
+// Histogram descriptions (same order as Histogram enum)
+static constexpr HistogramInfo histogramInfo[] = {
+  {"autoblinds_loop_period_us", "Control task period in microseconds",
+   {1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000}},
+  {"autoblinds_move_duration_ms", "Completed toggle move duration in milliseconds",
+   {1000, 2000, 5000, 10000, 20000, 30000, 60000, 120000}},
+  {"autoblinds_move_error", "Settled position error in encoder counts",
+   {5, 10, 21, 42, 84, 168, 336, 672}},
+  {"autoblinds_tof_read_us", "ToF sample latency from queueing the read to its result in microseconds",
+   {100, 250, 500, 1000, 5000, 20000, 50000, 100000}},
+  {"autoblinds_i2c_job_us", "I2C task bus time per job in microseconds",
+   {100, 250, 500, 1000, 2500, 10000, 50000, 250000}},
+  {"autoblinds_nvs_write_us", "Nonvolatile memory write latency in microseconds",
+   {500, 1000, 2500, 5000, 10000, 25000, 50000, 100000}},
+};
+static_assert(sizeof(histogramInfo) / sizeof(histogramInfo[0]) == NUM_HISTOGRAMS, "Histogram descriptions out of sync");
+
+// Histogram storage (buckets are not cumulative, sum wraps at 32 bits)
+struct HistogramData {
+  std::atomic<uint32_t> buckets[HISTOGRAM_BUCKETS + 1];
+  std::atomic<uint32_t> sum;
+};
+
+// Metric storage (statically allocated, updated with relaxed atomics)
+static std::atomic<uint32_t> counters[NUM_COUNTERS];
+static std::atomic<int32_t> gauges[NUM_GAUGES];
+static HistogramData histograms[NUM_HISTOGRAMS];
+
+// Export cursor kept across chunks of a single response
+struct MetricsCursor {
+  size_t record = 0;      // Next record to format
+  size_t length = 0;      // Formatted length of current record
+  size_t offset = 0;      // Bytes of current record already sent
+  char text[768];         // Current record text
+};
+
+// Increment counter (safe from any task)
+void metricIncrement(Counter counter, uint32_t amount) {
+  counters[(size_t)counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+// Set gauge value (safe from any task)
+void metricSet(Gauge gauge, int32_t value) {
+  gauges[(size_t)gauge].store(value, std::memory_order_relaxed);
+}
+
+// Record histogram observation (safe from any task)
+void metricObserve(Histogram histogram, uint32_t value) {
+  const uint32_t *bounds = histogramInfo[(size_t)histogram].bounds;
+  HistogramData &data = histograms[(size_t)histogram];
+
+  // Find first bucket containing value (last bucket is +Inf)
+  uint8_t bucket = 0;
+  while (bucket < HISTOGRAM_BUCKETS && value > bounds[bucket]) {
+    bucket++;
+  }
+  data.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  data.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Append formatted text, clamping at buffer end
+static size_t appendf(char *buf, size_t size, size_t pos, const char *format, ...) {
+  if (pos >= size) {
+    return pos;
+  }
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf + pos, size - pos, format, args);
+  va_end(args);
+  return (len < 0) ? pos : min(pos + (size_t)len, size - 1);
+}
+
+// Append HELP/TYPE header if metric family changed
+static size_t appendHeader(char *buf, size_t size, size_t pos, const MetricInfo *info, const MetricInfo *prev,
+                           const char *type) {
+  if (prev == nullptr || strcmp(prev->name, info->name) != 0) {
+    pos = appendf(buf, size, pos, "# HELP %s %s\n# TYPE %s %s\n", info->name, info->help, info->name, type);
+  }
+  return pos;
+}
+
+// Format a single export record (counter, gauge, or whole histogram)
+static size_t formatRecord(size_t record, char *buf, size_t size) {
+  size_t pos = 0;
+
+  // Counters
+  if (record < NUM_COUNTERS) {
+    const MetricInfo *info = &counterInfo[record];
+    pos = appendHeader(buf, size, pos, info, (record > 0) ? info - 1 : nullptr, "counter");
+    uint32_t value = counters[record].load(std::memory_order_relaxed);
+    if (info->labels[0] != '\0') {
+      return appendf(buf, size, pos, "%s{%s} %lu\n", info->name, info->labels, (unsigned long)value);
+    }
+    return appendf(buf, size, pos, "%s %lu\n", info->name, (unsigned long)value);
+  }
+  record -= NUM_COUNTERS;
+
+  // Gauges
+  if (record < NUM_GAUGES) {
+    const MetricInfo *info = &gaugeInfo[record];
+    pos = appendHeader(buf, size, pos, info, (record > 0) ? info - 1 : nullptr, "gauge");
+    return appendf(buf, size, pos, "%s %ld\n", info->name, (long)gauges[record].load(std::memory_order_relaxed));
+  }
+  record -= NUM_GAUGES;
+
+  // Histograms
+  const HistogramInfo &info = histogramInfo[record];
+  HistogramData &data = histograms[record];
+  pos = appendf(buf, size, pos, "# HELP %s %s\n# TYPE %s histogram\n", info.name, info.help, info.name);
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    cumulative += data.buckets[i].load(std::memory_order_relaxed);
+    pos = appendf(buf, size, pos, "%s_bucket{le=\"%lu\"} %lu\n", info.name, (unsigned long)info.bounds[i],
+                  (unsigned long)cumulative);
+  }
+  cumulative += data.buckets[HISTOGRAM_BUCKETS].load(std::memory_order_relaxed);
+  pos = appendf(buf, size, pos, "%s_bucket{le=\"+Inf\"} %lu\n", info.name, (unsigned long)cumulative);
+  pos = appendf(buf, size, pos, "%s_sum %lu\n", info.name, (unsigned long)data.sum.load(std::memory_order_relaxed));
+  return appendf(buf, size, pos, "%s_count %lu\n", info.name, (unsigned long)cumulative);
+}
+
+// Stream all metrics in Prometheus text format
+void handleMetricsRequest(AsyncWebServerRequest *request) {
+  metricIncrement(Counter::HTTP_METRICS);
+  std::shared_ptr<MetricsCursor> cursor = std::make_shared<MetricsCursor>();
+
+  // Fill each chunk with as many records as fit, resuming partial records
+  request->sendChunked("text/plain; version=0.0.4", [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    constexpr size_t numRecords = NUM_COUNTERS + NUM_GAUGES + NUM_HISTOGRAMS;
+    size_t written = 0;
+
+    while (written < maxLen) {
+      if (cursor->offset == cursor->length) {
+        if (cursor->record >= numRecords) {
+          break;
+        }
+        cursor->length = formatRecord(cursor->record++, cursor->text, sizeof(cursor->text));
+        cursor->offset = 0;
+      }
+      size_t len = min(maxLen - written, cursor->length - cursor->offset);
+      memcpy(buffer + written, cursor->text + cursor->offset, len);
+      cursor->offset += len;
+      written += len;
+    }
+    return written;
+  });
+}
@@ -0,0 +1,139 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "network.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiManager.h>
+#include <atomic>
+#include "config.h"
+#include "memory.h"
+#include "metrics.h"
+#include "log.h"
+
+// Network variables
+static WiFiManager wm;
+static TaskHandle_t networkTaskHandle = nullptr;
+static std::atomic<bool> connected(false);
+static std::atomic<bool> changed(false);
+static bool everConnected = false;
+static bool provisionRequested = false;
+
+// Wi-Fi event callback (runs in event task, only records state and wakes network task)
+static void onWiFiEvent(arduino_event_t *event) {
+  switch (event->event_id) {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP: {
+      IPAddress ip = WiFi.localIP();
+      LOG_INFO("Wi-Fi Connected (IP: %lld.%lld.%lld.%lld)\n", ip[0], ip[1], ip[2], ip[3]);
+      if (everConnected) {
+        metricIncrement(Counter::WIFI_RECONNECTS);
+      }
+      everConnected = true;
+      connected.store(true);
+      changed.store(true);
+      break;
+    }
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+      // Failed reconnect attempts also land here, only count the first loss
+      if (connected.exchange(false)) {
+        LOG_WARN("Wi-Fi Disconnected\n");
+        metricIncrement(Counter::WIFI_DISCONNECTS);
+        changed.store(true);
+      }
+      break;
+    default:
+      return;
+  }
+  if (networkTaskHandle != nullptr) {
+    xTaskNotifyGive(networkTaskHandle);
+  }
+}
+
+// Provision credentials, then reconnect with backoff whenever the link drops
+static void networkTask(void *arg) {
+  // Open the captive portal on request, otherwise try saved credentials and fall back to it
+  if (provisionRequested) {
+    wm.startConfigPortal(WIFI_AP_NAME, NULL);
+  }
+  if (provisionRequested || !wm.autoConnect(WIFI_AP_NAME, NULL)) {
+    LOG_INFO("Wi-Fi Provisioning Portal Started\n");
+    while (wm.getConfigPortalActive()) {
+      wm.process();
+      vTaskDelay(pdMS_TO_TICKS(NETWORK_PROCESS_INTERVAL));
+    }
+  }
+
+  uint32_t backoff = NETWORK_BACKOFF_MIN;
+  while (true) {
+    if (connected.load()) {
+      // Sleep until the next event
+      backoff = NETWORK_BACKOFF_MIN;
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+    // Retry saved credentials when nothing happens within the backoff
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(backoff)) == 0 && !connected.load()) {
+      LOG_DEBUG("Wi-Fi Reconnect Attempt (Backoff: %lld ms)\n", backoff);
+      WiFi.begin();
+      backoff = min(backoff * 2, NETWORK_BACKOFF_MAX);
+    }
+  }
+}
+
+// Start Wi-Fi provisioning and reconnection task
+bool setupNetwork() {
+  Serial.printf("Initializing Wi-Fi (SSID: %s)...", WIFI_AP_NAME);
+
+  WiFi.mode(WIFI_STA);
+  // Reconnects are handled by the network task
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent(onWiFiEvent);
+
+  // Set autoconnect timeout (s)
+  wm.setConnectTimeout(30);
+  // Set captive portal timeout (s)
+  wm.setConfigPortalTimeout(120);
+  wm.setConfigPortalBlocking(false);
+  // Configure menu items
+  std::vector<const char *> wm_menu  = {"wifi", "exit"};
+  wm.setShowInfoUpdate(false);
+  wm.setShowInfoErase(false);
+  wm.setMenu(wm_menu);
+
+  // A provisioning request only applies to the next boot
+  provisionRequested = loadProvisionRequest();
+  if (provisionRequested) {
+    saveProvisionRequest(false);
+  }
+
+  if (xTaskCreate(networkTask, "network", NETWORK_TASK_STACK, nullptr, 1, &networkTaskHandle) != pdPASS) {
+    Serial.print("Failed\n");
+    return false;
+  }
+  Serial.print("Done\n");
+  return true;
+}
+
+// Check if station is connected with an IP address
+bool isNetworkConnected() {
+  return connected.load();
+}
+
+// Check and clear connection change flag
+bool networkChanged() {
+  return changed.exchange(false);
+}
+
+// Restart into the captive portal to provision new credentials
+void restartIntoProvisioning() {
+  if (!saveProvisionRequest(true)) {
+    LOG_ERROR("Failed to Save Provisioning Request\n");
+    return;
+  }
+  LOG_INFO("Restarting into Provisioning Portal\n");
+  delay(100);
+  ESP.restart();
+}
@@ -0,0 +1,250 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "ota.h"
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+#include <atomic>
+#include "config.h"
+#include "clock.h"
+#include "states.h"
+#include "metrics.h"
+#include "log.h"
+
+constexpr size_t SHA256_SIZE = 32;
+
+// Upload session (only touched from web server task)
+struct UploadSession {
+  AsyncWebServerRequest *owner;    // Request writing the image (null = idle)
+  esp_ota_handle_t handle;
+  const esp_partition_t *partition;
+  mbedtls_sha256_context sha;
+  uint8_t expected[SHA256_SIZE];
+  size_t written;
+  bool writing;                    // OTA handle open
+  bool succeeded;
+  const char *error;               // Set on failure
+};
+
+static UploadSession session = {};
+
+// Loop handoff variables
+static std::atomic<bool> updateActive(false);
+static std::atomic<bool> restartPending(false);
+static bool motionHeld = false;
+static unsigned long restartTime = 0;
+static bool verifyPending = false;
+
+// Keep new images pending in the core until the main loop confirms them
+extern "C" bool verifyRollbackLater() {
+  return true;
+}
+
+// Parse 64 hex characters into a hash
+static bool parseHash(const String &text, uint8_t *hash) {
+  if (text.length() != SHA256_SIZE * 2) {
+    return false;
+  }
+  for (size_t i = 0; i < SHA256_SIZE * 2; i++) {
+    char c = text[i];
+    uint8_t nibble;
+    if (c >= '0' && c <= '9') {
+      nibble = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      nibble = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      nibble = c - 'A' + 10;
+    } else {
+      return false;
+    }
+    hash[i / 2] = (i % 2 == 0) ? (nibble << 4) : (hash[i / 2] | nibble);
+  }
+  return true;
+}
+
+// Abort open write and record failure
+static void failSession(const char *error) {
+  if (session.writing) {
+    esp_ota_abort(session.handle);
+    mbedtls_sha256_free(&session.sha);
+    session.writing = false;
+  }
+  if (session.error == nullptr) {
+    session.error = error;
+    metricIncrement(Counter::OTA_FAILURES);
+    LOG_WARN("Update Failed after %lld bytes\n", (int64_t)session.written);
+  }
+  updateActive.store(false);
+}
+
+// Open inactive partition and start hashing
+static bool beginSession(AsyncWebServerRequest *request) {
+  session = {};
+  session.owner = request;
+  // Connection lost before the final chunk leaves the running image in place, and releases the session even when
+  // it failed before writing
+  request->onDisconnect([request]() {
+    if (session.owner == request) {
+      failSession("Upload interrupted");
+      session.owner = nullptr;
+    }
+  });
+
+  if (!request->hasParam("sha256") || !parseHash(request->getParam("sha256")->value(), session.expected)) {
+    failSession("Missing or invalid sha256");
+    return false;
+  }
+  session.partition = esp_ota_get_next_update_partition(nullptr);
+  if (session.partition == nullptr) {
+    failSession("No update partition");
+    return false;
+  }
+  // Sequential writes erase sectors as they are reached instead of the whole partition up front
+  if (esp_ota_begin(session.partition, OTA_WITH_SEQUENTIAL_WRITES, &session.handle) != ESP_OK) {
+    failSession("Could not begin update");
+    return false;
+  }
+  mbedtls_sha256_init(&session.sha);
+  mbedtls_sha256_starts(&session.sha, 0);
+  session.writing = true;
+
+  // Loop stops the motor before the next chunk arrives
+  updateActive.store(true);
+  LOG_INFO("Update Started\n");
+  return true;
+}
+
+// Check hash, validate image, and switch boot partition
+static void finishSession() {
+  uint8_t actual[SHA256_SIZE];
+  mbedtls_sha256_finish(&session.sha, actual);
+  mbedtls_sha256_free(&session.sha);
+
+  if (memcmp(actual, session.expected, SHA256_SIZE) != 0) {
+    esp_ota_abort(session.handle);
+    session.writing = false;
+    failSession("SHA-256 mismatch");
+    return;
+  }
+  session.writing = false;
+  // Ending checks the image header and its own checksum
+  if (esp_ota_end(session.handle) != ESP_OK) {
+    failSession("Invalid firmware image");
+    return;
+  }
+  if (esp_ota_set_boot_partition(session.partition) != ESP_OK) {
+    failSession("Could not set boot partition");
+    return;
+  }
+  session.succeeded = true;
+  metricIncrement(Counter::OTA_UPDATES);
+  LOG_INFO("Update Written: %lld bytes\n", (int64_t)session.written);
+  restartPending.store(true);
+}
+
+// Handle each uploaded chunk
+static void handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data,
+                         size_t len, bool final) {
+  if (index == 0) {
+    // Reject without claiming the session if unauthorized or another update is running
+    if (OTA_PASSWORD[0] == '\0' || !request->authenticate(OTA_USERNAME, OTA_PASSWORD) ||
+        session.owner != nullptr || restartPending.load()) {
+      return;
+    }
+    if (!beginSession(request)) {
+      return;
+    }
+  }
+  if (session.owner != request || !session.writing) {
+    return;
+  }
+
+  mbedtls_sha256_update(&session.sha, data, len);
+  if (esp_ota_write(session.handle, data, len) != ESP_OK) {
+    failSession("Flash write failed");
+    return;
+  }
+  session.written += len;
+
+  if (final) {
+    finishSession();
+  }
+}
+
+// Respond once the request body has been received
+static void handleUpdateRequest(AsyncWebServerRequest *request) {
+  if (OTA_PASSWORD[0] == '\0') {
+    request->send(403, "text/plain", "Error 403: Updates disabled");
+    return;
+  }
+  if (!request->authenticate(OTA_USERNAME, OTA_PASSWORD)) {
+    request->requestAuthentication();
+    return;
+  }
+  if (session.owner == nullptr) {
+    request->send(400, "text/plain", "Error 400: No firmware");
+    return;
+  }
+  if (session.owner != request) {
+    request->send(409, "text/plain", "Error 409: Update already running");
+    return;
+  }
+
+  // Release session for the next upload
+  session.owner = nullptr;
+  if (session.writing) {
+    // Body ended without a final chunk
+    failSession("Upload incomplete");
+  }
+  if (!session.succeeded) {
+    request->send(400, "text/plain", String("Error 400: ") + (session.error ? session.error : "No firmware"));
+    return;
+  }
+  request->send(200, "text/plain", "Update OK, restarting");
+}
+
+// Attach update endpoint to web server
+void setupOta(AsyncWebServer &server) {
+  // Image booted from a fresh update is confirmed by the main loop
+  esp_ota_img_states_t state;
+  if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+      state == ESP_OTA_IMG_PENDING_VERIFY) {
+    verifyPending = true;
+    LOG_INFO("Running Updated Image (Pending Verify)\n");
+  }
+
+  server.on("/update", HTTP_POST, handleUpdateRequest, handleUpload);
+}
+
+// Hold motor during updates, confirm a new image, and restart after success
+void updateOta() {
+  // Reaching the loop marks the running image good and cancels rollback
+  if (verifyPending) {
+    verifyPending = false;
+    if (esp_ota_mark_app_valid_cancel_rollback() == ESP_OK) {
+      LOG_INFO("Updated Image Confirmed\n");
+    }
+  }
+
+  bool active = updateActive.load() || restartPending.load();
+  if (active != motionHeld) {
+    motionHeld = active;
+    setMotionLock(active);
+  }
+
+  // Give the response time to reach the client before restarting
+  if (restartPending.load()) {
+    if (restartTime == 0) {
+      restartTime = max(clockMillis(), (uint32_t)1);
+    } else if ((clockMillis() - restartTime) >= OTA_RESTART_DELAY) {
+      LOG_INFO("Restarting into Updated Image\n");
+      delay(100);
+      ESP.restart();
+    }
+  }
+}
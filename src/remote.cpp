@@ -0,0 +1,143 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "remote.h"
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include "config.h"
+#include "clock.h"
+#include "states.h"
+
+static AsyncWebSocket ws("/ws");
+
+// Pending command slot written by the network task and consumed by the loop
+// Packed as (opcode << 8 | argument), 0 when empty (newest command wins)
+static std::atomic<uint16_t> pendingCommand(0);
+static std::atomic<bool> forceBroadcast(false);
+
+// Broadcast variables
+static SystemState lastSentState = SystemState::ERROR;
+static uint8_t lastSentPercent = 0xFF;
+static unsigned long lastBroadcastTime = 0;
+static unsigned long lastCleanupTime = 0;
+
+// Store command in pending slot, replacing any older command
+void postRemoteCommand(uint8_t opcode, uint8_t arg) {
+  uint16_t newCommand = (opcode << 8) | arg;
+  uint16_t oldCommand = pendingCommand.load();
+
+  // Accumulate consecutive nudges so no step is lost
+  while (opcode == REMOTE_NUDGE && (oldCommand >> 8) == REMOTE_NUDGE) {
+    int sum = constrain((int8_t)(oldCommand & 0xFF) + (int8_t)arg, -100, 100);
+    newCommand = (REMOTE_NUDGE << 8) | (uint8_t)(int8_t)sum;
+    if (pendingCommand.compare_exchange_weak(oldCommand, newCommand)) {
+      return;
+    }
+  }
+  pendingCommand.store(newCommand);
+}
+
+// Handle WebSocket events from the network task
+static void onRemoteEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg,
+                          uint8_t *data, size_t len) {
+  switch (type) {
+    case WS_EVT_CONNECT:
+      // Drop state frames instead of closing on slow clients
+      client->setCloseClientOnQueueFull(false);
+      forceBroadcast.store(true);
+      break;
+    case WS_EVT_DATA: {
+      AwsFrameInfo *info = (AwsFrameInfo *)arg;
+      // Only accept complete single-frame binary messages
+      if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_BINARY || len == 0) {
+        return;
+      }
+      switch (data[0]) {
+        case REMOTE_MOVE:
+          if (len >= 2) {
+            postRemoteCommand(REMOTE_MOVE, min(data[1], (uint8_t)100));
+          }
+          break;
+        case REMOTE_STOP:
+          postRemoteCommand(REMOTE_STOP, 0);
+          break;
+        case REMOTE_NUDGE:
+          if (len >= 2) {
+            postRemoteCommand(REMOTE_NUDGE, data[1]);
+          }
+          break;
+        case REMOTE_OPEN:
+        case REMOTE_CLOSE:
+          postRemoteCommand(data[0]);
+          break;
+        default:
+          break;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Attach WebSocket control endpoint to web server
+void setupRemote(AsyncWebServer &server) {
+  ws.onEvent(onRemoteEvent);
+  server.addHandler(&ws);
+}
+
+// Apply latest remote command and broadcast state changes
+void updateRemote() {
+  unsigned long currentTime = clockMillis();
+
+  // Apply only the newest command received since last update
+  uint16_t command = pendingCommand.exchange(0);
+  if (command != 0) {
+    uint8_t arg = command & 0xFF;
+    switch (command >> 8) {
+      case REMOTE_MOVE:
+        triggerMoveTo(arg);
+        break;
+      case REMOTE_STOP:
+        triggerStop();
+        break;
+      case REMOTE_NUDGE:
+        triggerNudge((int8_t)arg);
+        break;
+      case REMOTE_OPEN:
+        triggerOpen();
+        break;
+      case REMOTE_CLOSE:
+        triggerClose();
+        break;
+    }
+  }
+
+  // Periodically release disconnected clients
+  if (currentTime - lastCleanupTime >= REMOTE_CLEANUP_INTERVAL) {
+    lastCleanupTime = currentTime;
+    ws.cleanupClients();
+  }
+
+  if (ws.count() == 0) {
+    return;
+  }
+
+  // Broadcast state on change, rate limited while moving
+  SystemState state = getState();
+  uint8_t percent = getPositionPercent();
+  bool force = forceBroadcast.exchange(false);
+  bool stateChanged = (state != lastSentState);
+  bool percentDue = (percent != lastSentPercent && currentTime - lastBroadcastTime >= REMOTE_BROADCAST_INTERVAL);
+  if (force || stateChanged || percentDue) {
+    uint8_t frame[3] = {REMOTE_STATE, (uint8_t)state, percent};
+    ws.binaryAll(frame, sizeof(frame));
+    lastSentState = state;
+    lastSentPercent = percent;
+    lastBroadcastTime = currentTime;
+  }
+}
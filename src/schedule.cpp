@@ -5,183 +5,512 @@
 
 #include "schedule.h"
 #include <Arduino.h>
-#include <WiFi.h>
-#include <WiFiManager.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
 #include <time.h>
+#include <esp_sntp.h>
+#include <atomic>
 #include "config.h"
+#include "clock.h"
 #include "memory.h"
 #include "states.h"
+#include "remote.h"
+#include "bridge.h"
+#include "group.h"
+#include "light.h"
+#include "ota.h"
+#include "tasks.h"
+#include "trace.h"
+#include "metrics.h"
+#include "log.h"
+#include "solar.h"
+#include "timekeeping.h"
+#include "network.h"
 
 // Network variables
 static AsyncWebServer server(WEB_SERVER_PORT);
 static bool wifiConnected = false;
+static bool serverStarted = false;
 static unsigned long lastNtpTime = 0;
-static unsigned long lastWifiTime = 0;
 
-// Scheduler variables
-static ScheduleTime openSched = {99, 99};
-static ScheduleTime closeSched = {99, 99};
-static int lastCheckedMinute = -1;
-static unsigned long lastScheduleTime = 0;
+// Scheduler variables (extra slot holds the vacation partial move)
+static constexpr uint8_t SCHEDULE_SLOTS = SCHEDULE_MAX_ENTRIES + 1;
+static constexpr uint8_t VACATION_SLOT = SCHEDULE_MAX_ENTRIES;
+static ScheduleEntry scheduleEntries[SCHEDULE_MAX_ENTRIES];
+static uint8_t scheduleCount = 0;
+static uint8_t presets[PRESET_COUNT];
+static int32_t lastFiredDate[SCHEDULE_SLOTS];
+static VacationConfig vacation = {false, false, 0, 1};
+static VacationConfig activeVacation = {false, false, 0, 1};
+static portMUX_TYPE scheduleLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Next event variables
+static esp_timer_handle_t scheduleTimer = nullptr;
+static time_t nextEventTime = 0;
+static uint32_t nextEventMask = 0;
+static int32_t nextEventDate[SCHEDULE_SLOTS];
+static std::atomic<bool> scheduleDue(false);
+static std::atomic<bool> scheduleDirty(false);
+static std::atomic<bool> scheduleReconcile(false);
+static time_t lastAppliedEvent = 0;
+
+// Solar variables (cache covers the full weekly search)
+static constexpr uint8_t SOLAR_CACHE_DAYS = 8;
+static int32_t latitude = DEFAULT_LATITUDE;
+static int32_t longitude = DEFAULT_LONGITUDE;
+static SolarTimes solarCache[SOLAR_CACHE_DAYS];
+static int32_t solarCacheDate[SOLAR_CACHE_DAYS];
+static std::atomic<bool> locationChanged(true);
+
+// Earliest time considered synced (2024-01-01)
+static constexpr time_t MIN_VALID_TIME = 1704067200;
 
 // Forward declarations
 static void setupWebServer();
-static void checkReconnectWiFi();
+static void updateConnection();
+static void armNextEvent();
+static void reconcileSchedule(time_t now);
+static void fireEvent(time_t eventTime, uint32_t eventMask, const int32_t *eventDate);
+static void runScheduleEntry(const ScheduleEntry &entry);
+static void onScheduleTimer(void *arg);
+static void onTimeSync(struct timeval *tv);
+static int32_t localDateKey(const struct tm &date);
 
 // Initialize scheduler, Wi-Fi, RTC, and web server
 bool setupScheduler() {
   Serial.print("Initializing Scheduler...");
 
-  loadSchedule(openSched, closeSched);
-
-  Serial.print("Done\n");
-  // Format and print schedule times
-  char openTimeStr[6];
-  char closeTimeStr[6];
-  if (openSched.hour == 99) {
-    snprintf(openTimeStr, sizeof(openTimeStr), "N/A");
-  } else {
-    snprintf(openTimeStr, sizeof(openTimeStr), "%02d:%02d", openSched.hour, openSched.minute);
+  scheduleCount = loadSchedule(scheduleEntries, SCHEDULE_MAX_ENTRIES);
+  loadPresets(presets, PRESET_COUNT);
+  loadLocation(latitude, longitude);
+  loadVacation(vacation);
+  lastAppliedEvent = loadLastEvent();
+  for (uint8_t i = 0; i < SCHEDULE_SLOTS; ++i) {
+    lastFiredDate[i] = -1;
   }
-  if (closeSched.hour == 99) {
-    snprintf(closeTimeStr, sizeof(closeTimeStr), "N/A");
-  } else {
-    snprintf(closeTimeStr, sizeof(closeTimeStr), "%02d:%02d", closeSched.hour, closeSched.minute);
-  }
-  Serial.printf("*Loaded Schedule: Open = %s, Close = %s\n", openTimeStr, closeTimeStr);
-
-  // Initialize Wi-Fi using WiFiManager libary
-  Serial.printf("Initializing Wi-Fi (SSID: %s)...\n", WIFI_AP_NAME);
-  WiFi.mode(WIFI_STA);
-  WiFiManager wm;
-  // Set autoconnect timeout (s)
-  wm.setConnectTimeout(30);
-  // Set captive portal timeout (s)
-  wm.setConfigPortalTimeout(120);
-  // Configure menu items
-  std::vector<const char *> wm_menu  = {"wifi", "exit"};
-  wm.setShowInfoUpdate(false);
-  wm.setShowInfoErase(false);
-  wm.setMenu(wm_menu);
-  wifiConnected = wm.autoConnect(WIFI_AP_NAME, NULL);
-  if (!wifiConnected) {
+
+  // Create one-shot timer for the next due event
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = onScheduleTimer;
+  timerArgs.name = "schedule";
+  if (esp_timer_create(&timerArgs, &scheduleTimer) != ESP_OK) {
+    Serial.print("Failed\n");
     return false;
   }
+  // Apply time zone before first sync so local times are valid offline
+  setenv("TZ", TIME_ZONE, 1);
+  tzset();
+  setupTimekeeping();
+  sntp_set_time_sync_notification_cb(onTimeSync);
+  sntp_set_sync_interval(NTP_SYNC_INTERVAL);
+  // Run from retained clock until first sync
+  scheduleReconcile.store(true);
+  scheduleDirty.store(true);
 
-  // Initializes system time using NTP server
-  Serial.print("Initializing Time Server...");
-  configTzTime(TIME_ZONE, NTP_SERVER);
-  struct tm timeinfo;
-  while (!getLocalTime(&timeinfo)) {
-    Serial.print(".");
-    delay(500);
-  }
   Serial.print("Done\n");
-  Serial.printf("*Time Synced: %s", asctime(&timeinfo));
+  Serial.printf("*Loaded Schedule: %u Entries\n", scheduleCount);
 
-  // Start web server over Wi-Fi
-  Serial.print("Initializing Web Server...");
+  // Initializes system time using NTP server (syncs once Wi-Fi connects)
+  configTzTime(TIME_ZONE, NTP_SERVER);
   setupWebServer();
-  server.begin();
-  Serial.print("Done\n");
 
-  lastWifiTime = millis();
-  return true;
+  // Start Wi-Fi in background, web server starts on first connection
+  return setupNetwork();
 }
 
-// Check scheduled times for action triggers
+// Run due scheduled actions and re-arm the next event timer
 void checkSchedule() {
-  unsigned long currentTime = millis();
+  // Follow connection changes reported by the network task
+  updateConnection();
 
-  // Periodically check/reconnect to Wi-Fi
-  if (currentTime - lastWifiTime >= WIFI_CHECK_INTERVAL) {
-    lastWifiTime = currentTime;
-    checkReconnectWiFi();
+  // Apply missed event after boot or clock sync
+  if (scheduleReconcile.exchange(false) && timeNow() >= MIN_VALID_TIME) {
+    reconcileSchedule(timeNow());
+    scheduleDirty.store(true);
   }
 
-  // Check if interval time is met
-  if (currentTime - lastScheduleTime <= SCHEDULE_CHECK_INTERVAL) {
-    return;
+  // Recompute next event after clock or table changes
+  if (scheduleDirty.exchange(false)) {
+    armNextEvent();
   }
-  lastScheduleTime = currentTime;
 
-  struct tm timeinfo;
-  // Check if time is available
-  if (!getLocalTime(&timeinfo) && wifiConnected) {
-    if (wifiConnected) {
-      Serial.print("ERROR: Failed to Obtain Time\n");
-      enterState(SystemState::ERROR);
-    }
+  // The timer runs on hardware time, so a virtual clock also polls for events it reached without it
+  bool due = scheduleDue.exchange(false) || (isVirtualClock() && nextEventMask != 0 && timeNow() >= nextEventTime);
+  if (!due || nextEventMask == 0) {
     return;
   }
 
-  // Prevent multiple triggers in the same minute
-  if (timeinfo.tm_min == lastCheckedMinute) {
+  // Re-arm if timer fired before the wall clock reached the event
+  time_t now = timeNow();
+  if (now < nextEventTime) {
+    esp_timer_start_once(scheduleTimer, delayUntil(nextEventTime));
     return;
   }
-  lastCheckedMinute = timeinfo.tm_min;
 
-  // Check open schedule
-  if (openSched.hour == timeinfo.tm_hour && openSched.minute == timeinfo.tm_min) {
-    Serial.printf("Scheduler: Open Trigger (%02d:%02d)\n", timeinfo.tm_hour, timeinfo.tm_min);
-    triggerOpen();
+  if (now - nextEventTime > (time_t)SCHEDULE_CATCHUP_GRACE) {
+    // Clock jumped past the event, apply the latest one still in effect instead
+    reconcileSchedule(now);
+  } else if (nextEventTime > lastAppliedEvent) {
+    fireEvent(nextEventTime, nextEventMask, nextEventDate);
   }
+  armNextEvent();
+}
 
-  // Check close schedule
-   if (closeSched.hour == timeinfo.tm_hour && closeSched.minute == timeinfo.tm_min) {
-    Serial.printf("Scheduler: Close Trigger (%02d:%02d)\n", timeinfo.tm_hour, timeinfo.tm_min);
-    triggerClose();
+// Pack entry for storage
+// Layout: days [0:6], minute [7:17], action [18:20], arg [21:27], base [28:30], reserved [31]
+uint32_t packScheduleEntry(const ScheduleEntry &entry) {
+  return ((uint32_t)(entry.days & 0x7F)) | ((uint32_t)(entry.minute & 0x7FF) << 7) |
+         ((uint32_t)((uint8_t)entry.action & 0x07) << 18) | ((uint32_t)(entry.arg & 0x7F) << 21) |
+         ((uint32_t)((uint8_t)entry.base & 0x07) << 28);
+}
+
+// Unpack entry from storage
+ScheduleEntry unpackScheduleEntry(uint32_t packed) {
+  ScheduleEntry entry;
+  entry.days = packed & 0x7F;
+  entry.minute = (packed >> 7) & 0x7FF;
+  entry.action = (ScheduleAction)((packed >> 18) & 0x07);
+  entry.arg = (packed >> 21) & 0x7F;
+  entry.base = (ScheduleBase)((packed >> 28) & 0x07);
+  // Solar offsets are stored as signed 11-bit values
+  if (entry.base != ScheduleBase::TIME && entry.minute >= 0x400) {
+    entry.minute -= 0x800;
+  }
+  // Treat out of range entries as unused
+  bool validMinute = (entry.base == ScheduleBase::TIME) ? (entry.minute < 1440) :
+                     (entry.minute >= -SOLAR_MAX_OFFSET && entry.minute <= SOLAR_MAX_OFFSET);
+  if (!validMinute || entry.action > ScheduleAction::WAKE || entry.base > ScheduleBase::DUSK) {
+    entry.days = 0;
   }
+  return entry;
 }
 
-// Sync RTC with NTP server
-void syncRTC() {
-  unsigned long currentTime = millis();
+// Get local date key for once-per-day tracking
+static int32_t localDateKey(const struct tm &date) {
+  return date.tm_year * 366 + date.tm_yday;
+}
 
-  // Periodically check/reconnect to Wi-Fi
-  if (currentTime - lastWifiTime >= WIFI_CHECK_INTERVAL) {
-    lastWifiTime = currentTime;
-    checkReconnectWiFi();
+// Get solar event time for a local date (0 if it does not occur)
+static time_t solarEventTime(const struct tm &day, int32_t dateKey, ScheduleBase base) {
+  uint8_t slot = dateKey % SOLAR_CACHE_DAYS;
+
+  // Drop cached solar times after a location change
+  if (locationChanged.exchange(false)) {
+    for (uint8_t i = 0; i < SOLAR_CACHE_DAYS; ++i) {
+      solarCacheDate[i] = -1;
+    }
   }
 
-  if (wifiConnected) {
-    // Periodically check NTP time
-    if (lastNtpTime == 0 || (currentTime - lastNtpTime > NTP_SYNC_INTERVAL)) {
-      struct tm timeinfo;
-      // Synchronize system time with NTP server
-      if (!getLocalTime(&timeinfo)) {
-        Serial.print("ERROR: Failed to Obtain Time\n");
-        enterState(SystemState::ERROR);
-        return;
+  // Compute once per day and location
+  if (solarCacheDate[slot] != dateKey) {
+    portENTER_CRITICAL(&scheduleLock);
+    int32_t lat = latitude;
+    int32_t lon = longitude;
+    portEXIT_CRITICAL(&scheduleLock);
+    solarCache[slot] = computeSolarTimes(day.tm_year + 1900, day.tm_mon + 1, day.tm_mday, lat, lon);
+    solarCacheDate[slot] = dateKey;
+  }
+
+  switch (base) {
+    case ScheduleBase::SUNRISE:
+      return solarCache[slot].sunrise;
+    case ScheduleBase::SUNSET:
+      return solarCache[slot].sunset;
+    case ScheduleBase::DAWN:
+      return solarCache[slot].dawn;
+    case ScheduleBase::DUSK:
+      return solarCache[slot].dusk;
+    default:
+      return 0;
+  }
+}
+
+// Get deterministic random value for a date and slot (stateless, so any day costs the same)
+static uint32_t vacationRandom(int32_t dateKey, uint8_t slot, uint8_t stream) {
+  uint32_t x = activeVacation.seed ^ ((uint32_t)dateKey * 0x9E3779B9u) ^ ((uint32_t)(slot << 8 | stream) * 0x85EBCA6Bu);
+  // Murmur3 finalizer
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+// Copy table into all slots so web updates cannot change it mid-search (unused slots have no days)
+static void copySchedule(ScheduleEntry *entries) {
+  memset(entries, 0, sizeof(ScheduleEntry) * SCHEDULE_SLOTS);
+  portENTER_CRITICAL(&scheduleLock);
+  memcpy(entries, scheduleEntries, sizeof(ScheduleEntry) * scheduleCount);
+  activeVacation = vacation;
+  portEXIT_CRITICAL(&scheduleLock);
+
+  // Daily partial move placed randomly in its window when fired
+  if (activeVacation.enabled && activeVacation.partialMoves) {
+    entries[VACATION_SLOT] = {0x7F, VACATION_PARTIAL_START, ScheduleAction::PERCENT, 0, ScheduleBase::TIME};
+  }
+}
+
+// Get local noon of a day relative to today (returns date key)
+static int32_t localDay(const struct tm &today, int dayOffset, struct tm &day) {
+  day = today;
+  day.tm_mday += dayOffset;
+  day.tm_hour = 12;
+  day.tm_min = 0;
+  day.tm_sec = 0;
+  day.tm_isdst = -1;
+  // Normalize date to get weekday (noon avoids DST edges)
+  mktime(&day);
+  return localDateKey(day);
+}
+
+// Get vacation shift of a slot on a day (s)
+static time_t vacationShift(int32_t dateKey, uint8_t slot) {
+  if (!activeVacation.enabled) {
+    return 0;
+  }
+  uint32_t random = vacationRandom(dateKey, slot, 0);
+  if (slot == VACATION_SLOT) {
+    return (time_t)(random % VACATION_PARTIAL_WINDOW) * 60;
+  }
+  int32_t span = 2 * activeVacation.maxOffset + 1;
+  return (time_t)((int32_t)(random % span) - activeVacation.maxOffset) * 60;
+}
+
+// Get event time of a slot on a day (0 if it does not run that day)
+static time_t entryEventTime(const ScheduleEntry &entry, uint8_t slot, const struct tm &day, int32_t dateKey) {
+  time_t eventTime;
+
+  if (!(entry.days & (1 << day.tm_wday))) {
+    return 0;
+  }
+  if (entry.base == ScheduleBase::TIME) {
+    struct tm eventTm = day;
+    eventTm.tm_hour = entry.minute / 60;
+    eventTm.tm_min = entry.minute % 60;
+    eventTm.tm_sec = 0;
+    eventTm.tm_isdst = -1;
+    eventTime = mktime(&eventTm);
+  } else {
+    // Skip days without the event (polar day/night)
+    time_t solarTime = solarEventTime(day, dateKey, entry.base);
+    if (solarTime == 0) {
+      return 0;
+    }
+    eventTime = solarTime + entry.minute * 60;
+  }
+  return eventTime + vacationShift(dateKey, slot);
+}
+
+// Find next event strictly after current time
+static void computeNextEvent(time_t now) {
+  ScheduleEntry entries[SCHEDULE_SLOTS];
+  int32_t firedDate[SCHEDULE_SLOTS];
+  copySchedule(entries);
+  // Web updates reset fired dates under the lock
+  portENTER_CRITICAL(&scheduleLock);
+  memcpy(firedDate, lastFiredDate, sizeof(firedDate));
+  portEXIT_CRITICAL(&scheduleLock);
+
+  nextEventTime = 0;
+  nextEventMask = 0;
+
+  struct tm today;
+  localtime_r(&now, &today);
+
+  // Search day by day, stopping at the first day with a future event
+  for (int dayOffset = 0; dayOffset <= 7 && nextEventMask == 0; ++dayOffset) {
+    struct tm day;
+    int32_t dateKey = localDay(today, dayOffset, day);
+
+    for (uint8_t i = 0; i < SCHEDULE_SLOTS; ++i) {
+      if (firedDate[i] == dateKey) {
+        continue;
+      }
+      time_t eventTime = entryEventTime(entries[i], i, day, dateKey);
+      if (eventTime <= now) {
+        continue;
+      }
+      if (nextEventMask == 0 || eventTime < nextEventTime) {
+        nextEventTime = eventTime;
+        nextEventMask = 1 << i;
+      } else if (eventTime == nextEventTime) {
+        nextEventMask |= 1 << i;
+      } else {
+        continue;
+      }
+      // Remember the scheduled day, offsets may cross midnight
+      nextEventDate[i] = dateKey;
+    }
+  }
+}
+
+// Apply the most recent past event within the grace window if it was missed
+static void reconcileSchedule(time_t now) {
+  ScheduleEntry entries[SCHEDULE_SLOTS];
+  int32_t eventDate[SCHEDULE_SLOTS];
+  time_t eventTime = 0;
+  uint32_t eventMask = 0;
+  copySchedule(entries);
+
+  struct tm today;
+  localtime_r(&now, &today);
+
+  // Search back over every day the grace window can reach
+  int days = SCHEDULE_CATCHUP_GRACE / 86400 + 1;
+  for (int dayOffset = -days; dayOffset <= 0; ++dayOffset) {
+    struct tm day;
+    int32_t dateKey = localDay(today, dayOffset, day);
+
+    for (uint8_t i = 0; i < SCHEDULE_SLOTS; ++i) {
+      time_t entryTime = entryEventTime(entries[i], i, day, dateKey);
+      if (entryTime == 0 || entryTime > now || now - entryTime > (time_t)SCHEDULE_CATCHUP_GRACE) {
+        continue;
+      }
+      if (eventMask == 0 || entryTime > eventTime) {
+        eventTime = entryTime;
+        eventMask = 1 << i;
+      } else if (entryTime == eventTime) {
+        eventMask |= 1 << i;
+      } else {
+        continue;
       }
-      lastNtpTime = millis();
+      eventDate[i] = dateKey;
     }
   }
+
+  // Persisted event time prevents firing twice across reboots
+  if (eventMask == 0 || eventTime <= lastAppliedEvent) {
+    return;
+  }
+  LOG_INFO("Scheduler: Catch-Up (%lld s Late)\n", (int64_t)(now - eventTime));
+  fireEvent(eventTime, eventMask, eventDate);
 }
 
-// Check Wi-Fi status and reconnect if necessary
-static void checkReconnectWiFi() {
-  wl_status_t currentStatus = WiFi.status();
+// Run every entry due at an event time once and record it as applied
+static void fireEvent(time_t eventTime, uint32_t eventMask, const int32_t *eventDate) {
+  ScheduleEntry entries[SCHEDULE_SLOTS];
+  copySchedule(entries);
 
-  if (currentStatus != WL_CONNECTED) {
-    // Not connected
-    if (wifiConnected) {
-      Serial.print("Wi-Fi Disconnected\nAttempting Reconnect...\n");
-      wifiConnected = false;
-      server.end();
+  for (uint8_t i = 0; i < SCHEDULE_SLOTS; ++i) {
+    if (!(eventMask & (1 << i)) || entries[i].days == 0) {
+      continue;
     }
-    // Attempt to reconnect
-    WiFi.begin();
-  } else {
-    // Connected
-    if (!wifiConnected) {
-      Serial.printf("Wi-Fi Reconnected (IP: %s)\n", WiFi.localIP().toString().c_str());
-      wifiConnected = true;
-      // Force RTC sync
-      lastNtpTime = 0;
+    // Partial move target is drawn for the day it runs
+    if (i == VACATION_SLOT) {
+      entries[i].arg = VACATION_PARTIAL_MIN +
+                       vacationRandom(eventDate[i], i, 1) % (VACATION_PARTIAL_MAX - VACATION_PARTIAL_MIN + 1);
+    }
+    portENTER_CRITICAL(&scheduleLock);
+    lastFiredDate[i] = eventDate[i];
+    portEXIT_CRITICAL(&scheduleLock);
+    runScheduleEntry(entries[i]);
+  }
+  lastAppliedEvent = eventTime;
+  if (!saveLastEvent((uint32_t)eventTime)) {
+    LOG_WARN("Failed to Save Last Event\n");
+  }
+}
+
+// Recompute next event and arm one-shot timer for it
+static void armNextEvent() {
+  time_t now = timeNow();
+
+  esp_timer_stop(scheduleTimer);
+  if (now < MIN_VALID_TIME) {
+    // Wait for time sync
+    nextEventTime = 0;
+    nextEventMask = 0;
+    return;
+  }
+
+  computeNextEvent(now);
+  if (nextEventMask == 0) {
+    return;
+  }
+  esp_timer_start_once(scheduleTimer, delayUntil(nextEventTime));
+  LOG_DEBUG("Scheduler: Next Event in %lld s (Mask: %llx)\n", (int64_t)(nextEventTime - now), nextEventMask);
+}
+
+// Perform a scheduled entry action
+static void runScheduleEntry(const ScheduleEntry &entry) {
+  LOG_INFO("Scheduler: Trigger (Base: %lld, Minute: %lld, Action: %lld)\n", (int)entry.base, entry.minute,
+           (int)entry.action);
+  switch (entry.action) {
+    case ScheduleAction::OPEN:
+      triggerOpen();
+      break;
+    case ScheduleAction::CLOSE:
+      triggerClose();
+      break;
+    case ScheduleAction::PERCENT:
+      triggerMoveTo(entry.arg);
+      break;
+    case ScheduleAction::PRESET: {
+      uint8_t percent;
+      if (getPresetPercent(entry.arg, percent)) {
+        triggerMoveTo(percent);
+      }
+      break;
+    }
+    case ScheduleAction::WAKE:
+      triggerWake((uint32_t)entry.arg * 60000UL);
+      break;
+  }
+}
+
+// Get preset position in percent open
+bool getPresetPercent(uint8_t index, uint8_t &percent) {
+  if (index >= PRESET_COUNT) {
+    return false;
+  }
+  portENTER_CRITICAL(&scheduleLock);
+  percent = presets[index];
+  portEXIT_CRITICAL(&scheduleLock);
+  return true;
+}
+
+// Timer callback (runs in timer task, only flags the loop)
+static void onScheduleTimer(void *arg) {
+  scheduleDue.store(true);
+}
+
+// Time sync callback (runs in SNTP task, only flags the loop)
+static void onTimeSync(struct timeval *tv) {
+  recordTimeSync(*tv);
+  scheduleReconcile.store(true);
+  scheduleDirty.store(true);
+}
+
+// Sync RTC with NTP server
+void syncRTC() {
+  unsigned long currentTime = clockMillis();
+
+  // Persist drift estimate after a sync
+  updateTimekeeping();
+
+  // SNTP resyncs on its own interval, only nudge it when the clock goes stale
+  if (wifiConnected && isTimeDegraded() &&
+      (lastNtpTime == 0 || currentTime - lastNtpTime > NTP_RETRY_INTERVAL)) {
+    LOG_WARN("Time Not Synced, Running on Drift-Corrected Clock\n");
+    lastNtpTime = currentTime;
+    sntp_restart();
+  }
+}
+
+// Apply Wi-Fi connection changes (reconnects are handled by the network task)
+static void updateConnection() {
+  if (!networkChanged()) {
+    return;
+  }
+  wifiConnected = isNetworkConnected();
+  if (wifiConnected) {
+    // Allow immediate resync if clock went stale
+    lastNtpTime = 0;
+    // Portal owns port 80 until the first connection
+    if (!serverStarted) {
       server.begin();
+      serverStarted = true;
     }
   }
 }
@@ -204,18 +533,174 @@ const char index_html[] = R"rawliteral(
   </form>
   <br>
   <br>
+  <label for="position">Position:</label>
+  <input type="range" id="position" min="0" max="100" value="0">
+  <span id="percent">-</span>%
+  <button type="button" id="stop">Stop</button>
+  <br>
+  <br>
+
+  <h2>Group</h2>
+  <form action="/setGroup" method="get">
+    <label>Group ID: <input type="number" name="group" id="groupId" min="0" max="255"></label>
+    <button type="submit">Save</button>
+  </form>
+  <button type="button" onclick="fetch('/groupMove?percent=100')">Open Group</button>
+  <button type="button" onclick="fetch('/groupMove?percent=0')">Close Group</button>
+  <div id="members"></div>
 
   <h2>Schedule</h2>
   <form action="/setSchedule" method="get">
-    <label for="openTime">Open Time:</label>
-    <input type="time" id="openTime" name="openTime" value=""> <input type="checkbox" id="openSet" name="openSet" title="Clear Open Time"> Clear this time<br>
-
-    <label for="closeTime">Close Time:</label>
-    <input type="time" id="closeTime" name="closeTime" value=""> <input type="checkbox" id="closeSet" name="closeSet" title="Clear Close Time"> Clear this time<br>
+    <table id="schedule">
+      <tr><th>Days</th><th>At</th><th>Time/Offset</th><th>Action</th><th>Value</th></tr>
+    </table>
     <br>
     <button type="submit">Save</button>
   </form>
 
+  <h2>Vacation</h2>
+  <form action="/setVacation" method="get">
+    <label><input type="checkbox" name="enabled" id="vacEnabled">Enabled</label>
+    <label><input type="checkbox" name="partial" id="vacPartial">Partial Moves</label>
+    <label>Max Shift: <input type="number" name="offset" id="vacOffset" min="0" max="120">min</label>
+    <label>Seed: <input type="number" name="seed" id="vacSeed" min="0" max="4294967295"></label>
+    <button type="submit">Save</button>
+  </form>
+
+  <h2>Glare</h2>
+  <form action="/setLight" method="get">
+    <label><input type="checkbox" name="enabled" id="lightEnabled">Enabled</label>
+    <label>Close to <input type="number" name="percent" id="lightPercent" min="0" max="100">%</label>
+    <label>above <input type="number" name="close" id="lightClose" min="1" max="65535">kcps</label>
+    <label>for <input type="number" name="closeDelay" id="lightCloseDelay" min="0" max="120">min,</label>
+    <label>reopen below <input type="number" name="open" id="lightOpen" min="0" max="65535">kcps</label>
+    <label>for <input type="number" name="openDelay" id="lightOpenDelay" min="0" max="120">min</label>
+    <span id="lightStatus"></span>
+    <button type="submit">Save</button>
+  </form>
+
+  <h2>MQTT</h2>
+  <form action="/setMqtt" method="get">
+    <label>Broker: <input type="text" name="uri" id="mqttUri" placeholder="mqtt://host:1883"></label>
+    <label>User: <input type="text" name="user" id="mqttUser"></label>
+    <label>Password: <input type="password" name="password" placeholder="unchanged"></label>
+    <span id="mqttStatus"></span>
+    <button type="submit">Save</button>
+  </form>
+
+  <h2>Location</h2>
+  <form action="/setLocation" method="get">
+    <label>Latitude: <input type="number" name="lat" id="lat" step="0.0001" min="-90" max="90"></label>
+    <label>Longitude: <input type="number" name="lon" id="lon" step="0.0001" min="-180" max="180"></label>
+    <button type="submit">Save</button>
+  </form>
+
+  <h2>Presets</h2>
+  <form action="/setPresets" method="get" id="presets">
+    <button type="submit">Save</button>
+  </form>
+
+  <h2>Firmware</h2>
+  <form action="/update" method="post" enctype="multipart/form-data"
+        onsubmit="this.action = '/update?sha256=' + document.getElementById('sha256').value.trim()">
+    <label>Image: <input type="file" name="firmware" accept=".bin"></label>
+    <label>SHA-256: <input type="text" name="sha256" id="sha256" size="64" pattern="[0-9a-fA-F]{64}"></label>
+    <button type="submit">Update</button>
+  </form>
+
+  <script>
+    var ws = new WebSocket("ws://" + location.host + "/ws");
+    var slider = document.getElementById("position");
+    var dragging = false;
+    ws.binaryType = "arraybuffer";
+    ws.onmessage = function(e) {
+      var frame = new Uint8Array(e.data);
+      // State broadcast: [0x80, state, percent]
+      if (frame[0] == 0x80) {
+        document.getElementById("percent").textContent = frame[2];
+        if (!dragging) slider.value = frame[2];
+      }
+    };
+    slider.oninput = function() {
+      dragging = true;
+      if (ws.readyState == 1) ws.send(new Uint8Array([0x01, slider.value]));
+    };
+    slider.onchange = function() { dragging = false; };
+    document.getElementById("stop").onclick = function() {
+      if (ws.readyState == 1) ws.send(new Uint8Array([0x02]));
+    };
+
+    fetch("/mqtt").then(function(r) { return r.json(); }).then(function(cfg) {
+      document.getElementById("mqttUri").value = cfg.uri;
+      document.getElementById("mqttUser").value = cfg.user;
+      document.getElementById("mqttStatus").textContent = cfg.connected ? "Connected (" + cfg.base + ")" : "";
+    });
+
+    fetch("/light").then(function(r) { return r.json(); }).then(function(cfg) {
+      document.getElementById("lightEnabled").checked = cfg.enabled;
+      document.getElementById("lightPercent").value = cfg.percent;
+      document.getElementById("lightClose").value = cfg.close;
+      document.getElementById("lightCloseDelay").value = cfg.closeDelay;
+      document.getElementById("lightOpen").value = cfg.open;
+      document.getElementById("lightOpenDelay").value = cfg.openDelay;
+      document.getElementById("lightStatus").textContent = "Now " + cfg.level + " kcps" + (cfg.glare ? " (glare)" : "");
+    });
+
+    fetch("/group").then(function(r) { return r.json(); }).then(function(cfg) {
+      document.getElementById("groupId").value = cfg.group;
+      var list = cfg.members.map(function(m) { return m.id + ": " + m.percent + "% (" + m.age + " s ago)"; });
+      document.getElementById("members").textContent = list.join(", ");
+    });
+
+    // Build schedule and preset forms from current settings
+    fetch("/schedule").then(function(r) { return r.json(); }).then(function(cfg) {
+      var table = document.getElementById("schedule");
+      var dayNames = ["Su", "Mo", "Tu", "We", "Th", "Fr", "Sa"];
+      var actions = ["Open", "Close", "Percent", "Preset", "Wake (min)"];
+      var bases = ["Time", "Sunrise", "Sunset", "Dawn", "Dusk"];
+      document.getElementById("lat").value = cfg.lat / 10000;
+      document.getElementById("lon").value = cfg.lon / 10000;
+      document.getElementById("vacEnabled").checked = cfg.vacation.enabled;
+      document.getElementById("vacPartial").checked = cfg.vacation.partial;
+      document.getElementById("vacOffset").value = cfg.vacation.offset;
+      document.getElementById("vacSeed").value = cfg.vacation.seed;
+      for (var i = 0; i < cfg.max; i++) {
+        var e = cfg.entries[i] || {days: 0, minute: 0, action: 0, arg: 0, base: 0};
+        var row = table.insertRow();
+        var html = "";
+        for (var d = 0; d < 7; d++) {
+          html += "<label><input type='checkbox' name='w" + i + "_" + d + "'" +
+                  ((e.days >> d) & 1 ? " checked" : "") + ">" + dayNames[d] + "</label> ";
+        }
+        row.insertCell().innerHTML = html;
+        var base = "<select name='b" + i + "'>";
+        for (var b = 0; b < bases.length; b++) {
+          base += "<option value='" + b + "'" + (e.base == b ? " selected" : "") + ">" + bases[b] + "</option>";
+        }
+        row.insertCell().innerHTML = base + "</select>";
+        // Fixed times use the time field, solar events use a signed minute offset
+        var clock = e.base == 0 ? e.minute : 0, offset = e.base == 0 ? 0 : e.minute;
+        var hh = ("0" + Math.floor(clock / 60)).slice(-2), mm = ("0" + (clock % 60)).slice(-2);
+        row.insertCell().innerHTML = "<input type='time' name='t" + i + "' value='" + hh + ":" + mm + "'> " +
+                                     "<input type='number' name='o" + i + "' min='-720' max='720' value='" +
+                                     offset + "'>min";
+        var select = "<select name='a" + i + "'>";
+        for (var a = 0; a < actions.length; a++) {
+          select += "<option value='" + a + "'" + (e.action == a ? " selected" : "") + ">" + actions[a] + "</option>";
+        }
+        row.insertCell().innerHTML = select + "</select>";
+        row.insertCell().innerHTML = "<input type='number' name='v" + i + "' min='0' max='100' value='" + e.arg + "'>";
+      }
+      var form = document.getElementById("presets");
+      for (var p = cfg.presets.length - 1; p >= 0; p--) {
+        var label = document.createElement("label");
+        label.innerHTML = "Preset " + p + ": <input type='number' name='p" + p + "' min='0' max='100' value='" +
+                          cfg.presets[p] + "'>%<br>";
+        form.insertBefore(label, form.firstChild);
+      }
+    });
+  </script>
+
 </body>
 </html>
 )rawliteral";
@@ -224,88 +709,260 @@ const char index_html[] = R"rawliteral(
 // Initialize web server routes
 static void setupWebServer() {
 
+  // WebSocket control channel ("/ws")
+  setupRemote(server);
+
+  // MQTT bridge settings ("/mqtt", "/setMqtt")
+  setupBridge(server);
+
+  // Synchronized group moves ("/group", "/setGroup", "/groupMove")
+  setupGroup(server);
+
+  // Glare rule ("/light", "/setLight")
+  setupLight(server);
+
+  // Firmware update ("/update")
+  setupOta(server);
+
+  // Input trace ("/trace", "/setTrace")
+  setupTrace(server);
+
   // Root page ("/")
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+    metricIncrement(Counter::HTTP_ROOT);
     request->send(200, "text/html", index_html);
   });
 
   // Handle open trigger
   server.on("/open", HTTP_GET, [](AsyncWebServerRequest *request) {
-    Serial.print("Web Server: Open Trigger\n");
-    triggerOpen();
+    LOG_INFO("Web Server: Open Trigger\n");
+    metricIncrement(Counter::HTTP_OPEN);
+    // Applied by the loop with the next remote update
+    postRemoteCommand(REMOTE_OPEN);
     // Redirect back to root page
     request->redirect("/");
   });
 
   // Handle close trigger
   server.on("/close", HTTP_GET, [](AsyncWebServerRequest *request) {
-    Serial.print("Web Server: Close Trigger\n");
-    triggerClose();
+    LOG_INFO("Web Server: Close Trigger\n");
+    metricIncrement(Counter::HTTP_CLOSE);
+    // Applied by the loop with the next remote update
+    postRemoteCommand(REMOTE_CLOSE);
     // Redirect back to root page
     request->redirect("/");
   });
 
+  // Current schedule and presets as JSON
+  server.on("/schedule", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    ScheduleEntry entries[SCHEDULE_MAX_ENTRIES];
+    uint8_t count;
+    uint8_t percents[PRESET_COUNT];
+    int32_t lat;
+    int32_t lon;
+    VacationConfig config;
+
+    portENTER_CRITICAL(&scheduleLock);
+    count = scheduleCount;
+    memcpy(entries, scheduleEntries, sizeof(ScheduleEntry) * count);
+    memcpy(percents, presets, sizeof(presets));
+    lat = latitude;
+    lon = longitude;
+    config = vacation;
+    portEXIT_CRITICAL(&scheduleLock);
+
+    response->printf("{\"max\":%u,\"lat\":%ld,\"lon\":%ld,\"entries\":[", SCHEDULE_MAX_ENTRIES, (long)lat,
+                     (long)lon);
+    for (uint8_t i = 0; i < count; ++i) {
+      response->printf("%s{\"days\":%u,\"minute\":%d,\"action\":%u,\"arg\":%u,\"base\":%u}",
+                       (i > 0) ? "," : "", entries[i].days, entries[i].minute, (uint8_t)entries[i].action,
+                       entries[i].arg, (uint8_t)entries[i].base);
+    }
+    response->print("],\"presets\":[");
+    for (uint8_t i = 0; i < PRESET_COUNT; ++i) {
+      response->printf("%s%u", (i > 0) ? "," : "", percents[i]);
+    }
+    response->printf("],\"vacation\":{\"enabled\":%u,\"partial\":%u,\"offset\":%u,\"seed\":%lu}}",
+                     config.enabled, config.partialMoves, config.maxOffset, (unsigned long)config.seed);
+    request->send(response);
+  });
+
   // Handle schedule form submission
   server.on("/setSchedule", HTTP_GET, [](AsyncWebServerRequest *request) {
-    Serial.print("Web Server: Schedule Form Submission\n");
-    ScheduleTime tempOpenSched = {99, 99};
-    ScheduleTime tempCloseSched = {99, 99};
-
-    bool openSet = request->hasParam("openSet");
-    bool closeSet = request->hasParam("closeSet");
-    int hour = -1, minute = -1;
-
-    // Process open time parameter if set
-    if (!openSet && request->hasParam("openTime")) {
-      String openTimeStr = request->getParam("openTime")->value();
-      // Convert time string to hour and minute
-      if (sscanf(openTimeStr.c_str(), "%d:%d", &hour, &minute) == 2) {
-        if (hour >= 0 && hour < 24 && minute >= 0 && minute < 60) {
-          tempOpenSched.hour = hour; tempOpenSched.minute = minute;
+    LOG_INFO("Web Server: Schedule Form Submission\n");
+    metricIncrement(Counter::HTTP_SCHEDULE);
+    ScheduleEntry tempEntries[SCHEDULE_MAX_ENTRIES];
+    uint8_t count = 0;
+    char name[8];
+
+    for (uint8_t i = 0; i < SCHEDULE_MAX_ENTRIES; ++i) {
+      ScheduleEntry entry = {0, 0, ScheduleAction::OPEN, 0, ScheduleBase::TIME};
+      int hour = -1, minute = -1;
+
+      // Collect weekday checkboxes into bitmask
+      for (uint8_t day = 0; day < 7; ++day) {
+        snprintf(name, sizeof(name), "w%u_%u", i, day);
+        if (request->hasParam(name)) {
+          entry.days |= 1 << day;
         }
       }
-    }
 
-    // Process close time parameter if set
-    if (!closeSet && request->hasParam("closeTime")) {
-      String closeTimeStr = request->getParam("closeTime")->value();
-      // Convert time string to hour and minute
-      if (sscanf(closeTimeStr.c_str(), "%d:%d", &hour, &minute) == 2) {
-        if (hour >= 0 && hour < 24 && minute >= 0 && minute < 60) {
-          tempCloseSched.hour = hour; tempCloseSched.minute = minute;
-        }
+      snprintf(name, sizeof(name), "b%u", i);
+      if (request->hasParam(name)) {
+        entry.base = (ScheduleBase)constrain(request->getParam(name)->value().toInt(), 0,
+                                             (int)ScheduleBase::DUSK);
       }
-    }
 
-    // Attempt to save new schedule times
-    if (saveSchedule(tempOpenSched, tempCloseSched)) {
-      openSched = tempOpenSched;
-      closeSched = tempCloseSched;
-      // Format and print schedule times
-      char openTimeStr[6];
-      char closeTimeStr[6];
-      if (openSched.hour == 99) {
-        snprintf(openTimeStr, sizeof(openTimeStr), "N/A");
+      if (entry.base == ScheduleBase::TIME) {
+        // Convert time string to minute of day
+        snprintf(name, sizeof(name), "t%u", i);
+        if (!request->hasParam(name) ||
+            sscanf(request->getParam(name)->value().c_str(), "%d:%d", &hour, &minute) != 2 ||
+            hour < 0 || hour >= 24 || minute < 0 || minute >= 60) {
+          continue;
+        }
+        entry.minute = hour * 60 + minute;
       } else {
-        snprintf(openTimeStr, sizeof(openTimeStr), "%02d:%02d", openSched.hour, openSched.minute);
+        // Offset in minutes from solar event
+        snprintf(name, sizeof(name), "o%u", i);
+        if (request->hasParam(name)) {
+          entry.minute = constrain(request->getParam(name)->value().toInt(), -SOLAR_MAX_OFFSET,
+                                   SOLAR_MAX_OFFSET);
+        }
       }
-      if (closeSched.hour == 99) {
-        snprintf(closeTimeStr, sizeof(closeTimeStr), "N/A");
-      } else {
-        snprintf(closeTimeStr, sizeof(closeTimeStr), "%02d:%02d", closeSched.hour, closeSched.minute);
+
+      snprintf(name, sizeof(name), "a%u", i);
+      if (request->hasParam(name)) {
+        entry.action = (ScheduleAction)constrain(request->getParam(name)->value().toInt(), 0,
+                                                 (int)ScheduleAction::WAKE);
+      }
+      snprintf(name, sizeof(name), "v%u", i);
+      if (request->hasParam(name)) {
+        entry.arg = constrain(request->getParam(name)->value().toInt(), 0, 100);
+      }
+      if (entry.action == ScheduleAction::PRESET && entry.arg >= PRESET_COUNT) {
+        entry.arg = PRESET_COUNT - 1;
+      }
+      if (entry.action == ScheduleAction::WAKE) {
+        entry.arg = constrain(entry.arg, 1, WAKE_MAX_MINUTES);
+      }
+
+      // Skip rows without any weekday selected
+      if (entry.days != 0) {
+        tempEntries[count++] = entry;
       }
-      Serial.printf("Saved Schedule: Open = %s, Close = %s\n", openTimeStr, closeTimeStr);
-      lastCheckedMinute = -1;
+    }
+
+    // Attempt to save new schedule entries
+    if (saveSchedule(tempEntries, count)) {
+      portENTER_CRITICAL(&scheduleLock);
+      memcpy(scheduleEntries, tempEntries, sizeof(ScheduleEntry) * count);
+      scheduleCount = count;
+      for (uint8_t i = 0; i < SCHEDULE_SLOTS; ++i) {
+        lastFiredDate[i] = -1;
+      }
+      portEXIT_CRITICAL(&scheduleLock);
+      LOG_INFO("Saved Schedule: %lld Entries\n", count);
+      scheduleDirty.store(true);
     } else {
-      Serial.print("ERROR: Failed to Save Schedule\n");
+      LOG_ERROR("Failed to Save Schedule\n");
       enterState(SystemState::ERROR);
     }
     // Redirect back to root page
     request->redirect("/");
   });
 
+  // Handle preset form submission
+  server.on("/setPresets", HTTP_GET, [](AsyncWebServerRequest *request) {
+    uint8_t tempPresets[PRESET_COUNT];
+    char name[4];
+
+    portENTER_CRITICAL(&scheduleLock);
+    memcpy(tempPresets, presets, sizeof(presets));
+    portEXIT_CRITICAL(&scheduleLock);
+    for (uint8_t i = 0; i < PRESET_COUNT; ++i) {
+      snprintf(name, sizeof(name), "p%u", i);
+      if (request->hasParam(name)) {
+        tempPresets[i] = constrain(request->getParam(name)->value().toInt(), 0, 100);
+      }
+    }
+    if (savePresets(tempPresets, PRESET_COUNT)) {
+      portENTER_CRITICAL(&scheduleLock);
+      memcpy(presets, tempPresets, sizeof(presets));
+      portEXIT_CRITICAL(&scheduleLock);
+    } else {
+      LOG_ERROR("Failed to Save Presets\n");
+    }
+    request->redirect("/");
+  });
+
+  // Handle vacation form submission
+  server.on("/setVacation", HTTP_GET, [](AsyncWebServerRequest *request) {
+    VacationConfig config;
+    portENTER_CRITICAL(&scheduleLock);
+    config = vacation;
+    portEXIT_CRITICAL(&scheduleLock);
+
+    config.enabled = request->hasParam("enabled");
+    config.partialMoves = request->hasParam("partial");
+    if (request->hasParam("offset")) {
+      config.maxOffset = constrain(request->getParam("offset")->value().toInt(), 0, VACATION_MAX_OFFSET);
+    }
+    if (request->hasParam("seed")) {
+      config.seed = strtoul(request->getParam("seed")->value().c_str(), nullptr, 10);
+    }
+
+    if (saveVacation(config)) {
+      portENTER_CRITICAL(&scheduleLock);
+      vacation = config;
+      portEXIT_CRITICAL(&scheduleLock);
+      LOG_INFO("Saved Vacation: %lld (Offset: %lld, Seed: %lld)\n", config.enabled, config.maxOffset, config.seed);
+      scheduleDirty.store(true);
+    } else {
+      LOG_ERROR("Failed to Save Vacation\n");
+    }
+    request->redirect("/");
+  });
+
+  // Handle location form submission
+  server.on("/setLocation", HTTP_GET, [](AsyncWebServerRequest *request) {
+    if (!request->hasParam("lat") || !request->hasParam("lon")) {
+      request->send(400, "text/plain", "Error 400: Missing lat/lon");
+      return;
+    }
+    // Convert decimal degrees to 1e-4 degrees
+    int32_t lat = lround(request->getParam("lat")->value().toDouble() * 10000.0);
+    int32_t lon = lround(request->getParam("lon")->value().toDouble() * 10000.0);
+    lat = constrain(lat, -900000, 900000);
+    lon = constrain(lon, -1800000, 1800000);
+
+    if (saveLocation(lat, lon)) {
+      portENTER_CRITICAL(&scheduleLock);
+      latitude = lat;
+      longitude = lon;
+      portEXIT_CRITICAL(&scheduleLock);
+      LOG_INFO("Saved Location: %lld, %lld\n", lat, lon);
+      locationChanged.store(true);
+      scheduleDirty.store(true);
+    } else {
+      LOG_ERROR("Failed to Save Location\n");
+    }
+    request->redirect("/");
+  });
+
+  // Prometheus metrics ("/metrics")
+  server.on("/metrics", HTTP_GET, handleMetricsRequest);
+
+  // Recent log entries ("/log")
+  server.on("/log", HTTP_GET, handleLogRequest);
+
+  // Task timing statistics ("/tasks")
+  server.on("/tasks", HTTP_GET, handleTasksRequest);
+
   // Handle not found
   server.onNotFound([](AsyncWebServerRequest *request){
+    metricIncrement(Counter::HTTP_NOT_FOUND);
     request->send(404, "text/plain", "Error 404: Not found");
   });
 }
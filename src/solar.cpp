@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "solar.h"
+
+// Binary angle (wraps naturally at 360 degrees)
+typedef uint32_t Angle;
+
+static constexpr int64_t Q30 = 1LL << 30;
+static constexpr int64_t SECONDS_PER_DAY = 86400;
+static constexpr int64_t J2000_UNIX = 946728000;    // 2000-01-01 12:00 UTC
+
+// Convert degrees to binary angle (compile time only)
+static constexpr Angle degrees(double deg) {
+  return (Angle)(int64_t)(deg * 4294967296.0 / 360.0 + (deg >= 0 ? 0.5 : -0.5));
+}
+
+// Convert degrees to fixed-point coefficient scaled by Q30 (compile time only)
+static constexpr int64_t q30(double value) {
+  return (int64_t)(value * Q30 + (value >= 0 ? 0.5 : -0.5));
+}
+
+// Algorithm constants
+static constexpr Angle MEAN_ANOMALY_J2000 = degrees(357.5291);
+static constexpr int64_t MEAN_ANOMALY_RATE = (int64_t)(0.98560028 / 86400.0 * 4294967296.0 / 360.0 * 65536.0 + 0.5);
+static constexpr Angle PERIHELION_OFFSET = degrees(180.0 + 102.9372);
+static constexpr Angle CENTER_1 = degrees(1.9148);
+static constexpr Angle CENTER_2 = degrees(0.0200);
+static constexpr Angle CENTER_3 = degrees(0.0003);
+static constexpr int64_t SIN_OBLIQUITY = q30(0.39777716);           // sin(23.4397 deg)
+static constexpr int64_t TRANSIT_ANOMALY = (int64_t)(0.0053 * 86400.0 * 65536.0 + 0.5);    // Seconds in Q16
+static constexpr int64_t TRANSIT_LONGITUDE = (int64_t)(0.0069 * 86400.0 * 65536.0 + 0.5);
+static constexpr Angle SUNRISE_ALTITUDE = degrees(-0.833);
+static constexpr Angle CIVIL_ALTITUDE = degrees(-6.0);
+
+// Sine of binary angle in Q30
+static int32_t sinQ30(Angle angle) {
+  // Fold into [-90, 90] degrees
+  int64_t x = (int32_t)angle;
+  if (x > (1LL << 30)) {
+    x = (1LL << 31) - x;
+  } else if (x < -(1LL << 30)) {
+    x = -(1LL << 31) - x;
+  }
+
+  // Radians in Q30 (x * pi / 2^31 scaled by 2^30)
+  int64_t r = (x * 3373259426LL) >> 31;
+  int64_t r2 = (r * r) >> 30;
+
+  // Taylor series to x^11 (Horner form)
+  int64_t term = Q30 - (r2 * q30(1.0 / 110.0) >> 30);
+  term = Q30 - ((r2 * term >> 30) * q30(1.0 / 72.0) >> 30);
+  term = Q30 - ((r2 * term >> 30) * q30(1.0 / 42.0) >> 30);
+  term = Q30 - ((r2 * term >> 30) * q30(1.0 / 20.0) >> 30);
+  term = Q30 - ((r2 * term >> 30) * q30(1.0 / 6.0) >> 30);
+  return (int32_t)((r * term) >> 30);
+}
+
+// Cosine of binary angle in Q30
+static int32_t cosQ30(Angle angle) {
+  return sinQ30(angle + 0x40000000);
+}
+
+// Integer square root of 64-bit value
+static uint32_t isqrt64(uint64_t value) {
+  uint64_t result = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= result + bit) {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)result;
+}
+
+// Arc cosine of Q30 value as binary angle in [0, 180] degrees
+static Angle acosAngle(int32_t value) {
+  Angle low = 0;
+  Angle high = 0x80000000;
+
+  // Bisection on monotonically decreasing cosine
+  for (int i = 0; i < 32 && high - low > 1; ++i) {
+    Angle mid = low + (high - low) / 2;
+    if (cosQ30(mid) > value) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+// Days since 1970-01-01 for a civil date
+static int64_t daysFromCivil(int year, int month, int day) {
+  year -= (month <= 2);
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int64_t yearOfEra = year - era * 400;
+  int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+// Get hour angle offset from transit (s) for a sun altitude, -1 if never reached
+static int64_t hourAngleSeconds(Angle altitude, int32_t sinLat, int32_t cosLat, int32_t sinDec, int32_t cosDec) {
+  int64_t numerator = (int64_t)sinQ30(altitude) - (((int64_t)sinLat * sinDec) >> 30);
+  int64_t denominator = ((int64_t)cosLat * cosDec) >> 30;
+
+  if (denominator <= 0) {
+    return -1;
+  }
+  int64_t cosHourAngle = (numerator << 30) / denominator;
+  if (cosHourAngle > Q30 || cosHourAngle < -Q30) {
+    return -1;
+  }
+  Angle hourAngle = acosAngle((int32_t)cosHourAngle);
+  return ((int64_t)hourAngle * SECONDS_PER_DAY) >> 32;
+}
+
+// Compute solar event times for a calendar date using fixed-point math
+SolarTimes computeSolarTimes(int year, int month, int day, int32_t latitude, int32_t longitude) {
+  SolarTimes times = {0, 0, 0, 0};
+
+  // Mean solar noon relative to J2000 (s), including 0.0008 day TT offset
+  int64_t dayNumber = daysFromCivil(year, month, day) - daysFromCivil(2000, 1, 1);
+  int64_t meanNoon = dayNumber * SECONDS_PER_DAY + 69 - (int64_t)longitude * SECONDS_PER_DAY / 3600000;
+
+  // Solar mean anomaly, equation of center, and ecliptic longitude
+  Angle meanAnomaly = MEAN_ANOMALY_J2000 + (Angle)((meanNoon * MEAN_ANOMALY_RATE) >> 16);
+  int64_t center = ((int64_t)CENTER_1 * sinQ30(meanAnomaly) + (int64_t)CENTER_2 * sinQ30(2 * meanAnomaly) +
+                    (int64_t)CENTER_3 * sinQ30(3 * meanAnomaly)) >> 30;
+  Angle eclipticLongitude = meanAnomaly + (Angle)(int32_t)center + PERIHELION_OFFSET;
+
+  // Solar transit (s since J2000)
+  int64_t transit = meanNoon + ((TRANSIT_ANOMALY * sinQ30(meanAnomaly) -
+                                 TRANSIT_LONGITUDE * sinQ30(2 * eclipticLongitude)) >> 46);
+
+  // Declination
+  int32_t sinDec = (int32_t)((sinQ30(eclipticLongitude) * SIN_OBLIQUITY) >> 30);
+  int32_t cosDec = (int32_t)isqrt64((uint64_t)(Q30 * Q30 - (int64_t)sinDec * sinDec));
+
+  // Latitude (1e-4 degrees to binary angle)
+  Angle lat = (Angle)(int32_t)((int64_t)latitude * 4294967296LL / 3600000);
+  int32_t sinLat = sinQ30(lat);
+  int32_t cosLat = cosQ30(lat);
+
+  int64_t riseOffset = hourAngleSeconds(SUNRISE_ALTITUDE, sinLat, cosLat, sinDec, cosDec);
+  if (riseOffset >= 0) {
+    times.sunrise = (time_t)(J2000_UNIX + transit - riseOffset);
+    times.sunset = (time_t)(J2000_UNIX + transit + riseOffset);
+  }
+  int64_t civilOffset = hourAngleSeconds(CIVIL_ALTITUDE, sinLat, cosLat, sinDec, cosDec);
+  if (civilOffset >= 0) {
+    times.dawn = (time_t)(J2000_UNIX + transit - civilOffset);
+    times.dusk = (time_t)(J2000_UNIX + transit + civilOffset);
+  }
+  return times;
+}
@@ -5,12 +5,19 @@
 
 #include "states.h"
 #include <Arduino.h>
+#include <array>
 #include <ESP32PCNTEncoder.h>
 #include "config.h"
+#include "clock.h"
 #include "memory.h"
 #include "buttons.h"
+#include "schedule.h"
+#include "network.h"
 #include "motor.h"
 #include "tof.h"
+#include "trace.h"
+#include "metrics.h"
+#include "log.h"
 
 // RGB LED color definitions
 #define RGB_RED 255, 0, 0
@@ -31,6 +38,29 @@ enum LEDStatus {
   STATUS_ERROR
 };
 
+// Transition action returning the state to enter (normally the table's next state)
+using Action = SystemState (*)(SystemState next);
+
+// Transition table entry
+struct Transition {
+  Action action;      // Event ignored when null
+  SystemState next;   // Default next state
+  bool consume;       // On state change, drop remaining HOLD/RELEASE events of buttons that are down
+};
+
+// Button gesture binding
+struct GestureBinding {
+  ButtonGesture gesture;
+  uint8_t buttons;        // Exact BTN_MASK_* bits of the gesture
+  uint8_t count;          // Taps for TAP, tier for LONG (ignored for CHORD)
+  StateEvent event;       // Dispatched through the transition table
+  uint8_t arg;            // Preset index for GESTURE_PRESET
+};
+
+static constexpr size_t NUM_STATES = (size_t)SystemState::ERROR + 1;
+static constexpr size_t NUM_EVENTS = (size_t)StateEvent::COUNT;
+using TransitionTable = std::array<std::array<Transition, NUM_EVENTS>, NUM_STATES>;
+
 // Get global encoder object from motor.h
 extern ESP32PCNTEncoder encoder;
 
@@ -46,25 +76,51 @@ static int64_t tempOpenPos = 0;
 static int64_t tempClosePos = 0;
 static unsigned long lastActivityTime = 0;
 
-// Button state variables
-static bool ignoreOpenRelease = false;
-static bool ignoreCloseRelease = false;
-static bool ignoreModeManualRelease = false;
-static bool ignoreModeConfigRelease = false;
-static bool ignoreModeExitRelease = false;
+// Move statistics variables
+static int64_t moveStartPos = 0;
+static unsigned long moveStartTime = 0;
+static unsigned long settleStartTime = 0;
+static bool settlePending = false;
+
+// Profiled (slow) move variables
+static bool profileActive = false;
+static int64_t profileStartPos = 0;
+static unsigned long profileStartTime = 0;
+static uint32_t profileDuration = 0;
+static int profileBoost = 0;
+static int64_t profileLastPos = 0;
+static unsigned long profileLastMoveTime = 0;
+static unsigned long profileBoostTime = 0;
+
+// Position requested by the last ToF hold gesture
+static uint8_t tofHoldPercent = 0;
+
+// Preset requested by the last button gesture
+static uint8_t gesturePreset = 0;
+
+// Last traced encoder position
+static int64_t tracedPos = 0;
+static unsigned long lastTraceTime = 0;
+
+// Motion lock (firmware update in progress)
+static bool motionLocked = false;
+
+// Buttons whose current press has been consumed by a transition (bit per button)
+static uint8_t consumedButtons = 0;
 
 // LED control variables
 static LEDStatus currentLEDStatus = STATUS_TOGGLE_IDLE;
 static unsigned long statusStartTime = 0;
 
 // Forward declarations
-static void startMovingTo(int64_t newTarget);
-static void handleToggleModeIdle();
-static void handleToggleModeMoving();
-static void handleManualMode();
-static void handleConfigSetting();
-static void handleConfigModeSaving();
+static void startMovingTo(int64_t newTarget, int speed = MOTOR_DEFAULT_SPEED);
+static void updateProfile();
+static bool isToggleState();
+static void handleButtonEvent(const ButtonEvent &buttonEvent);
+static void handleButtonGesture(const ButtonGestureEvent &gesture);
+static bool stateAccepts(SystemState state, StateEvent event);
 static void updateLedIndicator(SystemState systemState);
+static void recordMoveSettled();
 
 // Initialize state machine to initial values
 void setupStates() {
@@ -80,50 +136,91 @@ void setupStates() {
   Serial.printf("*Loaded Positions: Open = %lld, Close = %lld, Current = %lld\n", openPos, closePos, lastPos);
 }
 
-// Handle system state transitions and logic
-void updateStateMachine() {
-  // Fetch new button states
+// Fetch new button states and dispatch their events
+void updateButtonInput() {
   updateButtonStates();
+  ButtonEvent buttonEvent;
+  while (pollButtonEvent(buttonEvent)) {
+    // Drop button events while locked
+    if (!motionLocked) {
+      handleButtonEvent(buttonEvent);
+    }
+  }
+  // Gestures after the edges they complete
+  ButtonGestureEvent gesture;
+  while (pollButtonGesture(gesture)) {
+    if (!motionLocked) {
+      handleButtonGesture(gesture);
+    }
+  }
+}
 
-  // Execute state-specific logic
-  switch (currentState) {
-    case SystemState::TOGGLE_IDLE:
-      handleToggleModeIdle();
+// Dispatch ToF gestures, only polling in states that handle them
+void updateTofInput() {
+  // Stop ranging where gestures are ignored (and during moves if configured)
+  bool moving = currentState == SystemState::TOGGLE_OPEN || currentState == SystemState::TOGGLE_CLOSE;
+  bool suspend = motionLocked || !stateAccepts(currentState, StateEvent::TOF_TAP) || (TOF_SUSPEND_WHILE_MOVING && moving);
+  setTofSuspended(suspend);
+  // Keep polling while suspended so the sensors are stopped through the I2C task
+  uint8_t percent = 0;
+  switch (pollTofGesture(percent)) {
+    case TofGesture::TAP:
+      dispatchStateEvent(StateEvent::TOF_TAP);
       break;
-    case SystemState::TOGGLE_OPEN:
-    case SystemState::TOGGLE_CLOSE:
-      handleToggleModeMoving();
+    case TofGesture::APPROACH:
+      dispatchStateEvent(StateEvent::TOF_APPROACH);
       break;
-    case SystemState::MANUAL_IDLE:
-    case SystemState::MANUAL_MOVE:
-      handleManualMode();
+    case TofGesture::RETREAT:
+      dispatchStateEvent(StateEvent::TOF_RETREAT);
       break;
-    case SystemState::CONFIG_OPEN:
-    case SystemState::CONFIG_CLOSE:
-      handleConfigSetting();
-      break;
-    case SystemState::CONFIG_SAVE:
-      handleConfigModeSaving();
-      break;
-    case SystemState::ERROR:
+    case TofGesture::HOLD:
+      tofHoldPercent = percent;
+      dispatchStateEvent(StateEvent::TOF_HOLD);
       break;
     default:
-      Serial.printf("ERROR: Updated Invalid State: %d\n", (int)currentState);
-      enterState(SystemState::ERROR);
       break;
   }
+}
+
+// Handle periodic state logic
+void updateStateMachine() {
+  // Periodic checks (arrival, timeouts, saving)
+  dispatchStateEvent(StateEvent::TICK);
+
+  // Record final error once motor has settled after a move
+  if (settlePending && (clockMillis() - settleStartTime) >= MOVE_SETTLE_TIME) {
+    recordMoveSettled();
+  }
+  int64_t currentPos = encoder.getPosition();
+  metricSet(Gauge::POSITION, (int32_t)currentPos);
+
+  // Trace position changes at a limited rate
+  if (currentPos != tracedPos && (clockMillis() - lastTraceTime) >= TRACE_POSITION_INTERVAL) {
+    tracedPos = currentPos;
+    lastTraceTime = clockMillis();
+    traceRecord(TraceType::POSITION, (int32_t)currentPos);
+  }
+}
 
-  // Update LED based on current state after handling
+// Update LED animation for the current state
+void updateStatusLed() {
   updateLedIndicator(currentState);
 }
 
 // Transition to a new state and update LED
 void enterState(SystemState newState) {
   if (newState != currentState) {
-    Serial.printf("State Change: %d -> %d\n", (int)currentState, (int)newState);
+    LOG_INFO("State Change: %lld -> %lld\n", (int)currentState, (int)newState);
     previousState = currentState;
     currentState = newState;
-    lastActivityTime = millis();
+    lastActivityTime = clockMillis();
+    metricIncrement(Counter::STATE_TRANSITIONS);
+    metricSet(Gauge::STATE, (int32_t)newState);
+    traceRecord(TraceType::STATE, (int32_t)newState);
+    // Profiled moves only run while moving in toggle mode
+    if (newState != SystemState::TOGGLE_OPEN && newState != SystemState::TOGGLE_CLOSE) {
+      profileActive = false;
+    }
 
     // Execute state-specific logic
     switch (newState) {
@@ -139,15 +236,13 @@ void enterState(SystemState newState) {
         break;
       case SystemState::CONFIG_OPEN:
         motorStop();
-        Serial.print("Set OPEN Limit\n");
+        LOG_INFO("Set OPEN Limit\n");
         tempOpenPos = 0;
         tempClosePos = 0;
-        ignoreModeConfigRelease = true;
-        ignoreModeExitRelease = false;
         break;
       case SystemState::CONFIG_CLOSE:
         motorStop();
-        Serial.print("Set CLOSE Limit\n");
+        LOG_INFO("Set CLOSE Limit\n");
         break;
       case SystemState::CONFIG_SAVE:
         motorStop();
@@ -157,7 +252,7 @@ void enterState(SystemState newState) {
         break;
       default:
         motorStop();
-        Serial.printf("ERROR: Entered Invalid State: %d\n", (int)newState);
+        LOG_ERROR("Entered Invalid State: %lld\n", (int)newState);
         enterState(SystemState::ERROR);
         break;
     }
@@ -181,16 +276,115 @@ void triggerClose() {
   }
 }
 
+// Convert percent open (0-100) to encoder position
+static int64_t percentToPosition(int percent) {
+  percent = constrain(percent, 0, 100);
+  return closePos + (openPos - closePos) * percent / 100;
+}
+
+// Check if the state machine accepts remote position commands
+static bool isToggleState() {
+  return currentState == SystemState::TOGGLE_IDLE || currentState == SystemState::TOGGLE_OPEN ||
+         currentState == SystemState::TOGGLE_CLOSE;
+}
+
+// Move to percent open from external trigger (retargets an active move)
+void triggerMoveTo(uint8_t percent) {
+  // Ignore until limits are configured
+  if (!isToggleState() || openPos == closePos) {
+    return;
+  }
+  startMovingTo(percentToPosition(percent));
+}
+
+// Open slowly over a duration from external trigger
+void triggerWake(uint32_t duration) {
+  if (currentState != SystemState::TOGGLE_IDLE || openPos == closePos) {
+    return;
+  }
+  // Start stopped and let the profile drive the motor
+  startMovingTo(openPos, 0);
+  if (currentState != SystemState::TOGGLE_OPEN) {
+    return;
+  }
+  LOG_INFO("Wake Open over %lld s\n", duration / 1000);
+  profileActive = true;
+  profileStartPos = encoder.getPosition();
+  profileStartTime = clockMillis();
+  profileDuration = max(duration, (uint32_t)1);
+  profileBoost = 0;
+  profileLastPos = profileStartPos;
+  profileLastMoveTime = profileStartTime;
+  profileBoostTime = profileStartTime;
+}
+
+// Move relative to the current target by percent from external trigger
+void triggerNudge(int8_t percent) {
+  if (!isToggleState() || openPos == closePos) {
+    return;
+  }
+  // Nudge from target while moving, otherwise from current position
+  int64_t basePos = (currentState == SystemState::TOGGLE_IDLE) ? encoder.getPosition() : targetPos;
+  int basePercent = (int)((basePos - closePos) * 100 / (openPos - closePos));
+  startMovingTo(percentToPosition(basePercent + percent));
+}
+
+// Stop active movement from external trigger
+void triggerStop() {
+  if (currentState == SystemState::TOGGLE_OPEN || currentState == SystemState::TOGGLE_CLOSE) {
+    metricIncrement(Counter::MOVES_INTERRUPTED);
+    enterState(SystemState::TOGGLE_IDLE);
+  }
+}
+
+// Stop any movement and hold until unlocked
+void setMotionLock(bool locked) {
+  if (locked == motionLocked) {
+    return;
+  }
+  motionLocked = locked;
+  if (locked) {
+    LOG_INFO("Motion Locked\n");
+    // Leaving any mode stops the motor and saves the position
+    if (currentState != SystemState::ERROR) {
+      enterState(SystemState::TOGGLE_IDLE);
+    }
+    motorStop();
+  } else {
+    LOG_INFO("Motion Unlocked\n");
+  }
+}
+
+// Get current system state
+SystemState getState() {
+  return currentState;
+}
+
+// Get current position as percent open (0-100)
+uint8_t getPositionPercent() {
+  if (openPos == closePos) {
+    return 0;
+  }
+  int64_t percent = (encoder.getPosition() - closePos) * 100 / (openPos - closePos);
+  return (uint8_t)constrain(percent, (int64_t)0, (int64_t)100);
+}
+
 // Move motor to new target position
-static void startMovingTo(int64_t newTarget) {
+static void startMovingTo(int64_t newTarget, int speed) {
+  if (motionLocked) {
+    return;
+  }
   int64_t currentPos = encoder.getPosition();
   int motorSpeed = 0;
   SystemState nextState = currentState;
   targetPos = newTarget;
+  // Any new move cancels a running profile
+  profileActive = false;
 
   // Check if already at target
   if (abs(currentPos - targetPos) <= POS_TOLERANCE) {
-    Serial.print("Already at Target Position\n");
+    LOG_INFO("Already at Target Position\n");
+    metricIncrement(Counter::MOVES_COMPLETED);
     if (currentState == SystemState::TOGGLE_OPEN || currentState == SystemState::TOGGLE_CLOSE) {
       enterState(SystemState::TOGGLE_IDLE);
     }
@@ -198,251 +392,424 @@ static void startMovingTo(int64_t newTarget) {
   }
 
   // Determine motor direction
-  motorSpeed = (targetPos > currentPos) ? MOTOR_DEFAULT_SPEED : -MOTOR_DEFAULT_SPEED;
+  motorSpeed = (targetPos > currentPos) ? speed : -speed;
 
   // Determine next state based on target position
-  if (currentState == SystemState::TOGGLE_IDLE) {
+  if (isToggleState()) {
     if (newTarget == openPos) {
       nextState = SystemState::TOGGLE_OPEN;
     } else if (newTarget == closePos) {
       nextState = SystemState::TOGGLE_CLOSE;
     } else {
-      Serial.printf("ERROR: Attempted Move with Invalid Target: %lld\n", newTarget);
-      enterState(SystemState::ERROR);
-      return;
+      // Intermediate target uses the state of the limit in the direction of travel
+      bool towardOpen = (targetPos > currentPos) == (openPos > closePos);
+      nextState = towardOpen ? SystemState::TOGGLE_OPEN : SystemState::TOGGLE_CLOSE;
     }
   } else {
-    Serial.printf("ERROR: Attempted Move from Unexpected State: %d\n", (int)currentState);
+    LOG_ERROR("Attempted Move from Unexpected State: %lld\n", (int)currentState);
     enterState(SystemState::ERROR);
+    return;
+  }
+
+  // Start move statistics when leaving idle (a move still settling records its error now)
+  if (currentState == SystemState::TOGGLE_IDLE) {
+    if (settlePending) {
+      recordMoveSettled();
+    }
+    moveStartPos = currentPos;
+    moveStartTime = clockMillis();
   }
 
   // Move motor
-  Serial.printf("Moving to %lld (Current: %lld)\n", targetPos, currentPos);
+  LOG_INFO("Moving to %lld (Current: %lld)\n", targetPos, currentPos);
   motorMove(motorSpeed);
   if (nextState != currentState) {
     enterState(nextState);
   }
-  lastActivityTime = millis();
+  lastActivityTime = clockMillis();
 }
 
-// Handle motor movement for Manual/Config mode
-static bool handleMotorMovement(int speed) {
-  unsigned long currentTime = millis();
-  bool openHeld = isButtonHeld(PIN_BTN_OPEN);
-  bool closeHeld = isButtonHeld(PIN_BTN_CLOSE);
-  bool moving = false;
+// Track a linear position ramp at low speed (runs every tick of a profiled move)
+static void updateProfile() {
+  unsigned long currentTime = clockMillis();
+  int64_t currentPos = encoder.getPosition();
+  int64_t direction = (targetPos >= profileStartPos) ? 1 : -1;
 
-  // Postive direction
-  if (openHeld && !closeHeld) {
-    motorMove(speed);
-    lastActivityTime = currentTime;
-    moving = true;
-  }
-  // Negative direction
-  else if (closeHeld && !openHeld) {
-    motorMove(-speed);
-    lastActivityTime = currentTime;
-    moving = true;
-  }
-  // Stop movement
-  else {
+  // Setpoint moves linearly from start to target over the duration
+  uint32_t elapsed = min((uint32_t)(currentTime - profileStartTime), profileDuration);
+  int64_t setpoint = profileStartPos + (targetPos - profileStartPos) * elapsed / profileDuration;
+  int64_t lag = (setpoint - currentPos) * direction;
+
+  // Hold position while ahead of the ramp
+  if (lag <= 0) {
     motorStop();
-    if (isButtonPressed(PIN_BTN_OPEN) || isButtonReleased(PIN_BTN_OPEN) || isButtonPressed(PIN_BTN_CLOSE) ||
-        isButtonReleased(PIN_BTN_CLOSE)) {
-      lastActivityTime = currentTime;
+    profileLastMoveTime = currentTime;
+    return;
+  }
+
+  // Raise breakaway boost while commanded but stalled, let it decay again once turning
+  if (currentPos != profileLastPos) {
+    profileLastPos = currentPos;
+    profileLastMoveTime = currentTime;
+    if (currentTime - profileBoostTime >= WAKE_STALL_TIME) {
+      profileBoost = max(profileBoost - WAKE_KICK_STEP, 0);
+      profileBoostTime = currentTime;
     }
-    moving = false;
+  } else if (currentTime - profileLastMoveTime >= WAKE_STALL_TIME) {
+    profileBoost = min(profileBoost + WAKE_KICK_STEP, MOTOR_DEFAULT_SPEED - WAKE_MIN_SPEED);
+    profileLastMoveTime = currentTime;
+    profileBoostTime = currentTime;
   }
 
-  return moving;
+  // Proportional speed on lag above the stall threshold
+  int speed = WAKE_MIN_SPEED + profileBoost + (int)min(lag / WAKE_LAG_PER_STEP, (int64_t)MOTOR_DEFAULT_SPEED);
+  motorMove((int)direction * min(speed, MOTOR_DEFAULT_SPEED));
 }
 
-// Handle logic for TOGGLE_IDLE state
-static void handleToggleModeIdle() {
-  bool modeHandled = false;
+// Get motor direction from held Open/Close buttons (0 if none or both)
+static int jogDirection() {
+  bool openHeld = buttonsHeld() & BTN_MASK_OPEN;
+  bool closeHeld = buttonsHeld() & BTN_MASK_CLOSE;
 
-  // Ignore lingering inputs
-  if (ignoreModeExitRelease) {
-    modeHandled = true;
-    if (!isButtonPressed(PIN_BTN_MODE) && !isButtonHeld(PIN_BTN_MODE) && !isButtonReleased(PIN_BTN_MODE)) {
-        ignoreModeExitRelease = false;
-    }
+  if (openHeld == closeHeld) {
+    return 0;
   }
+  return openHeld ? 1 : -1;
+}
 
-  // Check for mode change
-  if (!modeHandled) {
-    if (isButtonHeld(PIN_BTN_MODE)) {
-      enterState(SystemState::CONFIG_OPEN);
-      return;
-    }
-    if (isButtonReleased(PIN_BTN_MODE)) {
-      ignoreOpenRelease = false;
-      ignoreCloseRelease = false;
-      enterState(SystemState::MANUAL_IDLE);
-      return;
-    }
-  }
+// Action: take transition without side effects
+static SystemState actGo(SystemState next) {
+  return next;
+}
 
-  // Check for open button release
-  if (isButtonReleased(PIN_BTN_OPEN)) {
-    if (!ignoreOpenRelease) {
-      ignoreCloseRelease = false;
+// Action: move to open position
+static SystemState actMoveOpen(SystemState next) {
+  startMovingTo(openPos);
+  return currentState;
+}
+
+// Action: move to close position
+static SystemState actMoveClose(SystemState next) {
+  startMovingTo(closePos);
+  return currentState;
+}
+
+// Action: toggle position on ToF trigger
+static SystemState actTofToggle(SystemState next) {
+  // Check if movement was interrupted and move to opposite position
+  if (previousState == SystemState::TOGGLE_OPEN) {
+    startMovingTo(closePos);
+  } else if (previousState == SystemState::TOGGLE_CLOSE) {
+    startMovingTo(openPos);
+  } else {
+    int64_t currentPos = encoder.getPosition();
+    if (abs(currentPos - openPos) < abs(currentPos - closePos)) {
+      startMovingTo(closePos);
+    } else {
       startMovingTo(openPos);
-      return;
     }
-    ignoreOpenRelease = false;
   }
+  return currentState;
+}
 
-  // Check for close button release
-  if (isButtonReleased(PIN_BTN_CLOSE)) {
-    if (!ignoreCloseRelease) {
-      ignoreOpenRelease = false;
-      startMovingTo(closePos);
-      return;
-    }
-    ignoreCloseRelease = false;
+// Action: move to position of held hand
+static SystemState actTofHold(SystemState next) {
+  // Ignore until limits are configured
+  if (openPos != closePos) {
+    startMovingTo(percentToPosition(tofHoldPercent));
   }
+  return currentState;
+}
 
-  // Check for ToF trigger
-  if (isTofTriggered()) {
-    // Check if movement was interrupted and move to opposite position
-    if (previousState == SystemState::TOGGLE_OPEN) {
-      startMovingTo(closePos);
-    } else if (previousState == SystemState::TOGGLE_CLOSE) {
-      startMovingTo(openPos);
-    } else {
-      int64_t currentPos = encoder.getPosition();
-      if (abs(currentPos - openPos) < abs(currentPos - closePos)) {
-        startMovingTo(closePos);
-      } else {
-        startMovingTo(openPos);
-      }
-    }
+// Action: move to the preset of the last button gesture
+static SystemState actPreset(SystemState next) {
+  uint8_t percent = 0;
+  // Ignore until limits are configured
+  if (openPos != closePos && getPresetPercent(gesturePreset, percent)) {
+    startMovingTo(percentToPosition(percent));
   }
+  return currentState;
+}
+
+// Action: interrupt toggle movement
+static SystemState actInterrupt(SystemState next) {
+  metricIncrement(Counter::MOVES_INTERRUPTED);
+  return next;
+}
+
+// Action: save position and restart into the provisioning portal
+static SystemState actProvision(SystemState next) {
+  motorStop();
+  saveLastPosition(encoder.getPosition());
+  restartIntoProvisioning();
+  return currentState;
 }
 
-// Handle logic for TOGGLE_OPEN/TOGGLE_CLOSE states
-static void handleToggleModeMoving() {
+// Action: stop toggle movement once target is reached
+static SystemState actCheckArrival(SystemState next) {
+  if (profileActive) {
+    updateProfile();
+  }
   int64_t currentPos = encoder.getPosition();
-  bool toggle = false;
-  bool manual = false;
 
-  // Check if already at target
-  if (abs(currentPos - targetPos) <= POS_TOLERANCE) {
-    Serial.printf("Moved to %lld  (Current: %lld)\n", targetPos, currentPos);
-    enterState(SystemState::TOGGLE_IDLE);
-    return;
+  if (abs(currentPos - targetPos) > POS_TOLERANCE) {
+    return currentState;
   }
+  LOG_INFO("Moved to %lld (Current: %lld)\n", targetPos, currentPos);
+  metricIncrement(Counter::MOVES_COMPLETED);
+  metricObserve(Histogram::MOVE_DURATION_MS, clockMillis() - moveStartTime);
+  // Measure final error after braking
+  settleStartTime = clockMillis();
+  settlePending = true;
+  return next;
+}
 
-  // Check for interruption by mode button
-  if (isButtonPressed(PIN_BTN_MODE)) {
-    ignoreModeManualRelease = true;
-    manual = true;
+// Action: jog motor with held buttons in Manual mode
+static SystemState actJogManual(SystemState next) {
+  int direction = jogDirection();
+
+  lastActivityTime = clockMillis();
+  if (direction == 0) {
+    motorStop();
+    return SystemState::MANUAL_IDLE;
   }
-  // Check for interruption by opposite button
-  else if (currentState == SystemState::TOGGLE_OPEN && isButtonPressed(PIN_BTN_CLOSE)) {
-    ignoreCloseRelease = true;
-    toggle = true;
-  } else if (currentState == SystemState::TOGGLE_CLOSE && isButtonPressed(PIN_BTN_OPEN)) {
-    ignoreOpenRelease = true;
-    toggle = true;
+  motorMove(direction * MOTOR_DEFAULT_SPEED);
+  return SystemState::MANUAL_MOVE;
+}
+
+// Action: jog motor with held buttons in Config mode
+static SystemState actJogConfig(SystemState next) {
+  int direction = jogDirection();
+
+  lastActivityTime = clockMillis();
+  if (direction == 0) {
+    motorStop();
+  } else {
+    motorMove(direction * MOTOR_CONFIG_SPEED);
   }
-  // Check for ToF trigger interruption
-  else if (isTofTriggered()) {
-    toggle = true;
+  return currentState;
+}
+
+// Action: leave Manual mode after inactivity
+static SystemState actManualTimeout(SystemState next) {
+  return ((clockMillis() - lastActivityTime) > MANUAL_TIMEOUT) ? next : currentState;
+}
+
+// Action: leave Config mode after inactivity
+static SystemState actConfigTimeout(SystemState next) {
+  // Holding a jog button counts as activity
+  if (buttonsDown() & (BTN_MASK_OPEN | BTN_MASK_CLOSE)) {
+    lastActivityTime = clockMillis();
   }
+  return ((clockMillis() - lastActivityTime) > CONFIG_TIMEOUT) ? next : currentState;
+}
 
-  if (toggle) {
-    ignoreModeManualRelease = false;
-    enterState(SystemState::TOGGLE_IDLE);
-  } else if (manual) {
-    ignoreOpenRelease = false;
-    ignoreCloseRelease = false;
-    enterState(SystemState::MANUAL_IDLE);
+// Action: store open limit
+static SystemState actSetOpenLimit(SystemState next) {
+  tempOpenPos = encoder.getPosition();
+  return next;
+}
+
+// Action: store close limit
+static SystemState actSetCloseLimit(SystemState next) {
+  tempClosePos = encoder.getPosition();
+  return next;
+}
+
+// Action: save limits to memory
+static SystemState actSaveLimits(SystemState next) {
+  if (!savePositions(tempOpenPos, tempClosePos)) {
+    LOG_ERROR("Failed to Save Positions\n");
+    return SystemState::ERROR;
   }
+  openPos = tempOpenPos;
+  closePos = tempClosePos;
+  LOG_INFO("Saved Positions: Open = %lld, Close = %lld\n", openPos, closePos);
+  return next;
 }
 
-// Handle logic for MANUAL_IDLE/MANUAL_MOVE states
-static void handleManualMode() {
-  // Check for mode change
-  if (isButtonReleased(PIN_BTN_MODE)) {
-    if (!ignoreModeManualRelease) {
-      enterState(SystemState::TOGGLE_IDLE);
-      return;
+// Build state x event transition table (unlisted pairs are ignored)
+static constexpr TransitionTable buildTransitionTable() {
+  TransitionTable table{};
+  auto on = [&table](SystemState state, StateEvent event, Action action, SystemState next, bool consume = false) {
+    table[(size_t)state][(size_t)event] = {action, next, consume};
+  };
+  // Add the same transition to every Open/Close button event
+  auto onJog = [&on](SystemState state, Action action) {
+    for (StateEvent event : {StateEvent::OPEN_PRESS, StateEvent::OPEN_HOLD, StateEvent::OPEN_RELEASE, StateEvent::CLOSE_PRESS,
+                        StateEvent::CLOSE_HOLD, StateEvent::CLOSE_RELEASE}) {
+      on(state, event, action, state);
     }
-    ignoreModeManualRelease = false;
+  };
+
+  // Toggle mode (single presses act once a multi-tap is ruled out)
+  on(SystemState::TOGGLE_IDLE, StateEvent::OPEN_CLICK, actMoveOpen, SystemState::TOGGLE_OPEN);
+  on(SystemState::TOGGLE_IDLE, StateEvent::CLOSE_CLICK, actMoveClose, SystemState::TOGGLE_CLOSE);
+  on(SystemState::TOGGLE_IDLE, StateEvent::GESTURE_PRESET, actPreset, SystemState::TOGGLE_IDLE);
+  on(SystemState::TOGGLE_IDLE, StateEvent::GESTURE_CALIBRATE, actGo, SystemState::CONFIG_OPEN, true);
+  on(SystemState::TOGGLE_IDLE, StateEvent::MODE_RELEASE, actGo, SystemState::MANUAL_IDLE);
+  on(SystemState::TOGGLE_IDLE, StateEvent::MODE_HOLD, actGo, SystemState::CONFIG_OPEN, true);
+  on(SystemState::TOGGLE_IDLE, StateEvent::TOF_TAP, actTofToggle, SystemState::TOGGLE_IDLE);
+  on(SystemState::TOGGLE_IDLE, StateEvent::TOF_APPROACH, actMoveOpen, SystemState::TOGGLE_OPEN);
+  on(SystemState::TOGGLE_IDLE, StateEvent::TOF_RETREAT, actMoveClose, SystemState::TOGGLE_CLOSE);
+  on(SystemState::TOGGLE_IDLE, StateEvent::TOF_HOLD, actTofHold, SystemState::TOGGLE_IDLE);
+
+  on(SystemState::TOGGLE_OPEN, StateEvent::CLOSE_PRESS, actInterrupt, SystemState::TOGGLE_IDLE, true);
+  on(SystemState::TOGGLE_OPEN, StateEvent::MODE_PRESS, actInterrupt, SystemState::MANUAL_IDLE, true);
+  on(SystemState::TOGGLE_OPEN, StateEvent::TOF_TAP, actInterrupt, SystemState::TOGGLE_IDLE);
+  on(SystemState::TOGGLE_OPEN, StateEvent::TOF_APPROACH, actMoveOpen, SystemState::TOGGLE_OPEN);
+  on(SystemState::TOGGLE_OPEN, StateEvent::TOF_RETREAT, actMoveClose, SystemState::TOGGLE_CLOSE);
+  on(SystemState::TOGGLE_OPEN, StateEvent::TOF_HOLD, actTofHold, SystemState::TOGGLE_OPEN);
+  on(SystemState::TOGGLE_OPEN, StateEvent::GESTURE_STOP, actInterrupt, SystemState::TOGGLE_IDLE, true);
+  on(SystemState::TOGGLE_OPEN, StateEvent::GESTURE_PRESET, actPreset, SystemState::TOGGLE_OPEN);
+  on(SystemState::TOGGLE_OPEN, StateEvent::GESTURE_CALIBRATE, actInterrupt, SystemState::CONFIG_OPEN, true);
+  on(SystemState::TOGGLE_OPEN, StateEvent::TICK, actCheckArrival, SystemState::TOGGLE_IDLE);
+
+  on(SystemState::TOGGLE_CLOSE, StateEvent::OPEN_PRESS, actInterrupt, SystemState::TOGGLE_IDLE, true);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::MODE_PRESS, actInterrupt, SystemState::MANUAL_IDLE, true);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::TOF_TAP, actInterrupt, SystemState::TOGGLE_IDLE);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::TOF_APPROACH, actMoveOpen, SystemState::TOGGLE_OPEN);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::TOF_RETREAT, actMoveClose, SystemState::TOGGLE_CLOSE);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::TOF_HOLD, actTofHold, SystemState::TOGGLE_CLOSE);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::GESTURE_STOP, actInterrupt, SystemState::TOGGLE_IDLE, true);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::GESTURE_PRESET, actPreset, SystemState::TOGGLE_CLOSE);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::GESTURE_CALIBRATE, actInterrupt, SystemState::CONFIG_OPEN, true);
+  on(SystemState::TOGGLE_CLOSE, StateEvent::TICK, actCheckArrival, SystemState::TOGGLE_IDLE);
+
+  // Manual mode
+  onJog(SystemState::MANUAL_IDLE, actJogManual);
+  on(SystemState::MANUAL_IDLE, StateEvent::MODE_RELEASE, actGo, SystemState::TOGGLE_IDLE);
+  on(SystemState::MANUAL_IDLE, StateEvent::GESTURE_CALIBRATE, actGo, SystemState::CONFIG_OPEN, true);
+  on(SystemState::MANUAL_IDLE, StateEvent::TICK, actManualTimeout, SystemState::TOGGLE_IDLE, true);
+
+  onJog(SystemState::MANUAL_MOVE, actJogManual);
+  on(SystemState::MANUAL_MOVE, StateEvent::MODE_RELEASE, actGo, SystemState::TOGGLE_IDLE);
+
+  // Config mode
+  onJog(SystemState::CONFIG_OPEN, actJogConfig);
+  on(SystemState::CONFIG_OPEN, StateEvent::MODE_RELEASE, actSetOpenLimit, SystemState::CONFIG_CLOSE);
+  on(SystemState::CONFIG_OPEN, StateEvent::MODE_HOLD, actGo, SystemState::TOGGLE_IDLE, true);
+  on(SystemState::CONFIG_OPEN, StateEvent::TICK, actConfigTimeout, SystemState::TOGGLE_IDLE, true);
+
+  onJog(SystemState::CONFIG_CLOSE, actJogConfig);
+  on(SystemState::CONFIG_CLOSE, StateEvent::MODE_RELEASE, actSetCloseLimit, SystemState::CONFIG_SAVE);
+  on(SystemState::CONFIG_CLOSE, StateEvent::MODE_HOLD, actGo, SystemState::TOGGLE_IDLE, true);
+  on(SystemState::CONFIG_CLOSE, StateEvent::TICK, actConfigTimeout, SystemState::TOGGLE_IDLE, true);
+
+  on(SystemState::CONFIG_SAVE, StateEvent::TICK, actSaveLimits, SystemState::TOGGLE_IDLE);
+
+  // Provisioning is reachable from every state, ERROR ignores all other events
+  for (size_t state = 0; state < NUM_STATES; ++state) {
+    on((SystemState)state, StateEvent::GESTURE_PROVISION, actProvision, (SystemState)state);
   }
+  return table;
+}
 
-  // Check for Idle state timeout
-  if (currentState == SystemState::MANUAL_IDLE && (millis() - lastActivityTime) > MANUAL_TIMEOUT) {
-    ignoreModeManualRelease = false;
-    enterState(SystemState::TOGGLE_IDLE);
+static constexpr TransitionTable transitionTable = buildTransitionTable();
+
+// Button gesture bindings (unbound gestures are ignored)
+static constexpr GestureBinding gestureBindings[] = {
+  {ButtonGesture::TAP, BTN_MASK_OPEN, 1, StateEvent::OPEN_CLICK, 0},
+  {ButtonGesture::LONG, BTN_MASK_OPEN, 0, StateEvent::OPEN_CLICK, 0},
+  {ButtonGesture::LONG, BTN_MASK_OPEN, 1, StateEvent::OPEN_CLICK, 0},
+  {ButtonGesture::LONG, BTN_MASK_OPEN, 2, StateEvent::OPEN_CLICK, 0},
+  {ButtonGesture::TAP, BTN_MASK_CLOSE, 1, StateEvent::CLOSE_CLICK, 0},
+  {ButtonGesture::LONG, BTN_MASK_CLOSE, 0, StateEvent::CLOSE_CLICK, 0},
+  {ButtonGesture::LONG, BTN_MASK_CLOSE, 1, StateEvent::CLOSE_CLICK, 0},
+  {ButtonGesture::LONG, BTN_MASK_CLOSE, 2, StateEvent::CLOSE_CLICK, 0},
+  {ButtonGesture::CHORD, BTN_MASK_OPEN | BTN_MASK_CLOSE, 0, StateEvent::GESTURE_STOP, 0},
+  {ButtonGesture::TAP, BTN_MASK_OPEN, 2, StateEvent::GESTURE_PRESET, 0},
+  {ButtonGesture::TAP, BTN_MASK_CLOSE, 2, StateEvent::GESTURE_PRESET, 1},
+  {ButtonGesture::TAP, BTN_MASK_OPEN, 3, StateEvent::GESTURE_PRESET, 2},
+  {ButtonGesture::TAP, BTN_MASK_CLOSE, 3, StateEvent::GESTURE_PRESET, 3},
+  {ButtonGesture::CHORD, BTN_MASK_CLOSE | BTN_MASK_MODE, 0, StateEvent::GESTURE_CALIBRATE, 0},
+  {ButtonGesture::LONG, BTN_MASK_MODE, 2, StateEvent::GESTURE_PROVISION, 0},
+};
+
+// Check if state has a transition for event
+static bool stateAccepts(SystemState state, StateEvent event) {
+  return transitionTable[(size_t)state][(size_t)event].action != nullptr;
+}
+
+// Look up and execute transition for event in current state
+void dispatchStateEvent(StateEvent event) {
+  if ((size_t)currentState >= NUM_STATES) {
+    LOG_ERROR("Updated Invalid State: %lld\n", (int)currentState);
+    enterState(SystemState::ERROR);
     return;
   }
 
-  // Handle motor movement
-  if (handleMotorMovement(MOTOR_DEFAULT_SPEED)) {
-    if (currentState == SystemState::MANUAL_IDLE) {
-      enterState(SystemState::MANUAL_MOVE);
-    }
-  } else {
-    if (currentState == SystemState::MANUAL_MOVE) {
-      enterState(SystemState::MANUAL_IDLE);
-    }
+  const Transition &transition = transitionTable[(size_t)currentState][(size_t)event];
+  if (transition.action == nullptr) {
+    return;
   }
+
+  SystemState fromState = currentState;
+  SystemState nextState = transition.action(transition.next);
+  if (transition.consume && nextState != fromState) {
+    // The press is spent: drop its remaining edges and the taps it would have counted
+    consumedButtons |= buttonsDown();
+    cancelButtonGestures(buttonsDown());
+  }
+  enterState(nextState);
 }
 
-// Handle logic for CONFIG_OPEN/CONFIG_CLOSE states
-static void handleConfigSetting() {
-  // Hold mode to cancel config
-  if (isButtonHeld(PIN_BTN_MODE)) {
-    if (!ignoreModeConfigRelease) {
-      ignoreModeExitRelease = true;
-      enterState(SystemState::TOGGLE_IDLE);
+// Map button event to state machine event, dropping consumed presses
+static void handleButtonEvent(const ButtonEvent &buttonEvent) {
+  uint8_t button = 0;
+
+  switch (buttonEvent.pin) {
+    case PIN_BTN_OPEN:
+      button = 0;
+      break;
+    case PIN_BTN_CLOSE:
+      button = 1;
+      break;
+    case PIN_BTN_MODE:
+      button = 2;
+      break;
+    default:
       return;
-    }
   }
 
-  // Check for Config mode timeout
-  if ((millis() - lastActivityTime) > CONFIG_TIMEOUT) {
-    ignoreModeConfigRelease = false;
-    ignoreModeExitRelease = true;
-    enterState(SystemState::TOGGLE_IDLE);
+  // A new press clears consumption, later edges of a consumed press are dropped
+  uint8_t buttonMask = 1 << button;
+  if (buttonEvent.edge == ButtonEdge::PRESS) {
+    consumedButtons &= ~buttonMask;
+  } else if (consumedButtons & buttonMask) {
     return;
   }
 
-  // Move motor
-  handleMotorMovement(MOTOR_CONFIG_SPEED);
+  dispatchStateEvent((StateEvent)(button * 3 + (uint8_t)buttonEvent.edge));
+}
 
-  // Check for state change
-  if (isButtonReleased(PIN_BTN_MODE)) {
-    // Ignore first mode button release
-    if (ignoreModeConfigRelease) {
-      ignoreModeConfigRelease = false;
-      return;
-    }
-    if (currentState == SystemState::CONFIG_OPEN) {
-      tempOpenPos = encoder.getPosition();
-      enterState(SystemState::CONFIG_CLOSE);
-    } else {
-      tempClosePos = encoder.getPosition();
-      enterState(SystemState::CONFIG_SAVE);
+// Dispatch the state event bound to a button gesture
+static void handleButtonGesture(const ButtonGestureEvent &gesture) {
+  for (const GestureBinding &binding : gestureBindings) {
+    if (binding.gesture != gesture.gesture || binding.buttons != gesture.buttons ||
+        (gesture.gesture != ButtonGesture::CHORD && binding.count != gesture.count)) {
+      continue;
     }
+    LOG_INFO("Button Gesture: %lld (Buttons: %lld, Count: %lld)\n", (int)gesture.gesture, gesture.buttons,
+             gesture.count);
+    // Remaining edges of buttons still down belong to the gesture (taps end with the buttons up)
+    consumedButtons |= gesture.buttons & buttonsDown();
+    gesturePreset = binding.arg;
+    dispatchStateEvent(binding.event);
     return;
   }
 }
 
-// Handle logic for CONFIG_SAVE state
-static void handleConfigModeSaving() {
-  if (savePositions(tempOpenPos, tempClosePos)) {
-    openPos = tempOpenPos;
-    closePos = tempClosePos;
-    Serial.printf("Saved Positions: Open = %lld, Close = %lld\n", openPos, closePos);
-    ignoreModeExitRelease = true;
-    enterState(SystemState::TOGGLE_IDLE);
-  } else {
-    Serial.print("ERROR: Failed to Save Positions\n");
-    enterState(SystemState::ERROR);
+// Record settled position error of the last completed move
+static void recordMoveSettled() {
+  int64_t error = encoder.getPosition() - targetPos;
+  int64_t direction = (targetPos >= moveStartPos) ? 1 : -1;
+  settlePending = false;
+
+  metricObserve(Histogram::MOVE_ERROR, (uint32_t)abs(error));
+  // Overshoot if stopped past target in the direction of travel
+  if (error * direction > POS_TOLERANCE) {
+    metricIncrement(Counter::MOVE_OVERSHOOTS);
   }
 }
 
@@ -472,7 +839,7 @@ static LEDStatus setLEDState(SystemState state) {
 
 // Handle LED indicator logic
 static void updateLedIndicator(SystemState systemState) {
-  unsigned long currentTime = millis();
+  unsigned long currentTime = clockMillis();
   LEDStatus newLedStatus = setLEDState(systemState);
 
   // Check if LED status has changed
@@ -0,0 +1,189 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "tasks.h"
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_timer.h>
+#include "config.h"
+#include "clock.h"
+#include "metrics.h"
+#include "log.h"
+
+// Per-task timing statistics (microseconds)
+struct TaskStats {
+  uint32_t runs;
+  uint32_t overruns;    // Periods skipped because a run started after the next deadline
+  uint32_t execMax;
+  uint32_t jitterMax;   // Start delay after deadline
+  uint64_t execTotal;
+  uint16_t load;        // Permille of the last load window spent running
+};
+
+// Registered task
+struct Task {
+  const char *name;
+  TaskFunction function;
+  uint32_t period;
+  TaskPriority priority;
+  uint32_t deadline;
+  uint32_t windowExec;
+  TaskStats stats;
+};
+
+// Scheduler variables
+static Task tasks[TASK_MAX_COUNT];
+static uint8_t taskCount = 0;
+static uint32_t windowStartTime = 0;
+static TaskHandle_t loopTask = nullptr;
+static esp_timer_handle_t wakeTimer = nullptr;
+static portMUX_TYPE statsLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Check if a wrapping timestamp has been reached
+static bool reached(uint32_t now, uint32_t deadline) {
+  return (int32_t)(now - deadline) >= 0;
+}
+
+// Wake loop task at deadline (esp_timer task)
+static void onWakeTimer(void *arg) {
+  xTaskNotifyGive(loopTask);
+}
+
+// Initialize scheduler (call from the loop task before adding tasks)
+void setupTasks() {
+  loopTask = xTaskGetCurrentTaskHandle();
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = onWakeTimer;
+  timerArgs.name = "tasks";
+  esp_timer_create(&timerArgs, &wakeTimer);
+  windowStartTime = clockMicros();
+}
+
+// Register periodic task, first run is due immediately
+bool addTask(const char *name, TaskFunction function, uint32_t periodUs, TaskPriority priority) {
+  if (taskCount >= TASK_MAX_COUNT || periodUs == 0) {
+    LOG_ERROR("Task Not Added (Count: %lld)\n", taskCount);
+    return false;
+  }
+  tasks[taskCount] = {name, function, periodUs, priority, clockMicros(), 0, {}};
+  taskCount++;
+  return true;
+}
+
+// Run task and advance its deadline past the current time
+static void runTask(Task &task) {
+  // Run time is code cost, so it stays on the hardware timer
+  uint32_t runStartTime = clockMicros();
+  uint32_t execStartTime = micros();
+  task.function();
+  uint32_t exec = micros() - execStartTime;
+  uint32_t runEndTime = clockMicros();
+
+  uint32_t jitter = runStartTime - task.deadline;
+  task.deadline += task.period;
+  task.windowExec += exec;
+
+  // Skip whole periods already missed instead of running back to back
+  uint32_t missed = 0;
+  if (reached(runEndTime, task.deadline)) {
+    missed = (runEndTime - task.deadline) / task.period + 1;
+    task.deadline += missed * task.period;
+    metricIncrement(Counter::TASK_OVERRUNS, missed);
+  }
+
+  portENTER_CRITICAL(&statsLock);
+  task.stats.runs++;
+  task.stats.overruns += missed;
+  task.stats.execMax = max(task.stats.execMax, exec);
+  task.stats.jitterMax = max(task.stats.jitterMax, jitter);
+  task.stats.execTotal += exec;
+  portEXIT_CRITICAL(&statsLock);
+}
+
+// Convert run time of each task in the finished window to load
+static void updateLoad(uint32_t now) {
+  uint32_t window = now - windowStartTime;
+  uint32_t total = 0;
+  windowStartTime = now;
+
+  portENTER_CRITICAL(&statsLock);
+  for (uint8_t i = 0; i < taskCount; i++) {
+    uint32_t load = (uint32_t)((uint64_t)tasks[i].windowExec * 1000 / window);
+    tasks[i].stats.load = (uint16_t)load;
+    tasks[i].windowExec = 0;
+    total += load;
+  }
+  portEXIT_CRITICAL(&statsLock);
+  metricSet(Gauge::TASK_LOAD, (int32_t)total);
+}
+
+// Run the most urgent due task, or sleep until the next deadline
+void runTasks() {
+  uint32_t now = clockMicros();
+  Task *due = nullptr;
+
+  if (reached(now, windowStartTime + TASK_LOAD_WINDOW)) {
+    updateLoad(now);
+  }
+  uint32_t earliest = now + TASK_MAX_SLEEP;
+
+  // Highest priority due task first, earliest deadline among equals
+  for (uint8_t i = 0; i < taskCount; i++) {
+    Task &task = tasks[i];
+    if (reached(now, task.deadline)) {
+      if (due == nullptr || task.priority < due->priority ||
+          (task.priority == due->priority && (int32_t)(task.deadline - due->deadline) < 0)) {
+        due = &task;
+      }
+    } else if ((int32_t)(task.deadline - earliest) < 0) {
+      earliest = task.deadline;
+    }
+  }
+
+  if (due != nullptr) {
+    runTask(*due);
+    return;
+  }
+
+  // Block until the earliest deadline, short waits are cheaper to spin through
+  uint32_t wait = earliest - now;
+  // A fast virtual clock jumps straight to the deadline
+  if (clockSkip(wait)) {
+    return;
+  }
+  if (wait < TASK_MIN_SLEEP || wakeTimer == nullptr) {
+    return;
+  }
+  if (esp_timer_start_once(wakeTimer, wait) == ESP_OK) {
+    // Timeout only guards against a lost wakeup
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait / 1000 + 2));
+    esp_timer_stop(wakeTimer);
+  }
+}
+
+// Send per-task timing statistics as JSON
+void handleTasksRequest(AsyncWebServerRequest *request) {
+  AsyncResponseStream *response = request->beginResponseStream("application/json");
+  uint32_t total = 0;
+
+  response->print("{\"tasks\":[");
+  for (uint8_t i = 0; i < taskCount; i++) {
+    portENTER_CRITICAL(&statsLock);
+    TaskStats stats = tasks[i].stats;
+    portEXIT_CRITICAL(&statsLock);
+    total += stats.load;
+
+    response->printf("%s{\"name\":\"%s\",\"period\":%lu,\"priority\":%u,\"runs\":%lu,\"overruns\":%lu,"
+                     "\"execAvg\":%lu,\"execMax\":%lu,\"jitterMax\":%lu,\"load\":%lu}",
+                     (i > 0) ? "," : "", tasks[i].name, (unsigned long)tasks[i].period,
+                     (unsigned)tasks[i].priority, (unsigned long)stats.runs, (unsigned long)stats.overruns,
+                     (unsigned long)(stats.runs ? stats.execTotal / stats.runs : 0), (unsigned long)stats.execMax,
+                     (unsigned long)stats.jitterMax, (unsigned long)stats.load);
+  }
+  // Load in permille of the last window
+  response->printf("],\"load\":%lu}", (unsigned long)total);
+  request->send(response);
+}
@@ -0,0 +1,187 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "timekeeping.h"
+#include <Arduino.h>
+#include <sys/time.h>
+#include <atomic>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "metrics.h"
+#include "log.h"
+
+// Sync point pairing monotonic timer with NTP time (us)
+struct SyncPoint {
+  int64_t monotonic;
+  int64_t reference;
+};
+
+// Sync history (ring buffer of recent points)
+static SyncPoint syncPoints[TIME_DRIFT_SAMPLES];
+static uint8_t syncCount = 0;
+static uint8_t syncHead = 0;
+static portMUX_TYPE timeLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Drift estimate and correction anchor
+static int32_t driftPpb = 0;
+static SyncPoint anchor = {0, 0};
+static bool anchored = false;
+static std::atomic<bool> driftChanged(false);
+
+// Fit drift as least-squares slope of (reference - monotonic) over monotonic
+static bool fitDrift(const SyncPoint *points, uint8_t count, int32_t &drift) {
+  if (count < 2) {
+    return false;
+  }
+  // Offsets relative to oldest point keep values small
+  double meanX = 0, meanY = 0;
+  for (uint8_t i = 0; i < count; ++i) {
+    meanX += (double)(points[i].monotonic - points[0].monotonic);
+    meanY += (double)((points[i].reference - points[0].reference) - (points[i].monotonic - points[0].monotonic));
+  }
+  meanX /= count;
+  meanY /= count;
+
+  double covariance = 0, variance = 0;
+  for (uint8_t i = 0; i < count; ++i) {
+    double x = (double)(points[i].monotonic - points[0].monotonic) - meanX;
+    double y = (double)((points[i].reference - points[0].reference) -
+                        (points[i].monotonic - points[0].monotonic)) - meanY;
+    covariance += x * y;
+    variance += x * x;
+  }
+  if (variance <= 0) {
+    return false;
+  }
+  double slope = covariance / variance * 1e9;
+  if (slope > TIME_MAX_DRIFT_PPB || slope < -TIME_MAX_DRIFT_PPB) {
+    return false;
+  }
+  drift = (int32_t)slope;
+  return true;
+}
+
+// Load learned clock drift and reset sync history
+void setupTimekeeping() {
+  driftPpb = loadClockDrift();
+  syncCount = 0;
+  syncHead = 0;
+  anchored = false;
+  metricSet(Gauge::CLOCK_DRIFT_PPB, driftPpb);
+  metricSet(Gauge::CLOCK_DEGRADED, 1);
+}
+
+// Record NTP sync point and refit drift (safe from SNTP task)
+void recordTimeSync(const struct timeval &tv) {
+  // NTP time does not pair with a virtual clock
+  if (isVirtualClock()) {
+    return;
+  }
+  SyncPoint point = {clockMonotonic(), (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec};
+  SyncPoint history[TIME_DRIFT_SAMPLES];
+  uint8_t count;
+  int32_t drift;
+
+  portENTER_CRITICAL(&timeLock);
+  // Replace latest point if syncs arrive too close together to resolve drift
+  uint8_t last = (syncHead + TIME_DRIFT_SAMPLES - 1) % TIME_DRIFT_SAMPLES;
+  if (syncCount > 0 && point.monotonic - syncPoints[last].monotonic < (int64_t)TIME_MIN_SYNC_SPACING * 1000000LL) {
+    syncPoints[last] = point;
+  } else {
+    syncPoints[syncHead] = point;
+    syncHead = (syncHead + 1) % TIME_DRIFT_SAMPLES;
+    if (syncCount < TIME_DRIFT_SAMPLES) {
+      ++syncCount;
+    }
+  }
+  // Copy history oldest first so the fit runs outside the lock
+  count = syncCount;
+  for (uint8_t i = 0; i < count; ++i) {
+    history[i] = syncPoints[(syncHead + TIME_DRIFT_SAMPLES - count + i) % TIME_DRIFT_SAMPLES];
+  }
+  anchor = point;
+  anchored = true;
+  portEXIT_CRITICAL(&timeLock);
+
+  bool fitted = fitDrift(history, count, drift);
+  if (fitted) {
+    portENTER_CRITICAL(&timeLock);
+    driftPpb = drift;
+    portEXIT_CRITICAL(&timeLock);
+  }
+
+  metricIncrement(Counter::NTP_SYNCS);
+  metricSet(Gauge::CLOCK_DEGRADED, 0);
+  if (fitted) {
+    metricSet(Gauge::CLOCK_DRIFT_PPB, drift);
+    driftChanged.store(true);
+  }
+}
+
+// Persist drift estimate after it changes
+void updateTimekeeping() {
+  if (isTimeDegraded()) {
+    metricSet(Gauge::CLOCK_DEGRADED, 1);
+  }
+  if (!driftChanged.exchange(false)) {
+    return;
+  }
+  int32_t drift = getClockDrift();
+  LOG_INFO("Clock Drift: %lld ppb\n", drift);
+  if (!saveClockDrift(drift)) {
+    LOG_WARN("Failed to Save Clock Drift\n");
+  }
+}
+
+// Get drift-corrected wall clock time in microseconds
+int64_t timeNowMicros() {
+  int64_t now = clockMonotonic();
+
+  portENTER_CRITICAL(&timeLock);
+  bool valid = anchored;
+  SyncPoint point = anchor;
+  int32_t drift = driftPpb;
+  portEXIT_CRITICAL(&timeLock);
+
+  if (!valid) {
+    // No sync since boot, trust retained system clock
+    return clockWall();
+  }
+  int64_t elapsed = now - point.monotonic;
+  return point.reference + elapsed + elapsed * drift / 1000000000LL;
+}
+
+// Get drift-corrected wall clock time
+time_t timeNow() {
+  return (time_t)(timeNowMicros() / 1000000LL);
+}
+
+// Get monotonic timer delay (us) until a wall clock time
+uint64_t delayUntil(time_t target) {
+  int64_t remaining = (int64_t)target * 1000000LL - timeNowMicros();
+  if (remaining <= 0) {
+    return 0;
+  }
+  // Convert corrected wall time span to local timer span
+  return (uint64_t)(remaining - remaining * getClockDrift() / (1000000000LL + getClockDrift()));
+}
+
+// Check if clock is running without a recent NTP sync
+bool isTimeDegraded() {
+  portENTER_CRITICAL(&timeLock);
+  bool valid = anchored;
+  int64_t last = anchor.monotonic;
+  portEXIT_CRITICAL(&timeLock);
+  return !valid || (clockMonotonic() - last) / 1000 > (int64_t)NTP_STALE_INTERVAL;
+}
+
+// Get estimated clock drift (parts per billion, positive = local clock slow)
+int32_t getClockDrift() {
+  portENTER_CRITICAL(&timeLock);
+  int32_t drift = driftPpb;
+  portEXIT_CRITICAL(&timeLock);
+  return drift;
+}
@@ -5,65 +5,374 @@
 
 #include "tof.h"
 #include <Arduino.h>
-#include <Wire.h>
 #include <VL53L0X.h>
 #include "config.h"
+#include "clock.h"
+#include "i2c.h"
+#include "light.h"
+#include "trace.h"
+#include "metrics.h"
+#include "log.h"
 
-static VL53L0X tof;
-static bool wasTriggered = false;
-static unsigned long lastTriggerTime = 0;
+// Check that every sensor of a group has a shutdown pin (a lone one may do without)
+static constexpr bool xshutWired() {
+  if (TOF_SENSOR_COUNT == 1) {
+    return true;
+  }
+  for (uint8_t i = 0; i < TOF_SENSOR_COUNT; i++) {
+    if (PIN_TOF_XSHUT[i] == PIN_NONE) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(TOF_SENSOR_COUNT > 0 && TOF_SENSOR_COUNT <= TOF_MAX_SENSORS, "Unsupported ToF sensor count");
+static_assert(xshutWired(), "Every ToF sensor needs XSHUT when more than one is fitted");
+static_assert(I2C_QUEUE_SIZE >= TOF_SENSOR_COUNT, "I2C queue must hold one job per ToF sensor");
+
+// Bus job kinds
+enum class TofJob : uint8_t {
+  SAMPLE,   // Check data ready, read result, clear interrupt
+  MODE,     // Restart ranging in target mode
+  INIT      // Reset and re-initialize after a bus error
+};
+
+// Per-sensor state (device and result fields belong to the I2C task while a job is queued)
+struct TofSensor {
+  VL53L0X device;
+  I2cTransaction transaction;
+  GestureRecognizer recognizer;
+  uint8_t index;
+  TofJob job;
+  TofMode mode;                 // Mode the sensor is actually ranging in
+  TofMode targetMode;           // Mode applied by a queued MODE job
+  bool online;                  // Came up at boot
+  bool failed;                  // Needs re-initialization
+  bool ready;                   // SAMPLE job found a measurement
+  uint8_t result[12];
+  unsigned long submitTime;     // Poll time the job was queued
+  unsigned long lastSampleTime; // Poll time the last measurement was read
+};
+
+static TofSensor sensors[TOF_SENSOR_COUNT];
+
+// Acquisition variables
+static TofMode mode = TofMode::SUSPENDED;
+static uint8_t nextSensor = 0;
+static unsigned long lastInterestTime = 0;
+
+// Fusion variables
+static uint8_t triggerSensor = 0;
+static unsigned long triggerTime = 0;
 
-// Initialize ToF sensor via I2C
+// Request mode for all sensors, applied one sensor per poll
+static void setMode(TofMode newMode) {
+  if (newMode == mode) {
+    return;
+  }
+  mode = newMode;
+
+  // Share of time each sensor spends ranging
+  uint32_t budget = (newMode == TofMode::IDLE) ? TOF_IDLE_BUDGET : (newMode == TofMode::ACTIVE) ? TOF_ACTIVE_BUDGET : 0;
+  int32_t duty = (budget == 0) ? 0 : (newMode == TofMode::ACTIVE) ? 1000 : (int32_t)(budget / TOF_IDLE_PERIOD);
+  metricSet(Gauge::TOF_DUTY_PERMILLE, duty);
+  LOG_INFO("ToF Mode: %lld\n", (int)newMode);
+}
+
+// Reset sensor through XSHUT, start it, and move it to its own address
+static bool initSensor(TofSensor &sensor) {
+  uint8_t pin = PIN_TOF_XSHUT[sensor.index];
+  if (pin != PIN_NONE) {
+    // Power cycle so the sensor answers at the default address again
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    delay(TOF_BOOT_TIME);
+    // Board pulls XSHUT up, so release it instead of driving it high
+    pinMode(pin, INPUT);
+    delay(TOF_BOOT_TIME);
+    sensor.device = VL53L0X();
+  }
+  // Set sensor timeout (ms)
+  sensor.device.setTimeout(500);
+  if (!sensor.device.init()) {
+    return false;
+  }
+  // Lone unwired sensor keeps the default address so it is found again after a reset without power loss
+  if (pin != PIN_NONE) {
+    sensor.device.setAddress(TOF_BASE_ADDRESS + sensor.index);
+  }
+  return sensor.device.last_status == 0;
+}
+
+// Check data ready and read status, signal rate, and range in one burst (I2C task)
+static bool sampleJob(TofSensor &sensor) {
+  sensor.ready = false;
+  uint8_t interrupt = sensor.device.readReg(VL53L0X::RESULT_INTERRUPT_STATUS);
+  metricIncrement(Counter::TOF_I2C_TRANSACTIONS);
+  if (sensor.device.last_status != 0) {
+    return false;
+  }
+  if ((interrupt & 0x07) == 0) {
+    return true;
+  }
+  sensor.device.readMulti(VL53L0X::RESULT_RANGE_STATUS, sensor.result, sizeof(sensor.result));
+  if (sensor.device.last_status != 0) {
+    return false;
+  }
+  sensor.device.writeReg(VL53L0X::SYSTEM_INTERRUPT_CLEAR, 0x01);
+  metricIncrement(Counter::TOF_I2C_TRANSACTIONS, 2);
+  sensor.ready = true;
+  return sensor.device.last_status == 0;
+}
+
+// Restart ranging with the budget and period of the target mode (I2C task)
+static bool modeJob(TofSensor &sensor) {
+  sensor.device.stopContinuous();
+  uint32_t budget = 0;
+  uint32_t period = 0;
+  switch (sensor.targetMode) {
+    case TofMode::IDLE:
+      budget = TOF_IDLE_BUDGET;
+      period = TOF_IDLE_PERIOD;
+      break;
+    case TofMode::ACTIVE:
+      budget = TOF_ACTIVE_BUDGET;
+      break;
+    case TofMode::SUSPENDED:
+      break;
+  }
+  if (budget != 0) {
+    sensor.device.setMeasurementTimingBudget(budget);
+    // Period 0 ranges back to back
+    sensor.device.startContinuous(period);
+  }
+  return sensor.device.last_status == 0;
+}
+
+// Run queued job of a sensor (I2C task)
+static bool runJob(void *context) {
+  TofSensor &sensor = *static_cast<TofSensor *>(context);
+  switch (sensor.job) {
+    case TofJob::SAMPLE:
+      return sampleJob(sensor);
+    case TofJob::MODE:
+      return modeJob(sensor);
+    case TofJob::INIT:
+      return initSensor(sensor);
+  }
+  return false;
+}
+
+// Initialize ToF sensors via I2C
 bool setupTof() {
   Serial.print("Initializing ToF...");
 
-  // Initialize I2C communication
-  Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
-  // Set sensor timeout (ms)
-  tof.setTimeout(500);
-  // Attempt to start ToF sensor
-  uint8_t attempts = 10;
-  while (!tof.init() && attempts > 0) {
-    attempts--;
-    Serial.print(".");
-    delay(500);
-  }
-  if (attempts == 0) {
+  // Hold every wired sensor in shutdown so none answers at the default address
+  for (uint8_t i = 0; i < TOF_SENSOR_COUNT; i++) {
+    sensors[i].index = i;
+    if (PIN_TOF_XSHUT[i] != PIN_NONE) {
+      pinMode(PIN_TOF_XSHUT[i], OUTPUT);
+      digitalWrite(PIN_TOF_XSHUT[i], LOW);
+    }
+  }
+
+  // Bring sensors up in order on the still idle bus, a missing one only costs its coverage
+  uint8_t online = 0;
+  for (TofSensor &sensor : sensors) {
+    uint8_t attempts = 10;
+    while (!initSensor(sensor) && attempts > 0) {
+      attempts--;
+      Serial.print(".");
+      delay(500);
+    }
+    if (attempts == 0) {
+      LOG_ERROR("ToF Sensor Failed: %lld\n", sensor.index);
+      continue;
+    }
+    sensor.mode = TofMode::SUSPENDED;
+    sensor.online = true;
+    resetGesture(sensor.recognizer);
+    online++;
+  }
+  metricSet(Gauge::TOF_SENSORS, online);
+  if (online == 0) {
     Serial.print("Failed\n");
     return false;
   }
-  // Set single measurement time (us)
-  tof.setMeasurementTimingBudget(40000);
-  // Start continuous measurements
-  tof.startContinuous();
+  // Start slow ranging until something comes near
+  setMode(TofMode::IDLE);
 
   Serial.print("Done\n");
   return true;
 }
 
-// Detect if an object just appeared within the threshold distance
-bool isTofTriggered() {
-  unsigned long currentTime = millis();
-  uint16_t distance = tof.readRangeContinuousMillimeters();
-  bool isTriggered = false;
-  bool trigger = false;
-
-  // Object detected if within threshold
-  isTriggered = (!tof.timeoutOccurred() && distance < TOF_THRESHOLD && distance > 0);
-
-  // Debounce object detection
-  if ((currentTime - lastTriggerTime) > TOF_DEBOUNCE) {
-    // Check if object just appeared
-    if (isTriggered && !wasTriggered) {
-      trigger = true;
-      // Store current time for next call
-      lastTriggerTime = currentTime;
-      Serial.printf("ToF Triggered: %u mm\n", distance);
+// Queue job for a sensor
+static void submitJob(TofSensor &sensor, TofJob job, unsigned long currentTime) {
+  sensor.job = job;
+  sensor.submitTime = currentTime;
+  sensor.targetMode = mode;
+  i2cSubmit(sensor.transaction, runJob, &sensor);
+}
+
+// Decode finished sample into a distance (0 = no target or rejected)
+static uint16_t decodeSample(const TofSensor &sensor) {
+  uint8_t rangeStatus = (sensor.result[0] & 0x78) >> 3;
+  uint16_t signalRate = ((uint16_t)sensor.result[6] << 8) | sensor.result[7];
+  uint16_t distance = ((uint16_t)sensor.result[10] << 8) | sensor.result[11];
+
+  // Record latency from queueing the read to its result
+  metricObserve(Histogram::TOF_READ_US, sensor.transaction.latency);
+  metricIncrement(Counter::TOF_READS);
+  if (rangeStatus != TOF_RANGE_VALID || signalRate < TOF_MIN_SIGNAL_RATE) {
+    // Low confidence sample counts as a dropout
+    metricIncrement(Counter::TOF_REJECTED);
+    return 0;
+  }
+  return distance;
+}
+
+// Take result of a finished job, returning true if a sample was read
+static bool collectJob(TofSensor &sensor, I2cState state) {
+  sensor.transaction.state.store(I2cState::IDLE);
+  if (state == I2cState::FAILED) {
+    // Bus error leaves the sensor in an unknown state
+    if (!sensor.failed) {
+      metricIncrement(Counter::TOF_TIMEOUTS);
+      LOG_WARN("ToF Sensor Error: %lld\n", sensor.index);
+    }
+    sensor.failed = true;
+    sensor.mode = TofMode::SUSPENDED;
+    return false;
+  }
+  switch (sensor.job) {
+    case TofJob::SAMPLE:
+      if (!sensor.ready) {
+        return false;
+      }
+      // The read ran right after queueing, collecting waits for the next poll
+      sensor.lastSampleTime = sensor.submitTime;
+      return true;
+    case TofJob::MODE:
+      sensor.mode = sensor.targetMode;
+      sensor.lastSampleTime = sensor.submitTime;
+      return false;
+    case TofJob::INIT:
+      sensor.failed = false;
+      resetGesture(sensor.recognizer);
+      LOG_INFO("ToF Sensor Recovered: %lld\n", sensor.index);
+      return false;
+  }
+  return false;
+}
+
+// Check if an idle sensor has work to queue
+static bool needsJob(const TofSensor &sensor, unsigned long currentTime) {
+  if (sensor.failed) {
+    return i2cAvailable(sensor.transaction);
+  }
+  if (sensor.mode != mode) {
+    return true;
+  }
+  // Leave the bus alone until the next measurement can be due
+  uint32_t period = (mode == TofMode::IDLE) ? TOF_IDLE_PERIOD : TOF_ACTIVE_BUDGET / 1000;
+  return mode != TofMode::SUSPENDED && currentTime - sensor.lastSampleTime + TOF_POLL_MARGIN >= period;
+}
+
+// Service next sensor in turn and recognize gestures (nothing is reported while suspended)
+TofGesture pollTofGesture(uint8_t &percent) {
+  unsigned long currentTime = clockMillis();
+
+  // Pick next sensor with a finished job, or with nothing queued and work to do
+  TofSensor *sensor = nullptr;
+  I2cState state = I2cState::IDLE;
+  for (uint8_t i = 0; i < TOF_SENSOR_COUNT; i++) {
+    TofSensor &candidate = sensors[(nextSensor + i) % TOF_SENSOR_COUNT];
+    if (!candidate.online) {
+      continue;
+    }
+    state = candidate.transaction.state.load(std::memory_order_acquire);
+    if (state == I2cState::DONE || state == I2cState::FAILED ||
+        (state == I2cState::IDLE && needsJob(candidate, currentTime))) {
+      sensor = &candidate;
+      break;
     }
   }
+  if (sensor == nullptr) {
+    return TofGesture::NONE;
+  }
+  nextSensor = (sensor->index + 1) % TOF_SENSOR_COUNT;
+
+  if (state == I2cState::IDLE) {
+    submitJob(*sensor, sensor->failed ? TofJob::INIT : (sensor->mode != mode) ? TofJob::MODE : TofJob::SAMPLE,
+              currentTime);
+    return TofGesture::NONE;
+  }
+  // Samples still in flight when suspending are dropped
+  if (!collectJob(*sensor, state) || mode == TofMode::SUSPENDED) {
+    return TofGesture::NONE;
+  }
+  uint8_t index = sensor->index;
+  uint16_t distance = decodeSample(*sensor);
+
+  // Ambient rate comes with the result block, skip samples shaded by something near the sensor
+  if (distance == 0 || distance >= TOF_INTEREST_RANGE) {
+    lightSample(((uint16_t)sensor->result[8] << 8) | sensor->result[9]);
+  }
 
-  // Store current state for next call
-  wasTriggered = isTriggered;
+  // Sensor index in the low bits keeps interleaved sensors apart in the trace
+  traceRecord(TraceType::TOF, ((int32_t)distance << 2) | index);
+
+  // Range fast while something is near any sensor, fall back after it has been gone a while
+  if (distance > 0 && distance < TOF_INTEREST_RANGE) {
+    lastInterestTime = currentTime;
+    setMode(TofMode::ACTIVE);
+  } else if (mode == TofMode::ACTIVE && currentTime - lastInterestTime >= TOF_ACTIVE_HOLD) {
+    setMode(TofMode::IDLE);
+  }
+
+  uint8_t sensorPercent = 0;
+  TofGesture gesture = updateGesture(sensor->recognizer, currentTime, distance, sensorPercent);
+  if (gesture == TofGesture::NONE) {
+    return gesture;
+  }
+  // Sensor that triggered last keeps the trigger while its window is open
+  if (index != triggerSensor && currentTime - triggerTime < TOF_FUSION_WINDOW) {
+    return TofGesture::NONE;
+  }
+  triggerSensor = index;
+  triggerTime = currentTime;
+
+  switch (gesture) {
+    case TofGesture::TAP:
+      metricIncrement(Counter::TOF_TAPS);
+      break;
+    case TofGesture::APPROACH:
+      metricIncrement(Counter::TOF_APPROACHES);
+      break;
+    case TofGesture::RETREAT:
+      metricIncrement(Counter::TOF_RETREATS);
+      break;
+    case TofGesture::HOLD:
+      metricIncrement(Counter::TOF_HOLDS);
+      percent = sensorPercent;
+      break;
+    default:
+      break;
+  }
+  LOG_INFO("ToF Gesture: %lld (Sensor: %lld, %lld mm)\n", (int)gesture, index, distance);
+  return gesture;
+}
+
+// Stop ranging while gestures are not needed, resume in idle mode
+void setTofSuspended(bool suspended) {
+  if (suspended) {
+    setMode(TofMode::SUSPENDED);
+  } else if (mode == TofMode::SUSPENDED) {
+    setMode(TofMode::IDLE);
+  }
+}
 
-  return trigger;
+// Get current acquisition mode
+TofMode getTofMode() {
+  return mode;
 }
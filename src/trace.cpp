@@ -0,0 +1,193 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "trace.h"
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <array>
+#include <atomic>
+#include "config.h"
+#include "clock.h"
+#include "log.h"
+
+constexpr size_t TRACE_TYPE_COUNT = (size_t)TraceType::COUNT;
+constexpr uint8_t TRACE_VERSION = 2;
+constexpr size_t TRACE_HEADER_SIZE = 8;
+constexpr size_t TRACE_RECORD_MAX = 11;    // Type + two 5-byte varints
+
+// Block ring (newest block is being written)
+static uint8_t blocks[TRACE_BLOCK_COUNT][TRACE_BLOCK_SIZE];
+static uint8_t newestBlock = 0;
+static uint8_t blockCount = 0;
+static size_t blockLength = 0;
+
+// Delta state of the newest block
+static uint32_t lastTime = 0;
+static int32_t lastValue[TRACE_TYPE_COUNT];
+
+// Recording control
+static std::atomic<bool> enabled(true);
+static bool downloading = false;
+static uint32_t downloadId = 0;
+static portMUX_TYPE traceLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Append unsigned varint, returning bytes written
+static size_t writeVarint(uint8_t *buffer, uint32_t value) {
+  size_t length = 0;
+  while (value >= 0x80) {
+    buffer[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  buffer[length++] = (uint8_t)value;
+  return length;
+}
+
+// Map signed delta to unsigned so small magnitudes stay short
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+// Check if type stores deltas
+static bool isDeltaCoded(TraceType type) {
+  return type == TraceType::TOF || type == TraceType::POSITION;
+}
+
+// Encode record against current delta state
+static size_t encodeRecord(uint8_t *buffer, TraceType type, uint32_t time, int32_t value) {
+  size_t length = 0;
+  buffer[length++] = (uint8_t)type;
+  length += writeVarint(buffer + length, time - lastTime);
+  uint32_t coded = isDeltaCoded(type) ? zigzag(value - lastValue[(size_t)type]) : (uint32_t)value;
+  length += writeVarint(buffer + length, coded);
+  return length;
+}
+
+// Start new block at time, overwriting the oldest when the ring is full
+static void startBlock(uint32_t time) {
+  if (blockCount == 0) {
+    newestBlock = 0;
+  } else {
+    newestBlock = (newestBlock + 1) % TRACE_BLOCK_COUNT;
+  }
+  if (blockCount < TRACE_BLOCK_COUNT) {
+    blockCount++;
+  }
+  uint8_t *block = blocks[newestBlock];
+  memset(block, 0, TRACE_BLOCK_SIZE);
+  memcpy(block, &time, sizeof(time));
+  blockLength = sizeof(time);
+  lastTime = time;
+  memset(lastValue, 0, sizeof(lastValue));
+}
+
+// Append record to the trace ring (loop task only)
+void traceRecord(TraceType type, int32_t value) {
+  if (!enabled.load(std::memory_order_relaxed) || (size_t)type >= TRACE_TYPE_COUNT) {
+    return;
+  }
+  uint32_t time = clockMillis();
+  uint8_t record[TRACE_RECORD_MAX];
+
+  portENTER_CRITICAL(&traceLock);
+  if (!downloading) {
+    size_t length = encodeRecord(record, type, time, value);
+    if (blockCount == 0 || blockLength + length > TRACE_BLOCK_SIZE) {
+      startBlock(time);
+      length = encodeRecord(record, type, time, value);
+    }
+    memcpy(blocks[newestBlock] + blockLength, record, length);
+    blockLength += length;
+    lastTime = time;
+    lastValue[(size_t)type] = value;
+  }
+  portEXIT_CRITICAL(&traceLock);
+}
+
+// Resume recording after download, ignoring a stale end of an earlier one
+static void endDownload(uint32_t id) {
+  portENTER_CRITICAL(&traceLock);
+  if (downloadId == id) {
+    downloading = false;
+  }
+  portEXIT_CRITICAL(&traceLock);
+}
+
+// Stream trace ring with header, oldest block first
+static void handleTraceRequest(AsyncWebServerRequest *request) {
+  portENTER_CRITICAL(&traceLock);
+  bool busy = downloading;
+  downloading = true;
+  uint32_t id = busy ? 0 : ++downloadId;
+  uint8_t count = blockCount;
+  uint8_t oldest = (blockCount < TRACE_BLOCK_COUNT) ? 0 : (newestBlock + 1) % TRACE_BLOCK_COUNT;
+  portEXIT_CRITICAL(&traceLock);
+  if (busy) {
+    request->send(409, "text/plain", "Error 409: Download in progress");
+    return;
+  }
+
+  std::array<uint8_t, TRACE_HEADER_SIZE> header;
+  uint16_t blockSize = TRACE_BLOCK_SIZE;
+  memcpy(header.data(), "ABTR", 4);
+  header[4] = TRACE_VERSION;
+  header[5] = count;
+  memcpy(header.data() + 6, &blockSize, sizeof(blockSize));
+
+  // Resume recording if the client goes away early
+  request->onDisconnect([id]() {
+    endDownload(id);
+  });
+
+  // Serve header then blocks as one byte stream (ring is frozen until the end)
+  size_t total = TRACE_HEADER_SIZE + (size_t)count * TRACE_BLOCK_SIZE;
+  request->sendChunked("application/octet-stream",
+                       [header, id, oldest, total](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    if (index >= total) {
+      endDownload(id);
+      return 0;
+    }
+    size_t written = 0;
+    while (written < maxLen && index < total) {
+      size_t len;
+      if (index < TRACE_HEADER_SIZE) {
+        len = min(maxLen - written, TRACE_HEADER_SIZE - index);
+        memcpy(buffer + written, header.data() + index, len);
+      } else {
+        size_t offset = index - TRACE_HEADER_SIZE;
+        size_t block = (oldest + offset / TRACE_BLOCK_SIZE) % TRACE_BLOCK_COUNT;
+        size_t blockOffset = offset % TRACE_BLOCK_SIZE;
+        len = min(maxLen - written, TRACE_BLOCK_SIZE - blockOffset);
+        memcpy(buffer + written, blocks[block] + blockOffset, len);
+      }
+      written += len;
+      index += len;
+    }
+    return written;
+  });
+}
+
+// Attach trace routes to web server
+void setupTrace(AsyncWebServer &server) {
+  // Download trace ("/trace")
+  server.on("/trace", HTTP_GET, handleTraceRequest);
+
+  // Enable, disable, or clear recording ("/setTrace?enabled=0|1&clear=1")
+  server.on("/setTrace", HTTP_GET, [](AsyncWebServerRequest *request) {
+    if (request->hasParam("enabled")) {
+      enabled.store(request->getParam("enabled")->value().toInt() != 0);
+    }
+    if (request->hasParam("clear")) {
+      portENTER_CRITICAL(&traceLock);
+      if (!downloading) {
+        blockCount = 0;
+        blockLength = 0;
+      }
+      portEXIT_CRITICAL(&traceLock);
+    }
+    LOG_INFO("Trace Recording: %lld\n", enabled.load() ? 1 : 0);
+    request->send(200, "text/plain", enabled.load() ? "Recording" : "Stopped");
+  });
+}
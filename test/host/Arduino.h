@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+#include <ctime>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+using std::min;
+using std::max;
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+#define OUTPUT_OPEN_DRAIN 0x13
+#define RGB_BUILTIN 8
+#define IRAM_ATTR
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Time since process start
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// GPIO (levels and modes are kept in the host pin table)
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void rgbLedWrite(uint8_t pin, uint8_t red, uint8_t green, uint8_t blue);
+
+long random(long max);
+long random(long min, long max);
+
+// Arduino string on top of std::string
+class String {
+ public:
+  String() {}
+  String(const char *text) : text_(text ? text : "") {}
+  String(const std::string &text) : text_(text) {}
+  String(char c) : text_(1, c) {}
+  String(int value) : text_(std::to_string(value)) {}
+  String(unsigned value) : text_(std::to_string(value)) {}
+  String(long value) : text_(std::to_string(value)) {}
+  String(unsigned long value) : text_(std::to_string(value)) {}
+  String(long long value) : text_(std::to_string(value)) {}
+  String(unsigned long long value) : text_(std::to_string(value)) {}
+  String(double value, unsigned decimals = 2);
+
+  const char *c_str() const { return text_.c_str(); }
+  size_t length() const { return text_.size(); }
+  bool isEmpty() const { return text_.empty(); }
+  char operator[](unsigned index) const { return index < text_.size() ? text_[index] : 0; }
+  long toInt() const { return strtol(text_.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(text_.c_str(), nullptr); }
+  double toDouble() const { return strtod(text_.c_str(), nullptr); }
+  bool startsWith(const String &prefix) const { return text_.rfind(prefix.text_, 0) == 0; }
+  bool equals(const String &other) const { return text_ == other.text_; }
+  void reserve(size_t size) { text_.reserve(size); }
+
+  String &operator+=(const String &other) { text_ += other.text_; return *this; }
+  String &operator+=(const char *other) { text_ += other; return *this; }
+  String &operator+=(char c) { text_ += c; return *this; }
+  friend String operator+(const String &a, const String &b) { return String(a.text_ + b.text_); }
+  friend String operator+(const String &a, const char *b) { return String(a.text_ + b); }
+  bool operator==(const String &other) const { return text_ == other.text_; }
+  bool operator==(const char *other) const { return text_ == other; }
+  bool operator!=(const String &other) const { return text_ != other.text_; }
+
+  const std::string &str() const { return text_; }
+
+ private:
+  std::string text_;
+};
+
+// Byte sink with the Arduino print helpers
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(const uint8_t *data, size_t size) = 0;
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t print(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+  size_t print(const String &text) { return write((const uint8_t *)text.c_str(), text.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value) { return print(String(value)); }
+  size_t print(unsigned value) { return print(String(value)); }
+  size_t print(long value) { return print(String(value)); }
+  size_t print(unsigned long value) { return print(String(value)); }
+  size_t println(const char *text = "") { return print(text) + print("\r\n"); }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  int availableForWrite() { return 128; }
+  void flush() {}
+};
+
+// Serial port (discarded unless HOST_SERIAL is set in the environment)
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long baud) {}
+  size_t write(const uint8_t *data, size_t size) override;
+  using Print::write;
+};
+extern HardwareSerial Serial;
+
+// IPv4 address (byte 0 first, as on the ESP32)
+class IPAddress {
+ public:
+  IPAddress() : bytes_{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes_{a, b, c, d} {}
+  IPAddress(uint32_t address) {
+    for (int i = 0; i < 4; i++) {
+      bytes_[i] = (address >> (8 * i)) & 0xFF;
+    }
+  }
+  uint8_t operator[](int index) const { return bytes_[index & 3]; }
+  operator uint32_t() const {
+    return bytes_[0] | (bytes_[1] << 8) | (bytes_[2] << 16) | ((uint32_t)bytes_[3] << 24);
+  }
+  bool operator==(const IPAddress &other) const { return (uint32_t)*this == (uint32_t)other; }
+  String toString() const;
+  bool fromString(const char *text);
+
+ private:
+  uint8_t bytes_[4];
+};
+
+// Apply time zone (SNTP is faked in esp_sntp.h)
+void configTzTime(const char *tz, const char *server1, const char *server2 = nullptr, const char *server3 = nullptr);
+bool getLocalTime(struct tm *info, uint32_t ms = 5000);
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+extern "C" size_t strlcpy(char *dst, const char *src, size_t size);
+#endif
+
+// Chip control (restarts are only counted)
+class EspClass {
+ public:
+  void restart();
+};
+extern EspClass ESP;
+
+#endif // HOST_ARDUINO_H
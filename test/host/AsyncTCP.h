@@ -0,0 +1,11 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_ASYNCTCP_H
+#define HOST_ASYNCTCP_H
+
+// Connections are simulated by the fake web server
+
+#endif // HOST_ASYNCTCP_H
@@ -0,0 +1,52 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_ASYNCUDP_H
+#define HOST_ASYNCUDP_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "Arduino.h"
+
+// Received datagram
+class AsyncUDPPacket {
+ public:
+  AsyncUDPPacket(uint8_t *data, size_t length, IPAddress remote, uint16_t port)
+      : data_(data), length_(length), remote_(remote), port_(port) {}
+  uint8_t *data() { return data_; }
+  size_t length() { return length_; }
+  IPAddress remoteIP() { return remote_; }
+  uint16_t remotePort() { return port_; }
+
+ private:
+  uint8_t *data_;
+  size_t length_;
+  IPAddress remote_;
+  uint16_t port_;
+};
+
+typedef std::function<void(AsyncUDPPacket &packet)> AuPacketHandlerFunction;
+
+// UDP socket on the host loopback interface (multicast loops back to every process on the machine)
+class AsyncUDP {
+ public:
+  ~AsyncUDP();
+  bool listenMulticast(const IPAddress &address, uint16_t port, uint8_t ttl = 1);
+  void onPacket(AuPacketHandlerFunction handler) { handler_ = handler; }
+  size_t writeTo(const uint8_t *data, size_t length, const IPAddress &address, uint16_t port);
+  void close();
+  bool connected() { return socket_ >= 0; }
+
+ private:
+  void receive();
+
+  int socket_ = -1;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  AuPacketHandlerFunction handler_;
+};
+
+#endif // HOST_ASYNCUDP_H
@@ -0,0 +1,31 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_ESP32PCNTENCODER_H
+#define HOST_ESP32PCNTENCODER_H
+
+#include <cstdint>
+#include "esp_timer.h"
+
+enum class EncoderType { SINGLE, HALF_QUAD, FULL_QUAD };
+enum class PullType { NONE, UP, DOWN };
+
+// Encoder reading the simulated motor plant
+class ESP32PCNTEncoder {
+ public:
+  ESP32PCNTEncoder(uint8_t pinA, uint8_t pinB, uint8_t pcntUnit = 0);
+
+  void setEncoderType(EncoderType type) {}
+  void setPullResistors(PullType type) {}
+  void setFilterNs(uint32_t value_ns) {}
+  bool begin();
+  int64_t getPosition();
+  void setPosition(int64_t position);
+  void resetPosition() { setPosition(0); }
+  esp_err_t pauseCount() { return ESP_OK; }
+  esp_err_t resumeCount() { return ESP_OK; }
+};
+
+#endif // HOST_ESP32PCNTENCODER_H
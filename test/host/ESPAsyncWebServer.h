@@ -0,0 +1,179 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_ESPASYNCWEBSERVER_H
+#define HOST_ESPASYNCWEBSERVER_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+// Requests are injected by hostRequest()/hostUpload() and run on the calling thread
+enum WebRequestMethod : uint8_t { HTTP_GET = 1, HTTP_POST = 2, HTTP_ANY = 0xFF };
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data,
+                           size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+typedef std::function<void()> ArDisconnectHandler;
+
+// Query parameter
+class AsyncWebParameter {
+ public:
+  AsyncWebParameter(const String &name, const String &value) : name_(name), value_(value) {}
+  const String &name() const { return name_; }
+  const String &value() const { return value_; }
+
+ private:
+  String name_;
+  String value_;
+};
+
+// Response collected into memory
+class AsyncWebServerResponse {
+ public:
+  virtual ~AsyncWebServerResponse() {}
+  int status = 200;
+  std::string type;
+  std::string body;
+  AwsResponseFiller filler;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+ public:
+  size_t write(const uint8_t *data, size_t size) override {
+    body.append((const char *)data, size);
+    return size;
+  }
+  using Print::write;
+};
+
+class AsyncWebServerRequest {
+ public:
+  AsyncWebServerRequest(WebRequestMethodComposite method, const std::string &url, const char *user,
+                        const char *password);
+  ~AsyncWebServerRequest();
+
+  WebRequestMethodComposite method() const { return method_; }
+  const String &url() const { return path_; }
+  bool hasParam(const char *name) const;
+  bool hasParam(const String &name) const { return hasParam(name.c_str()); }
+  const AsyncWebParameter *getParam(const char *name) const;
+  const AsyncWebParameter *getParam(const String &name) const { return getParam(name.c_str()); }
+  size_t params() const { return params_.size(); }
+
+  void send(int code, const char *type = "", const char *content = "");
+  void send(int code, const char *type, const String &content) { send(code, type, content.c_str()); }
+  void send(int code, const String &type, const String &content) { send(code, type.c_str(), content.c_str()); }
+  void send(AsyncWebServerResponse *response);
+  AsyncResponseStream *beginResponseStream(const char *type, size_t bufferSize = 1460);
+  void sendChunked(const char *type, AwsResponseFiller filler);
+  void redirect(const char *url);
+  bool authenticate(const char *user, const char *password) const;
+  void requestAuthentication();
+  void onDisconnect(ArDisconnectHandler handler) { disconnect_ = handler; }
+
+  // Host side
+  AsyncWebServerResponse *response() const { return response_; }
+  const std::string &location() const { return location_; }
+  void disconnect();
+
+ private:
+  WebRequestMethodComposite method_;
+  String path_;
+  std::vector<AsyncWebParameter> params_;
+  std::string user_;
+  std::string password_;
+  AsyncWebServerResponse *response_ = nullptr;
+  std::string location_;
+  ArDisconnectHandler disconnect_;
+};
+
+// WebSocket events
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PING, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+typedef enum { WS_CONTINUATION, WS_TEXT, WS_BINARY, WS_DISCONNECT = 0x08, WS_PING, WS_PONG } AwsFrameType;
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocket;
+
+class AsyncWebSocketClient {
+ public:
+  AsyncWebSocketClient(uint32_t id) : id_(id) {}
+  uint32_t id() const { return id_; }
+  void setCloseClientOnQueueFull(bool close) {}
+
+ private:
+  uint32_t id_;
+};
+
+typedef std::function<void(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg,
+                           uint8_t *data, size_t len)> AwsEventHandler;
+
+class AsyncWebSocket {
+ public:
+  explicit AsyncWebSocket(const char *url) : url_(url) {}
+  void onEvent(AwsEventHandler handler) { handler_ = handler; }
+  void binaryAll(const uint8_t *data, size_t len);
+  void binaryAll(const char *data, size_t len) { binaryAll((const uint8_t *)data, len); }
+  void textAll(const char *text) { binaryAll((const uint8_t *)text, strlen(text)); }
+  void cleanupClients(uint16_t maxClients = 8) {}
+  size_t count() const;
+
+  // Host side
+  void connect(uint32_t id);
+  void disconnect(uint32_t id);
+  void receive(uint32_t id, const uint8_t *data, size_t len);
+
+ private:
+  std::string url_;
+  AwsEventHandler handler_;
+  std::map<uint32_t, AsyncWebSocketClient *> clients_;
+};
+
+class AsyncWebServer {
+ public:
+  explicit AsyncWebServer(uint16_t port);
+  ~AsyncWebServer();
+
+  void on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+          ArUploadHandlerFunction onUpload = nullptr);
+  void onNotFound(ArRequestHandlerFunction handler) { notFound_ = handler; }
+  void addHandler(AsyncWebSocket *socket) { sockets_.push_back(socket); }
+  void begin() { started_ = true; }
+  void end() { started_ = false; }
+
+  // Host side
+  struct Route {
+    std::string uri;
+    WebRequestMethodComposite method;
+    ArRequestHandlerFunction onRequest;
+    ArUploadHandlerFunction onUpload;
+  };
+  const Route *find(WebRequestMethodComposite method, const std::string &path) const;
+  const ArRequestHandlerFunction &notFound() const { return notFound_; }
+  const std::vector<AsyncWebSocket *> &sockets() const { return sockets_; }
+
+ private:
+  std::vector<Route> routes_;
+  ArRequestHandlerFunction notFound_;
+  std::vector<AsyncWebSocket *> sockets_;
+  bool started_ = false;
+};
+
+#endif // HOST_ESPASYNCWEBSERVER_H
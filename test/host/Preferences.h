@@ -0,0 +1,52 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Key-value storage kept in memory for the life of the process
+class Preferences {
+ public:
+  bool begin(const char *name, bool readOnly = false, const char *partition = nullptr);
+  void end() {}
+  bool clear();
+  bool remove(const char *key);
+  bool isKey(const char *key);
+
+  size_t putBool(const char *key, bool value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putUChar(const char *key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putInt(const char *key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putUInt(const char *key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putLong64(const char *key, int64_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t putBytes(const char *key, const void *value, size_t length);
+
+  bool getBool(const char *key, bool defaultValue = false) { return get(key, defaultValue); }
+  uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return get(key, defaultValue); }
+  int32_t getInt(const char *key, int32_t defaultValue = 0) { return get(key, defaultValue); }
+  uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return get(key, defaultValue); }
+  int64_t getLong64(const char *key, int64_t defaultValue = 0) { return get(key, defaultValue); }
+  size_t getBytesLength(const char *key);
+  size_t getBytes(const char *key, void *buffer, size_t length);
+
+ private:
+  // Read fixed-size value, default if missing or of another size
+  template <typename T>
+  T get(const char *key, T defaultValue) {
+    T value;
+    if (getBytesLength(key) != sizeof(T)) {
+      return defaultValue;
+    }
+    getBytes(key, &value, sizeof(T));
+    return value;
+  }
+
+  std::string name_;
+};
+
+#endif // HOST_PREFERENCES_H
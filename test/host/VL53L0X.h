@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_VL53L0X_H
+#define HOST_VL53L0X_H
+
+#include <cstdint>
+#include "Wire.h"
+
+// Driver subset with the Pololu API, talking to simulated sensors over the fake bus
+class VL53L0X {
+ public:
+  enum regAddr {
+    SYSRANGE_START = 0x00,
+    SYSTEM_INTERMEASUREMENT_PERIOD = 0x04,
+    SYSTEM_INTERRUPT_CLEAR = 0x0B,
+    RESULT_INTERRUPT_STATUS = 0x13,
+    RESULT_RANGE_STATUS = 0x14,
+    FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI = 0x71,
+    I2C_SLAVE_DEVICE_ADDRESS = 0x8A,
+    IDENTIFICATION_MODEL_ID = 0xC0
+  };
+
+  uint8_t last_status = 0;
+
+  VL53L0X() {}
+  void setBus(TwoWire *bus) { bus_ = bus; }
+  void setAddress(uint8_t newAddress);
+  uint8_t getAddress() { return address_; }
+  bool init(bool io2v8 = true);
+
+  void writeReg(uint8_t reg, uint8_t value);
+  void writeReg32Bit(uint8_t reg, uint32_t value);
+  uint8_t readReg(uint8_t reg);
+  void readMulti(uint8_t reg, uint8_t *dst, uint8_t count);
+
+  bool setMeasurementTimingBudget(uint32_t budgetUs);
+  uint32_t getMeasurementTimingBudget() { return budget_; }
+  void startContinuous(uint32_t periodMs = 0);
+  void stopContinuous();
+  void setTimeout(uint16_t timeout) { timeout_ = timeout; }
+  uint16_t getTimeout() { return timeout_; }
+  bool timeoutOccurred() { return false; }
+
+ private:
+  TwoWire *bus_ = &Wire;
+  uint8_t address_ = 0x29;
+  uint16_t timeout_ = 0;
+  uint32_t budget_ = 33000;
+};
+
+#endif // HOST_VL53L0X_H
@@ -0,0 +1,44 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+// Station with a simulated access point, events arrive on the esp_timer thread
+typedef enum { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_START = 2,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP = 9
+} arduino_event_id_t;
+
+typedef struct {
+  arduino_event_id_t event_id;
+} arduino_event_t;
+
+typedef void (*WiFiEventSysCb)(arduino_event_t *event);
+
+typedef enum { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 } wl_status_t;
+
+class WiFiClass {
+ public:
+  bool mode(wifi_mode_t mode) { return true; }
+  bool setAutoReconnect(bool autoReconnect) { return true; }
+  void onEvent(WiFiEventSysCb callback);
+  wl_status_t begin();
+  wl_status_t begin(const char *ssid, const char *password = nullptr) { return begin(); }
+  bool disconnect(bool wifiOff = false);
+  bool isConnected();
+  wl_status_t status() { return isConnected() ? WL_CONNECTED : WL_DISCONNECTED; }
+  IPAddress localIP();
+};
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
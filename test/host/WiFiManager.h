@@ -0,0 +1,27 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_WIFIMANAGER_H
+#define HOST_WIFIMANAGER_H
+
+#include <vector>
+#include "WiFi.h"
+
+// Provisioning portal driven by hostPortalSubmit()
+class WiFiManager {
+ public:
+  void setConnectTimeout(unsigned long seconds) {}
+  void setConfigPortalTimeout(unsigned long seconds) {}
+  void setConfigPortalBlocking(bool blocking) {}
+  void setShowInfoUpdate(bool show) {}
+  void setShowInfoErase(bool show) {}
+  void setMenu(std::vector<const char *> &menu) {}
+  bool autoConnect(const char *apName, const char *apPassword = nullptr);
+  bool startConfigPortal(const char *apName, const char *apPassword = nullptr);
+  bool getConfigPortalActive();
+  bool process();
+};
+
+#endif // HOST_WIFIMANAGER_H
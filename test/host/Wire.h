@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Master on the simulated I2C bus (endTransmission: 0 = ok, 2 = address NACK, 5 = timeout)
+class TwoWire {
+ public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  bool end();
+  void setClock(uint32_t frequency);
+  void setTimeOut(uint16_t timeoutMs) {}
+
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t size);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, size_t size, bool sendStop = true);
+  int available();
+  int read();
+
+ private:
+  uint8_t address_ = 0;
+  std::vector<uint8_t> txBuffer_;
+  std::vector<uint8_t> rxBuffer_;
+  size_t rxIndex_ = 0;
+};
+extern TwoWire Wire;
+
+#endif // HOST_WIRE_H
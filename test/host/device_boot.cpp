@@ -0,0 +1,22 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "memory.h"
+#include "motor.h"
+#include "buttons.h"
+#include "states.h"
+#include "host.h"
+
+void hostBootDevice(int64_t lastPos, const std::function<void()> &setupModules) {
+  setupMemory();
+  setupMotor();
+  savePositions(OPEN_POS, CLOSE_POS);
+  saveLastPosition(lastPos);
+  if (setupModules) {
+    setupModules();
+  }
+  setupButtons();
+  setupStates();
+}
@@ -0,0 +1,17 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_ESP_MAC_H
+#define HOST_ESP_MAC_H
+
+#include <cstdint>
+#include "esp_timer.h"
+
+typedef enum { ESP_MAC_WIFI_STA, ESP_MAC_WIFI_SOFTAP, ESP_MAC_BT, ESP_MAC_ETH } esp_mac_type_t;
+
+// Station MAC set by hostSetMac()
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type);
+
+#endif // HOST_ESP_MAC_H
@@ -0,0 +1,46 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_ESP_OTA_OPS_H
+#define HOST_ESP_OTA_OPS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "esp_timer.h"
+
+// Two app slots of the default_8MB layout kept in memory
+#define ESP_ERR_OTA_VALIDATE_FAILED 0x1503
+#define OTA_SIZE_UNKNOWN 0xffffffff
+#define OTA_WITH_SEQUENTIAL_WRITES 0xfffffffe
+
+typedef uint32_t esp_ota_handle_t;
+
+typedef struct {
+  const char *label;
+  uint32_t address;
+  uint32_t size;
+} esp_partition_t;
+
+typedef enum {
+  ESP_OTA_IMG_NEW = 0x0,
+  ESP_OTA_IMG_PENDING_VERIFY = 0x1,
+  ESP_OTA_IMG_VALID = 0x2,
+  ESP_OTA_IMG_INVALID = 0x3,
+  ESP_OTA_IMG_ABORTED = 0x4,
+  ESP_OTA_IMG_UNDEFINED = 0xFFFFFFFF
+} esp_ota_img_states_t;
+
+const esp_partition_t *esp_ota_get_running_partition();
+const esp_partition_t *esp_ota_get_boot_partition();
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start);
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t imageSize, esp_ota_handle_t *handle);
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size);
+esp_err_t esp_ota_end(esp_ota_handle_t handle);
+esp_err_t esp_ota_abort(esp_ota_handle_t handle);
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition);
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *state);
+esp_err_t esp_ota_mark_app_valid_cancel_rollback();
+
+#endif // HOST_ESP_OTA_OPS_H
@@ -0,0 +1,273 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "Arduino.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "soc/gpio_reg.h"
+#include "host.h"
+#include "fake_pins.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+volatile uint32_t hostGpioIn = 0;
+
+// Pin table (outputs keep their level while switched to input)
+static constexpr uint8_t PIN_COUNT = 64;
+static uint8_t pinModes[PIN_COUNT];
+static uint8_t pinLevels[PIN_COUNT];
+static int analogValues[PIN_COUNT];
+static uint32_t ledColor = 0;
+static uint32_t restarts = 0;
+
+// Pin lock (used by listeners registered during static initialization)
+static std::recursive_mutex &pinLock() {
+  static std::recursive_mutex *lock = new std::recursive_mutex();
+  return *lock;
+}
+
+static std::vector<HostPinListener> &pinListeners() {
+  static std::vector<HostPinListener> *listeners = new std::vector<HostPinListener>();
+  return *listeners;
+}
+
+static HostPinReader &pinReader() {
+  static HostPinReader *reader = new HostPinReader();
+  return *reader;
+}
+
+void hostAddPinListener(HostPinListener listener) {
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  pinListeners().push_back(listener);
+}
+
+void hostSetPinReader(HostPinReader reader) {
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  pinReader() = reader;
+}
+
+// Notify listeners around a pin change
+static void notifyPin(uint8_t pin, bool before) {
+  for (HostPinListener &listener : pinListeners()) {
+    listener(pin, before);
+  }
+}
+
+unsigned long millis() {
+  return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)esp_timer_get_time();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  // Busy wait like the ROM delay
+  int64_t end = esp_timer_get_time() + us;
+  while (esp_timer_get_time() < end) {
+  }
+}
+
+void yield() {
+  std::this_thread::yield();
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= PIN_COUNT) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  notifyPin(pin, true);
+  pinModes[pin] = mode;
+  notifyPin(pin, false);
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin >= PIN_COUNT) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  notifyPin(pin, true);
+  pinLevels[pin] = level ? HIGH : LOW;
+  notifyPin(pin, false);
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= PIN_COUNT) {
+    return LOW;
+  }
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  uint8_t mode = pinModes[pin];
+  if (mode == OUTPUT) {
+    return pinLevels[pin];
+  }
+  // Open drain reads low while driven low, otherwise what the bus or input says
+  if (mode == OUTPUT_OPEN_DRAIN && pinLevels[pin] == LOW) {
+    return LOW;
+  }
+  if (pinReader()) {
+    int level = pinReader()(pin);
+    if (level >= 0) {
+      return level;
+    }
+  }
+  if (pin < 32) {
+    return (hostGpioIn >> pin) & 1;
+  }
+  return mode == INPUT_PULLUP || mode == OUTPUT_OPEN_DRAIN ? HIGH : LOW;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  if (pin >= PIN_COUNT) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  notifyPin(pin, true);
+  analogValues[pin] = value;
+  notifyPin(pin, false);
+}
+
+int hostAnalogValue(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  return pin < PIN_COUNT ? analogValues[pin] : 0;
+}
+
+void rgbLedWrite(uint8_t pin, uint8_t red, uint8_t green, uint8_t blue) {
+  ledColor = ((uint32_t)red << 16) | ((uint32_t)green << 8) | blue;
+}
+
+long random(long max) {
+  return max <= 0 ? 0 : (long)(rand() % max);
+}
+
+long random(long min, long max) {
+  return max <= min ? min : min + random(max - min);
+}
+
+String::String(double value, unsigned decimals) {
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+  text_ = buffer;
+}
+
+size_t Print::printf(const char *format, ...) {
+  char stackBuffer[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, args);
+  va_end(args);
+  if (length < 0) {
+    return 0;
+  }
+  if ((size_t)length < sizeof(stackBuffer)) {
+    return write((const uint8_t *)stackBuffer, length);
+  }
+  std::vector<char> buffer(length + 1);
+  va_start(args, format);
+  vsnprintf(buffer.data(), buffer.size(), format, args);
+  va_end(args);
+  return write((const uint8_t *)buffer.data(), length);
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t size) {
+  static const bool enabled = getenv("HOST_SERIAL") != nullptr;
+  if (enabled) {
+    fwrite(data, 1, size, stderr);
+  }
+  return size;
+}
+
+String IPAddress::toString() const {
+  char buffer[16];
+  snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", bytes_[0], bytes_[1], bytes_[2], bytes_[3]);
+  return String(buffer);
+}
+
+bool IPAddress::fromString(const char *text) {
+  unsigned a, b, c, d;
+  if (sscanf(text, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+    return false;
+  }
+  *this = IPAddress(a, b, c, d);
+  return true;
+}
+
+void configTzTime(const char *tz, const char *server1, const char *server2, const char *server3) {
+  setenv("TZ", tz, 1);
+  tzset();
+}
+
+bool getLocalTime(struct tm *info, uint32_t ms) {
+  time_t now = time(nullptr);
+  localtime_r(&now, info);
+  return true;
+}
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+extern "C" size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t length = strlen(src);
+  if (size > 0) {
+    size_t copy = length < size - 1 ? length : size - 1;
+    memcpy(dst, src, copy);
+    dst[copy] = '\0';
+  }
+  return length;
+}
+#endif
+
+void EspClass::restart() {
+  restarts++;
+}
+
+// Test side
+
+int64_t hostMicros() {
+  return esp_timer_get_time();
+}
+
+int hostExit(int code) {
+  fflush(stdout);
+  fflush(stderr);
+  _exit(code);
+}
+
+void hostSetInput(uint8_t pin, bool level) {
+  if (pin >= 32) {
+    return;
+  }
+  if (level) {
+    hostGpioIn = hostGpioIn | (1u << pin);
+  } else {
+    hostGpioIn = hostGpioIn & ~(1u << pin);
+  }
+}
+
+int hostOutputLevel(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  if (pin >= PIN_COUNT || (pinModes[pin] != OUTPUT && pinModes[pin] != OUTPUT_OPEN_DRAIN)) {
+    return -1;
+  }
+  return pinLevels[pin];
+}
+
+uint8_t hostPinMode(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(pinLock());
+  return pin < PIN_COUNT ? pinModes[pin] : 0;
+}
+
+uint32_t hostLedColor() {
+  return ledColor;
+}
+
+uint32_t hostRestartCount() {
+  return restarts;
+}
@@ -0,0 +1,103 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "esp_timer.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "fake_kernel.h"
+
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  int64_t due;
+  bool active;
+};
+
+static std::vector<esp_timer *> timers;
+static std::condition_variable *timerSignal = nullptr;
+
+// Process start as the time origin
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Run due callbacks one at a time, like the esp_timer task
+static void timerThread() {
+  std::unique_lock<std::mutex> lock(hostKernelLock());
+  for (;;) {
+    esp_timer *next = nullptr;
+    for (esp_timer *timer : timers) {
+      if (timer->active && (next == nullptr || timer->due < next->due)) {
+        next = timer;
+      }
+    }
+    if (next == nullptr) {
+      timerSignal->wait(lock);
+      continue;
+    }
+    int64_t now = esp_timer_get_time();
+    if (next->due > now) {
+      timerSignal->wait_for(lock, std::chrono::microseconds(next->due - now));
+      continue;
+    }
+    next->active = false;
+    hostKernelBusy(1);
+    lock.unlock();
+    next->callback(next->arg);
+    lock.lock();
+    hostKernelBusy(-1);
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle) {
+  if (args == nullptr || args->callback == nullptr || handle == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  std::lock_guard<std::mutex> lock(hostKernelLock());
+  if (timerSignal == nullptr) {
+    timerSignal = new std::condition_variable();
+    std::thread(timerThread).detach();
+  }
+  esp_timer *timer = new esp_timer{args->callback, args->arg, 0, false};
+  timers.push_back(timer);
+  *handle = timer;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout) {
+  std::lock_guard<std::mutex> lock(hostKernelLock());
+  if (timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->due = esp_timer_get_time() + (int64_t)timeout;
+  timer->active = true;
+  timerSignal->notify_all();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  std::lock_guard<std::mutex> lock(hostKernelLock());
+  if (!timer->active) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  timer->active = false;
+  return ESP_OK;
+}
+
+// Check for timers past their deadline (kernel lock held)
+bool hostTimersDue() {
+  int64_t now = esp_timer_get_time();
+  for (esp_timer *timer : timers) {
+    if (timer->active && timer->due <= now) {
+      return true;
+    }
+  }
+  return false;
+}
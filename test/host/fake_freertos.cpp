@@ -0,0 +1,242 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "freertos/FreeRTOS.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "esp_timer.h"
+#include "host.h"
+#include "fake_kernel.h"
+
+// Task state (kernel lock guards everything but the thread itself)
+struct HostTask {
+  std::string name;
+  TaskFunction_t function;
+  void *param;
+  bool counted;               // Created task (the test thread is not counted as running)
+  bool waiting;
+  bool woken;
+  bool waitingNotify;
+  uint32_t notifyCount;
+  std::condition_variable wake;
+};
+
+// Queue of fixed-size items
+struct HostQueue {
+  size_t length;
+  size_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+  HostTask *receiver;
+};
+
+static thread_local HostTask *currentTask = nullptr;
+
+std::mutex &hostKernelLock() {
+  static std::mutex *lock = new std::mutex();
+  return *lock;
+}
+
+static std::condition_variable &idleSignal() {
+  static std::condition_variable *signal = new std::condition_variable();
+  return *signal;
+}
+
+// Created tasks not blocked, plus timer callbacks in progress
+static int running = 0;
+
+void hostKernelBusy(int delta) {
+  running += delta;
+  if (running == 0) {
+    idleSignal().notify_all();
+  }
+}
+
+// Get task of the calling thread (threads not created as tasks get an uncounted one)
+static HostTask *selfTask() {
+  if (currentTask == nullptr) {
+    currentTask = new HostTask();
+    currentTask->name = "host";
+    currentTask->counted = false;
+  }
+  return currentTask;
+}
+
+// Block calling task until woken or timed out (kernel lock held), true if woken
+static bool blockTask(std::unique_lock<std::mutex> &lock, HostTask *task, TickType_t ticks) {
+  task->waiting = true;
+  task->woken = false;
+  if (task->counted) {
+    hostKernelBusy(-1);
+  }
+  if (ticks == portMAX_DELAY) {
+    task->wake.wait(lock, [task] { return task->woken; });
+  } else {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+    task->wake.wait_until(lock, deadline, [task] { return task->woken; });
+  }
+  bool woken = task->woken;
+  task->waiting = false;
+  // A waker already counted the task as running
+  if (!woken && task->counted) {
+    hostKernelBusy(1);
+  }
+  return woken;
+}
+
+// Wake blocked task (kernel lock held)
+static void wakeTask(HostTask *task) {
+  if (!task->waiting || task->woken) {
+    return;
+  }
+  task->woken = true;
+  if (task->counted) {
+    hostKernelBusy(1);
+  }
+  task->wake.notify_one();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack, void *param, UBaseType_t priority,
+                       TaskHandle_t *handle) {
+  HostTask *task = new HostTask();
+  task->name = name;
+  task->function = function;
+  task->param = param;
+  task->counted = true;
+  {
+    std::lock_guard<std::mutex> lock(hostKernelLock());
+    hostKernelBusy(1);
+  }
+  if (handle != nullptr) {
+    *handle = task;
+  }
+  std::thread([task] {
+    currentTask = task;
+    task->function(task->param);
+    std::lock_guard<std::mutex> lock(hostKernelLock());
+    hostKernelBusy(-1);
+  }).detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return selfTask();
+}
+
+void vTaskDelay(TickType_t ticks) {
+  HostTask *task = selfTask();
+  if (ticks == 0) {
+    std::this_thread::yield();
+    return;
+  }
+  std::unique_lock<std::mutex> lock(hostKernelLock());
+  blockTask(lock, task, ticks);
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  std::lock_guard<std::mutex> lock(hostKernelLock());
+  task->notifyCount++;
+  if (task->waitingNotify) {
+    wakeTask(task);
+  }
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+  HostTask *task = selfTask();
+  std::unique_lock<std::mutex> lock(hostKernelLock());
+  if (task->notifyCount == 0 && ticks != 0) {
+    task->waitingNotify = true;
+    blockTask(lock, task, ticks);
+    task->waitingNotify = false;
+  }
+  uint32_t value = task->notifyCount;
+  if (clear) {
+    task->notifyCount = 0;
+  } else if (value > 0) {
+    task->notifyCount--;
+  }
+  return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  HostQueue *queue = new HostQueue();
+  queue->length = length;
+  queue->itemSize = itemSize;
+  queue->receiver = nullptr;
+  return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+  std::lock_guard<std::mutex> lock(hostKernelLock());
+  if (queue->items.size() >= queue->length) {
+    return pdFALSE;
+  }
+  const uint8_t *bytes = static_cast<const uint8_t *>(item);
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  if (queue->receiver != nullptr) {
+    wakeTask(queue->receiver);
+  }
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  HostTask *task = selfTask();
+  std::unique_lock<std::mutex> lock(hostKernelLock());
+  if (queue->items.empty() && ticks != 0) {
+    queue->receiver = task;
+    blockTask(lock, task, ticks);
+    queue->receiver = nullptr;
+  }
+  if (queue->items.empty()) {
+    return pdFALSE;
+  }
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(hostKernelLock());
+  return queue->items.size();
+}
+
+bool xPortInIsrContext() {
+  return false;
+}
+
+void hostEnterCritical(portMUX_TYPE *mux) {
+  while (mux->locked.exchange(true, std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+}
+
+void hostExitCritical(portMUX_TYPE *mux) {
+  mux->locked.store(false, std::memory_order_release);
+}
+
+// Wait until every fake task is blocked and no timer callback is due or running
+void hostSettle() {
+  std::unique_lock<std::mutex> lock(hostKernelLock());
+  for (;;) {
+    idleSignal().wait(lock, [] { return running == 0; });
+    if (!hostTimersDue()) {
+      return;
+    }
+    // Let the timer thread pick up due callbacks
+    lock.unlock();
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    lock.lock();
+  }
+}
@@ -0,0 +1,491 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "Wire.h"
+#include "VL53L0X.h"
+#include <algorithm>
+#include <mutex>
+#include "Arduino.h"
+#include "clock.h"
+#include "config.h"
+#include "host.h"
+#include "fake_pins.h"
+
+TwoWire Wire;
+
+// Simulated VL53L0X (register subset used by the driver fake)
+struct SimTof {
+  uint8_t xshut;
+  bool powered;
+  bool nack;
+  uint8_t address;
+  uint8_t pointer;
+  bool ranging;
+  bool timed;               // Inter-measurement period applies (not back to back)
+  uint32_t periodMs;
+  uint32_t budgetUs;
+  int64_t rangingStart;
+  int64_t completed;        // Measurements finished since ranging started
+  bool interrupt;
+  uint8_t result[12];
+  uint8_t scratch[4];       // Shift register for multi-byte writes
+  HostTofScene scene;
+  HostTofScene ambient;
+  HostTofScene signal;
+  HostTofStats stats;
+};
+
+static std::recursive_mutex busLock;
+static std::vector<SimTof> devices;
+static HostI2cStats busStats = {};
+static bool busBegun = false;
+static bool realTime = false;
+static uint8_t stuckPulses = 0;
+static std::once_flag listening;
+
+// Reset sensor to its power-on state
+static void powerUp(SimTof &device) {
+  device.powered = true;
+  device.address = 0x29;
+  device.pointer = 0;
+  device.ranging = false;
+  device.periodMs = 0;
+  device.budgetUs = 33000;
+  device.interrupt = false;
+  memset(device.result, 0, sizeof(device.result));
+}
+
+// Time between measurements in the current ranging mode (us)
+static int64_t measurementInterval(const SimTof &device) {
+  if (!device.timed) {
+    return device.budgetUs;
+  }
+  return std::max<int64_t>(device.budgetUs, (int64_t)device.periodMs * 1000);
+}
+
+// Finish measurements due by now and latch the newest result
+static void updateRanging(SimTof &device) {
+  if (!device.ranging) {
+    return;
+  }
+  int64_t interval = measurementInterval(device);
+  int64_t due = (clockMonotonic() - device.rangingStart) / interval;
+  if (due <= device.completed) {
+    return;
+  }
+  device.stats.measurements += (uint32_t)(due - device.completed);
+  device.stats.rangingUs += (double)(due - device.completed) * device.budgetUs;
+  device.completed = due;
+  int64_t time = device.rangingStart + due * interval;
+
+  uint16_t distance = device.scene ? device.scene(time) : 0;
+  uint16_t signal = device.signal ? device.signal(time) : (distance > 0 ? 1280 : 0);
+  uint16_t ambient = device.ambient ? device.ambient(time) : 0;
+  // No target reads as a phase failure at the maximum range
+  uint8_t status = distance > 0 ? TOF_RANGE_VALID : 4;
+  if (distance == 0) {
+    distance = 8190;
+  }
+  memset(device.result, 0, sizeof(device.result));
+  device.result[0] = status << 3;
+  device.result[6] = signal >> 8;
+  device.result[7] = signal & 0xFF;
+  device.result[8] = ambient >> 8;
+  device.result[9] = ambient & 0xFF;
+  device.result[10] = distance >> 8;
+  device.result[11] = distance & 0xFF;
+  device.interrupt = true;
+}
+
+// Start or stop ranging
+static void setRanging(SimTof &device, bool ranging) {
+  updateRanging(device);
+  device.ranging = ranging;
+  device.stats.ranging = ranging;
+  if (ranging) {
+    device.rangingStart = clockMonotonic();
+    device.completed = 0;
+  }
+}
+
+// Register write
+static void writeRegister(SimTof &device, uint8_t reg, uint8_t value) {
+  updateRanging(device);
+  switch (reg) {
+    case VL53L0X::SYSRANGE_START:
+      if (value == 0x02 || value == 0x04) {
+        device.timed = value == 0x04;
+        setRanging(device, true);
+      } else {
+        setRanging(device, false);
+      }
+      break;
+    case VL53L0X::SYSTEM_INTERMEASUREMENT_PERIOD:
+    case VL53L0X::SYSTEM_INTERMEASUREMENT_PERIOD + 1:
+    case VL53L0X::SYSTEM_INTERMEASUREMENT_PERIOD + 2:
+    case VL53L0X::SYSTEM_INTERMEASUREMENT_PERIOD + 3:
+      device.scratch[reg - VL53L0X::SYSTEM_INTERMEASUREMENT_PERIOD] = value;
+      device.periodMs = ((uint32_t)device.scratch[0] << 24) | ((uint32_t)device.scratch[1] << 16) |
+                        ((uint32_t)device.scratch[2] << 8) | device.scratch[3];
+      break;
+    case VL53L0X::FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI:
+    case VL53L0X::FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI + 1:
+    case VL53L0X::FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI + 2:
+    case VL53L0X::FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI + 3:
+      device.scratch[reg - VL53L0X::FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI] = value;
+      device.budgetUs = ((uint32_t)device.scratch[0] << 24) | ((uint32_t)device.scratch[1] << 16) |
+                        ((uint32_t)device.scratch[2] << 8) | device.scratch[3];
+      break;
+    case VL53L0X::SYSTEM_INTERRUPT_CLEAR:
+      if (value & 0x01) {
+        device.interrupt = false;
+      }
+      break;
+    case VL53L0X::I2C_SLAVE_DEVICE_ADDRESS:
+      device.address = value & 0x7F;
+      break;
+    default:
+      break;
+  }
+}
+
+// Register read
+static uint8_t readRegister(SimTof &device, uint8_t reg) {
+  updateRanging(device);
+  if (reg == VL53L0X::RESULT_INTERRUPT_STATUS) {
+    return device.interrupt ? 0x04 : 0x00;
+  }
+  if (reg >= VL53L0X::RESULT_RANGE_STATUS && reg < VL53L0X::RESULT_RANGE_STATUS + sizeof(device.result)) {
+    return device.result[reg - VL53L0X::RESULT_RANGE_STATUS];
+  }
+  if (reg == VL53L0X::IDENTIFICATION_MODEL_ID) {
+    return 0xEE;
+  }
+  return 0;
+}
+
+// Track XSHUT levels and SCL pulses (pin lock held)
+static void onPin(uint8_t pin, bool before) {
+  if (before) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  for (SimTof &device : devices) {
+    if (device.xshut != pin) {
+      continue;
+    }
+    // Board pulls XSHUT up unless driven low
+    bool powered = hostPinMode(pin) != OUTPUT || hostOutputLevel(pin) == HIGH;
+    if (powered && !device.powered) {
+      powerUp(device);
+    } else if (!powered && device.powered) {
+      setRanging(device, false);
+      device.powered = false;
+    }
+  }
+  if (pin == PIN_I2C_SCL && hostOutputLevel(pin) == HIGH) {
+    busStats.clearPulses++;
+    if (stuckPulses > 0) {
+      stuckPulses--;
+    }
+  }
+}
+
+// SDA reads low while a device holds it
+static int readPin(uint8_t pin) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  if (pin == PIN_I2C_SDA) {
+    return stuckPulses > 0 ? LOW : HIGH;
+  }
+  if (pin == PIN_I2C_SCL) {
+    return HIGH;
+  }
+  return -1;
+}
+
+// Register pin hooks once (before taking the bus lock, pin hooks run under the pin lock)
+static void listen() {
+  std::call_once(listening, [] {
+    hostAddPinListener(onPin);
+    hostSetPinReader(readPin);
+  });
+}
+
+// Count bus time of one transfer and take it in real time if enabled
+static void clockBytes(size_t bytes) {
+  uint32_t frequency = busStats.frequency ? busStats.frequency : 100000;
+  double us = ((bytes + 1) * 9 + 2) * 1e6 / frequency;
+  busStats.transfers++;
+  busStats.busTimeUs += us;
+  if (realTime) {
+    int64_t end = esp_timer_get_time() + (int64_t)us;
+    while (esp_timer_get_time() < end) {
+    }
+  }
+}
+
+// Devices acknowledging an address
+static std::vector<SimTof *> addressed(uint8_t address) {
+  std::vector<SimTof *> found;
+  for (SimTof &device : devices) {
+    if (device.powered && device.address == address) {
+      device.stats.transfers++;
+      if (!device.nack) {
+        found.push_back(&device);
+      }
+    }
+  }
+  if (found.empty()) {
+    busStats.nacks++;
+  }
+  return found;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  listen();
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  busBegun = true;
+  busStats.frequency = frequency ? frequency : 100000;
+  return true;
+}
+
+bool TwoWire::end() {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  busBegun = false;
+  return true;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  busStats.frequency = frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  address_ = address;
+  txBuffer_.clear();
+}
+
+size_t TwoWire::write(uint8_t data) {
+  txBuffer_.push_back(data);
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t size) {
+  txBuffer_.insert(txBuffer_.end(), data, data + size);
+  return size;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  if (!busBegun) {
+    return 4;
+  }
+  if (stuckPulses > 0) {
+    // Master cannot generate START while SDA is held low
+    return 5;
+  }
+  clockBytes(txBuffer_.size());
+  std::vector<SimTof *> targets = addressed(address_);
+  if (targets.empty()) {
+    return 2;
+  }
+  // Every device at the address sees the write
+  for (SimTof *device : targets) {
+    if (txBuffer_.empty()) {
+      continue;
+    }
+    device->pointer = txBuffer_[0];
+    for (size_t i = 1; i < txBuffer_.size(); i++) {
+      writeRegister(*device, device->pointer++, txBuffer_[i]);
+    }
+  }
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, size_t size, bool sendStop) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  rxBuffer_.clear();
+  rxIndex_ = 0;
+  if (!busBegun || stuckPulses > 0) {
+    return 0;
+  }
+  clockBytes(size);
+  std::vector<SimTof *> targets = addressed(address);
+  if (targets.empty()) {
+    return 0;
+  }
+  if (targets.size() > 1) {
+    busStats.collisions++;
+  }
+  // Open-drain bus ANDs the bytes of devices answering together
+  rxBuffer_.assign(size, 0xFF);
+  for (SimTof *device : targets) {
+    for (size_t i = 0; i < size; i++) {
+      rxBuffer_[i] &= readRegister(*device, device->pointer++);
+    }
+  }
+  return (uint8_t)size;
+}
+
+int TwoWire::available() {
+  return (int)(rxBuffer_.size() - rxIndex_);
+}
+
+int TwoWire::read() {
+  return rxIndex_ < rxBuffer_.size() ? rxBuffer_[rxIndex_++] : -1;
+}
+
+void VL53L0X::setAddress(uint8_t newAddress) {
+  writeReg(I2C_SLAVE_DEVICE_ADDRESS, newAddress & 0x7F);
+  address_ = newAddress & 0x7F;
+}
+
+bool VL53L0X::init(bool io2v8) {
+  if (readReg(IDENTIFICATION_MODEL_ID) != 0xEE || last_status != 0) {
+    return false;
+  }
+  // Tuning and calibration writes of the real driver
+  for (int i = 0; i < 30 && last_status == 0; i++) {
+    writeReg(0x88, 0x00);
+  }
+  return last_status == 0;
+}
+
+void VL53L0X::writeReg(uint8_t reg, uint8_t value) {
+  bus_->beginTransmission(address_);
+  bus_->write(reg);
+  bus_->write(value);
+  last_status = bus_->endTransmission();
+}
+
+void VL53L0X::writeReg32Bit(uint8_t reg, uint32_t value) {
+  bus_->beginTransmission(address_);
+  bus_->write(reg);
+  bus_->write((uint8_t)(value >> 24));
+  bus_->write((uint8_t)(value >> 16));
+  bus_->write((uint8_t)(value >> 8));
+  bus_->write((uint8_t)value);
+  last_status = bus_->endTransmission();
+}
+
+uint8_t VL53L0X::readReg(uint8_t reg) {
+  bus_->beginTransmission(address_);
+  bus_->write(reg);
+  last_status = bus_->endTransmission();
+  bus_->requestFrom(address_, (size_t)1);
+  int value = bus_->read();
+  return value < 0 ? 0 : (uint8_t)value;
+}
+
+void VL53L0X::readMulti(uint8_t reg, uint8_t *dst, uint8_t count) {
+  bus_->beginTransmission(address_);
+  bus_->write(reg);
+  last_status = bus_->endTransmission();
+  bus_->requestFrom(address_, (size_t)count);
+  for (uint8_t i = 0; i < count; i++) {
+    int value = bus_->read();
+    dst[i] = value < 0 ? 0 : (uint8_t)value;
+  }
+}
+
+bool VL53L0X::setMeasurementTimingBudget(uint32_t budgetUs) {
+  if (budgetUs < 20000) {
+    return false;
+  }
+  writeReg32Bit(FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, budgetUs);
+  budget_ = budgetUs;
+  return last_status == 0;
+}
+
+void VL53L0X::startContinuous(uint32_t periodMs) {
+  if (periodMs != 0) {
+    writeReg32Bit(SYSTEM_INTERMEASUREMENT_PERIOD, periodMs);
+    writeReg(SYSRANGE_START, 0x04);
+  } else {
+    writeReg(SYSRANGE_START, 0x02);
+  }
+}
+
+void VL53L0X::stopContinuous() {
+  writeReg(SYSRANGE_START, 0x01);
+}
+
+HostI2cStats hostI2cStats() {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  return busStats;
+}
+
+void hostI2cResetStats() {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  uint32_t frequency = busStats.frequency;
+  busStats = {};
+  busStats.frequency = frequency;
+}
+
+void hostI2cRealTime(bool enabled) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  realTime = enabled;
+}
+
+void hostI2cStickSda(uint8_t pulses) {
+  listen();
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  stuckPulses = pulses;
+}
+
+int hostTofAdd(uint8_t xshut) {
+  listen();
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  SimTof device = {};
+  device.xshut = xshut;
+  powerUp(device);
+  devices.push_back(device);
+  return (int)devices.size() - 1;
+}
+
+void hostTofClear() {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  devices.clear();
+}
+
+void hostTofSetScene(int sensor, HostTofScene scene) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  devices.at(sensor).scene = scene;
+}
+
+void hostTofSetAmbient(int sensor, HostTofScene ambient) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  devices.at(sensor).ambient = ambient;
+}
+
+void hostTofSetSignal(int sensor, HostTofScene signal) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  devices.at(sensor).signal = signal;
+}
+
+void hostTofSetNack(int sensor, bool nack) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  devices.at(sensor).nack = nack;
+}
+
+HostTofStats hostTofStats(int sensor) {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  SimTof &device = devices.at(sensor);
+  updateRanging(device);
+  HostTofStats stats = device.stats;
+  stats.address = device.powered ? device.address : 0;
+  stats.ranging = device.ranging;
+  return stats;
+}
+
+void hostTofResetStats() {
+  std::lock_guard<std::recursive_mutex> lock(busLock);
+  for (SimTof &device : devices) {
+    updateRanging(device);
+    bool ranging = device.ranging;
+    device.stats = {};
+    device.stats.ranging = ranging;
+  }
+}
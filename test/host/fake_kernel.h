@@ -0,0 +1,20 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_FAKE_KERNEL_H
+#define HOST_FAKE_KERNEL_H
+
+#include <mutex>
+
+// Lock shared by fake tasks, queues, and timers
+std::mutex &hostKernelLock();
+
+// Count work in progress for hostSettle() (kernel lock held)
+void hostKernelBusy(int delta);
+
+// Check for timers past their deadline (kernel lock held)
+bool hostTimersDue();
+
+#endif // HOST_FAKE_KERNEL_H
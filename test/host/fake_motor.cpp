@@ -0,0 +1,127 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "ESP32PCNTEncoder.h"
+#include <cmath>
+#include <mutex>
+#include "Arduino.h"
+#include "clock.h"
+#include "config.h"
+#include "host.h"
+#include "fake_pins.h"
+
+// Plant state (position in encoder counts, integrated on the firmware clock)
+static std::recursive_mutex plantLock;
+static HostMotorModel model = hostMotorDefaultModel();
+static double position = 0;
+static double velocity = 0;
+static int64_t lastUpdate = 0;
+static bool listening = false;
+
+// Signed PWM the driver pins command right now
+static int drivenCommand() {
+  int pwm = hostAnalogValue(PIN_MTR_PWM);
+  int in1 = hostOutputLevel(PIN_MTR_IN1);
+  int in2 = hostOutputLevel(PIN_MTR_IN2);
+  if (hostOutputLevel(PIN_MTR_STBY) != HIGH || pwm == 0 || in1 == in2) {
+    return 0;
+  }
+  return in1 == HIGH ? pwm : -pwm;
+}
+
+// Integrate position up to now
+static void advance() {
+  int64_t now = clockMonotonic();
+  if (now > lastUpdate) {
+    position += velocity * (now - lastUpdate) / 1e6;
+  }
+  lastUpdate = now;
+}
+
+// Settle velocity for the current command
+static void applyCommand() {
+  int command = drivenCommand();
+  int magnitude = abs(command);
+  bool turning = velocity != 0;
+  if (magnitude == 0 || magnitude < (turning ? model.stallPwm : model.breakawayPwm)) {
+    // Coast in proportion to the speed it had
+    if (turning) {
+      double fullSpeed = 255 * model.countsPerPwm;
+      position += model.coastCounts * velocity / fullSpeed;
+    }
+    velocity = 0;
+    return;
+  }
+  velocity = command * model.countsPerPwm;
+}
+
+// Track driver pins (listener registered with the first encoder)
+static void onPin(uint8_t pin, bool before) {
+  if (pin != PIN_MTR_IN1 && pin != PIN_MTR_IN2 && pin != PIN_MTR_PWM && pin != PIN_MTR_STBY) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(plantLock);
+  if (before) {
+    advance();
+  } else {
+    applyCommand();
+  }
+}
+
+ESP32PCNTEncoder::ESP32PCNTEncoder(uint8_t pinA, uint8_t pinB, uint8_t pcntUnit) {
+  if (!listening) {
+    listening = true;
+    hostAddPinListener(onPin);
+  }
+}
+
+bool ESP32PCNTEncoder::begin() {
+  return true;
+}
+
+int64_t ESP32PCNTEncoder::getPosition() {
+  std::lock_guard<std::recursive_mutex> lock(plantLock);
+  advance();
+  return (int64_t)std::floor(position);
+}
+
+void ESP32PCNTEncoder::setPosition(int64_t newPosition) {
+  std::lock_guard<std::recursive_mutex> lock(plantLock);
+  advance();
+  position = (double)newPosition;
+}
+
+HostMotorModel hostMotorDefaultModel() {
+  // Geared motor turning about 2000 counts/s at full speed
+  return {8.0, 20, 35, 12.0};
+}
+
+void hostMotorSetModel(const HostMotorModel &newModel) {
+  std::lock_guard<std::recursive_mutex> lock(plantLock);
+  advance();
+  model = newModel;
+  applyCommand();
+}
+
+void hostMotorSetPosition(double newPosition) {
+  std::lock_guard<std::recursive_mutex> lock(plantLock);
+  advance();
+  position = newPosition;
+}
+
+double hostMotorPosition() {
+  std::lock_guard<std::recursive_mutex> lock(plantLock);
+  advance();
+  return position;
+}
+
+int hostMotorCommand() {
+  return drivenCommand();
+}
+
+bool hostMotorTurning() {
+  std::lock_guard<std::recursive_mutex> lock(plantLock);
+  return velocity != 0;
+}
@@ -0,0 +1,353 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "mqtt_client.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "host.h"
+
+// Message waiting in a client outbox or inbox
+struct MqttMessage {
+  std::string topic;
+  std::string payload;
+  bool retain;
+};
+
+// Client with its own task, API calls take the client lock like esp-mqtt
+struct esp_mqtt_client {
+  std::string uri;
+  std::string willTopic;
+  std::string willMessage;
+  bool willRetain;
+  esp_event_handler_t handler;
+  void *handlerArg;
+  std::recursive_mutex apiLock;
+  TaskHandle_t task;
+  bool connectRequested;
+  bool connected;
+  bool stopping;
+  bool exited;
+  std::condition_variable_any exitSignal;
+  std::deque<MqttMessage> outbox;
+  std::deque<MqttMessage> inbox;    // Guarded by the broker lock
+  std::set<std::string> subscriptions;
+  int nextMessageId;
+};
+
+// Broker state
+static std::mutex brokerLock;
+static bool brokerRunning = false;
+static std::string brokerUri;
+static uint32_t stallMs = 0;
+static std::vector<esp_mqtt_client *> brokerClients;
+static std::map<std::string, std::string> retained;
+static std::vector<HostMqttMessage> received;
+
+// Wake client task
+static void wakeClient(esp_mqtt_client *client) {
+  if (client->task != nullptr) {
+    xTaskNotifyGive(client->task);
+  }
+}
+
+// Broker receives a message from a client (broker lock held)
+static void brokerReceive(const std::string &topic, const std::string &payload, bool retain) {
+  received.push_back({topic, payload, retain, esp_timer_get_time()});
+  if (retain) {
+    if (payload.empty()) {
+      retained.erase(topic);
+    } else {
+      retained[topic] = payload;
+    }
+  }
+  for (esp_mqtt_client *client : brokerClients) {
+    if (client->subscriptions.count(topic) > 0) {
+      client->inbox.push_back({topic, payload, retain});
+      wakeClient(client);
+    }
+  }
+}
+
+// Drop client from broker, publishing its will unless it left cleanly (broker lock held)
+static void brokerDrop(esp_mqtt_client *client, bool clean) {
+  auto it = std::find(brokerClients.begin(), brokerClients.end(), client);
+  if (it == brokerClients.end()) {
+    return;
+  }
+  brokerClients.erase(it);
+  client->subscriptions.clear();
+  if (!clean && !client->willTopic.empty()) {
+    brokerReceive(client->willTopic, client->willMessage, client->willRetain);
+  }
+}
+
+// Post event to the registered handler (client lock held)
+static void postEvent(esp_mqtt_client *client, esp_mqtt_event_id_t id, MqttMessage *message = nullptr) {
+  if (client->handler == nullptr) {
+    return;
+  }
+  esp_mqtt_event_t event = {};
+  event.event_id = id;
+  event.client = client;
+  if (message != nullptr) {
+    event.topic = &message->topic[0];
+    event.topic_len = (int)message->topic.size();
+    event.data = &message->payload[0];
+    event.data_len = (int)message->payload.size();
+    event.total_data_len = event.data_len;
+  }
+  client->handler(client->handlerArg, "MQTT_EVENTS", id, &event);
+}
+
+// Send one message while holding the client lock (a stalled broker keeps it held)
+static void sendMessage(esp_mqtt_client *client, const MqttMessage &message) {
+  uint32_t stall;
+  {
+    std::lock_guard<std::mutex> lock(brokerLock);
+    stall = stallMs;
+  }
+  if (stall > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+  }
+  std::lock_guard<std::mutex> lock(brokerLock);
+  brokerReceive(message.topic, message.payload, message.retain);
+}
+
+// Client task: connect on request, flush outbox, deliver inbound messages
+static void clientTask(void *arg) {
+  esp_mqtt_client *client = static_cast<esp_mqtt_client *>(arg);
+  for (;;) {
+    std::unique_lock<std::recursive_mutex> api(client->apiLock);
+    if (client->stopping) {
+      client->exited = true;
+      client->exitSignal.notify_all();
+      return;
+    }
+    if (client->connectRequested) {
+      client->connectRequested = false;
+      bool accepted;
+      {
+        std::lock_guard<std::mutex> lock(brokerLock);
+        accepted = brokerRunning && brokerUri == client->uri;
+        if (accepted) {
+          brokerClients.push_back(client);
+        }
+      }
+      client->connected = accepted;
+      postEvent(client, accepted ? MQTT_EVENT_CONNECTED : MQTT_EVENT_DISCONNECTED);
+    }
+    if (client->connected) {
+      bool alive;
+      {
+        std::lock_guard<std::mutex> lock(brokerLock);
+        alive = std::find(brokerClients.begin(), brokerClients.end(), client) != brokerClients.end();
+      }
+      if (!alive) {
+        client->connected = false;
+        postEvent(client, MQTT_EVENT_DISCONNECTED);
+      }
+    }
+    bool busy = false;
+    if (client->connected && !client->outbox.empty()) {
+      MqttMessage message = client->outbox.front();
+      client->outbox.pop_front();
+      sendMessage(client, message);
+      busy = true;
+    }
+    if (client->connected) {
+      MqttMessage message;
+      bool has = false;
+      {
+        std::lock_guard<std::mutex> lock(brokerLock);
+        if (!client->inbox.empty()) {
+          message = client->inbox.front();
+          client->inbox.pop_front();
+          has = true;
+        }
+      }
+      if (has) {
+        postEvent(client, MQTT_EVENT_DATA, &message);
+        busy = true;
+      }
+    }
+    api.unlock();
+    if (!busy) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+  }
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config) {
+  esp_mqtt_client *client = new esp_mqtt_client();
+  client->uri = config->broker.address.uri ? config->broker.address.uri : "";
+  client->willTopic = config->session.last_will.topic ? config->session.last_will.topic : "";
+  client->willMessage = config->session.last_will.msg ? config->session.last_will.msg : "";
+  client->willRetain = config->session.last_will.retain != 0;
+  client->nextMessageId = 1;
+  return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void *arg) {
+  std::lock_guard<std::recursive_mutex> lock(client->apiLock);
+  client->handler = handler;
+  client->handlerArg = arg;
+  return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+  std::lock_guard<std::recursive_mutex> lock(client->apiLock);
+  if (client->task != nullptr) {
+    return ESP_FAIL;
+  }
+  client->connectRequested = true;
+  xTaskCreate(clientTask, "mqtt_task", 6144, client, 5, &client->task);
+  return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client) {
+  std::lock_guard<std::recursive_mutex> lock(client->apiLock);
+  client->connectRequested = true;
+  wakeClient(client);
+  return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client) {
+  std::unique_lock<std::recursive_mutex> lock(client->apiLock);
+  if (client->task == nullptr) {
+    return ESP_FAIL;
+  }
+  {
+    std::lock_guard<std::mutex> broker(brokerLock);
+    brokerDrop(client, true);
+  }
+  client->connected = false;
+  client->stopping = true;
+  wakeClient(client);
+  // Wait for the client task to end, like the library
+  client->exitSignal.wait(lock, [client] { return client->exited; });
+  return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client) {
+  if (client == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (client->task != nullptr) {
+    esp_mqtt_client_stop(client);
+  }
+  {
+    std::lock_guard<std::mutex> broker(brokerLock);
+    brokerDrop(client, true);
+  }
+  // Task thread may still be returning, so the client is leaked instead of freed
+  return ESP_OK;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos) {
+  std::lock_guard<std::recursive_mutex> lock(client->apiLock);
+  if (!client->connected) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> broker(brokerLock);
+  client->subscriptions.insert(topic);
+  // Retained message is delivered on subscribe
+  auto it = retained.find(topic);
+  if (it != retained.end()) {
+    client->inbox.push_back({topic, it->second, true});
+    wakeClient(client);
+  }
+  return client->nextMessageId++;
+}
+
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos,
+                            int retain, bool store) {
+  std::lock_guard<std::recursive_mutex> lock(client->apiLock);
+  if (!client->connected && (qos == 0 || !store)) {
+    return -1;
+  }
+  std::string payload = len > 0 ? std::string(data, len) : std::string(data ? data : "");
+  client->outbox.push_back({topic, payload, retain != 0});
+  wakeClient(client);
+  return client->nextMessageId++;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos,
+                            int retain) {
+  std::lock_guard<std::recursive_mutex> lock(client->apiLock);
+  if (!client->connected) {
+    return -1;
+  }
+  std::string payload = len > 0 ? std::string(data, len) : std::string(data ? data : "");
+  sendMessage(client, {topic, payload, retain != 0});
+  return client->nextMessageId++;
+}
+
+int esp_mqtt_client_get_outbox_size(esp_mqtt_client_handle_t client) {
+  std::lock_guard<std::recursive_mutex> lock(client->apiLock);
+  int size = 0;
+  for (const MqttMessage &message : client->outbox) {
+    size += (int)(message.topic.size() + message.payload.size());
+  }
+  return size;
+}
+
+void hostBrokerStart(const char *uri) {
+  std::lock_guard<std::mutex> lock(brokerLock);
+  brokerRunning = true;
+  brokerUri = uri;
+}
+
+void hostBrokerStop() {
+  std::lock_guard<std::mutex> lock(brokerLock);
+  brokerRunning = false;
+  std::vector<esp_mqtt_client *> clients = brokerClients;
+  for (esp_mqtt_client *client : clients) {
+    brokerDrop(client, false);
+    wakeClient(client);
+  }
+}
+
+void hostBrokerPublish(const char *topic, const char *payload) {
+  std::lock_guard<std::mutex> lock(brokerLock);
+  for (esp_mqtt_client *client : brokerClients) {
+    if (client->subscriptions.count(topic) > 0) {
+      client->inbox.push_back({topic, payload, false});
+      wakeClient(client);
+    }
+  }
+}
+
+void hostBrokerStall(uint32_t ms) {
+  std::lock_guard<std::mutex> lock(brokerLock);
+  stallMs = ms;
+}
+
+std::vector<HostMqttMessage> hostBrokerTakeMessages() {
+  std::lock_guard<std::mutex> lock(brokerLock);
+  std::vector<HostMqttMessage> taken;
+  taken.swap(received);
+  return taken;
+}
+
+std::string hostBrokerRetained(const char *topic) {
+  std::lock_guard<std::mutex> lock(brokerLock);
+  auto it = retained.find(topic);
+  return it == retained.end() ? "" : it->second;
+}
+
+bool hostBrokerConnected() {
+  std::lock_guard<std::mutex> lock(brokerLock);
+  return !brokerClients.empty();
+}
@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "WiFi.h"
+#include "WiFiManager.h"
+#include "esp_sntp.h"
+#include "esp_mac.h"
+#include "host.h"
+
+WiFiClass WiFi;
+
+// Simulated access point and station
+static std::atomic<bool> apAvailable(true);
+static std::atomic<bool> credentialsSaved(true);
+static std::atomic<uint32_t> connectTime(50);
+static std::atomic<uint32_t> portalProcessTime(0);
+static std::atomic<bool> portalActive(false);
+static std::atomic<bool> portalSubmitted(false);
+static std::atomic<bool> stationConnected(false);
+static std::atomic<uint32_t> beginCount(0);
+static WiFiEventSysCb eventCallback = nullptr;
+static esp_timer_handle_t connectTimer = nullptr;
+static std::mutex wifiLock;
+
+// SNTP state
+static sntp_sync_time_cb_t syncCallback = nullptr;
+static std::atomic<uint32_t> sntpRestarts(0);
+static uint8_t stationMac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+
+// Deliver Wi-Fi event like the event task
+static void sendEvent(arduino_event_id_t id) {
+  arduino_event_t event = {id};
+  if (eventCallback != nullptr) {
+    eventCallback(&event);
+  }
+}
+
+// Connection attempt finished (esp_timer thread)
+static void onConnectTimer(void *arg) {
+  if (apAvailable.load() && credentialsSaved.load()) {
+    stationConnected.store(true);
+    sendEvent(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  } else {
+    stationConnected.store(false);
+    sendEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+  }
+}
+
+void WiFiClass::onEvent(WiFiEventSysCb callback) {
+  eventCallback = callback;
+}
+
+wl_status_t WiFiClass::begin() {
+  beginCount++;
+  std::lock_guard<std::mutex> lock(wifiLock);
+  if (connectTimer == nullptr) {
+    esp_timer_create_args_t args = {};
+    args.callback = onConnectTimer;
+    args.name = "wifi";
+    esp_timer_create(&args, &connectTimer);
+  }
+  esp_timer_stop(connectTimer);
+  esp_timer_start_once(connectTimer, (uint64_t)connectTime.load() * 1000);
+  return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+  if (stationConnected.exchange(false)) {
+    sendEvent(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+  }
+  return true;
+}
+
+bool WiFiClass::isConnected() {
+  return stationConnected.load();
+}
+
+IPAddress WiFiClass::localIP() {
+  return stationConnected.load() ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+bool WiFiManager::autoConnect(const char *apName, const char *apPassword) {
+  // Blocks the calling task for the connect attempt, like the library
+  if (credentialsSaved.load() && apAvailable.load()) {
+    WiFi.begin();
+    std::this_thread::sleep_for(std::chrono::milliseconds(connectTime.load() + 5));
+    if (stationConnected.load()) {
+      return true;
+    }
+  }
+  portalActive.store(true);
+  return false;
+}
+
+bool WiFiManager::startConfigPortal(const char *apName, const char *apPassword) {
+  portalActive.store(true);
+  return false;
+}
+
+bool WiFiManager::getConfigPortalActive() {
+  return portalActive.load();
+}
+
+bool WiFiManager::process() {
+  // Serving the portal costs CPU on the calling task only
+  int64_t end = esp_timer_get_time() + portalProcessTime.load();
+  while (esp_timer_get_time() < end) {
+  }
+  if (portalSubmitted.exchange(false)) {
+    credentialsSaved.store(true);
+    portalActive.store(false);
+    WiFi.begin();
+    return true;
+  }
+  return false;
+}
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback) {
+  syncCallback = callback;
+}
+
+void sntp_set_sync_interval(uint32_t interval) {
+}
+
+bool sntp_restart() {
+  sntpRestarts++;
+  return true;
+}
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type) {
+  memcpy(mac, stationMac, sizeof(stationMac));
+  return ESP_OK;
+}
+
+void hostWifiSetAvailable(bool available) {
+  apAvailable.store(available);
+  if (!available) {
+    WiFi.disconnect();
+  }
+}
+
+void hostWifiSetSaved(bool saved) {
+  credentialsSaved.store(saved);
+}
+
+void hostWifiSetConnectTime(uint32_t ms) {
+  connectTime.store(ms);
+}
+
+void hostPortalSetProcessTime(uint32_t us) {
+  portalProcessTime.store(us);
+}
+
+void hostPortalSubmit() {
+  portalSubmitted.store(true);
+}
+
+bool hostPortalActive() {
+  return portalActive.load();
+}
+
+uint32_t hostWifiBeginCount() {
+  return beginCount.load();
+}
+
+void hostSntpSync(int64_t wallMicros) {
+  struct timeval tv = {(time_t)(wallMicros / 1000000), (suseconds_t)(wallMicros % 1000000)};
+  if (syncCallback != nullptr) {
+    syncCallback(&tv);
+  }
+}
+
+uint32_t hostSntpRestartCount() {
+  return sntpRestarts.load();
+}
+
+void hostSetMac(const uint8_t mac[6]) {
+  memcpy(stationMac, mac, sizeof(stationMac));
+}
@@ -0,0 +1,310 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "esp_ota_ops.h"
+#include "mbedtls/sha256.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include "host.h"
+
+// First byte of an ESP app image
+static constexpr uint8_t IMAGE_MAGIC = 0xE9;
+static constexpr size_t IMAGE_MIN_SIZE = 24;
+
+static const esp_partition_t partitions[2] = {{"app0", 0x10000, 0x330000}, {"app1", 0x340000, 0x330000}};
+
+// Flash contents and OTA data
+static std::mutex otaLock;
+static std::vector<uint8_t> images[2];
+static esp_ota_img_states_t states[2] = {ESP_OTA_IMG_VALID, ESP_OTA_IMG_UNDEFINED};
+static int running = 0;
+static int boot = 0;
+static int writing = -1;
+static esp_ota_handle_t openHandle = 0;
+static HostOtaStats stats = {};
+
+static int indexOf(const esp_partition_t *partition) {
+  return partition == &partitions[1] ? 1 : partition == &partitions[0] ? 0 : -1;
+}
+
+const esp_partition_t *esp_ota_get_running_partition() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return &partitions[running];
+}
+
+const esp_partition_t *esp_ota_get_boot_partition() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return &partitions[boot];
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return &partitions[1 - running];
+}
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t imageSize, esp_ota_handle_t *handle) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  int index = indexOf(partition);
+  if (index < 0 || index == running) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (writing >= 0) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (imageSize != OTA_SIZE_UNKNOWN && imageSize != OTA_WITH_SEQUENTIAL_WRITES && imageSize > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  writing = index;
+  images[index].clear();
+  states[index] = ESP_OTA_IMG_UNDEFINED;
+  stats.begins++;
+  stats.written = 0;
+  *handle = ++openHandle;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  if (writing < 0 || handle != openHandle) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (images[writing].size() + size > partitions[writing].size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  images[writing].insert(images[writing].end(), bytes, bytes + size);
+  stats.written += size;
+  stats.largestWrite = std::max(stats.largestWrite, size);
+  stats.writes++;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  if (writing < 0 || handle != openHandle) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  int index = writing;
+  writing = -1;
+  stats.ends++;
+  if (images[index].size() < IMAGE_MIN_SIZE || images[index][0] != IMAGE_MAGIC) {
+    return ESP_ERR_OTA_VALIDATE_FAILED;
+  }
+  states[index] = ESP_OTA_IMG_NEW;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  if (writing < 0 || handle != openHandle) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  states[writing] = ESP_OTA_IMG_ABORTED;
+  writing = -1;
+  stats.aborts++;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  int index = indexOf(partition);
+  if (index < 0 || (index != running && states[index] != ESP_OTA_IMG_NEW)) {
+    return ESP_ERR_OTA_VALIDATE_FAILED;
+  }
+  boot = index;
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_get_state_partition(const esp_partition_t *partition, esp_ota_img_states_t *state) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  int index = indexOf(partition);
+  if (index < 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *state = states[index];
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_mark_app_valid_cancel_rollback() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  states[running] = ESP_OTA_IMG_VALID;
+  return ESP_OK;
+}
+
+void hostOtaReset() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  images[0].assign(4096, 0);
+  images[0][0] = IMAGE_MAGIC;
+  images[1].clear();
+  states[0] = ESP_OTA_IMG_VALID;
+  states[1] = ESP_OTA_IMG_UNDEFINED;
+  running = 0;
+  boot = 0;
+  writing = -1;
+  stats = {};
+}
+
+HostOtaStats hostOtaStats() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return stats;
+}
+
+const char *hostOtaBootLabel() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return partitions[boot].label;
+}
+
+const char *hostOtaRunningLabel() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return partitions[running].label;
+}
+
+std::vector<uint8_t> hostOtaImage(const char *label) {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return strcmp(label, partitions[1].label) == 0 ? images[1] : images[0];
+}
+
+void hostOtaReboot() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  if (boot != running) {
+    // Fresh image runs pending verify, the bootloader rolls back if it is not confirmed
+    if (states[boot] == ESP_OTA_IMG_NEW) {
+      states[boot] = ESP_OTA_IMG_PENDING_VERIFY;
+    }
+    running = boot;
+  } else if (states[running] == ESP_OTA_IMG_PENDING_VERIFY) {
+    // Unconfirmed image rolls back
+    states[running] = ESP_OTA_IMG_ABORTED;
+    running = boot = 1 - running;
+  }
+}
+
+bool hostOtaPendingVerify() {
+  std::lock_guard<std::mutex> lock(otaLock);
+  return states[running] == ESP_OTA_IMG_PENDING_VERIFY;
+}
+
+// SHA-256 (FIPS 180-4)
+
+static const uint32_t roundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static uint32_t rotateRight(uint32_t value, int bits) {
+  return (value >> bits) | (value << (32 - bits));
+}
+
+// Process one 64-byte block
+static void sha256Block(mbedtls_sha256_context *ctx, const uint8_t *block) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) | ((uint32_t)block[i * 4 + 2] << 8) |
+           block[i * 4 + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+  uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+    uint32_t choice = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + choice + roundConstants[i] + w[i];
+    uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+    uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + majority;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  ctx->state[0] += a;
+  ctx->state[1] += b;
+  ctx->state[2] += c;
+  ctx->state[3] += d;
+  ctx->state[4] += e;
+  ctx->state[5] += f;
+  ctx->state[6] += g;
+  ctx->state[7] += h;
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx) {
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx) {
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224) {
+  static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  memcpy(ctx->state, initial, sizeof(initial));
+  ctx->length = 0;
+  ctx->used = 0;
+  return is224 ? -1 : 0;
+}
+
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t length) {
+  ctx->length += length;
+  while (length > 0) {
+    size_t take = std::min(length, sizeof(ctx->buffer) - ctx->used);
+    memcpy(ctx->buffer + ctx->used, input, take);
+    ctx->used += take;
+    input += take;
+    length -= take;
+    if (ctx->used == sizeof(ctx->buffer)) {
+      sha256Block(ctx, ctx->buffer);
+      ctx->used = 0;
+    }
+  }
+  return 0;
+}
+
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32]) {
+  uint64_t bits = ctx->length * 8;
+  uint8_t pad = 0x80;
+  mbedtls_sha256_update(ctx, &pad, 1);
+  pad = 0;
+  while (ctx->used != 56) {
+    mbedtls_sha256_update(ctx, &pad, 1);
+  }
+  uint8_t lengthBytes[8];
+  for (int i = 0; i < 8; i++) {
+    lengthBytes[i] = (uint8_t)(bits >> (56 - 8 * i));
+  }
+  mbedtls_sha256_update(ctx, lengthBytes, 8);
+  for (int i = 0; i < 8; i++) {
+    output[i * 4] = ctx->state[i] >> 24;
+    output[i * 4 + 1] = ctx->state[i] >> 16;
+    output[i * 4 + 2] = ctx->state[i] >> 8;
+    output[i * 4 + 3] = ctx->state[i];
+  }
+  return 0;
+}
+
+int mbedtls_sha256(const unsigned char *input, size_t length, unsigned char output[32], int is224) {
+  mbedtls_sha256_context ctx;
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts(&ctx, is224);
+  mbedtls_sha256_update(&ctx, input, length);
+  mbedtls_sha256_finish(&ctx, output);
+  mbedtls_sha256_free(&ctx);
+  return 0;
+}
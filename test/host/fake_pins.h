@@ -0,0 +1,23 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_FAKE_PINS_H
+#define HOST_FAKE_PINS_H
+
+#include <cstdint>
+#include <functional>
+
+// Called before a pin changes mode, level, or PWM duty (pin = GPIO number)
+using HostPinListener = std::function<void(uint8_t pin, bool before)>;
+void hostAddPinListener(HostPinListener listener);
+
+// Override read level of a pin that is not driven (returns -1 to fall back to GPIO_IN)
+using HostPinReader = std::function<int(uint8_t pin)>;
+void hostSetPinReader(HostPinReader reader);
+
+// Get last PWM duty written to a pin
+int hostAnalogValue(uint8_t pin);
+
+#endif // HOST_FAKE_PINS_H
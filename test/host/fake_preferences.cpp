@@ -0,0 +1,83 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "Preferences.h"
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "host.h"
+
+// Namespaced keys (name/key) to stored bytes
+static std::map<std::string, std::vector<uint8_t>> storage;
+static std::mutex storageLock;
+static bool failWrites = false;
+static uint32_t writeCount = 0;
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition) {
+  name_ = name;
+  return true;
+}
+
+bool Preferences::clear() {
+  std::lock_guard<std::mutex> lock(storageLock);
+  std::string prefix = name_ + "/";
+  for (auto it = storage.begin(); it != storage.end();) {
+    it = it->first.rfind(prefix, 0) == 0 ? storage.erase(it) : std::next(it);
+  }
+  return true;
+}
+
+bool Preferences::remove(const char *key) {
+  std::lock_guard<std::mutex> lock(storageLock);
+  return storage.erase(name_ + "/" + key) > 0;
+}
+
+bool Preferences::isKey(const char *key) {
+  std::lock_guard<std::mutex> lock(storageLock);
+  return storage.count(name_ + "/" + key) > 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t length) {
+  std::lock_guard<std::mutex> lock(storageLock);
+  if (failWrites) {
+    return 0;
+  }
+  const uint8_t *bytes = static_cast<const uint8_t *>(value);
+  storage[name_ + "/" + key].assign(bytes, bytes + length);
+  writeCount++;
+  return length;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+  std::lock_guard<std::mutex> lock(storageLock);
+  auto it = storage.find(name_ + "/" + key);
+  return it == storage.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t length) {
+  std::lock_guard<std::mutex> lock(storageLock);
+  auto it = storage.find(name_ + "/" + key);
+  if (it == storage.end() || it->second.size() > length) {
+    return 0;
+  }
+  memcpy(buffer, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+void hostNvsClear() {
+  std::lock_guard<std::mutex> lock(storageLock);
+  storage.clear();
+}
+
+void hostNvsFailWrites(bool fail) {
+  std::lock_guard<std::mutex> lock(storageLock);
+  failWrites = fail;
+}
+
+uint32_t hostNvsWriteCount() {
+  std::lock_guard<std::mutex> lock(storageLock);
+  return writeCount;
+}
@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "AsyncUDP.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "fake_kernel.h"
+
+AsyncUDP::~AsyncUDP() {
+  close();
+}
+
+bool AsyncUDP::listenMulticast(const IPAddress &address, uint16_t port, uint8_t ttl) {
+  close();
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_port = htons(port);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  ip_mreq membership = {};
+  membership.imr_multiaddr.s_addr = (uint32_t)address;
+  membership.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+  in_addr interface = {};
+  interface.s_addr = htonl(INADDR_LOOPBACK);
+  unsigned char loop = 1;
+  if (bind(fd, (sockaddr *)&local, sizeof(local)) != 0 ||
+      setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0 ||
+      setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) != 0 ||
+      setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0 ||
+      setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0) {
+    ::close(fd);
+    return false;
+  }
+  socket_ = fd;
+  running_ = true;
+  thread_ = std::thread(&AsyncUDP::receive, this);
+  return true;
+}
+
+// Receive on a plain thread (not a fake task, so blocking here does not keep hostSettle waiting)
+void AsyncUDP::receive() {
+  uint8_t buffer[1500];
+  while (running_) {
+    pollfd entry = {socket_, POLLIN, 0};
+    if (poll(&entry, 1, 20) <= 0) {
+      continue;
+    }
+    sockaddr_in remote = {};
+    socklen_t remoteLength = sizeof(remote);
+    ssize_t length = recvfrom(socket_, buffer, sizeof(buffer), 0, (sockaddr *)&remote, &remoteLength);
+    if (length < 0 || !handler_) {
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock(hostKernelLock());
+      hostKernelBusy(1);
+    }
+    AsyncUDPPacket packet(buffer, (size_t)length, IPAddress((uint32_t)remote.sin_addr.s_addr), ntohs(remote.sin_port));
+    handler_(packet);
+    std::lock_guard<std::mutex> lock(hostKernelLock());
+    hostKernelBusy(-1);
+  }
+}
+
+size_t AsyncUDP::writeTo(const uint8_t *data, size_t length, const IPAddress &address, uint16_t port) {
+  if (socket_ < 0) {
+    return 0;
+  }
+  sockaddr_in target = {};
+  target.sin_family = AF_INET;
+  target.sin_port = htons(port);
+  target.sin_addr.s_addr = (uint32_t)address;
+  ssize_t sent = sendto(socket_, data, length, 0, (sockaddr *)&target, sizeof(target));
+  return sent < 0 ? 0 : (size_t)sent;
+}
+
+void AsyncUDP::close() {
+  if (socket_ < 0) {
+    return;
+  }
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  ::close(socket_);
+  socket_ = -1;
+}
@@ -0,0 +1,317 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include "ESPAsyncWebServer.h"
+#include <algorithm>
+#include <mutex>
+#include "host.h"
+
+// Filler buffer size (about one TCP segment, as in the library)
+static constexpr size_t CHUNK_SIZE = 1436;
+
+static std::vector<AsyncWebServer *> &servers() {
+  static std::vector<AsyncWebServer *> *list = new std::vector<AsyncWebServer *>();
+  return *list;
+}
+
+static std::mutex broadcastLock;
+static std::vector<std::vector<uint8_t>> broadcasts;
+static std::recursive_mutex socketLock;
+
+// Decode %XX and '+' in a query component
+static std::string decode(const std::string &text) {
+  std::string result;
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '+') {
+      result += ' ';
+    } else if (text[i] == '%' && i + 2 < text.size()) {
+      result += (char)strtol(text.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      result += text[i];
+    }
+  }
+  return result;
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(WebRequestMethodComposite method, const std::string &url,
+                                             const char *user, const char *password)
+    : method_(method), user_(user ? user : ""), password_(password ? password : "") {
+  size_t query = url.find('?');
+  path_ = String(url.substr(0, query));
+  if (query == std::string::npos) {
+    return;
+  }
+  std::string rest = url.substr(query + 1);
+  while (!rest.empty()) {
+    size_t end = rest.find('&');
+    std::string pair = rest.substr(0, end);
+    size_t equals = pair.find('=');
+    if (!pair.empty()) {
+      params_.emplace_back(String(decode(pair.substr(0, equals))),
+                           String(equals == std::string::npos ? "" : decode(pair.substr(equals + 1))));
+    }
+    rest = end == std::string::npos ? "" : rest.substr(end + 1);
+  }
+}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+  delete response_;
+}
+
+bool AsyncWebServerRequest::hasParam(const char *name) const {
+  return getParam(name) != nullptr;
+}
+
+const AsyncWebParameter *AsyncWebServerRequest::getParam(const char *name) const {
+  for (const AsyncWebParameter &param : params_) {
+    if (param.name() == name) {
+      return &param;
+    }
+  }
+  return nullptr;
+}
+
+void AsyncWebServerRequest::send(int code, const char *type, const char *content) {
+  AsyncWebServerResponse *response = new AsyncWebServerResponse();
+  response->status = code;
+  response->type = type;
+  response->body = content;
+  send(response);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response) {
+  // First response wins, like the library
+  if (response_ != nullptr) {
+    delete response;
+    return;
+  }
+  response_ = response;
+}
+
+AsyncResponseStream *AsyncWebServerRequest::beginResponseStream(const char *type, size_t bufferSize) {
+  AsyncResponseStream *response = new AsyncResponseStream();
+  response->type = type;
+  return response;
+}
+
+void AsyncWebServerRequest::sendChunked(const char *type, AwsResponseFiller filler) {
+  AsyncWebServerResponse *response = new AsyncWebServerResponse();
+  response->type = type;
+  response->filler = filler;
+  send(response);
+}
+
+void AsyncWebServerRequest::redirect(const char *url) {
+  location_ = url;
+  AsyncWebServerResponse *response = new AsyncWebServerResponse();
+  response->status = 302;
+  send(response);
+}
+
+bool AsyncWebServerRequest::authenticate(const char *user, const char *password) const {
+  return user_ == user && password_ == password;
+}
+
+void AsyncWebServerRequest::requestAuthentication() {
+  send(401, "text/plain", "");
+}
+
+void AsyncWebServerRequest::disconnect() {
+  ArDisconnectHandler handler = disconnect_;
+  disconnect_ = nullptr;
+  if (handler) {
+    handler();
+  }
+}
+
+void AsyncWebSocket::binaryAll(const uint8_t *data, size_t len) {
+  std::lock_guard<std::mutex> lock(broadcastLock);
+  broadcasts.emplace_back(data, data + len);
+}
+
+size_t AsyncWebSocket::count() const {
+  std::lock_guard<std::recursive_mutex> lock(socketLock);
+  return clients_.size();
+}
+
+void AsyncWebSocket::connect(uint32_t id) {
+  std::lock_guard<std::recursive_mutex> lock(socketLock);
+  if (clients_.count(id) > 0) {
+    return;
+  }
+  AsyncWebSocketClient *client = new AsyncWebSocketClient(id);
+  clients_[id] = client;
+  if (handler_) {
+    handler_(this, client, WS_EVT_CONNECT, nullptr, nullptr, 0);
+  }
+}
+
+void AsyncWebSocket::disconnect(uint32_t id) {
+  std::lock_guard<std::recursive_mutex> lock(socketLock);
+  auto it = clients_.find(id);
+  if (it == clients_.end()) {
+    return;
+  }
+  if (handler_) {
+    handler_(this, it->second, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+  }
+  delete it->second;
+  clients_.erase(it);
+}
+
+void AsyncWebSocket::receive(uint32_t id, const uint8_t *data, size_t len) {
+  std::lock_guard<std::recursive_mutex> lock(socketLock);
+  auto it = clients_.find(id);
+  if (it == clients_.end() || !handler_) {
+    return;
+  }
+  AwsFrameInfo info = {};
+  info.message_opcode = WS_BINARY;
+  info.final = 1;
+  info.opcode = WS_BINARY;
+  info.len = len;
+  std::vector<uint8_t> copy(data, data + len);
+  handler_(this, it->second, WS_EVT_DATA, &info, copy.data(), len);
+}
+
+AsyncWebServer::AsyncWebServer(uint16_t port) {
+  servers().push_back(this);
+}
+
+AsyncWebServer::~AsyncWebServer() {
+  auto &list = servers();
+  list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+void AsyncWebServer::on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                        ArUploadHandlerFunction onUpload) {
+  routes_.push_back({uri, method, onRequest, onUpload});
+}
+
+const AsyncWebServer::Route *AsyncWebServer::find(WebRequestMethodComposite method, const std::string &path) const {
+  for (const Route &route : routes_) {
+    if (route.uri == path && (route.method & method) != 0) {
+      return &route;
+    }
+  }
+  return nullptr;
+}
+
+// Find route for a request on any server
+static const AsyncWebServer::Route *findRoute(AsyncWebServerRequest &request, ArRequestHandlerFunction *notFound) {
+  for (AsyncWebServer *server : servers()) {
+    const AsyncWebServer::Route *route = server->find(request.method(), request.url().str());
+    if (route != nullptr) {
+      return route;
+    }
+    if (server->notFound()) {
+      *notFound = server->notFound();
+    }
+  }
+  return nullptr;
+}
+
+// Collect response, running the filler of a chunked one to the end
+static HostResponse finishRequest(AsyncWebServerRequest &request) {
+  HostResponse result = {};
+  AsyncWebServerResponse *response = request.response();
+  if (response != nullptr) {
+    result.status = response->status;
+    result.type = response->type;
+    result.body = response->body;
+    if (response->filler) {
+      std::vector<uint8_t> buffer(CHUNK_SIZE);
+      for (;;) {
+        size_t len = response->filler(buffer.data(), buffer.size(), result.body.size());
+        result.chunks++;
+        if (len == 0) {
+          break;
+        }
+        result.body.append((const char *)buffer.data(), std::min(len, buffer.size()));
+      }
+    }
+  }
+  result.location = request.location();
+  // Connection closes once the response is sent
+  request.disconnect();
+  return result;
+}
+
+HostResponse hostRequest(const char *method, const char *url, const char *user, const char *password) {
+  WebRequestMethodComposite verb = strcmp(method, "POST") == 0 ? HTTP_POST : HTTP_GET;
+  AsyncWebServerRequest request(verb, url, user, password);
+  ArRequestHandlerFunction notFound;
+  const AsyncWebServer::Route *route = findRoute(request, &notFound);
+  if (route != nullptr) {
+    route->onRequest(&request);
+  } else if (notFound) {
+    notFound(&request);
+  }
+  return finishRequest(request);
+}
+
+HostResponse hostUpload(const char *url, const uint8_t *data, size_t size, size_t chunk, size_t stopAfter,
+                        const char *user, const char *password) {
+  AsyncWebServerRequest request(HTTP_POST, url, user, password);
+  ArRequestHandlerFunction notFound;
+  const AsyncWebServer::Route *route = findRoute(request, &notFound);
+  if (route == nullptr) {
+    if (notFound) {
+      notFound(&request);
+    }
+    return finishRequest(request);
+  }
+  // Body arrives in chunks (an empty body still gets one empty final chunk)
+  size_t index = 0;
+  std::vector<uint8_t> buffer;
+  do {
+    size_t len = std::min(chunk, size - index);
+    if (index + len > stopAfter) {
+      len = stopAfter - index;
+    }
+    if (index >= stopAfter && size > 0) {
+      // Connection lost mid-body
+      request.disconnect();
+      return {};
+    }
+    buffer.assign(data + index, data + index + len);
+    bool final = index + len == size;
+    if (route->onUpload) {
+      route->onUpload(&request, String("firmware.bin"), index, buffer.data(), len, final);
+    }
+    index += len;
+  } while (index < size);
+  route->onRequest(&request);
+  return finishRequest(request);
+}
+
+// Run on every WebSocket of every server
+static void forEachSocket(const std::function<void(AsyncWebSocket *)> &function) {
+  for (AsyncWebServer *server : servers()) {
+    for (AsyncWebSocket *socket : server->sockets()) {
+      function(socket);
+    }
+  }
+}
+
+void hostWsConnect(uint32_t client) {
+  forEachSocket([client](AsyncWebSocket *socket) { socket->connect(client); });
+}
+
+void hostWsDisconnect(uint32_t client) {
+  forEachSocket([client](AsyncWebSocket *socket) { socket->disconnect(client); });
+}
+
+void hostWsSend(uint32_t client, const uint8_t *data, size_t size) {
+  forEachSocket([client, data, size](AsyncWebSocket *socket) { socket->receive(client, data, size); });
+}
+
+std::vector<std::vector<uint8_t>> hostWsTakeBroadcasts() {
+  std::lock_guard<std::mutex> lock(broadcastLock);
+  std::vector<std::vector<uint8_t>> taken;
+  taken.swap(broadcasts);
+  return taken;
+}
@@ -0,0 +1,179 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Test side of the host fakes (native env only)
+
+// Wait until every fake task is blocked and no timer callback is due or running
+void hostSettle();
+
+// Real time since process start (us)
+int64_t hostMicros();
+
+// Flush output and leave without static destructors (fake tasks never return)
+int hostExit(int code);
+
+// Set level of an input pin (buttons read it through GPIO_IN_REG)
+void hostSetInput(uint8_t pin, bool level);
+
+// Get driven output level of a pin (-1 if not an output)
+int hostOutputLevel(uint8_t pin);
+
+// Get last mode set for a pin (0 if never set)
+uint8_t hostPinMode(uint8_t pin);
+
+// Last color written to the status LED (0xRRGGBB)
+uint32_t hostLedColor();
+
+// Number of ESP.restart() calls
+uint32_t hostRestartCount();
+
+// Motor and encoder plant (integrated on the firmware clock whenever the encoder or motor pins are touched)
+struct HostMotorModel {
+  double countsPerPwm;    // Speed per PWM step while turning (counts/s)
+  int stallPwm;           // Turning motor stops below this PWM
+  int breakawayPwm;       // Stopped motor starts at or above this PWM
+  double coastCounts;     // Counts travelled after braking from full speed
+};
+void hostMotorSetModel(const HostMotorModel &model);
+HostMotorModel hostMotorDefaultModel();
+void hostMotorSetPosition(double position);
+double hostMotorPosition();
+int hostMotorCommand();    // Signed PWM driven right now (0 = stopped or braking)
+bool hostMotorTurning();
+
+// Nonvolatile storage
+void hostNvsClear();
+void hostNvsFailWrites(bool fail);
+uint32_t hostNvsWriteCount();
+
+// HTTP requests against all fake web servers
+struct HostResponse {
+  int status;             // 0 if no route matched and no not-found handler is set
+  std::string type;
+  std::string body;
+  std::string location;   // Redirect target
+  size_t chunks;          // Filler calls for chunked responses
+};
+HostResponse hostRequest(const char *method, const char *url, const char *user = nullptr,
+                         const char *password = nullptr);
+
+// Multipart upload in chunks, the connection drops after stopAfter bytes (response status 0)
+HostResponse hostUpload(const char *url, const uint8_t *data, size_t size, size_t chunk,
+                        size_t stopAfter = SIZE_MAX, const char *user = nullptr, const char *password = nullptr);
+
+// WebSocket clients of the fake server
+void hostWsConnect(uint32_t client);
+void hostWsDisconnect(uint32_t client);
+void hostWsSend(uint32_t client, const uint8_t *data, size_t size);
+std::vector<std::vector<uint8_t>> hostWsTakeBroadcasts();
+
+// Wi-Fi access point and provisioning portal
+void hostWifiSetAvailable(bool available);
+void hostWifiSetSaved(bool saved);
+void hostWifiSetConnectTime(uint32_t ms);
+void hostPortalSetProcessTime(uint32_t us);
+void hostPortalSubmit();
+bool hostPortalActive();
+uint32_t hostWifiBeginCount();
+
+// SNTP sync (runs the notification callback on the calling thread)
+void hostSntpSync(int64_t wallMicros);
+uint32_t hostSntpRestartCount();
+
+// Station MAC address
+void hostSetMac(const uint8_t mac[6]);
+
+// Simulated I2C bus
+struct HostI2cStats {
+  uint32_t transfers;       // Address phases on the bus
+  uint32_t nacks;
+  uint32_t collisions;      // Reads answered by more than one device
+  double busTimeUs;         // Time the bus was driven at its clock rate
+  uint32_t frequency;
+  uint32_t clearPulses;     // SCL pulses from bus recovery
+};
+HostI2cStats hostI2cStats();
+void hostI2cResetStats();
+void hostI2cRealTime(bool enabled);       // Transfers take their bus time in real time
+void hostI2cStickSda(uint8_t pulses);     // SDA held low until SCL is clocked this many times
+
+// Simulated VL53L0X sensors (xshut = PIN_NONE if not wired)
+using HostTofScene = std::function<uint16_t(int64_t timeUs)>;     // Distance (mm, 0 = no target)
+struct HostTofStats {
+  uint32_t transfers;
+  uint32_t measurements;
+  double rangingUs;     // Time spent ranging
+  uint8_t address;
+  bool ranging;
+};
+int hostTofAdd(uint8_t xshut);
+void hostTofClear();
+void hostTofSetScene(int sensor, HostTofScene scene);
+void hostTofSetAmbient(int sensor, HostTofScene ambient);    // Ambient rate (MCPS, 9.7 fixed point)
+void hostTofSetSignal(int sensor, HostTofScene signal);      // Return signal rate (MCPS, 9.7 fixed point)
+void hostTofSetNack(int sensor, bool nack);
+HostTofStats hostTofStats(int sensor);
+void hostTofResetStats();
+
+// Trace downloads (records of "/trace", deltas resolved)
+struct HostTraceRecord {
+  uint8_t type;         // TraceType
+  uint32_t time;        // Firmware time (ms)
+  int32_t value;
+};
+// Decode a download, bytes is set to the encoded record bytes (without header and padding)
+std::vector<HostTraceRecord> hostTraceDecode(const std::string &file, size_t *bytes = nullptr);
+// Feed recorded button levels and ToF ranges back in from now, calling step until the trace has ended
+void hostTraceReplay(const std::vector<HostTraceRecord> &records, const std::function<void()> &step);
+
+// In-process MQTT broker
+struct HostMqttMessage {
+  std::string topic;
+  std::string payload;
+  bool retain;
+  int64_t time;         // Broker receive time (us)
+};
+void hostBrokerStart(const char *uri);
+void hostBrokerStop();
+void hostBrokerPublish(const char *topic, const char *payload);
+void hostBrokerStall(uint32_t ms);      // Client send holds its lock this long per message
+std::vector<HostMqttMessage> hostBrokerTakeMessages();
+std::string hostBrokerRetained(const char *topic);
+bool hostBrokerConnected();
+
+// OTA partitions
+struct HostOtaStats {
+  size_t written;           // Bytes written to the open update
+  size_t largestWrite;      // Largest single esp_ota_write
+  uint32_t writes;
+  uint32_t begins;
+  uint32_t ends;
+  uint32_t aborts;
+};
+void hostOtaReset();
+HostOtaStats hostOtaStats();
+const char *hostOtaBootLabel();
+const char *hostOtaRunningLabel();
+std::vector<uint8_t> hostOtaImage(const char *label);
+void hostOtaReboot();       // Boot the selected partition (pending verify if it changed)
+bool hostOtaPendingVerify();
+
+// Calibrated travel of a booted device (encoder counts)
+constexpr int64_t OPEN_POS = 1000;
+constexpr int64_t CLOSE_POS = 0;
+// Boot the firmware core in main.cpp order: NVS, motor, saved positions (resting at lastPos), setupModules (I2C, ToF,
+// scheduler and the settings they load), then buttons and states
+void hostBootDevice(int64_t lastPos, const std::function<void()> &setupModules = nullptr);
+
+#endif // HOST_H
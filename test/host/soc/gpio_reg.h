@@ -0,0 +1,17 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#ifndef HOST_GPIO_REG_H
+#define HOST_GPIO_REG_H
+
+#include <cstdint>
+
+// Input levels of GPIO 0-31 (set by tests through hostSetInput)
+extern volatile uint32_t hostGpioIn;
+
+#define GPIO_IN_REG (&hostGpioIn)
+#define REG_READ(reg) (*(reg))
+
+#endif // HOST_GPIO_REG_H
@@ -0,0 +1,109 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include "clock.h"
+#include "trace.h"
+#include "host.h"
+
+// Read unsigned varint (false if it runs past the end)
+static bool readVarint(const uint8_t *data, size_t size, size_t &offset, uint32_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 35 && offset < size; shift += 7) {
+    uint8_t byte = data[offset++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<HostTraceRecord> hostTraceDecode(const std::string &file, size_t *bytes) {
+  std::vector<HostTraceRecord> records;
+  size_t used = 0;
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(file.data());
+  if (file.size() < 8 || memcmp(data, "ABTR", 4) != 0) {
+    if (bytes != nullptr) {
+      *bytes = 0;
+    }
+    return records;
+  }
+  uint8_t count = data[5];
+  uint16_t blockSize = (uint16_t)(data[6] | data[7] << 8);
+
+  for (uint8_t block = 0; block < count && 8 + (size_t)(block + 1) * blockSize <= file.size(); block++) {
+    const uint8_t *start = data + 8 + (size_t)block * blockSize;
+    uint32_t time;
+    memcpy(&time, start, sizeof(time));
+    int32_t lastValue[(size_t)TraceType::COUNT] = {};
+    size_t offset = sizeof(time);
+    // Padding after the last record reads as type 0
+    while (offset < blockSize && start[offset] != 0 && start[offset] < (uint8_t)TraceType::COUNT) {
+      size_t recordStart = offset;
+      uint8_t type = start[offset++];
+      uint32_t delta, coded;
+      if (!readVarint(start, blockSize, offset, delta) || !readVarint(start, blockSize, offset, coded)) {
+        offset = recordStart;
+        break;
+      }
+      time += delta;
+      int32_t value = (int32_t)coded;
+      if (type == (uint8_t)TraceType::TOF || type == (uint8_t)TraceType::POSITION) {
+        value = lastValue[type] + (int32_t)((coded >> 1) ^ (0u - (coded & 1)));
+        lastValue[type] = value;
+      }
+      records.push_back({type, time, value});
+    }
+    used += offset - sizeof(time);
+  }
+  if (bytes != nullptr) {
+    *bytes = used;
+  }
+  return records;
+}
+
+void hostTraceReplay(const std::vector<HostTraceRecord> &records, const std::function<void()> &step) {
+  if (records.empty()) {
+    return;
+  }
+  int64_t offset = clockMonotonic() / 1000 - records.front().time;
+
+  // Each sensor ranges the recorded distances, held until the next record
+  std::map<int, std::shared_ptr<std::vector<std::pair<int64_t, uint16_t>>>> ranges;
+  for (const HostTraceRecord &record : records) {
+    if (record.type != (uint8_t)TraceType::TOF) {
+      continue;
+    }
+    auto &samples = ranges[record.value & 0x03];
+    if (!samples) {
+      samples = std::make_shared<std::vector<std::pair<int64_t, uint16_t>>>();
+    }
+    samples->push_back({(record.time + offset) * 1000, (uint16_t)(record.value >> 2)});
+  }
+  for (auto &sensor : ranges) {
+    auto samples = sensor.second;
+    hostTofSetScene(sensor.first, [samples](int64_t timeUs) -> uint16_t {
+      auto next = std::upper_bound(samples->begin(), samples->end(), std::make_pair(timeUs, (uint16_t)UINT16_MAX));
+      return next == samples->begin() ? 0 : (next - 1)->second;
+    });
+  }
+
+  // Button levels change as the loop read them
+  int64_t end = (records.back().time + offset + 1000) * 1000;
+  size_t next = 0;
+  while (clockMonotonic() < end) {
+    int64_t now = clockMonotonic() / 1000;
+    for (; next < records.size() && records[next].time + offset <= now; next++) {
+      if (records[next].type == (uint8_t)TraceType::BUTTON) {
+        hostSetInput((uint8_t)(records[next].value >> 1), records[next].value & 1);
+      }
+    }
+    step();
+  }
+}
@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "states.h"
+#include "schedule.h"
+#include "remote.h"
+#include "bridge.h"
+#include "tasks.h"
+#include "host.h"
+
+static const char *const BROKER = "mqtt://broker.local:1883";
+static const char *const BASE = "autoblinds/000001/";
+
+// Longest gap between control runs (us)
+static std::atomic<int64_t> worstGap(0);
+static std::atomic<int64_t> lastControl(0);
+static std::atomic<bool> loopRunning(true);
+
+// Control task with a gap probe
+static void probedControl() {
+  int64_t now = hostMicros();
+  int64_t last = lastControl.exchange(now);
+  if (last != 0 && now - last > worstGap.load()) {
+    worstGap.store(now - last);
+  }
+  updateStateMachine();
+}
+
+static void loopThread() {
+  setupTasks();
+  addTask("control", probedControl, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("remote", updateRemote, REMOTE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("bridge", updateBridge, BRIDGE_PERIOD, TaskPriority::BACKGROUND);
+  while (loopRunning.load()) {
+    runTasks();
+  }
+}
+
+// Wait for a condition (false on timeout)
+template <typename Condition>
+static bool waitFor(Condition condition, int64_t timeoutUs) {
+  int64_t end = hostMicros() + timeoutUs;
+  while (!condition()) {
+    if (hostMicros() > end) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+static std::string topic(const char *suffix) {
+  return std::string(BASE) + suffix;
+}
+
+// Wait for a retained value at the broker
+static bool retainedBecomes(const char *suffix, const char *value, int64_t timeoutUs = 2000000) {
+  std::string name = topic(suffix);
+  return waitFor([&] { return hostBrokerRetained(name.c_str()) == value; }, timeoutUs);
+}
+
+// Wait for the retained position to match the blind after it coasted to a stop
+static bool positionRetained() {
+  std::string value = std::to_string(getPositionPercent());
+  return retainedBecomes("position", value.c_str());
+}
+
+// Count messages received on a topic
+static int countMessages(const std::vector<HostMqttMessage> &messages, const char *suffix) {
+  std::string name = topic(suffix);
+  int count = 0;
+  for (const HostMqttMessage &message : messages) {
+    count += message.topic == name;
+  }
+  return count;
+}
+
+// Move through the MQTT command topics and let the blind arrive
+static void moveTo(const char *command, const char *payload, int64_t position) {
+  hostBrokerPublish(topic(command).c_str(), payload);
+  TEST_ASSERT_TRUE(waitFor([] { return hostMotorCommand() != 0; }, 1000000));
+  hostMotorSetPosition(position);
+  TEST_ASSERT_TRUE(waitFor([] { return hostMotorCommand() == 0; }, 1000000));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Connecting announces the device and publishes retained state
+static void test_connect_publishes_retained() {
+  std::string url = std::string("/setMqtt?uri=") + BROKER;
+  hostRequest("GET", url.c_str());
+  TEST_ASSERT_TRUE(retainedBecomes("availability", "online"));
+  TEST_ASSERT_TRUE(retainedBecomes("state", "closed"));
+  TEST_ASSERT_TRUE(retainedBecomes("position", "0"));
+  TEST_ASSERT_FALSE(hostBrokerRetained("homeassistant/cover/000001/config").empty());
+}
+
+// Commands move the blind and the final state is retained
+static void test_commands_move_blind() {
+  moveTo("set", "OPEN", OPEN_POS);
+  TEST_ASSERT_TRUE(retainedBecomes("state", "open"));
+  TEST_ASSERT_TRUE(positionRetained());
+  moveTo("set_position", "25", 250);
+  TEST_ASSERT_TRUE(retainedBecomes("state", "stopped"));
+  TEST_ASSERT_TRUE(positionRetained());
+}
+
+// A position held back by the rate limit does not resend the retained state
+static void test_held_position_keeps_state() {
+  hostBrokerTakeMessages();
+  moveTo("set_position", "40", 400);
+  moveTo("set_position", "60", 600);
+  TEST_ASSERT_TRUE(positionRetained());
+  std::this_thread::sleep_for(std::chrono::milliseconds(2 * MQTT_PUBLISH_INTERVAL));
+  std::vector<HostMqttMessage> messages = hostBrokerTakeMessages();
+  int states = countMessages(messages, "state");
+  int positions = countMessages(messages, "position");
+  printf("two moves: %d state and %d position messages\n", states, positions);
+  // Opening and stopped once per move
+  TEST_ASSERT_LESS_OR_EQUAL(4, states);
+  TEST_ASSERT_LESS_OR_EQUAL(4, positions);
+}
+
+// A stalled broker and a settings change keep the client lock busy off the loop
+static void test_stalled_broker_keeps_loop_running() {
+  worstGap.store(0);
+  hostBrokerStall(300);
+  hostRequest("GET", "/open");
+  hostMotorSetPosition(OPEN_POS);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::string url = std::string("/setMqtt?uri=") + BROKER;
+  hostRequest("GET", url.c_str());
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  int64_t stalledGap = worstGap.load();
+  hostBrokerStall(0);
+  TEST_ASSERT_TRUE(retainedBecomes("state", "open", 5000000));
+  printf("worst loop gap with 300 ms broker stalls and a client restart: %lld us\n", (long long)stalledGap);
+  TEST_ASSERT_LESS_THAN(20000, (int)stalledGap);
+}
+
+// Broker loss publishes the will and the client comes back after the backoff
+static void test_broker_restart() {
+  hostBrokerStop();
+  TEST_ASSERT_TRUE(retainedBecomes("availability", "offline"));
+  hostBrokerStart(BROKER);
+  int64_t start = hostMicros();
+  TEST_ASSERT_TRUE(retainedBecomes("availability", "online", 5000000));
+  printf("reconnected %lld ms after the broker returned\n", (long long)(hostMicros() - start) / 1000);
+  TEST_ASSERT_TRUE(retainedBecomes("state", "open"));
+}
+
+int main() {
+  hostWifiSetAvailable(true);
+  hostWifiSetSaved(true);
+  hostBrokerStart(BROKER);
+
+  hostBootDevice(CLOSE_POS, [] {
+    setupScheduler();
+  });
+  hostSettle();
+  std::thread loop(loopThread);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_connect_publishes_retained);
+  RUN_TEST(test_commands_move_blind);
+  RUN_TEST(test_held_position_keeps_state);
+  RUN_TEST(test_stalled_broker_keeps_loop_running);
+  RUN_TEST(test_broker_restart);
+  loopRunning.store(false);
+  loop.join();
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,311 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "config.h"
+#include "clock.h"
+#include "buttonbank.h"
+#include "buttons.h"
+#include "host.h"
+
+using Bank = ButtonBank<ButtonSpec<PIN_BTN_OPEN, BTN_HOLD_TIME, BTN_DEBOUNCE>,
+                        ButtonSpec<PIN_BTN_CLOSE, BTN_HOLD_TIME, BTN_DEBOUNCE>,
+                        ButtonSpec<PIN_BTN_MODE, CONFIG_HOLD_TIME, BTN_DEBOUNCE>>;
+static constexpr uint8_t PINS[] = {PIN_BTN_OPEN, PIN_BTN_CLOSE, PIN_BTN_MODE};
+
+// Button array the bank replaced, kept as the reference (same fields and rules as the old buttons.cpp, with the
+// 32-bit unsigned long of the device)
+struct LegacyButton {
+  enum class State { IDLE, PRESSED, HELD };
+  const uint8_t pin;
+  State state;
+  bool lastReading;
+  uint32_t lastStateTime;
+  uint32_t pressStartTime;
+  bool holdTriggered;
+};
+
+struct Legacy {
+  LegacyButton buttons[3] = {
+    {PIN_BTN_OPEN, LegacyButton::State::IDLE, false, 0, 0, false},
+    {PIN_BTN_CLOSE, LegacyButton::State::IDLE, false, 0, 0, false},
+    {PIN_BTN_MODE, LegacyButton::State::IDLE, false, 0, 0, false},
+  };
+  std::vector<ButtonEvent> events;
+
+  void update(uint32_t levels, uint32_t currentTime) {
+    for (LegacyButton &button : buttons) {
+      bool reading = (levels >> button.pin) & 1;
+      if (reading != button.lastReading) {
+        button.lastStateTime = currentTime;
+      }
+      if ((currentTime - button.lastStateTime) > BTN_DEBOUNCE) {
+        bool isPressed = reading;
+        if (isPressed != (button.state != LegacyButton::State::IDLE)) {
+          if (isPressed) {
+            button.state = LegacyButton::State::PRESSED;
+            button.pressStartTime = currentTime;
+            button.holdTriggered = false;
+            events.push_back({button.pin, ButtonEdge::PRESS});
+          } else {
+            button.state = LegacyButton::State::IDLE;
+            events.push_back({button.pin, ButtonEdge::RELEASE});
+          }
+        } else if (button.state == LegacyButton::State::PRESSED && !button.holdTriggered) {
+          uint32_t holdDuration = (button.pin == PIN_BTN_MODE) ? CONFIG_HOLD_TIME : 500;
+          if ((currentTime - button.pressStartTime) >= holdDuration) {
+            button.state = LegacyButton::State::HELD;
+            button.holdTriggered = true;
+            events.push_back({button.pin, ButtonEdge::HOLD});
+          }
+        }
+      }
+      button.lastReading = reading;
+    }
+  }
+
+  bool isButtonDown(uint8_t pin) const {
+    for (const LegacyButton &button : buttons) {
+      if (button.pin == pin) {
+        return button.state != LegacyButton::State::IDLE;
+      }
+    }
+    return false;
+  }
+
+  bool isButtonHeld(uint8_t pin) const {
+    for (const LegacyButton &button : buttons) {
+      if (button.pin == pin) {
+        return button.state == LegacyButton::State::HELD;
+      }
+    }
+    return false;
+  }
+};
+
+// Level sequence with bouncy edges, taps, holds and long presses on all three buttons
+struct Stimulus {
+  uint32_t seed;
+  uint32_t levels = 0;
+  uint8_t bounce[32] = {};
+
+  uint32_t next() {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+  }
+
+  // Levels for the next update: a pin flips rarely, and chatters for a few updates after it does
+  uint32_t step() {
+    for (uint8_t pin : PINS) {
+      uint32_t roll = next() % 1000;
+      if (roll < 8) {
+        levels ^= 1u << pin;
+        bounce[pin] = 4;
+      } else if (bounce[pin] > 0) {
+        bounce[pin]--;
+        if (roll < 300) {
+          levels ^= 1u << pin;
+        }
+      }
+    }
+    return levels;
+  }
+
+  // Update interval (ms): mostly the task period, sometimes late
+  uint32_t interval() {
+    uint32_t roll = next() % 100;
+    return roll < 90 ? BUTTON_PERIOD / 1000 : 1 + roll % 40;
+  }
+};
+
+// Bank edges of the last update as events, in bank order like the button layer
+static void bankEvents(const Bank &bank, std::vector<ButtonEvent> &events) {
+  for (uint8_t i = 0; i < Bank::count; i++) {
+    uint8_t bit = 1 << i;
+    if (bank.pressed() & bit) {
+      events.push_back({Bank::pinOf(i), ButtonEdge::PRESS});
+    } else if (bank.heldEdge() & bit) {
+      events.push_back({Bank::pinOf(i), ButtonEdge::HOLD});
+    } else if (bank.released() & bit) {
+      events.push_back({Bank::pinOf(i), ButtonEdge::RELEASE});
+    }
+  }
+}
+
+static void assertSameEvents(const std::vector<ButtonEvent> &expected, const std::vector<ButtonEvent> &actual) {
+  TEST_ASSERT_EQUAL(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    TEST_ASSERT_EQUAL(expected[i].pin, actual[i].pin);
+    TEST_ASSERT_EQUAL((int)expected[i].edge, (int)actual[i].edge);
+  }
+}
+
+// Replay a stimulus through the reference and a bank from a start time, comparing every update
+static size_t compareFrom(uint32_t seed, uint32_t start, int updates) {
+  Legacy legacy;
+  Bank bank;
+  Stimulus stimulus{seed};
+  std::vector<ButtonEvent> events;
+  uint32_t time = start;
+  for (int n = 0; n < updates; n++) {
+    time += stimulus.interval();
+    uint32_t levels = stimulus.step();
+    legacy.update(levels, time);
+    bank.update(levels, time);
+    bankEvents(bank, events);
+    for (uint8_t pin : PINS) {
+      TEST_ASSERT_EQUAL(legacy.isButtonDown(pin), (bank.down() & Bank::maskOf(pin)) != 0);
+      TEST_ASSERT_EQUAL(legacy.isButtonHeld(pin), (bank.held() & Bank::maskOf(pin)) != 0);
+    }
+  }
+  assertSameEvents(legacy.events, events);
+  return events.size();
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Random bouncy presses give the same edges and states as the old per-button loop
+static void test_matches_legacy() {
+  size_t events = 0;
+  for (uint32_t seed = 1; seed <= 20; seed++) {
+    events += compareFrom(seed, 0, 20000);
+  }
+  printf("%zu events identical over 400000 updates\n", events);
+  TEST_ASSERT_GREATER_THAN(1000, events);
+}
+
+// Identical across the millisecond counter wrapping
+static void test_matches_legacy_across_wrap() {
+  for (uint32_t seed = 100; seed < 110; seed++) {
+    compareFrom(seed, UINT32_MAX - 30000, 20000);
+  }
+}
+
+// Each button holds after its own compile-time hold time
+static void test_hold_times() {
+  Bank bank;
+  uint32_t levels = (1u << PIN_BTN_OPEN) | (1u << PIN_BTN_MODE);
+  uint32_t openHeld = 0, modeHeld = 0;
+  for (uint32_t time = 1; time < 3000; time++) {
+    bank.update(levels, time);
+    if (bank.heldEdge() & Bank::maskOf(PIN_BTN_OPEN)) {
+      openHeld = time;
+    }
+    if (bank.heldEdge() & Bank::maskOf(PIN_BTN_MODE)) {
+      modeHeld = time;
+    }
+  }
+  // Down once stable for longer than the debounce (from 1 ms), held after the hold time from there
+  TEST_ASSERT_EQUAL(BTN_DEBOUNCE + 2 + BTN_HOLD_TIME, openHeld);
+  TEST_ASSERT_EQUAL(BTN_DEBOUNCE + 2 + CONFIG_HOLD_TIME, modeHeld);
+  TEST_ASSERT_EQUAL(0, bank.held() & Bank::maskOf(PIN_BTN_CLOSE));
+}
+
+// The button layer reads the same events through the GPIO register and its queue
+static void test_button_layer_matches_legacy() {
+  Legacy legacy;
+  Stimulus stimulus{7};
+  std::vector<ButtonEvent> events;
+  for (int n = 0; n < 20000; n++) {
+    advanceVirtualClock(stimulus.interval() * 1000);
+    uint32_t levels = stimulus.step();
+    for (uint8_t pin : PINS) {
+      hostSetInput(pin, (levels >> pin) & 1);
+    }
+    legacy.update(levels, clockMillis());
+    updateButtonStates();
+    ButtonEvent event;
+    while (pollButtonEvent(event)) {
+      events.push_back(event);
+    }
+    TEST_ASSERT_EQUAL(legacy.isButtonDown(PIN_BTN_MODE) ? BTN_MASK_MODE : 0, buttonsDown() & BTN_MASK_MODE);
+  }
+  assertSameEvents(legacy.events, events);
+}
+
+static constexpr int BENCH_UPDATES = 2000000;
+
+// Old loop: ns per update with the six pin queries (best of three)
+static double legacyCost(const std::vector<uint32_t> &levels, uint32_t &hits, size_t &events) {
+  double best = 1e9;
+  for (int round = 0; round < 3; round++) {
+    Legacy legacy;
+    hits = 0;
+    int64_t start = hostMicros();
+    for (int n = 0; n < BENCH_UPDATES; n++) {
+      legacy.update(levels[n % levels.size()], (uint32_t)n * 5);
+      for (uint8_t pin : PINS) {
+        hits += legacy.isButtonDown(pin) + legacy.isButtonHeld(pin);
+      }
+    }
+    best = std::min(best, (hostMicros() - start) * 1000.0 / BENCH_UPDATES);
+    events = legacy.events.size();
+  }
+  return best;
+}
+
+// Bank: ns per update with the same queries as mask tests (best of three)
+static double bankCost(const std::vector<uint32_t> &levels, uint32_t &hits, size_t &events) {
+  double best = 1e9;
+  for (int round = 0; round < 3; round++) {
+    Bank bank;
+    std::vector<ButtonEvent> edges;
+    hits = 0;
+    int64_t start = hostMicros();
+    for (int n = 0; n < BENCH_UPDATES; n++) {
+      bank.update(levels[n % levels.size()], (uint32_t)n * 5);
+      bankEvents(bank, edges);
+      // Masks are constants, as in the button layer
+      hits += ((bank.down() & BTN_MASK_OPEN) != 0) + ((bank.held() & BTN_MASK_OPEN) != 0) +
+              ((bank.down() & BTN_MASK_CLOSE) != 0) + ((bank.held() & BTN_MASK_CLOSE) != 0) +
+              ((bank.down() & BTN_MASK_MODE) != 0) + ((bank.held() & BTN_MASK_MODE) != 0);
+    }
+    best = std::min(best, (hostMicros() - start) * 1000.0 / BENCH_UPDATES);
+    events = edges.size();
+  }
+  return best;
+}
+
+// Update and query cost of the bank against the old loop, with no button touched and with constant presses
+static void test_benchmark() {
+  std::vector<uint32_t> idle(1, 0);
+  std::vector<uint32_t> busy(4096);
+  Stimulus stimulus{3};
+  for (uint32_t &level : busy) {
+    level = stimulus.step();
+  }
+
+  for (const std::vector<uint32_t> *levels : {&idle, &busy}) {
+    uint32_t legacyHits, bankHits;
+    size_t legacyEvents, bankEvents;
+    double legacy = legacyCost(*levels, legacyHits, legacyEvents);
+    double bank = bankCost(*levels, bankHits, bankEvents);
+    printf("%s: update + 6 queries: bank %.1f ns, legacy %.1f ns (%zu events)\n", levels == &idle ? "idle" : "busy",
+           bank, legacy, bankEvents);
+    TEST_ASSERT_EQUAL(legacyHits, bankHits);
+    TEST_ASSERT_EQUAL(legacyEvents, bankEvents);
+    TEST_ASSERT_LESS_THAN(legacy, bank);
+  }
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, false);
+  setupButtons();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_matches_legacy);
+  RUN_TEST(test_matches_legacy_across_wrap);
+  RUN_TEST(test_hold_times);
+  RUN_TEST(test_button_layer_matches_legacy);
+  RUN_TEST(test_benchmark);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,308 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <vector>
+#include "config.h"
+#include "clock.h"
+#include "buttons.h"
+#include "buttongesture.h"
+#include "states.h"
+#include "tasks.h"
+#include "host.h"
+
+static constexpr int64_t MID_POS = 400;
+static constexpr uint32_t STEP = BUTTON_PERIOD / 1000;   // Recognizer update interval (ms)
+
+// Scripted press (times in ms from the timeline start, mask of recognizer bits)
+struct Press {
+  uint32_t start;
+  uint32_t length;
+  uint8_t buttons;
+};
+
+// Gesture with the time it was reported
+struct Seen {
+  uint32_t time;
+  ButtonGestureEvent event;
+};
+
+// Feed a timeline to a fresh recognizer at the button task rate, cancelling buttons at a time like a consuming transition
+static std::vector<Seen> recognize(const std::vector<Press> &presses, uint32_t span, uint32_t cancelTime = UINT32_MAX,
+                                   uint8_t cancelButtons = 0) {
+  ButtonGestureRecognizer recognizer;
+  resetButtonGestures(recognizer);
+  std::vector<Seen> seen;
+  for (uint32_t t = 0; t <= span; t += STEP) {
+    uint8_t down = 0;
+    for (const Press &press : presses) {
+      if (t >= press.start && t < press.start + press.length) {
+        down |= press.buttons;
+      }
+    }
+    ButtonGestureEvent events[BUTTON_GESTURE_MAX_EVENTS];
+    uint8_t count = updateButtonGestures(recognizer, 1000 + t, down, events);
+    for (uint8_t i = 0; i < count; ++i) {
+      seen.push_back({t, events[i]});
+    }
+    if (t == cancelTime) {
+      cancelButtonGestures(recognizer, cancelButtons);
+    }
+  }
+  return seen;
+}
+
+static void expectGesture(const Seen &seen, ButtonGesture gesture, uint8_t buttons, uint8_t count) {
+  TEST_ASSERT_EQUAL((int)gesture, (int)seen.event.gesture);
+  TEST_ASSERT_EQUAL_HEX8(buttons, seen.event.buttons);
+  TEST_ASSERT_EQUAL(count, seen.event.count);
+}
+
+// Run the firmware with button presses at their times (us from start), returns when the motor first turned (-1 none)
+static int64_t runWithPresses(int64_t span, const std::vector<Press> &presses, int *firstCommand = nullptr) {
+  int64_t start = clockMonotonic();
+  int64_t turned = -1;
+  while (clockMonotonic() < start + span) {
+    int64_t t = (clockMonotonic() - start) / 1000;
+    for (uint8_t pin : {PIN_BTN_OPEN, PIN_BTN_CLOSE, PIN_BTN_MODE}) {
+      uint8_t mask = pin == PIN_BTN_OPEN ? BTN_MASK_OPEN : pin == PIN_BTN_CLOSE ? BTN_MASK_CLOSE : BTN_MASK_MODE;
+      bool level = false;
+      for (const Press &press : presses) {
+        level |= (press.buttons & mask) && t >= press.start && t < press.start + press.length;
+      }
+      hostSetInput(pin, level);
+    }
+    runTasks();
+    hostSettle();
+    if (turned < 0 && hostMotorCommand() != 0) {
+      turned = clockMonotonic() - start;
+      if (firstCommand != nullptr) {
+        *firstCommand = hostMotorCommand();
+      }
+    }
+  }
+  return turned;
+}
+
+// Idle blind at the middle with all buttons up and no pending gestures
+static void resetBlind() {
+  runWithPresses(1000000, {});
+  enterState(SystemState::TOGGLE_IDLE);
+  hostMotorSetPosition(MID_POS);
+  runWithPresses(1000000, {});
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Taps are counted and reported once the gap passes, the last possible tap at once
+static void test_tap_counts() {
+  std::vector<Seen> seen = recognize({{0, 100, BTN_MASK_OPEN}}, 2000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::TAP, BTN_MASK_OPEN, 1);
+  TEST_ASSERT_UINT32_WITHIN(STEP, 100 + BTN_TAP_GAP + STEP, seen[0].time);
+
+  seen = recognize({{0, 100, BTN_MASK_CLOSE}, {250, 100, BTN_MASK_CLOSE}}, 2000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::TAP, BTN_MASK_CLOSE, 2);
+
+  seen = recognize({{0, 100, BTN_MASK_OPEN}, {250, 100, BTN_MASK_OPEN}, {500, 100, BTN_MASK_OPEN}}, 2000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::TAP, BTN_MASK_OPEN, BTN_TAP_MAX);
+  TEST_ASSERT_EQUAL(600, seen[0].time);
+
+  // Taps further apart than the gap are separate sequences
+  seen = recognize({{0, 100, BTN_MASK_OPEN}, {100 + BTN_TAP_GAP + 100, 100, BTN_MASK_OPEN}}, 2000);
+  TEST_ASSERT_EQUAL(2, seen.size());
+  expectGesture(seen[0], ButtonGesture::TAP, BTN_MASK_OPEN, 1);
+  expectGesture(seen[1], ButtonGesture::TAP, BTN_MASK_OPEN, 1);
+}
+
+// A cancelled press reports nothing and drops the taps before it, the next press starts afresh
+static void test_cancelled_press() {
+  std::vector<Seen> seen = recognize({{0, 100, BTN_MASK_OPEN}, {250, 100, BTN_MASK_OPEN}, {500, 100, BTN_MASK_OPEN}},
+                                     2000, 250, BTN_MASK_OPEN);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::TAP, BTN_MASK_OPEN, 1);
+  TEST_ASSERT_UINT32_WITHIN(STEP, 600 + BTN_TAP_GAP + STEP, seen[0].time);
+
+  // Long presses too, and buttons that are up are not affected
+  seen = recognize({{0, BTN_LONG_TIME[0] + 500, BTN_MASK_OPEN}, {1500, 100, BTN_MASK_CLOSE}},
+                   BTN_LONG_TIME[0] + 1000, 1000, BTN_MASK_OPEN | BTN_MASK_CLOSE);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::TAP, BTN_MASK_CLOSE, 1);
+}
+
+// Presses slower than a tap report on release, tiers below the top on release, the top tier while held
+static void test_slow_and_long_presses() {
+  std::vector<Seen> seen = recognize({{0, BTN_TAP_TIME + 100, BTN_MASK_OPEN}}, 2000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::LONG, BTN_MASK_OPEN, 0);
+  TEST_ASSERT_EQUAL(BTN_TAP_TIME + 100, seen[0].time);
+
+  // A slow press ends a tap sequence without counting it
+  seen = recognize({{0, 100, BTN_MASK_OPEN}, {250, BTN_TAP_TIME + 100, BTN_MASK_OPEN}}, 2000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::LONG, BTN_MASK_OPEN, 0);
+
+  seen = recognize({{0, BTN_LONG_TIME[0] + 500, BTN_MASK_MODE}}, BTN_LONG_TIME[0] + 1000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::LONG, BTN_MASK_MODE, 1);
+  TEST_ASSERT_EQUAL(BTN_LONG_TIME[0] + 500, seen[0].time);
+
+  seen = recognize({{0, BTN_LONG_TIME[BTN_LONG_TIERS - 1] + 2000, BTN_MASK_MODE}},
+                   BTN_LONG_TIME[BTN_LONG_TIERS - 1] + 3000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::LONG, BTN_MASK_MODE, BTN_LONG_TIERS);
+  TEST_ASSERT_EQUAL(BTN_LONG_TIME[BTN_LONG_TIERS - 1], seen[0].time);
+}
+
+// Presses inside the chord window form a chord and leave no taps behind, presses further apart stay separate
+static void test_chord_or_taps() {
+  std::vector<Seen> seen =
+      recognize({{0, 200, BTN_MASK_OPEN}, {BTN_CHORD_WINDOW - 50, 150, BTN_MASK_CLOSE}}, 2000);
+  TEST_ASSERT_EQUAL(1, seen.size());
+  expectGesture(seen[0], ButtonGesture::CHORD, BTN_MASK_OPEN | BTN_MASK_CLOSE, 2);
+  TEST_ASSERT_EQUAL(BTN_CHORD_WINDOW - 50, seen[0].time);
+
+  seen = recognize({{0, 100, BTN_MASK_OPEN}, {BTN_CHORD_WINDOW + 50, 100, BTN_MASK_CLOSE}}, 2000);
+  TEST_ASSERT_EQUAL(2, seen.size());
+  expectGesture(seen[0], ButtonGesture::TAP, BTN_MASK_OPEN, 1);
+  expectGesture(seen[1], ButtonGesture::TAP, BTN_MASK_CLOSE, 1);
+}
+
+// A single tap opens only once a double tap is ruled out
+static void test_single_tap_waits_for_gap() {
+  resetBlind();
+  int command = 0;
+  int64_t turned = runWithPresses(2000000, {{100, 100, BTN_MASK_OPEN}}, &command);
+  // Release is seen after the debounce, the tap after the gap
+  int64_t latency = turned - 200000;
+  printf("single tap: motor starts %lld ms after release (gap %d ms, debounce %d ms)\n", (long long)latency / 1000,
+         BTN_TAP_GAP, BTN_DEBOUNCE);
+  TEST_ASSERT_GREATER_THAN(0, command);
+  TEST_ASSERT_GREATER_OR_EQUAL((int64_t)BTN_TAP_GAP * 1000, latency);
+  TEST_ASSERT_LESS_OR_EQUAL((int64_t)(BTN_TAP_GAP + BTN_DEBOUNCE + 3 * STEP) * 1000, latency);
+  TEST_ASSERT_GREATER_THAN(MID_POS, hostMotorPosition());
+
+  // A slow press moves on release
+  resetBlind();
+  turned = runWithPresses(2000000, {{100, BTN_TAP_TIME + 200, BTN_MASK_CLOSE}}, &command);
+  latency = turned - (100 + BTN_TAP_TIME + 200) * 1000LL;
+  printf("slow press: motor starts %lld ms after release\n", (long long)latency / 1000);
+  TEST_ASSERT_LESS_THAN(0, command);
+  TEST_ASSERT_LESS_OR_EQUAL((int64_t)(BTN_DEBOUNCE + 2 * STEP) * 1000, latency);
+}
+
+// A double or triple tap goes straight to its preset without starting the single tap move first
+static void test_multi_tap_moves_to_preset() {
+  resetBlind();
+  int command = 0;
+  int64_t turned = runWithPresses(2000000, {{100, 80, BTN_MASK_OPEN}, {300, 80, BTN_MASK_OPEN}}, &command);
+  int64_t latency = turned - 380000;
+  printf("double tap: motor starts %lld ms after the last release\n", (long long)latency / 1000);
+  // Presets default to 0 %, so an Open double tap closes
+  TEST_ASSERT_LESS_THAN(0, command);
+  TEST_ASSERT_LESS_THAN(MID_POS, hostMotorPosition());
+
+  resetBlind();
+  turned = runWithPresses(2000000, {{100, 80, BTN_MASK_OPEN}, {300, 80, BTN_MASK_OPEN}, {500, 80, BTN_MASK_OPEN}},
+                          &command);
+  latency = turned - 580000;
+  printf("triple tap: motor starts %lld ms after the last release\n", (long long)latency / 1000);
+  TEST_ASSERT_LESS_THAN(0, command);
+  TEST_ASSERT_LESS_OR_EQUAL((int64_t)(BTN_DEBOUNCE + 2 * STEP) * 1000, latency);
+}
+
+// Chords go through the transition table: stop a move, start calibrating
+static void test_chords_through_table() {
+  resetBlind();
+  triggerOpen();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_OPEN, (int)getState());
+  // Open then Close inside the window: the Close press interrupts, the chord keeps the Open release from acting
+  runWithPresses(2000000, {{100, 300, BTN_MASK_OPEN}, {150, 250, BTN_MASK_CLOSE}});
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+  TEST_ASSERT_EQUAL(0, hostMotorCommand());
+
+  resetBlind();
+  triggerClose();
+  runWithPresses(2000000, {{100, 300, BTN_MASK_CLOSE | BTN_MASK_MODE}});
+  TEST_ASSERT_EQUAL((int)SystemState::CONFIG_OPEN, (int)getState());
+  TEST_ASSERT_EQUAL(0, hostMotorCommand());
+  // The chord's releases do not walk the config steps
+  runWithPresses(1000000, {});
+  TEST_ASSERT_EQUAL((int)SystemState::CONFIG_OPEN, (int)getState());
+}
+
+// A tap that stops a move does not start another once the gap passes
+static void test_stopping_tap_is_consumed() {
+  resetBlind();
+  triggerClose();
+  runWithPresses(2000000, {{100, 100, BTN_MASK_OPEN}});
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+  TEST_ASSERT_EQUAL(0, hostMotorCommand());
+  TEST_ASSERT_LESS_OR_EQUAL(MID_POS, hostMotorPosition());
+}
+
+// Open and Close held into a long-press tier still move, lower tiers on release and the top tier once reached
+static void test_long_press_moves() {
+  for (uint32_t hold : {6000u, 11000u}) {
+    resetBlind();
+    int command = 0;
+    int64_t turned = runWithPresses((hold + 1000) * 1000LL, {{100, hold, BTN_MASK_OPEN}}, &command);
+    printf("open held %u ms: motor starts %lld ms after the press\n", hold, (long long)turned / 1000 - 100);
+    TEST_ASSERT_GREATER_THAN(0, command);
+    TEST_ASSERT_GREATER_THAN(MID_POS, hostMotorPosition());
+    int64_t tierTime = hold < BTN_LONG_TIME[BTN_LONG_TIERS - 1] ? 100 + hold : 100 + BTN_LONG_TIME[BTN_LONG_TIERS - 1];
+    TEST_ASSERT_INT64_WITHIN((BTN_DEBOUNCE + 2 * STEP) * 1000, (tierTime + BTN_DEBOUNCE) * 1000, turned);
+  }
+
+  resetBlind();
+  int command = 0;
+  runWithPresses(7000000, {{100, 6000, BTN_MASK_CLOSE}}, &command);
+  TEST_ASSERT_LESS_THAN(0, command);
+  TEST_ASSERT_LESS_THAN(MID_POS, hostMotorPosition());
+}
+
+// A tap right after a stopping tap counts on its own instead of making a double tap
+static void test_tap_after_stop() {
+  resetBlind();
+  triggerClose();
+  runWithPresses(250000, {{100, 80, BTN_MASK_OPEN}});
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+  int64_t stopped = hostMotorPosition();
+  // Inside the tap gap of the stopping tap: a double tap would go to the 0 % preset and close
+  int command = 0;
+  runWithPresses(2000000, {{0, 80, BTN_MASK_OPEN}}, &command);
+  TEST_ASSERT_GREATER_THAN(0, command);
+  TEST_ASSERT_GREATER_THAN(stopped, hostMotorPosition());
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+
+  hostBootDevice(MID_POS);
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("buttons", updateButtonInput, BUTTON_PERIOD, TaskPriority::SENSOR);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_tap_counts);
+  RUN_TEST(test_cancelled_press);
+  RUN_TEST(test_slow_and_long_presses);
+  RUN_TEST(test_chord_or_taps);
+  RUN_TEST(test_single_tap_waits_for_gap);
+  RUN_TEST(test_multi_tap_moves_to_preset);
+  RUN_TEST(test_chords_through_table);
+  RUN_TEST(test_stopping_tap_is_consumed);
+  RUN_TEST(test_long_press_moves);
+  RUN_TEST(test_tap_after_stop);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,100 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <ctime>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "states.h"
+#include "schedule.h"
+#include "host.h"
+
+static constexpr int64_t PARK_POS = 300;
+
+// Boot at 08:00 EST on 2025-01-01, an hour after the 07:00 event
+static constexpr int64_t BOOT_TIME = CLOCK_VIRTUAL_START + 13 * 3600;
+static constexpr time_t MISSED_EVENT = BOOT_TIME - 3600;
+
+// Count and park started moves
+static int moveStarts = 0;
+
+static void takeMoveStart() {
+  if (hostMotorCommand() != 0) {
+    moveStarts++;
+    triggerStop();
+    hostMotorSetPosition(PARK_POS);
+  }
+}
+
+// Run the schedule task once a minute for a span (s)
+static void runSchedule(int64_t spanSeconds) {
+  for (int64_t t = 0; t < spanSeconds; t += 60) {
+    advanceVirtualClock(60000000LL);
+    checkSchedule();
+    takeMoveStart();
+  }
+}
+
+void setUp() {
+  moveStarts = 0;
+}
+
+void tearDown() {
+}
+
+// Event missed while powered off within the grace window runs once at boot
+static void test_boot_catch_up() {
+  checkSchedule();
+  takeMoveStart();
+  TEST_ASSERT_EQUAL(1, moveStarts);
+  TEST_ASSERT_EQUAL((uint32_t)MISSED_EVENT, loadLastEvent());
+  runSchedule(600);
+  TEST_ASSERT_EQUAL(1, moveStarts);
+}
+
+// Jumping past an event beyond the grace window skips it
+static void test_jump_past_grace() {
+  // 08:10 to 12:10 the next day passes the 07:00 event by five hours
+  advanceVirtualClock(28LL * 3600 * 1000000);
+  checkSchedule();
+  takeMoveStart();
+  TEST_ASSERT_EQUAL(0, moveStarts);
+  // The 20:00 event still fires on time
+  runSchedule(8 * 3600);
+  TEST_ASSERT_EQUAL(1, moveStarts);
+}
+
+// A clock sync after missing an event applies it once, not again through the due check
+static void test_sync_catch_up() {
+  // 20:10 to 07:30, then sync (07:00 is within the grace window)
+  advanceVirtualClock((11LL * 3600 + 20 * 60) * 1000000);
+  hostSntpSync(clockWall());
+  checkSchedule();
+  takeMoveStart();
+  TEST_ASSERT_EQUAL(1, moveStarts);
+  runSchedule(3600);
+  TEST_ASSERT_EQUAL(1, moveStarts);
+}
+
+int main() {
+  startVirtualClock(BOOT_TIME * 1000000LL, false);
+  hostBootDevice(PARK_POS, [] {
+    const ScheduleEntry entries[] = {
+      {0x7F, 7 * 60, ScheduleAction::OPEN, 0, ScheduleBase::TIME},
+      {0x7F, 20 * 60, ScheduleAction::CLOSE, 0, ScheduleBase::TIME},
+    };
+    saveSchedule(entries, 2);
+    // The 07:00 event of the day before was the last one applied
+    saveLastEvent((uint32_t)(MISSED_EVENT - 86400));
+    setupScheduler();
+  });
+
+  UNITY_BEGIN();
+  RUN_TEST(test_boot_catch_up);
+  RUN_TEST(test_jump_past_grace);
+  RUN_TEST(test_sync_catch_up);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,215 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "config.h"
+#include "gesture.h"
+#include "host.h"
+
+// Sample period in active ranging (ms)
+static constexpr uint32_t SAMPLE_PERIOD = 33;
+static constexpr int TRACES = 200;
+
+// Distance at a time along the trace (mm, 0 = nothing in range)
+struct Keyframe {
+  uint32_t time;
+  uint16_t distance;
+};
+
+// Outcome of a replayed trace
+struct Replay {
+  TofGesture first;       // First gesture reported
+  int gestures;           // Gestures other than hold updates
+  uint8_t percent;        // Last hold position
+  uint32_t latency;       // Trace start to first gesture (ms)
+};
+
+static GestureRecognizer recognizer;
+static uint32_t clockTime = 1000;
+static uint32_t seed = 1;
+static int64_t samples = 0;
+static int64_t sampleNanos = 0;
+
+static uint32_t nextRandom() {
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 16;
+}
+
+// Uniform integer in [low, high]
+static int randomBetween(int low, int high) {
+  return low + (int)(nextRandom() % (uint32_t)(high - low + 1));
+}
+
+static TofGesture feed(uint16_t distance, uint8_t &percent) {
+  auto start = std::chrono::steady_clock::now();
+  TofGesture gesture = updateGesture(recognizer, clockTime, distance, percent);
+  sampleNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  samples++;
+  clockTime += SAMPLE_PERIOD;
+  return gesture;
+}
+
+// Replay keyframes with sensor noise and dropouts, then an empty second
+static Replay replay(const std::vector<Keyframe> &keyframes, int noise, int dropoutPercent) {
+  Replay result = {TofGesture::NONE, 0, 0, 0};
+  uint32_t start = clockTime;
+  uint32_t end = keyframes.back().time + 1000;
+  for (uint32_t t = 0; t < end; t += SAMPLE_PERIOD) {
+    uint16_t distance = 0;
+    if (t <= keyframes.back().time) {
+      size_t i = 1;
+      while (i < keyframes.size() - 1 && keyframes[i].time < t) {
+        i++;
+      }
+      const Keyframe &a = keyframes[i - 1];
+      const Keyframe &b = keyframes[i];
+      int32_t span = (int32_t)(b.time - a.time);
+      int32_t offset = std::min((int32_t)(t - a.time), span);
+      int32_t value = a.distance + (span > 0 ? ((int32_t)b.distance - a.distance) * offset / span : 0);
+      value += noise > 0 ? randomBetween(-noise, noise) : 0;
+      distance = (uint16_t)std::max(value, 1);
+      if (randomBetween(0, 99) < dropoutPercent) {
+        distance = 0;
+      }
+    }
+    uint8_t percent = 0;
+    TofGesture gesture = feed(distance, percent);
+    if (gesture == TofGesture::NONE) {
+      continue;
+    }
+    if (result.first == TofGesture::NONE) {
+      result.first = gesture;
+      result.latency = clockTime - SAMPLE_PERIOD - start;
+    }
+    if (gesture == TofGesture::HOLD) {
+      result.percent = percent;
+    } else {
+      result.gestures++;
+    }
+  }
+  return result;
+}
+
+// Quick dip close to the sensor, a short touch and back out
+static std::vector<Keyframe> tapTrace() {
+  uint32_t in = randomBetween(80, 140);
+  uint32_t touch = in + randomBetween(70, 110);
+  uint16_t close = randomBetween(8, 16);
+  return {{0, 280}, {in, close}, {touch, close}, {touch + randomBetween(60, 120), 290}};
+}
+
+// Fast move toward the sensor that stops short of a tap
+static std::vector<Keyframe> approachTrace() {
+  uint32_t arrive = randomBetween(100, 250);
+  uint32_t stay = arrive + randomBetween(400, 700);
+  uint16_t close = randomBetween(50, 90);
+  return {{0, 290}, {arrive, close}, {stay, close}};
+}
+
+// Hand resting near the sensor that is pulled away fast
+static std::vector<Keyframe> retreatTrace() {
+  uint16_t close = randomBetween(50, 90);
+  uint32_t leave = randomBetween(200, 500);
+  return {{0, close}, {leave, close}, {leave + randomBetween(150, 300), 335}};
+}
+
+// Hand held still at a distance
+static std::vector<Keyframe> holdTrace(uint16_t distance) {
+  return {{0, distance}, {(uint32_t)randomBetween(1300, 1800), distance}};
+}
+
+// Expected hold position for a distance
+static int expectedPercent(uint16_t distance) {
+  return (int)(GESTURE_HOLD_FAR - distance) * 100 / (GESTURE_HOLD_FAR - GESTURE_HOLD_NEAR);
+}
+
+// Replay a class of traces and return how many were recognized as expected
+static int recognized(const char *name, std::vector<Keyframe> (*trace)(), TofGesture expected, int noise,
+                      int dropoutPercent) {
+  int correct = 0;
+  uint32_t worstLatency = 0;
+  for (int i = 0; i < TRACES; ++i) {
+    Replay result = replay(trace(), noise, dropoutPercent);
+    if (result.first == expected && result.gestures == 1) {
+      correct++;
+      worstLatency = std::max(worstLatency, result.latency);
+    }
+  }
+  printf("%-8s noise %d mm, %2d%% dropouts: %3d/%d recognized, worst latency %u ms\n", name, noise, dropoutPercent,
+         correct, TRACES, worstLatency);
+  return correct;
+}
+
+void setUp() {
+  resetGesture(recognizer);
+}
+
+void tearDown() {
+}
+
+// Quick passes close to the sensor are taps even though they approach fast
+static void test_taps() {
+  TEST_ASSERT_EQUAL(TRACES, recognized("tap", tapTrace, TofGesture::TAP, 0, 0));
+  TEST_ASSERT_GREATER_OR_EQUAL(TRACES * 95 / 100, recognized("tap", tapTrace, TofGesture::TAP, 3, 5));
+}
+
+// Fast moves toward or away from the sensor are reported once
+static void test_swipes() {
+  TEST_ASSERT_EQUAL(TRACES, recognized("approach", approachTrace, TofGesture::APPROACH, 0, 0));
+  TEST_ASSERT_GREATER_OR_EQUAL(TRACES * 95 / 100, recognized("approach", approachTrace, TofGesture::APPROACH, 3, 5));
+  TEST_ASSERT_EQUAL(TRACES, recognized("retreat", retreatTrace, TofGesture::RETREAT, 0, 0));
+  TEST_ASSERT_GREATER_OR_EQUAL(TRACES * 95 / 100, recognized("retreat", retreatTrace, TofGesture::RETREAT, 3, 5));
+}
+
+// A held hand reports the position for its distance and nothing else
+static void test_holds() {
+  int correct = 0;
+  int worstError = 0;
+  for (int i = 0; i < TRACES; ++i) {
+    uint16_t distance = randomBetween(GESTURE_HOLD_NEAR + 10, GESTURE_HOLD_FAR - 10);
+    Replay result = replay(holdTrace(distance), 3, 5);
+    int error = std::abs((int)result.percent - expectedPercent(distance));
+    if (result.first == TofGesture::HOLD && result.gestures == 0) {
+      correct++;
+      worstError = std::max(worstError, error);
+    }
+  }
+  printf("hold     noise 3 mm,  5%% dropouts: %3d/%d recognized, worst position error %d%%\n", correct, TRACES,
+         worstError);
+  TEST_ASSERT_GREATER_OR_EQUAL(TRACES * 95 / 100, correct);
+  TEST_ASSERT_LESS_OR_EQUAL(10, worstError);
+}
+
+// Isolated close readings are noise, not gestures
+static void test_spikes_ignored() {
+  uint8_t percent = 0;
+  int gestures = 0;
+  bool spiked = false;
+  for (int i = 0; i < 3000; ++i) {
+    spiked = !spiked && randomBetween(0, 99) < 20;
+    gestures += feed(spiked ? (uint16_t)randomBetween(5, 200) : 0, percent) != TofGesture::NONE;
+  }
+  TEST_ASSERT_EQUAL(0, gestures);
+}
+
+// Per-sample cost over everything replayed so far
+static void test_sample_cost() {
+  printf("%lld samples, %.0f ns per sample\n", (long long)samples, (double)sampleNanos / samples);
+  TEST_ASSERT_GREATER_THAN(0, samples);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_taps);
+  RUN_TEST(test_swipes);
+  RUN_TEST(test_holds);
+  RUN_TEST(test_spikes_ignored);
+  RUN_TEST(test_sample_cost);
+  return hostExit(UNITY_END());
+}
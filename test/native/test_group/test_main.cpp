@@ -0,0 +1,254 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <AsyncUDP.h>
+#include "config.h"
+#include "memory.h"
+#include "states.h"
+#include "schedule.h"
+#include "group.h"
+#include "timekeeping.h"
+#include "tasks.h"
+#include "host.h"
+#include "fake_pins.h"
+
+static constexpr uint8_t GROUP = 7;
+static constexpr uint32_t PEER_ID = 0x0BADF00D;
+
+// Datagram as seen on the wire
+struct Datagram {
+  uint8_t type;
+  uint8_t group;
+  uint8_t percent;
+  uint16_t sequence;
+  uint32_t sender;
+  int64_t time;
+  int64_t received;    // Wall time at the peer (us)
+};
+
+// Peer member on the same multicast group
+static AsyncUDP peer;
+static std::mutex peerLock;
+static std::vector<Datagram> peerReceived;
+
+// Motor starts seen on the driver pins (wall time, us)
+static std::mutex startLock;
+static std::vector<int64_t> motorStarts;
+static std::atomic<bool> loopRunning(true);
+
+static void loopThread() {
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("group", updateGroup, GROUP_PERIOD, TaskPriority::CONTROL);
+  while (loopRunning.load()) {
+    runTasks();
+  }
+}
+
+// Wait for a condition (false on timeout)
+template <typename Condition>
+static bool waitFor(Condition condition, int64_t timeoutUs) {
+  int64_t end = hostMicros() + timeoutUs;
+  while (!condition()) {
+    if (hostMicros() > end) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+// Send a datagram from the peer
+static void peerSend(uint8_t type, uint8_t group, uint8_t percent, uint16_t sequence, int64_t time,
+                     size_t length = 20) {
+  uint8_t buffer[24] = {'A', 'B', 1, type, group, percent, (uint8_t)sequence, (uint8_t)(sequence >> 8)};
+  for (int i = 0; i < 4; ++i) {
+    buffer[8 + i] = (PEER_ID >> (8 * i)) & 0xFF;
+  }
+  for (int i = 0; i < 8; ++i) {
+    buffer[12 + i] = ((uint64_t)time >> (8 * i)) & 0xFF;
+  }
+  IPAddress address(GROUP_MULTICAST_ADDR[0], GROUP_MULTICAST_ADDR[1], GROUP_MULTICAST_ADDR[2], GROUP_MULTICAST_ADDR[3]);
+  peer.writeTo(buffer, length, address, GROUP_PORT);
+}
+
+// Datagrams the device sent since the last call
+static std::vector<Datagram> takeDeviceDatagrams() {
+  std::lock_guard<std::mutex> lock(peerLock);
+  std::vector<Datagram> taken;
+  for (const Datagram &datagram : peerReceived) {
+    if (datagram.sender != PEER_ID) {
+      taken.push_back(datagram);
+    }
+  }
+  peerReceived.clear();
+  return taken;
+}
+
+static std::vector<int64_t> takeMotorStarts() {
+  std::lock_guard<std::mutex> lock(startLock);
+  std::vector<int64_t> taken;
+  taken.swap(motorStarts);
+  return taken;
+}
+
+// Stop at a position and let the group task report it
+static void arriveAt(int64_t position) {
+  hostMotorSetPosition(position);
+  TEST_ASSERT_TRUE(waitFor([] { return hostMotorCommand() == 0; }, 1000000));
+}
+
+void setUp() {
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  takeDeviceDatagrams();
+  takeMotorStarts();
+}
+
+void tearDown() {
+}
+
+// A peer's move starts the motor once at the shared start time
+static void test_peer_move_starts_on_time() {
+  int64_t start = timeNowMicros() + 300000;
+  for (int i = 0; i < GROUP_SEND_REPEATS; ++i) {
+    peerSend(0x01, GROUP, 50, 1, start);
+  }
+  TEST_ASSERT_TRUE(waitFor([] { return hostMotorCommand() != 0; }, 1000000));
+  arriveAt(500);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::vector<int64_t> starts = takeMotorStarts();
+  TEST_ASSERT_EQUAL(1, starts.size());
+  printf("peer move started %lld us after the shared start time\n", (long long)(starts[0] - start));
+  TEST_ASSERT_INT_WITHIN(10000, 0, starts[0] - start);
+
+  // Completion is reported once with the reached position
+  std::vector<Datagram> sent = takeDeviceDatagrams();
+  TEST_ASSERT_EQUAL(1, sent.size());
+  TEST_ASSERT_EQUAL(0x02, sent[0].type);
+  TEST_ASSERT_EQUAL(GROUP, sent[0].group);
+  TEST_ASSERT_EQUAL(50, sent[0].percent);
+}
+
+// A peer that rebooted restarts its sequence, and its next move is not taken for a repeat of the last one
+static void test_peer_reboot_move() {
+  int64_t start = timeNowMicros() + 300000;
+  for (int i = 0; i < GROUP_SEND_REPEATS; ++i) {
+    peerSend(0x01, GROUP, 30, 1, start);
+  }
+  TEST_ASSERT_TRUE(waitFor([] { return hostMotorCommand() != 0; }, 1000000));
+  arriveAt(300);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  TEST_ASSERT_EQUAL(1, takeMotorStarts().size());
+  std::vector<Datagram> sent = takeDeviceDatagrams();
+  TEST_ASSERT_EQUAL(1, sent.size());
+  TEST_ASSERT_INT_WITHIN(1, 30, sent[0].percent);
+}
+
+// A local group move is announced with repeats and starts with the lead time
+static void test_local_move_announced() {
+  int64_t requested = timeNowMicros();
+  TEST_ASSERT_EQUAL(200, hostRequest("GET", "/groupMove?percent=80").status);
+  TEST_ASSERT_TRUE(waitFor([] { return hostMotorCommand() != 0; }, 2000000));
+  arriveAt(800);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  std::vector<Datagram> sent = takeDeviceDatagrams();
+  TEST_ASSERT_EQUAL(GROUP_SEND_REPEATS + 1, sent.size());
+  for (int i = 0; i < GROUP_SEND_REPEATS; ++i) {
+    TEST_ASSERT_EQUAL(0x01, sent[i].type);
+    TEST_ASSERT_EQUAL(80, sent[i].percent);
+    TEST_ASSERT_EQUAL(sent[0].sequence, sent[i].sequence);
+  }
+  TEST_ASSERT_INT_WITHIN(50000, requested + (int64_t)GROUP_LEAD_TIME * 1000, sent[0].time);
+  std::vector<int64_t> starts = takeMotorStarts();
+  TEST_ASSERT_EQUAL(1, starts.size());
+  printf("local move started %lld us after the announced start time\n", (long long)(starts[0] - sent[0].time));
+  TEST_ASSERT_INT_WITHIN(10000, 0, starts[0] - sent[0].time);
+}
+
+// Other groups, stale or distant start times, and malformed datagrams are ignored
+static void test_rejected_moves() {
+  int64_t now = timeNowMicros();
+  peerSend(0x01, GROUP + 1, 20, 10, now + 100000);
+  peerSend(0x01, GROUP, 20, 11, now - 1000000);
+  peerSend(0x01, GROUP, 20, 12, now + (int64_t)(GROUP_MAX_LEAD + 1000) * 1000);
+  peerSend(0x01, GROUP, 20, 13, now + 100000, 19);
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  TEST_ASSERT_EQUAL(0, takeMotorStarts().size());
+  TEST_ASSERT_EQUAL(0, hostMotorCommand());
+}
+
+// Peer completion reports show up in the member list
+static void test_member_report() {
+  peerSend(0x02, GROUP, 35, 20, timeNowMicros());
+  std::string id = "\"id\":\"0badf00d\",\"percent\":35";
+  TEST_ASSERT_TRUE(waitFor([&] { return hostRequest("GET", "/group").body.find(id) != std::string::npos; }, 1000000));
+}
+
+int main() {
+  hostWifiSetAvailable(true);
+  hostWifiSetSaved(true);
+  hostAddPinListener([](uint8_t pin, bool before) {
+    static int lastCommand = 0;
+    if (before || (pin != PIN_MTR_PWM && pin != PIN_MTR_IN1 && pin != PIN_MTR_IN2)) {
+      return;
+    }
+    int command = hostMotorCommand();
+    if (command != 0 && lastCommand == 0) {
+      std::lock_guard<std::mutex> lock(startLock);
+      motorStarts.push_back(timeNowMicros());
+    }
+    lastCommand = command;
+  });
+
+  IPAddress address(GROUP_MULTICAST_ADDR[0], GROUP_MULTICAST_ADDR[1], GROUP_MULTICAST_ADDR[2], GROUP_MULTICAST_ADDR[3]);
+  if (!peer.listenMulticast(address, GROUP_PORT)) {
+    printf("multicast on loopback unavailable\n");
+    return 1;
+  }
+  peer.onPacket([](AsyncUDPPacket &packet) {
+    const uint8_t *data = packet.data();
+    if (packet.length() != 20) {
+      return;
+    }
+    Datagram datagram = {data[3], data[4], data[5], (uint16_t)(data[6] | data[7] << 8), 0, 0, timeNowMicros()};
+    for (int i = 0; i < 4; ++i) {
+      datagram.sender |= (uint32_t)data[8 + i] << (8 * i);
+    }
+    for (int i = 0; i < 8; ++i) {
+      datagram.time |= (int64_t)data[12 + i] << (8 * i);
+    }
+    std::lock_guard<std::mutex> lock(peerLock);
+    peerReceived.push_back(datagram);
+  });
+
+  hostBootDevice(CLOSE_POS, [] {
+    saveGroup(GROUP);
+    setupScheduler();
+  });
+  hostSettle();
+  std::thread loop(loopThread);
+  // Wait for the device to join the multicast group
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  UNITY_BEGIN();
+  RUN_TEST(test_peer_move_starts_on_time);
+  RUN_TEST(test_peer_reboot_move);
+  RUN_TEST(test_local_move_announced);
+  RUN_TEST(test_rejected_moves);
+  RUN_TEST(test_member_report);
+  loopRunning.store(false);
+  loop.join();
+  peer.close();
+  return hostExit(UNITY_END());
+}
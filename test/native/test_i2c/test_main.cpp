@@ -0,0 +1,156 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+#include "clock.h"
+#include "i2c.h"
+#include "tof.h"
+#include "states.h"
+#include "metrics.h"
+#include "tasks.h"
+#include "host.h"
+
+static constexpr int64_t SECOND = 1000000;
+
+static AsyncWebServer server(80);
+static bool near = false;
+static int64_t loopBlockedUs = 0;
+static int64_t loopBlockedWorst = 0;
+static uint32_t loopRuns = 0;
+
+// Someone in the interest zone keeps the sensor ranging back to back
+static uint16_t scene(int64_t timeUs) {
+  return near ? 450 : 0;
+}
+
+// ToF task timed in real time, the share of the loop a transfer could block
+static void timedTofInput() {
+  int64_t start = hostMicros();
+  updateTofInput();
+  int64_t span = hostMicros() - start;
+  loopBlockedUs += span;
+  loopBlockedWorst = std::max(loopBlockedWorst, span);
+  loopRuns++;
+}
+
+static void runFor(int64_t span) {
+  int64_t end = clockMonotonic() + span;
+  while (clockMonotonic() < end) {
+    runTasks();
+    // The I2C task outranks the loop on the device, let it finish before the clock jumps
+    hostSettle();
+  }
+}
+
+// Read a sample value from the /metrics export, skipping its HELP line (-1 if missing)
+static double sampleValue(const char *sample) {
+  std::string body = hostRequest("GET", "/metrics").body;
+  size_t pos = body.find(std::string("\n") + sample);
+  return pos == std::string::npos ? -1 : strtod(body.c_str() + pos + 1 + strlen(sample), nullptr);
+}
+
+void setUp() {
+  hostI2cResetStats();
+  hostTofResetStats();
+}
+
+void tearDown() {
+}
+
+// Reads are queued and finish on the I2C task, the loop only pays for queueing and collecting
+static void test_read_latency_and_blocking() {
+  near = true;
+  runFor(5 * SECOND);
+  hostI2cRealTime(true);
+  hostI2cResetStats();
+  hostTofResetStats();
+  double readSum = sampleValue("autoblinds_tof_read_us_sum ");
+  double readCount = sampleValue("autoblinds_tof_read_us_count ");
+  double jobSum = sampleValue("autoblinds_i2c_job_us_sum ");
+  double jobCount = sampleValue("autoblinds_i2c_job_us_count ");
+  loopBlockedUs = loopBlockedWorst = loopRuns = 0;
+  runFor(30 * SECOND);
+  hostI2cRealTime(false);
+
+  HostI2cStats bus = hostI2cStats();
+  HostTofStats sensor = hostTofStats(0);
+  double reads = sampleValue("autoblinds_tof_read_us_count ") - readCount;
+  double readMean = (sampleValue("autoblinds_tof_read_us_sum ") - readSum) / reads;
+  double jobMean = (sampleValue("autoblinds_i2c_job_us_sum ") - jobSum) /
+                   (sampleValue("autoblinds_i2c_job_us_count ") - jobCount);
+  double busPerRead = bus.busTimeUs / sensor.measurements;
+  printf("%.0f reads at %u kHz: read latency mean %.0f us, job %.0f us, bus %.0f us per measurement; "
+         "loop in ToF task mean %.1f us, worst %lld us over %u runs\n",
+         reads, bus.frequency / 1000, readMean, jobMean, busPerRead, (double)loopBlockedUs / loopRuns,
+         (long long)loopBlockedWorst, loopRuns);
+  TEST_ASSERT_EQUAL(I2C_FREQUENCY, bus.frequency);
+  TEST_ASSERT_GREATER_THAN(0, reads);
+  // A synchronous read would hold the loop for the whole bus time of every measurement
+  TEST_ASSERT_LESS_THAN(busPerRead / 2, (double)loopBlockedUs / loopRuns);
+  near = false;
+}
+
+// A sensor that stops acknowledging is retried with growing backoff and picked up again once it answers
+static void test_nack_backoff() {
+  double recoveries = sampleValue("autoblinds_i2c_recoveries_total ");
+  hostTofSetNack(0, true);
+  runFor(30 * SECOND);
+  double attempts = sampleValue("autoblinds_i2c_recoveries_total ") - recoveries;
+  hostTofSetNack(0, false);
+  int64_t release = clockMonotonic();
+  hostTofResetStats();
+  while (hostTofStats(0).measurements == 0 && clockMonotonic() < release + 2 * I2C_BACKOFF_MAX * 1000LL) {
+    runFor(10000);
+  }
+  int64_t recovery = clockMonotonic() - release;
+  printf("30 s without acknowledge: %.0f failed attempts, measuring again %lld ms after release\n", attempts,
+         (long long)recovery / 1000);
+  // 10 ms doubling to 10 s is 11 tries in the first 10 s, then one per 10 s
+  TEST_ASSERT_LESS_OR_EQUAL(14.0, attempts);
+  TEST_ASSERT_GREATER_THAN(0, hostTofStats(0).measurements);
+  TEST_ASSERT_LESS_OR_EQUAL((I2C_BACKOFF_MAX + 2 * TOF_IDLE_PERIOD) * 1000LL, recovery);
+}
+
+// SDA held low by a device is released by clocking SCL, and sampling resumes
+static void test_stuck_sda() {
+  runFor(SECOND);
+  hostI2cResetStats();
+  hostI2cStickSda(5);
+  runFor(SECOND);
+  HostI2cStats bus = hostI2cStats();
+  hostTofResetStats();
+  runFor(SECOND);
+  printf("stuck SDA: %u clear pulses, %u measurements in the next second\n", bus.clearPulses,
+         hostTofStats(0).measurements);
+  TEST_ASSERT_GREATER_OR_EQUAL(5, bus.clearPulses);
+  TEST_ASSERT_GREATER_THAN(0, hostTofStats(0).measurements);
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  hostTofSetScene(hostTofAdd(PIN_TOF_XSHUT[0]), scene);
+
+  hostBootDevice(CLOSE_POS, [] {
+    setupI2c();
+    setupTof();
+  });
+  setupTasks();
+  server.on("/metrics", HTTP_GET, handleMetricsRequest);
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("tof", timedTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_read_latency_and_blocking);
+  RUN_TEST(test_nack_backoff);
+  RUN_TEST(test_stuck_sda);
+  return hostExit(UNITY_END());
+}
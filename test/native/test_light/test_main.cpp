@@ -0,0 +1,199 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+#include "clock.h"
+#include "i2c.h"
+#include "tof.h"
+#include "light.h"
+#include "states.h"
+#include "tasks.h"
+#include "host.h"
+
+static constexpr int64_t MINUTE = 60000000LL;
+static constexpr int64_t HOUR = 60 * MINUTE;
+static constexpr int64_t DAY = 24 * HOUR;
+static constexpr int STOP_PERCENT = POS_TOLERANCE * 100 / (OPEN_POS - CLOSE_POS) + 1;   // Motor stops this close
+
+// Blind position over time
+struct Move {
+  int64_t time;     // From the start of the replay (us)
+  uint8_t percent;  // Where it settled
+};
+
+static AsyncWebServer server(80);
+static int64_t replayStart = 0;
+static uint32_t (*lightShape)(int64_t t) = nullptr;
+static std::vector<Move> moves;
+static int64_t evaluateUs = 0;
+static uint32_t evaluations = 0;
+
+// Linear ramp between two levels over a span
+static uint32_t ramp(int64_t t, int64_t start, int64_t span, uint32_t from, uint32_t to) {
+  return (uint32_t)(from + ((int64_t)to - (int64_t)from) * (t - start) / span);
+}
+
+// Sunny day on a south window: a short bright spell in the morning, glare from late morning to afternoon with two
+// clouds passing, then dusk (kcps)
+static uint32_t sunnyDay(int64_t t) {
+  if (t < 7 * HOUR) {
+    return 20;
+  }
+  if (t < 9 * HOUR) {
+    return ramp(t, 7 * HOUR, 2 * HOUR, 20, 1500);
+  }
+  if (t < 10 * HOUR) {
+    return t < 9 * HOUR + 6 * MINUTE ? 2600 : 1500;
+  }
+  if (t < 10 * HOUR + 30 * MINUTE) {
+    return ramp(t, 10 * HOUR, 30 * MINUTE, 1500, 3000);
+  }
+  if (t < 15 * HOUR) {
+    bool cloud = (t >= 12 * HOUR && t < 12 * HOUR + 5 * MINUTE) || (t >= 13 * HOUR && t < 13 * HOUR + 5 * MINUTE);
+    return cloud ? 600 : 3000;
+  }
+  if (t < 16 * HOUR) {
+    return ramp(t, 15 * HOUR, HOUR, 3000, 500);
+  }
+  return t < 19 * HOUR ? ramp(t, 16 * HOUR, 3 * HOUR, 500, 20) : 20;
+}
+
+// Broken clouds: the level swings inside the hysteresis band for hours
+static uint32_t brokenClouds(int64_t t) {
+  return (t / (3 * MINUTE)) % 2 == 0 ? 1900 : 1100;
+}
+
+// Bright for two hours from the first
+static uint32_t brightSpell(int64_t t) {
+  return t >= HOUR && t < 3 * HOUR ? 3000 : 200;
+}
+
+// Ambient rate seen by the sensor (MCPS, 9.7 fixed point), with a little shot noise
+static uint16_t ambient(int64_t timeUs) {
+  if (lightShape == nullptr) {
+    return 0;
+  }
+  uint32_t kcps = lightShape(timeUs - replayStart);
+  uint32_t noise = (uint32_t)(timeUs / 1000 * 2654435761u >> 16) % 16;
+  return (uint16_t)(((kcps + noise - 8) << 7) / 1000);
+}
+
+// Light task timed in real time
+static void timedLight() {
+  int64_t start = hostMicros();
+  updateLight();
+  evaluateUs += hostMicros() - start;
+  evaluations++;
+}
+
+// Run the firmware, recording where each move settles
+static void runFor(int64_t span) {
+  int64_t end = clockMonotonic() + span;
+  bool turning = false;
+  while (clockMonotonic() < end) {
+    runTasks();
+    // The I2C task outranks the loop on the device, let it finish before the clock jumps
+    hostSettle();
+    if (turning && !hostMotorTurning()) {
+      moves.push_back({clockMonotonic() - replayStart, getPositionPercent()});
+    }
+    turning = hostMotorTurning();
+  }
+}
+
+// Replay a light profile from an open blind
+static void replay(uint32_t (*shape)(int64_t), int64_t span) {
+  lightShape = nullptr;
+  runFor(LIGHT_STALE_TIME * 1000LL + 2 * LIGHT_PERIOD);
+  hostMotorSetPosition(OPEN_POS);
+  runFor(MOVE_SETTLE_TIME * 1000LL + LIGHT_PERIOD);
+  moves.clear();
+  evaluateUs = 0;
+  evaluations = 0;
+  lightShape = shape;
+  replayStart = clockMonotonic();
+  runFor(span);
+}
+
+void setUp() {
+  HostResponse response =
+      hostRequest("GET", "/setLight?enabled=1&percent=60&close=2000&closeDelay=10&open=1000&openDelay=10");
+  TEST_ASSERT_EQUAL_STRING("/", response.location.c_str());
+}
+
+void tearDown() {
+}
+
+// Glare closes to the rule position once the level has held above it, clouds and spells shorter than the hold time
+// move nothing, and the blind reopens after dusk
+static void test_sunny_day() {
+  hostI2cResetStats();
+  hostTofResetStats();
+  replay(sunnyDay, DAY);
+  HostTofStats sensor = hostTofStats(0);
+  for (const Move &move : moves) {
+    printf("moved to %u %% at %02lld:%02lld\n", move.percent, (long long)(move.time / HOUR),
+           (long long)(move.time % HOUR / MINUTE));
+  }
+  printf("day: %u evaluations, %.2f us each, %.2f transfers per measurement\n", evaluations,
+         (double)evaluateUs / evaluations, (double)sensor.transfers / sensor.measurements);
+  TEST_ASSERT_EQUAL(2, moves.size());
+  // Level crosses 2000 at 10:10, plus the EMA lag and the 10 min hold
+  TEST_ASSERT_INT_WITHIN(STOP_PERCENT, 60, moves[0].percent);
+  TEST_ASSERT_INT64_WITHIN(2 * MINUTE, 10 * HOUR + 21 * MINUTE, moves[0].time);
+  // Level drops below 1000 at 15:48
+  TEST_ASSERT_INT_WITHIN(STOP_PERCENT, 100, moves[1].percent);
+  TEST_ASSERT_INT64_WITHIN(2 * MINUTE, 15 * HOUR + 59 * MINUTE, moves[1].time);
+  // One evaluation per period, the ambient rate comes with the result block
+  TEST_ASSERT_INT_WITHIN(2, DAY / LIGHT_PERIOD, evaluations);
+  // Status check, result block, interrupt clear
+  TEST_ASSERT_LESS_OR_EQUAL(5.0, (double)sensor.transfers / sensor.measurements);
+  TEST_ASSERT_LESS_THAN(50.0, (double)evaluateUs / evaluations);
+}
+
+// A level swinging between the open and close levels never moves the blind
+static void test_inside_band() {
+  replay(brokenClouds, 4 * HOUR);
+  TEST_ASSERT_EQUAL(0, moves.size());
+}
+
+// A blind moved by hand during glare stays where it was put
+static void test_manual_override() {
+  replay(brightSpell, 2 * HOUR);
+  TEST_ASSERT_EQUAL(1, moves.size());
+  TEST_ASSERT_INT_WITHIN(STOP_PERCENT, 60, moves[0].percent);
+  triggerMoveTo(30);
+  moves.clear();
+  runFor(2 * HOUR);
+  TEST_ASSERT_EQUAL(1, moves.size());
+  TEST_ASSERT_INT_WITHIN(STOP_PERCENT, 30, moves[0].percent);
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  hostTofSetAmbient(hostTofAdd(PIN_TOF_XSHUT[0]), ambient);
+
+  hostBootDevice(OPEN_POS, [] {
+    setupI2c();
+    setupTof();
+  });
+  setupLight(server);
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("tof", updateTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  addTask("light", timedLight, LIGHT_PERIOD, TaskPriority::BACKGROUND);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sunny_day);
+  RUN_TEST(test_inside_band);
+  RUN_TEST(test_manual_override);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,129 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "buttons.h"
+#include "motor.h"
+#include "i2c.h"
+#include "tof.h"
+#include "states.h"
+#include "schedule.h"
+#include "remote.h"
+#include "bridge.h"
+#include "group.h"
+#include "light.h"
+#include "ota.h"
+#include "tasks.h"
+#include "log.h"
+#include "host.h"
+
+// Virtual time covered by the report (us)
+static constexpr int64_t REPORT_SPAN = 60000000;
+
+struct TaskInfo {
+  const char *name;
+  uint32_t period;
+};
+
+static const TaskInfo taskInfo[] = {
+  {"control", CONTROL_PERIOD}, {"group", GROUP_PERIOD},   {"buttons", BUTTON_PERIOD},
+  {"tof", TOF_PERIOD / TOF_SENSOR_COUNT}, {"led", LED_PERIOD}, {"remote", REMOTE_PERIOD},
+  {"bridge", BRIDGE_PERIOD}, {"ota", OTA_PERIOD},   {"schedule", SCHEDULE_PERIOD},
+  {"light", LIGHT_PERIOD},
+};
+
+// Same tasks as main.cpp
+static void controlTask() {
+  updateStateMachine();
+}
+
+static void scheduleTask() {
+  syncRTC();
+  checkSchedule();
+}
+
+// Read a numeric field of a task from the /tasks report (-1 if missing)
+static long taskField(const std::string &report, const char *name, const char *field) {
+  size_t task = report.find(std::string("\"name\":\"") + name + "\"");
+  if (task == std::string::npos) {
+    return -1;
+  }
+  size_t value = report.find(std::string("\"") + field + "\":", task);
+  if (value == std::string::npos) {
+    return -1;
+  }
+  return strtol(report.c_str() + value + strlen(field) + 3, nullptr, 10);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Firmware task set for a virtual minute: runs per task, host cost, and load per virtual time
+static void test_load_report() {
+  int64_t virtualStart = clockMonotonic();
+  int64_t realStart = hostMicros();
+  while (clockMonotonic() - virtualStart < REPORT_SPAN) {
+    runTasks();
+  }
+  int64_t realSpan = hostMicros() - realStart;
+  hostSettle();
+
+  HostResponse response = hostRequest("GET", "/tasks");
+  TEST_ASSERT_EQUAL(200, response.status);
+  printf("%-10s %8s %8s %8s %8s %10s\n", "task", "period", "runs", "avg_us", "max_us", "overruns");
+  for (const TaskInfo &info : taskInfo) {
+    long runs = taskField(response.body, info.name, "runs");
+    printf("%-10s %8lu %8ld %8ld %8ld %10ld\n", info.name, (unsigned long)info.period, runs,
+           taskField(response.body, info.name, "execAvg"), taskField(response.body, info.name, "execMax"),
+           taskField(response.body, info.name, "overruns"));
+    // Skipped idle time never makes a task late, so every period runs exactly once
+    TEST_ASSERT_INT_WITHIN_MESSAGE(1, REPORT_SPAN / info.period, runs, info.name);
+    TEST_ASSERT_EQUAL_MESSAGE(0, taskField(response.body, info.name, "overruns"), info.name);
+  }
+  printf("virtual %.1f s in %.3f s real (x%.0f)\n", REPORT_SPAN / 1e6, realSpan / 1e6,
+         (double)REPORT_SPAN / realSpan);
+}
+
+int main() {
+  // Fast virtual clock, as with CLOCK_VIRTUAL and CLOCK_VIRTUAL_FAST
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  hostTofAdd(PIN_TOF_XSHUT[0]);
+  hostWifiSetAvailable(true);
+  hostWifiSetSaved(true);
+
+  setupLog();
+  setupMemory();
+  setupMotor();
+  setupI2c();
+  setupTof();
+  setupScheduler();
+  setupButtons();
+  setupStates();
+  setupTasks();
+  addTask("control", controlTask, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("group", updateGroup, GROUP_PERIOD, TaskPriority::CONTROL);
+  addTask("buttons", updateButtonInput, BUTTON_PERIOD, TaskPriority::SENSOR);
+  addTask("tof", updateTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  addTask("led", updateStatusLed, LED_PERIOD, TaskPriority::DISPLAY);
+  addTask("remote", updateRemote, REMOTE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("bridge", updateBridge, BRIDGE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("ota", updateOta, OTA_PERIOD, TaskPriority::BACKGROUND);
+  addTask("schedule", scheduleTask, SCHEDULE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("light", updateLight, LIGHT_PERIOD, TaskPriority::BACKGROUND);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_load_report);
+  return hostExit(UNITY_END());
+}
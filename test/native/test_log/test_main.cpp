@@ -0,0 +1,119 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+#include "log.h"
+#include "host.h"
+
+static AsyncWebServer server(80);
+
+// Lines of the /log export
+static std::vector<std::string> logLines() {
+  std::vector<std::string> lines;
+  std::istringstream body(hostRequest("GET", "/log").body);
+  std::string line;
+  while (std::getline(body, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Entries are formatted from their stored arguments
+static void test_format() {
+  logWrite(LogLevel::WARN, "Value %lld of %llx\n", -5, 255);
+  std::vector<std::string> lines = logLines();
+  TEST_ASSERT_FALSE(lines.empty());
+  const std::string &last = lines.back();
+  TEST_ASSERT_TRUE(last.find("] W Value -5 of ff") != std::string::npos);
+}
+
+// A full ring keeps the newest entries in order
+static void test_wrap_keeps_newest() {
+  for (int i = 0; i < 3 * (int)LOG_BUFFER_SIZE; ++i) {
+    logWrite(LogLevel::INFO, "Entry %lld\n", i);
+  }
+  std::vector<std::string> lines = logLines();
+  TEST_ASSERT_EQUAL(LOG_BUFFER_SIZE, lines.size());
+  for (size_t i = 0; i < lines.size(); ++i) {
+    long long value = -1;
+    sscanf(lines[i].c_str() + lines[i].find("Entry"), "Entry %lld", &value);
+    TEST_ASSERT_EQUAL(2 * (int)LOG_BUFFER_SIZE + (int)i, value);
+  }
+}
+
+// Concurrent writers never produce a torn entry in the export
+static void test_concurrent_writers() {
+  constexpr int writers = 4;
+  constexpr int entries = 20000;
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int w = 0; w < writers; ++w) {
+    threads.emplace_back([w] {
+      for (int i = 0; i < entries; ++i) {
+        logWrite(LogLevel::INFO, "Pair %lld %lld %lld\n", w, i, i * 3 + w);
+      }
+    });
+  }
+  int checked = 0;
+  while (checked < 20000) {
+    for (const std::string &line : logLines()) {
+      size_t pos = line.find("Pair");
+      if (pos == std::string::npos) {
+        continue;
+      }
+      long long w = 0, i = 0, sum = 0;
+      TEST_ASSERT_EQUAL(3, sscanf(line.c_str() + pos, "Pair %lld %lld %lld", &w, &i, &sum));
+      TEST_ASSERT_EQUAL(i * 3 + w, sum);
+      checked++;
+    }
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+// Cost of a log call on the hot path
+static void test_benchmark() {
+  constexpr int rounds = 1000000;
+  int64_t start = hostMicros();
+  for (int i = 0; i < rounds; ++i) {
+    LOG_INFO("Bench %lld %lld\n", i, rounds);
+  }
+  double writeNs = (hostMicros() - start) * 1000.0 / rounds;
+
+  start = hostMicros();
+  constexpr int exports = 100;
+  size_t size = 0;
+  for (int i = 0; i < exports; ++i) {
+    size = hostRequest("GET", "/log").body.size();
+  }
+  double exportUs = (double)(hostMicros() - start) / exports;
+  printf("logWrite %.1f ns, /log export %.1f us (%zu bytes)\n", writeNs, exportUs, size);
+  TEST_ASSERT_LESS_THAN(500, (int)writeNs);
+}
+
+int main() {
+  server.on("/log", HTTP_GET, handleLogRequest);
+  UNITY_BEGIN();
+  RUN_TEST(test_format);
+  RUN_TEST(test_wrap_keeps_newest);
+  RUN_TEST(test_concurrent_writers);
+  RUN_TEST(test_benchmark);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,144 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+#include "clock.h"
+#include "states.h"
+#include "metrics.h"
+#include "host.h"
+
+static AsyncWebServer server(80);
+
+static const char *const COMPLETED = "autoblinds_moves_total{outcome=\"completed\"} ";
+static const char *const INTERRUPTED = "autoblinds_moves_total{outcome=\"interrupted\"} ";
+static const char *const ERROR_COUNT = "autoblinds_move_error_count ";
+
+// Read a sample value from the /metrics export (-1 if missing)
+static long sampleValue(const char *sample) {
+  std::string body = hostRequest("GET", "/metrics").body;
+  size_t pos = body.find(sample);
+  return pos == std::string::npos ? -1 : strtol(body.c_str() + pos + strlen(sample), nullptr, 10);
+}
+
+// Step the control task for a span of virtual time (ms)
+static void runControl(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; ++i) {
+    advanceVirtualClock(1000);
+    updateStateMachine();
+  }
+}
+
+// Let the machine see the blind at the open limit
+static void arriveOpen() {
+  hostMotorSetPosition(OPEN_POS);
+  updateStateMachine();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+}
+
+void setUp() {
+  runControl(MOVE_SETTLE_TIME + 1);
+  enterState(SystemState::TOGGLE_IDLE);
+  hostMotorSetPosition(CLOSE_POS);
+}
+
+void tearDown() {
+}
+
+// Arrival counts the move at once, the settle only adds the error observation
+static void test_completed_at_arrival() {
+  long completed = sampleValue(COMPLETED);
+  long errors = sampleValue(ERROR_COUNT);
+  triggerOpen();
+  arriveOpen();
+  TEST_ASSERT_EQUAL(completed + 1, sampleValue(COMPLETED));
+  TEST_ASSERT_EQUAL(errors, sampleValue(ERROR_COUNT));
+  runControl(MOVE_SETTLE_TIME + 1);
+  TEST_ASSERT_EQUAL(completed + 1, sampleValue(COMPLETED));
+  TEST_ASSERT_EQUAL(errors + 1, sampleValue(ERROR_COUNT));
+}
+
+// A move started while the last one settles keeps both counts and the error
+static void test_move_during_settle() {
+  long completed = sampleValue(COMPLETED);
+  long errors = sampleValue(ERROR_COUNT);
+  triggerOpen();
+  arriveOpen();
+  runControl(MOVE_SETTLE_TIME / 2);
+  triggerClose();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_CLOSE, (int)getState());
+  TEST_ASSERT_EQUAL(errors + 1, sampleValue(ERROR_COUNT));
+  hostMotorSetPosition(CLOSE_POS);
+  updateStateMachine();
+  TEST_ASSERT_EQUAL(completed + 2, sampleValue(COMPLETED));
+}
+
+// A request for the current position completes without moving
+static void test_already_at_target() {
+  long completed = sampleValue(COMPLETED);
+  triggerClose();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+  TEST_ASSERT_EQUAL(completed + 1, sampleValue(COMPLETED));
+}
+
+// Interrupted moves are not completed
+static void test_interrupted() {
+  long completed = sampleValue(COMPLETED);
+  long interrupted = sampleValue(INTERRUPTED);
+  triggerOpen();
+  triggerStop();
+  runControl(MOVE_SETTLE_TIME + 1);
+  TEST_ASSERT_EQUAL(completed, sampleValue(COMPLETED));
+  TEST_ASSERT_EQUAL(interrupted + 1, sampleValue(INTERRUPTED));
+}
+
+// Cost of hot-path updates and of a full export
+static void test_benchmark() {
+  constexpr int rounds = 1000000;
+  int64_t start = hostMicros();
+  for (int i = 0; i < rounds; ++i) {
+    metricIncrement(Counter::TOF_READS);
+  }
+  double incrementNs = (hostMicros() - start) * 1000.0 / rounds;
+
+  start = hostMicros();
+  for (int i = 0; i < rounds; ++i) {
+    metricObserve(Histogram::TOF_READ_US, (uint32_t)(i & 0xFFFF));
+  }
+  double observeNs = (hostMicros() - start) * 1000.0 / rounds;
+
+  constexpr int exports = 200;
+  size_t size = 0;
+  size_t chunks = 0;
+  start = hostMicros();
+  for (int i = 0; i < exports; ++i) {
+    HostResponse response = hostRequest("GET", "/metrics");
+    size = response.body.size();
+    chunks = response.chunks;
+  }
+  double exportUs = (double)(hostMicros() - start) / exports;
+
+  printf("metricIncrement %.1f ns, metricObserve %.1f ns, /metrics %.1f us (%zu bytes, %zu chunks)\n", incrementNs,
+         observeNs, exportUs, size, chunks);
+  TEST_ASSERT_LESS_THAN(100, (int)incrementNs);
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, false);
+  hostBootDevice(CLOSE_POS);
+  server.on("/metrics", HTTP_GET, handleMetricsRequest);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_completed_at_arrival);
+  RUN_TEST(test_move_during_settle);
+  RUN_TEST(test_already_at_target);
+  RUN_TEST(test_interrupted);
+  RUN_TEST(test_benchmark);
+  return hostExit(UNITY_END());
+}
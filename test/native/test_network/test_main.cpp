@@ -0,0 +1,118 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include "config.h"
+#include "memory.h"
+#include "network.h"
+#include "tasks.h"
+#include "host.h"
+
+// Longest gap between control runs (us)
+static std::atomic<int64_t> worstGap(0);
+static std::atomic<int64_t> lastControl(0);
+static std::atomic<int> changes(0);
+static std::atomic<bool> loopRunning(true);
+
+// Control task probe
+static void probeControl() {
+  int64_t now = hostMicros();
+  int64_t last = lastControl.exchange(now);
+  if (last != 0) {
+    int64_t gap = now - last;
+    int64_t worst = worstGap.load();
+    while (gap > worst && !worstGap.compare_exchange_weak(worst, gap)) {
+    }
+  }
+}
+
+// Background task following connection changes like the scheduler
+static void probeConnection() {
+  if (networkChanged()) {
+    changes++;
+  }
+}
+
+static void loopThread() {
+  setupTasks();
+  addTask("control", probeControl, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("schedule", probeConnection, 10000, TaskPriority::BACKGROUND);
+  while (loopRunning.load()) {
+    runTasks();
+  }
+}
+
+// Wait for a condition (false on timeout)
+template <typename Condition>
+static bool waitFor(Condition condition, int64_t timeoutUs) {
+  int64_t end = hostMicros() + timeoutUs;
+  while (!condition()) {
+    if (hostMicros() > end) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// A busy provisioning portal runs on the network task, not the loop
+static void test_portal_does_not_block_loop() {
+  TEST_ASSERT_TRUE(waitFor([] { return hostPortalActive(); }, 1000000));
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  TEST_ASSERT_FALSE(isNetworkConnected());
+
+  hostPortalSubmit();
+  TEST_ASSERT_TRUE(waitFor([] { return isNetworkConnected(); }, 1000000));
+  TEST_ASSERT_TRUE(waitFor([] { return changes.load() == 1; }, 100000));
+  printf("worst loop gap with a 20 ms portal step: %lld us\n", (long long)worstGap.load());
+  // Shorter than a single portal step
+  TEST_ASSERT_LESS_THAN(20000, (int)worstGap.load());
+}
+
+// Outages retry saved credentials with a doubling backoff and reconnect on their own
+static void test_outage_backoff() {
+  uint32_t begins = hostWifiBeginCount();
+  hostWifiSetAvailable(false);
+  TEST_ASSERT_TRUE(waitFor([] { return changes.load() == 2; }, 100000));
+  TEST_ASSERT_FALSE(isNetworkConnected());
+
+  // Attempts after 1 s and 3 s, the next one waits until 7 s
+  std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+  TEST_ASSERT_EQUAL(begins + 2, hostWifiBeginCount());
+
+  hostWifiSetAvailable(true);
+  int64_t start = hostMicros();
+  TEST_ASSERT_TRUE(waitFor([] { return isNetworkConnected(); }, 5000000));
+  printf("reconnected %lld ms after the access point returned, %u attempts\n",
+         (long long)(hostMicros() - start) / 1000, hostWifiBeginCount() - begins);
+  TEST_ASSERT_EQUAL(begins + 3, hostWifiBeginCount());
+  TEST_ASSERT_LESS_THAN(20000, (int)worstGap.load());
+}
+
+int main() {
+  setupMemory();
+  // Nothing saved yet, so the first boot opens the portal
+  hostWifiSetSaved(false);
+  hostPortalSetProcessTime(20000);
+  std::thread loop(loopThread);
+  setupNetwork();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_portal_does_not_block_loop);
+  RUN_TEST(test_outage_backoff);
+  loopRunning.store(false);
+  loop.join();
+  return hostExit(UNITY_END());
+}
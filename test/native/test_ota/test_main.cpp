@@ -0,0 +1,169 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <ESPAsyncWebServer.h>
+#include <mbedtls/sha256.h>
+#include "config.h"
+#include "clock.h"
+#include "states.h"
+#include "ota.h"
+#include "host.h"
+
+static constexpr size_t IMAGE_SIZE = 1200 * 1024;
+static constexpr size_t CHUNK = 1436;
+
+static AsyncWebServer server(80);
+static std::vector<uint8_t> image;
+
+// Firmware image with the app image magic byte
+static std::vector<uint8_t> makeImage(size_t size, uint32_t seed) {
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    data[i] = seed >> 16;
+  }
+  data[0] = 0xE9;
+  return data;
+}
+
+// Update URL carrying the image hash
+static std::string updateUrl(const std::vector<uint8_t> &data) {
+  uint8_t hash[32];
+  mbedtls_sha256(data.data(), data.size(), hash, 0);
+  std::string url = "/update?sha256=";
+  char hex[3];
+  for (uint8_t byte : hash) {
+    snprintf(hex, sizeof(hex), "%02x", byte);
+    url += hex;
+  }
+  return url;
+}
+
+static HostResponse upload(const std::vector<uint8_t> &data, size_t stopAfter = SIZE_MAX,
+                           const char *password = OTA_PASSWORD) {
+  return hostUpload(updateUrl(data).c_str(), data.data(), data.size(), CHUNK, stopAfter, OTA_USERNAME, password);
+}
+
+// Check whether a move can start (motion lock released)
+static bool motionAllowed() {
+  enterState(SystemState::TOGGLE_IDLE);
+  hostMotorSetPosition(CLOSE_POS);
+  triggerOpen();
+  bool moving = hostMotorCommand() != 0;
+  triggerStop();
+  return moving;
+}
+
+void setUp() {
+  hostOtaReset();
+  updateOta();
+}
+
+void tearDown() {
+}
+
+// A dropped connection aborts the write and leaves the running image booting
+static void test_interrupted_upload() {
+  for (size_t stopAfter : {(size_t)0, CHUNK / 2, IMAGE_SIZE / 2, IMAGE_SIZE - 1}) {
+    hostOtaReset();
+    HostResponse response = upload(image, stopAfter);
+    TEST_ASSERT_EQUAL(0, response.status);
+    HostOtaStats stats = hostOtaStats();
+    TEST_ASSERT_EQUAL(stopAfter == 0 ? 0 : 1, stats.aborts);
+    TEST_ASSERT_EQUAL(0, stats.ends);
+    TEST_ASSERT_EQUAL_STRING("app0", hostOtaBootLabel());
+    updateOta();
+    TEST_ASSERT_TRUE(motionAllowed());
+    hostOtaReboot();
+    TEST_ASSERT_EQUAL_STRING("app0", hostOtaRunningLabel());
+  }
+
+  // A request rejected before writing that then drops still releases the session for the next upload
+  hostOtaReset();
+  HostResponse response = hostUpload("/update?sha256=00", image.data(), image.size(), CHUNK, CHUNK / 2, OTA_USERNAME,
+                                     OTA_PASSWORD);
+  TEST_ASSERT_EQUAL(0, response.status);
+  TEST_ASSERT_EQUAL(0, hostOtaStats().begins);
+  upload(image, IMAGE_SIZE / 2);
+  TEST_ASSERT_EQUAL(1, hostOtaStats().begins);
+  TEST_ASSERT_EQUAL(1, hostOtaStats().aborts);
+  updateOta();
+  TEST_ASSERT_TRUE(motionAllowed());
+}
+
+// Wrong hash, invalid image or password never switch the boot partition
+static void test_rejected_uploads() {
+  std::vector<uint8_t> corrupt = image;
+  std::string url = updateUrl(image);
+  corrupt[IMAGE_SIZE / 3] ^= 0x01;
+  HostResponse response = hostUpload(url.c_str(), corrupt.data(), corrupt.size(), CHUNK, SIZE_MAX, OTA_USERNAME,
+                                     OTA_PASSWORD);
+  TEST_ASSERT_EQUAL(400, response.status);
+  TEST_ASSERT_TRUE(response.body.find("SHA-256") != std::string::npos);
+  TEST_ASSERT_EQUAL_STRING("app0", hostOtaBootLabel());
+
+  std::vector<uint8_t> noMagic = makeImage(4096, 7);
+  noMagic[0] = 0;
+  TEST_ASSERT_EQUAL(400, upload(noMagic).status);
+  TEST_ASSERT_EQUAL_STRING("app0", hostOtaBootLabel());
+
+  uint32_t begins = hostOtaStats().begins;
+  TEST_ASSERT_EQUAL(401, upload(image, SIZE_MAX, "wrong").status);
+  TEST_ASSERT_EQUAL(begins, hostOtaStats().begins);
+  updateOta();
+  TEST_ASSERT_TRUE(motionAllowed());
+}
+
+// Complete upload streams chunk by chunk, switches boot and holds motion until restart
+static void test_complete_upload() {
+  uint32_t restarts = hostRestartCount();
+  int64_t start = hostMicros();
+  HostResponse response = upload(image);
+  int64_t span = hostMicros() - start;
+  TEST_ASSERT_EQUAL(200, response.status);
+  HostOtaStats stats = hostOtaStats();
+  // Each chunk is hashed and written from the server's buffer, so the largest write is the RAM a chunk holds
+  printf("complete upload: %zu bytes in %u writes, largest %zu bytes, %.1f MB/s on the host\n", stats.written,
+         stats.writes, stats.largestWrite, stats.written / (double)span);
+  TEST_ASSERT_EQUAL(IMAGE_SIZE, stats.written);
+  TEST_ASSERT_EQUAL(CHUNK, stats.largestWrite);
+  TEST_ASSERT_TRUE(hostOtaImage("app1") == image);
+  TEST_ASSERT_EQUAL_STRING("app1", hostOtaBootLabel());
+
+  updateOta();
+  TEST_ASSERT_FALSE(motionAllowed());
+  updateOta();
+  advanceVirtualClock((int64_t)OTA_RESTART_DELAY * 1000);
+  updateOta();
+  TEST_ASSERT_EQUAL(restarts + 1, hostRestartCount());
+
+  // The new image stays pending until the loop of the restarted firmware confirms it
+  hostOtaReboot();
+  TEST_ASSERT_EQUAL_STRING("app1", hostOtaRunningLabel());
+  TEST_ASSERT_TRUE(hostOtaPendingVerify());
+  AsyncWebServer restarted(80);
+  setupOta(restarted);
+  TEST_ASSERT_TRUE(hostOtaPendingVerify());
+  updateOta();
+  TEST_ASSERT_FALSE(hostOtaPendingVerify());
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, false);
+  hostBootDevice(CLOSE_POS);
+  setupOta(server);
+  image = makeImage(IMAGE_SIZE, 1);
+
+  UNITY_BEGIN();
+  // Rejected uploads first, a successful one leaves a restart pending
+  RUN_TEST(test_interrupted_upload);
+  RUN_TEST(test_rejected_uploads);
+  RUN_TEST(test_complete_upload);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,185 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "config.h"
+#include "states.h"
+#include "schedule.h"
+#include "remote.h"
+#include "tasks.h"
+#include "host.h"
+#include "fake_pins.h"
+
+static constexpr uint32_t CLIENT = 1;
+
+// Time the motor was last commanded from stopped (us)
+static std::atomic<int64_t> motorStartTime(0);
+static std::atomic<bool> loopRunning(false);
+
+// Put the blind at the close limit with the machine idle
+static void resetPosition() {
+  enterState(SystemState::TOGGLE_IDLE);
+  hostMotorSetPosition(CLOSE_POS);
+}
+
+static void sendFrame(std::initializer_list<uint8_t> frame) {
+  std::vector<uint8_t> bytes(frame);
+  hostWsSend(CLIENT, bytes.data(), bytes.size());
+}
+
+// Let the machine see the blind at a position and check it arrived
+static bool arrivesAt(int64_t position) {
+  hostMotorSetPosition(position);
+  dispatchStateEvent(StateEvent::TICK);
+  return getState() == SystemState::TOGGLE_IDLE;
+}
+
+// Loop task running the control and remote tasks on the hardware clock
+static void loopThread() {
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("remote", updateRemote, REMOTE_PERIOD, TaskPriority::BACKGROUND);
+  while (loopRunning.load()) {
+    runTasks();
+  }
+}
+
+// Wait for a condition written by the loop (false on timeout)
+template <typename Condition>
+static bool waitFor(Condition condition, int64_t timeoutUs) {
+  int64_t end = hostMicros() + timeoutUs;
+  while (!condition()) {
+    if (hostMicros() > end) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+void setUp() {
+  resetPosition();
+  updateRemote();
+}
+
+void tearDown() {
+}
+
+// Web handlers only post the command, the loop starts the move
+static void test_http_open_close_are_deferred() {
+  HostResponse response = hostRequest("GET", "/open");
+  TEST_ASSERT_EQUAL(302, response.status);
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+  TEST_ASSERT_EQUAL(0, hostMotorCommand());
+  updateRemote();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_OPEN, (int)getState());
+  TEST_ASSERT_GREATER_THAN(0, hostMotorCommand());
+
+  resetPosition();
+  hostMotorSetPosition(OPEN_POS);
+  hostRequest("GET", "/close");
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+  updateRemote();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_CLOSE, (int)getState());
+  TEST_ASSERT_LESS_THAN(0, hostMotorCommand());
+}
+
+// Only the newest absolute command of an update is applied
+static void test_newest_command_wins() {
+  sendFrame({REMOTE_MOVE, 30});
+  hostRequest("GET", "/open");
+  sendFrame({REMOTE_MOVE, 70});
+  updateRemote();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_OPEN, (int)getState());
+  TEST_ASSERT_FALSE(arrivesAt(300));
+  TEST_ASSERT_TRUE(arrivesAt(700));
+}
+
+// Nudges between updates add up instead of replacing each other
+static void test_nudges_accumulate() {
+  sendFrame({REMOTE_NUDGE, 10});
+  sendFrame({REMOTE_NUDGE, 10});
+  updateRemote();
+  TEST_ASSERT_FALSE(arrivesAt(100));
+  TEST_ASSERT_TRUE(arrivesAt(200));
+}
+
+// WebSocket frames reach the same slot
+static void test_websocket_open_and_stop() {
+  sendFrame({REMOTE_OPEN});
+  updateRemote();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_OPEN, (int)getState());
+  sendFrame({REMOTE_STOP});
+  updateRemote();
+  TEST_ASSERT_EQUAL((int)SystemState::TOGGLE_IDLE, (int)getState());
+  TEST_ASSERT_EQUAL(0, hostMotorCommand());
+}
+
+// Request to motor start latency with the loop running its tasks on the hardware clock
+static void test_latency_report() {
+  constexpr int rounds = 100;
+  std::vector<int64_t> latencies;
+  std::vector<int64_t> handlerTimes;
+
+  loopRunning.store(true);
+  std::thread loop(loopThread);
+  for (int i = 0; i < rounds; ++i) {
+    motorStartTime.store(0);
+    int64_t requestTime = hostMicros();
+    hostRequest("GET", "/open");
+    handlerTimes.push_back(hostMicros() - requestTime);
+    TEST_ASSERT_TRUE(waitFor([] { return motorStartTime.load() != 0; }, 1000000));
+    latencies.push_back(motorStartTime.load() - requestTime);
+
+    // Stop through the same slot and start the next round from the close limit
+    sendFrame({REMOTE_STOP});
+    TEST_ASSERT_TRUE(waitFor([] { return hostMotorCommand() == 0; }, 1000000));
+    hostMotorSetPosition(CLOSE_POS);
+    // Spread request times over the remote period
+    std::this_thread::sleep_for(std::chrono::microseconds(1000 + (i * 3700) % REMOTE_PERIOD));
+  }
+  loopRunning.store(false);
+  loop.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  std::sort(handlerTimes.begin(), handlerTimes.end());
+  printf("/open to motor start us: p50 %lld, p90 %lld, max %lld (remote period %lu)\n",
+         (long long)latencies[rounds / 2], (long long)latencies[rounds * 9 / 10], (long long)latencies.back(),
+         (unsigned long)REMOTE_PERIOD);
+  printf("/open handler us: p50 %lld, max %lld\n", (long long)handlerTimes[rounds / 2],
+         (long long)handlerTimes.back());
+  // Bounded by one remote period plus scheduling slack
+  TEST_ASSERT_LESS_THAN(REMOTE_PERIOD, latencies[rounds / 2]);
+  TEST_ASSERT_LESS_THAN(3 * REMOTE_PERIOD, latencies.back());
+}
+
+int main() {
+  hostWifiSetAvailable(true);
+  hostWifiSetSaved(true);
+  hostAddPinListener([](uint8_t pin, bool before) {
+    if (!before && pin == PIN_MTR_PWM && hostMotorCommand() != 0 && motorStartTime.load() == 0) {
+      motorStartTime.store(hostMicros());
+    }
+  });
+
+  hostBootDevice(CLOSE_POS, [] {
+    setupScheduler();
+  });
+  hostSettle();
+  hostWsConnect(CLIENT);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_http_open_close_are_deferred);
+  RUN_TEST(test_newest_command_wins);
+  RUN_TEST(test_nudges_accumulate);
+  RUN_TEST(test_websocket_open_and_stop);
+  RUN_TEST(test_latency_report);
+  return hostExit(UNITY_END());
+}
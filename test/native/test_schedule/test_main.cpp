@@ -0,0 +1,147 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <ctime>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "states.h"
+#include "schedule.h"
+#include "host.h"
+
+// Parking position every scheduled action has to move from
+static constexpr int64_t PARK_POS = 300;
+
+// Local time of a scheduled move start
+struct Fired {
+  int year;
+  int yday;
+  int hour;
+  int minute;
+};
+
+// Stop a started move and park the blind again (false if nothing started)
+static bool takeMoveStart() {
+  if (hostMotorCommand() == 0) {
+    return false;
+  }
+  triggerStop();
+  hostMotorSetPosition(PARK_POS);
+  return true;
+}
+
+// Step the schedule a minute at a time over a span, recording move starts
+static std::vector<Fired> runSchedule(int64_t spanSeconds) {
+  std::vector<Fired> fired;
+  for (int64_t t = 0; t < spanSeconds; t += 60) {
+    advanceVirtualClock(60000000LL);
+    checkSchedule();
+    if (takeMoveStart()) {
+      time_t now = (time_t)(clockWall() / 1000000);
+      struct tm local;
+      localtime_r(&now, &local);
+      fired.push_back({local.tm_year, local.tm_yday, local.tm_hour, local.tm_min});
+    }
+  }
+  return fired;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Packed entries survive a round trip, and out of range ones are dropped
+static void test_pack_round_trip() {
+  const ScheduleEntry entries[] = {
+    {0x7F, 1439, ScheduleAction::WAKE, 127, ScheduleBase::TIME},
+    {0x41, -240, ScheduleAction::PERCENT, 35, ScheduleBase::SUNSET},
+    {0x02, 240, ScheduleAction::PRESET, 3, ScheduleBase::DUSK},
+  };
+  for (const ScheduleEntry &entry : entries) {
+    ScheduleEntry unpacked = unpackScheduleEntry(packScheduleEntry(entry));
+    TEST_ASSERT_EQUAL(entry.days, unpacked.days);
+    TEST_ASSERT_EQUAL(entry.minute, unpacked.minute);
+    TEST_ASSERT_EQUAL((int)entry.action, (int)unpacked.action);
+    TEST_ASSERT_EQUAL(entry.arg, unpacked.arg);
+    TEST_ASSERT_EQUAL((int)entry.base, (int)unpacked.base);
+  }
+  ScheduleEntry late = unpackScheduleEntry(packScheduleEntry({0x7F, 1440, ScheduleAction::OPEN, 0, ScheduleBase::TIME}));
+  TEST_ASSERT_EQUAL(0, late.days);
+}
+
+// Presets saved through /setPresets are what moves and /schedule read back
+static void test_presets_round_trip() {
+  hostRequest("GET", "/setPresets?p0=10&p2=90");
+  std::string expected = "\"presets\":[";
+  for (uint8_t i = 0; i < PRESET_COUNT; i++) {
+    uint8_t percent;
+    TEST_ASSERT_TRUE(getPresetPercent(i, percent));
+    if (i == 0 || i == 2) {
+      TEST_ASSERT_EQUAL(i == 0 ? 10 : 90, percent);
+    }
+    expected += (i > 0 ? "," : "") + std::to_string(percent);
+  }
+  uint8_t percent;
+  TEST_ASSERT_FALSE(getPresetPercent(PRESET_COUNT, percent));
+  HostResponse response = hostRequest("GET", "/schedule");
+  TEST_ASSERT_NOT_NULL(strstr(response.body.c_str(), (expected + "]").c_str()));
+}
+
+// A year of daily events in a DST zone fires every entry once per local date at its local time
+static void test_year_across_dst() {
+  std::vector<Fired> fired = runSchedule(365LL * 86400);
+
+  // Events per local date by minute of day
+  std::map<int, std::vector<int>> days;
+  for (const Fired &event : fired) {
+    days[event.year * 366 + event.yday].push_back(event.hour * 60 + event.minute);
+  }
+  TEST_ASSERT_EQUAL(365, days.size());
+
+  // 2025: spring forward on Mar 9 (day 67), fall back on Nov 2 (day 305)
+  constexpr int springDay = 125 * 366 + 67;
+  constexpr int fallDay = 125 * 366 + 305;
+  for (const auto &day : days) {
+    char message[48];
+    snprintf(message, sizeof(message), "yday %d", day.first % 366);
+    TEST_ASSERT_EQUAL_MESSAGE(3, day.second.size(), message);
+    TEST_ASSERT_EQUAL_MESSAGE(90, day.second[0], message);
+    // 02:30 does not exist on the spring day and runs an hour later
+    TEST_ASSERT_EQUAL_MESSAGE(day.first == springDay ? 210 : 150, day.second[1], message);
+    TEST_ASSERT_EQUAL_MESSAGE(450, day.second[2], message);
+  }
+  // 01:30 happens twice on the fall day but fires once
+  TEST_ASSERT_EQUAL(3, days[fallDay].size());
+  printf("%zu scheduled moves over 365 local days\n", fired.size());
+}
+
+int main() {
+  // 2025-01-01 00:00 UTC is 2024-12-31 19:00 in the EST5EDT zone of TIME_ZONE
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, false);
+  hostBootDevice(PARK_POS, [] {
+    // 01:30 is repeated on the fall day, 02:30 is skipped on the spring day
+    const ScheduleEntry entries[] = {
+      {0x7F, 90, ScheduleAction::PERCENT, 50, ScheduleBase::TIME},
+      {0x7F, 150, ScheduleAction::CLOSE, 0, ScheduleBase::TIME},
+      {0x7F, 450, ScheduleAction::OPEN, 0, ScheduleBase::TIME},
+    };
+    saveSchedule(entries, 3);
+    setupScheduler();
+  });
+
+  UNITY_BEGIN();
+  RUN_TEST(test_pack_round_trip);
+  RUN_TEST(test_presets_round_trip);
+  RUN_TEST(test_year_across_dst);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,158 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "solar.h"
+#include "host.h"
+
+// Test locations (1e-4 degrees)
+struct Location {
+  const char *name;
+  int32_t latitude;
+  int32_t longitude;
+};
+
+static const Location locations[] = {
+  {"New York", 407128, -740060},
+  {"Quito", -1807, -784678},
+  {"Sydney", -338688, 1512093},
+  {"Reykjavik", 641466, -219426},
+  {"Tromso", 696492, 189553},
+  {"Longyearbyen", 782232, 156267},
+};
+
+// Same sunrise equation in double precision
+static SolarTimes referenceTimes(int year, int month, int day, int32_t latitude, int32_t longitude) {
+  const double rad = M_PI / 180.0;
+  struct tm date = {};
+  date.tm_year = year - 1900;
+  date.tm_mon = month - 1;
+  date.tm_mday = day;
+  double dayNumber = std::floor((double)timegm(&date) / 86400.0) - 10957.0;
+  double meanNoon = dayNumber + 0.0008 - longitude / 1e4 / 360.0;
+  double meanAnomaly = std::fmod(357.5291 + 0.98560028 * meanNoon, 360.0);
+  double center = 1.9148 * std::sin(meanAnomaly * rad) + 0.0200 * std::sin(2 * meanAnomaly * rad) +
+                  0.0003 * std::sin(3 * meanAnomaly * rad);
+  double ecliptic = std::fmod(meanAnomaly + center + 180.0 + 102.9372, 360.0);
+  double transit = meanNoon + 0.0053 * std::sin(meanAnomaly * rad) - 0.0069 * std::sin(2 * ecliptic * rad);
+  double sinDec = std::sin(ecliptic * rad) * std::sin(23.4397 * rad);
+  double cosDec = std::cos(std::asin(sinDec));
+  double lat = latitude / 1e4 * rad;
+
+  SolarTimes times = {0, 0, 0, 0};
+  auto offset = [&](double altitude) {
+    double cosHour = (std::sin(altitude * rad) - std::sin(lat) * sinDec) / (std::cos(lat) * cosDec);
+    return (cosHour < -1.0 || cosHour > 1.0) ? -1.0 : std::acos(cosHour) / (2 * M_PI);
+  };
+  double transitUnix = 946728000.0 + transit * 86400.0;
+  double rise = offset(-0.833);
+  if (rise >= 0) {
+    times.sunrise = (time_t)std::lround(transitUnix - rise * 86400.0);
+    times.sunset = (time_t)std::lround(transitUnix + rise * 86400.0);
+  }
+  double civil = offset(-6.0);
+  if (civil >= 0) {
+    times.dawn = (time_t)std::lround(transitUnix - civil * 86400.0);
+    times.dusk = (time_t)std::lround(transitUnix + civil * 86400.0);
+  }
+  return times;
+}
+
+// Get UTC time of a date and clock time
+static time_t utc(int year, int month, int day, int hour, int minute) {
+  struct tm date = {};
+  date.tm_year = year - 1900;
+  date.tm_mon = month - 1;
+  date.tm_mday = day;
+  date.tm_hour = hour;
+  date.tm_min = minute;
+  return timegm(&date);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Published times for New York on the June solstice (within the equation's accuracy)
+static void test_known_times() {
+  SolarTimes times = computeSolarTimes(2025, 6, 21, 407128, -740060);
+  TEST_ASSERT_INT_WITHIN(120, utc(2025, 6, 21, 9, 25), times.sunrise);
+  TEST_ASSERT_INT_WITHIN(120, utc(2025, 6, 22, 0, 31), times.sunset);
+  TEST_ASSERT_INT_WITHIN(120, utc(2025, 6, 21, 8, 52), times.dawn);
+  TEST_ASSERT_INT_WITHIN(120, utc(2025, 6, 22, 1, 4), times.dusk);
+}
+
+// Events that do not happen are reported as 0
+static void test_polar_days() {
+  SolarTimes midnightSun = computeSolarTimes(2025, 6, 21, 696492, 189553);
+  TEST_ASSERT_EQUAL(0, midnightSun.sunrise);
+  TEST_ASSERT_EQUAL(0, midnightSun.dawn);
+  SolarTimes polarNight = computeSolarTimes(2025, 12, 21, 696492, 189553);
+  TEST_ASSERT_EQUAL(0, polarNight.sunrise);
+  TEST_ASSERT_NOT_EQUAL(0, polarNight.dawn);
+  SolarTimes darkNight = computeSolarTimes(2025, 12, 21, 782232, 156267);
+  TEST_ASSERT_EQUAL(0, darkNight.dawn);
+}
+
+// Fixed point matches the double precision equation every day of a year
+static void test_matches_reference() {
+  int64_t worst = 0;
+  int mismatchedPresence = 0;
+  for (const Location &location : locations) {
+    for (int day = 0; day < 365; ++day) {
+      time_t date = utc(2025, 1, 1, 0, 0) + day * 86400;
+      struct tm civil;
+      gmtime_r(&date, &civil);
+      SolarTimes fixed = computeSolarTimes(2025, civil.tm_mon + 1, civil.tm_mday, location.latitude,
+                                           location.longitude);
+      SolarTimes reference = referenceTimes(2025, civil.tm_mon + 1, civil.tm_mday, location.latitude,
+                                            location.longitude);
+      const time_t fixedTimes[] = {fixed.dawn, fixed.sunrise, fixed.sunset, fixed.dusk};
+      const time_t referenceTimes[] = {reference.dawn, reference.sunrise, reference.sunset, reference.dusk};
+      for (int i = 0; i < 4; ++i) {
+        // Near the polar thresholds the two may disagree on whether the event happens
+        if ((fixedTimes[i] == 0) != (referenceTimes[i] == 0)) {
+          mismatchedPresence++;
+          continue;
+        }
+        if (fixedTimes[i] != 0) {
+          worst = std::max(worst, (int64_t)std::llabs(fixedTimes[i] - referenceTimes[i]));
+        }
+      }
+    }
+  }
+  printf("worst difference to double precision: %lld s, presence mismatches: %d\n", (long long)worst,
+         mismatchedPresence);
+  TEST_ASSERT_LESS_OR_EQUAL(10, worst);
+  TEST_ASSERT_LESS_OR_EQUAL(2, mismatchedPresence);
+}
+
+// Cost per day of events
+static void test_benchmark() {
+  constexpr int rounds = 100000;
+  volatile time_t sink = 0;
+  int64_t start = hostMicros();
+  for (int i = 0; i < rounds; ++i) {
+    sink = sink + computeSolarTimes(2025, 1 + i % 12, 1 + i % 28, 407128, -740060).sunrise;
+  }
+  double ns = (hostMicros() - start) * 1000.0 / rounds;
+  printf("computeSolarTimes %.0f ns\n", ns);
+  TEST_ASSERT_LESS_THAN(100000, (int)ns);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_known_times);
+  RUN_TEST(test_polar_days);
+  RUN_TEST(test_matches_reference);
+  RUN_TEST(test_benchmark);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,96 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+#include "clock.h"
+#include "tasks.h"
+#include "host.h"
+
+static AsyncWebServer server(80);
+
+// Run order of the first runs (task letters)
+static std::string order;
+static int slowRuns = 0;
+
+static void taskFast() {
+  if (order.size() < 8) {
+    order += 'A';
+  }
+}
+
+static void taskMid() {
+  if (order.size() < 8) {
+    order += 'B';
+  }
+}
+
+// Third run takes longer than two of its periods
+static void taskSlow() {
+  if (order.size() < 8) {
+    order += 'C';
+  }
+  if (++slowRuns == 3) {
+    advanceVirtualClock(45000);
+  }
+}
+
+// Read a numeric field of a task from the /tasks report (-1 if missing)
+static long taskField(const std::string &report, const char *name, const char *field) {
+  size_t task = report.find(std::string("\"name\":\"") + name + "\"");
+  if (task == std::string::npos) {
+    return -1;
+  }
+  size_t value = report.find(std::string("\"") + field + "\":", task);
+  if (value == std::string::npos) {
+    return -1;
+  }
+  return strtol(report.c_str() + value + strlen(field) + 3, nullptr, 10);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Due tasks run by priority, then stay on their period grid across an overrun
+static void test_priority_periods_and_overruns() {
+  int64_t start = clockMonotonic();
+  addTask("A", taskFast, 1000, TaskPriority::CONTROL);
+  addTask("C", taskSlow, 20000, TaskPriority::BACKGROUND);
+  addTask("B", taskMid, 5000, TaskPriority::SENSOR);
+  while (clockMonotonic() - start < 100000) {
+    runTasks();
+  }
+  // First deadline is shared, later ones follow the periods
+  TEST_ASSERT_EQUAL_STRING("ABCAAAAA", order.c_str());
+
+  HostResponse response = hostRequest("GET", "/tasks");
+  TEST_ASSERT_EQUAL(200, response.status);
+  // C ran at 40 ms and ended at 85 ms, skipping its 60 and 80 ms deadlines
+  TEST_ASSERT_EQUAL(2, taskField(response.body, "C", "overruns"));
+  TEST_ASSERT_EQUAL(3, taskField(response.body, "C", "runs"));
+  // A and B resume on their grid after skipping what they missed
+  TEST_ASSERT_EQUAL(44, taskField(response.body, "A", "overruns"));
+  TEST_ASSERT_EQUAL(8, taskField(response.body, "B", "overruns"));
+  TEST_ASSERT_EQUAL(56, taskField(response.body, "A", "runs"));
+  TEST_ASSERT_EQUAL(12, taskField(response.body, "B", "runs"));
+  // Skipped idle time starts the runs that were not delayed on their deadlines
+  TEST_ASSERT_EQUAL(0, taskField(response.body, "C", "jitterMax"));
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  setupTasks();
+  server.on("/tasks", HTTP_GET, handleTasksRequest);
+  UNITY_BEGIN();
+  RUN_TEST(test_priority_periods_and_overruns);
+  return hostExit(UNITY_END());
+}
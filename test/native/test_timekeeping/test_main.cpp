@@ -0,0 +1,146 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "timekeeping.h"
+#include "host.h"
+
+// Simulated oscillator: local timer runs slow by DRIFT_PPB against true time
+static constexpr int64_t DRIFT_PPB = 40000;
+static constexpr int64_t START_WALL = 1735689600LL * 1000000;
+static int64_t trueTime = 0;     // us since boot
+
+static int64_t localMonotonic() {
+  return trueTime - trueTime * DRIFT_PPB / 1000000000LL;
+}
+
+static int64_t localWall() {
+  return START_WALL + localMonotonic();
+}
+
+static bool noSkip(int64_t span) {
+  return false;
+}
+
+static const ClockSource driftingClock = {localMonotonic, localWall, noSkip};
+
+// Deterministic NTP error within +-jitter (us)
+static int64_t ntpError(int64_t jitter) {
+  return (int64_t)(rand() % (2 * jitter + 1)) - jitter;
+}
+
+// Deliver an NTP sync with true time plus network error
+static void sync(int64_t jitter) {
+  int64_t reference = START_WALL + trueTime + ntpError(jitter);
+  struct timeval tv = {(time_t)(reference / 1000000), (suseconds_t)(reference % 1000000)};
+  recordTimeSync(tv);
+}
+
+static void advanceHours(int64_t hours) {
+  trueTime += hours * 3600 * 1000000LL;
+}
+
+// Error of corrected time against true time (us)
+static int64_t timeError() {
+  return timeNowMicros() - (START_WALL + trueTime);
+}
+
+void setUp() {
+  srand(1);
+  trueTime = 0;
+  hostNvsClear();
+  setupMemory();
+  setupTimekeeping();
+}
+
+void tearDown() {
+}
+
+// Twelve-hourly syncs with 20 ms network error learn the drift
+static void test_fit_learns_drift() {
+  for (int i = 0; i < TIME_DRIFT_SAMPLES; ++i) {
+    sync(20000);
+    advanceHours(12);
+  }
+  sync(20000);
+  printf("learned drift %ld ppb (true %lld)\n", (long)getClockDrift(), (long long)DRIFT_PPB);
+  TEST_ASSERT_INT_WITHIN(1000, DRIFT_PPB, getClockDrift());
+  updateTimekeeping();
+  TEST_ASSERT_EQUAL(getClockDrift(), loadClockDrift());
+}
+
+// A week offline stays within a second of true time
+static void test_offline_week() {
+  for (int i = 0; i < TIME_DRIFT_SAMPLES; ++i) {
+    sync(20000);
+    advanceHours(12);
+  }
+  sync(20000);
+  advanceHours(7 * 24);
+  int64_t corrected = timeError();
+  int64_t uncorrected = localWall() - (START_WALL + trueTime);
+  printf("offline week error: corrected %lld ms, uncorrected %lld ms\n", (long long)(corrected / 1000),
+         (long long)(uncorrected / 1000));
+  TEST_ASSERT_INT_WITHIN(1000000, 0, corrected);
+  TEST_ASSERT_TRUE(isTimeDegraded());
+}
+
+// Syncs closer than the minimum spacing replace the last point instead of skewing the fit
+static void test_close_syncs_replace() {
+  sync(0);
+  advanceHours(12);
+  sync(0);
+  int32_t drift = getClockDrift();
+  for (int i = 0; i < 20; ++i) {
+    trueTime += 1000000;
+    sync(50000);
+  }
+  TEST_ASSERT_INT_WITHIN(5000, drift, getClockDrift());
+}
+
+// A timer delay in local time lands on the wall clock target
+static void test_delay_until() {
+  for (int i = 0; i < 4; ++i) {
+    sync(0);
+    advanceHours(12);
+  }
+  sync(0);
+  time_t target = (time_t)(timeNowMicros() / 1000000) + 86400;
+  uint64_t delay = delayUntil(target);
+  // Advance true time by the local delay
+  int64_t localStart = localMonotonic();
+  while (localMonotonic() - localStart < (int64_t)delay) {
+    trueTime += 1000;
+  }
+  TEST_ASSERT_INT_WITHIN(20000, (int64_t)target * 1000000, START_WALL + trueTime);
+}
+
+// Drift beyond what a crystal can have is not learned
+static void test_rejects_implausible_drift() {
+  sync(0);
+  advanceHours(1);
+  // A server ten seconds off after an hour implies 2800 ppm
+  int64_t reference = START_WALL + trueTime + 10 * 1000000LL;
+  struct timeval tv = {(time_t)(reference / 1000000), (suseconds_t)(reference % 1000000)};
+  recordTimeSync(tv);
+  TEST_ASSERT_EQUAL(0, getClockDrift());
+}
+
+int main() {
+  setClockSource(driftingClock);
+  UNITY_BEGIN();
+  RUN_TEST(test_fit_learns_drift);
+  RUN_TEST(test_offline_week);
+  RUN_TEST(test_close_syncs_replace);
+  RUN_TEST(test_delay_until);
+  RUN_TEST(test_rejects_implausible_drift);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,145 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include "config.h"
+#include "clock.h"
+#include "i2c.h"
+#include "tof.h"
+#include "states.h"
+#include "tasks.h"
+#include "host.h"
+
+// Several sensors on one bus (pio test -e native_tofbus)
+static_assert(TOF_SENSOR_COUNT > 1, "Build with more than one XSHUT pin, e.g. -D TOF_XSHUT_PINS=2,3,4");
+
+static int64_t tapStart = -1;
+static bool moving = false;
+static int64_t motorStart = -1;
+
+// Hand tapping in front of the last sensor, nothing in front of the others
+static uint16_t tapScene(int64_t timeUs) {
+  int64_t t = timeUs - tapStart;
+  if (tapStart < 0 || t < 0) {
+    return 0;
+  }
+  if (t < 250000) {
+    return (uint16_t)(550 - t / 1000);
+  }
+  if (t < 370000) {
+    return (uint16_t)(300 - (t - 250000) * 290 / 120000);
+  }
+  if (t < 520000) {
+    return 10;
+  }
+  return t < 620000 ? (uint16_t)(10 + (t - 520000) * 3 / 1000) : 0;
+}
+
+// Run the task set, letting a started move arrive at once
+static void runFor(int64_t span) {
+  int64_t end = clockMonotonic() + span;
+  while (clockMonotonic() < end) {
+    runTasks();
+    // The I2C task outranks the loop on the device, let it finish before the clock jumps
+    hostSettle();
+    int command = hostMotorCommand();
+    if (command != 0 && !moving) {
+      motorStart = clockMonotonic();
+      hostMotorSetPosition(hostMotorPosition() < (OPEN_POS + CLOSE_POS) / 2 ? OPEN_POS : CLOSE_POS);
+    }
+    moving = command != 0;
+  }
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Bring-up moves every sensor to its own address without two ever answering at once
+static void test_bring_up_addresses() {
+  HostI2cStats bus = hostI2cStats();
+  printf("bring-up of %d sensors: %u transfers, %u nacks, %u collisions\n", TOF_SENSOR_COUNT, bus.transfers, bus.nacks,
+         bus.collisions);
+  TEST_ASSERT_EQUAL(0, bus.collisions);
+  for (int i = 0; i < TOF_SENSOR_COUNT; i++) {
+    TEST_ASSERT_EQUAL_HEX8(TOF_BASE_ADDRESS + i, hostTofStats(i).address);
+  }
+}
+
+// Every sensor is sampled in turn and a tap on the last one moves the blind
+static void test_round_robin_sampling() {
+  hostI2cResetStats();
+  hostTofResetStats();
+  motorStart = -1;
+  tapStart = clockMonotonic() + 1000000;
+  runFor(5000000);
+  for (int i = 0; i < TOF_SENSOR_COUNT; i++) {
+    HostTofStats sensor = hostTofStats(i);
+    printf("sensor %d: %u transfers, %u measurements\n", i, sensor.transfers, sensor.measurements);
+    TEST_ASSERT_GREATER_THAN(0, sensor.measurements);
+  }
+  TEST_ASSERT_EQUAL(0, hostI2cStats().collisions);
+  TEST_ASSERT_GREATER_OR_EQUAL(tapStart + 620000, motorStart);
+  TEST_ASSERT_LESS_THAN(tapStart + 1620000, motorStart);
+}
+
+// A sensor that stops answering is power cycled and readdressed while the others keep sampling undisturbed
+static void test_reinit_one_sensor() {
+  hostTofResetStats();
+  runFor(10000000);
+  uint32_t baseline[TOF_SENSOR_COUNT];
+  for (int i = 0; i < TOF_SENSOR_COUNT; i++) {
+    baseline[i] = hostTofStats(i).measurements;
+  }
+  hostI2cResetStats();
+  hostTofResetStats();
+  hostTofSetNack(1, true);
+  runFor(10000000);
+  TEST_ASSERT_GREATER_THAN(0, hostI2cStats().nacks);
+  for (int i = 0; i < TOF_SENSOR_COUNT; i++) {
+    HostTofStats sensor = hostTofStats(i);
+    printf("outage of sensor 1, sensor %d: %u measurements (%u before)\n", i, sensor.measurements, baseline[i]);
+    if (i != 1) {
+      TEST_ASSERT_GREATER_OR_EQUAL(baseline[i] * 9 / 10, sensor.measurements);
+      TEST_ASSERT_EQUAL_HEX8(TOF_BASE_ADDRESS + i, sensor.address);
+    }
+  }
+  hostTofSetNack(1, false);
+  hostTofResetStats();
+  runFor(12000000);
+  HostI2cStats bus = hostI2cStats();
+  printf("sensor 1 back: %u nacks, %u collisions\n", bus.nacks, bus.collisions);
+  TEST_ASSERT_EQUAL(0, bus.collisions);
+  for (int i = 0; i < TOF_SENSOR_COUNT; i++) {
+    TEST_ASSERT_EQUAL_HEX8(TOF_BASE_ADDRESS + i, hostTofStats(i).address);
+    TEST_ASSERT_GREATER_THAN(0, hostTofStats(i).measurements);
+  }
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  for (int i = 0; i < TOF_SENSOR_COUNT; i++) {
+    hostTofAdd(PIN_TOF_XSHUT[i]);
+  }
+  hostTofSetScene(TOF_SENSOR_COUNT - 1, tapScene);
+
+  hostBootDevice(CLOSE_POS, [] {
+    setupI2c();
+    setupTof();
+  });
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("tof", updateTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_bring_up_addresses);
+  RUN_TEST(test_round_robin_sampling);
+  RUN_TEST(test_reinit_one_sensor);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,214 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "config.h"
+#include "clock.h"
+#include "i2c.h"
+#include "tof.h"
+#include "states.h"
+#include "tasks.h"
+#include "host.h"
+
+static constexpr int64_t HOUR = 3600000000LL;
+static constexpr int64_t TAP_SPACING = 30000000;
+static constexpr int TAPS = 60;
+static constexpr int64_t TOUCH_START = 370000;   // Hand within a few mm (us into the tap)
+
+// Legacy trigger: one raw sample below the threshold, 400 ms debounce, 40 ms back-to-back ranging
+static constexpr int64_t LEGACY_PERIOD = 40000;
+static constexpr int64_t LEGACY_DEBOUNCE = 400000;
+
+static int64_t traceStart = 0;
+static int64_t touchTime = 150000;
+static bool tapping = false;
+static std::vector<int64_t> motorStarts;
+
+// Stateless hash of a millisecond, so both consumers see the same noise
+static uint32_t noiseAt(int64_t timeUs, uint32_t salt) {
+  uint64_t x = (uint64_t)(timeUs / 1000) * 0x9E3779B97F4A7C15ull + salt;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return (uint32_t)(x ^ (x >> 31));
+}
+
+// Stray close reading (crosstalk, dust, sunlight), 0 if none
+static uint16_t spikeAt(int64_t timeUs) {
+  uint32_t hash = noiseAt(timeUs, 1);
+  return hash % 1000 < 20 ? (uint16_t)(5 + (hash >> 12) % 200) : 0;
+}
+
+// Hand coming in through the interest zone, touching, and pulled out again (0 = gone)
+static uint16_t tapDistance(int64_t t) {
+  if (t < 250000) {
+    return (uint16_t)(550 - t / 1000);
+  }
+  if (t < TOUCH_START) {
+    return (uint16_t)(300 - (t - 250000) * 290 / 120000);
+  }
+  if (t < TOUCH_START + touchTime) {
+    return 10;
+  }
+  t -= TOUCH_START + touchTime;
+  return t < 100000 ? (uint16_t)(10 + t * 3 / 1000) : 0;
+}
+
+// Distance seen at a time: taps every spacing (when tapping) over stray readings
+static uint16_t scene(int64_t timeUs) {
+  int64_t t = timeUs - traceStart;
+  if (tapping && t >= 0) {
+    uint16_t hand = tapDistance(t % TAP_SPACING);
+    if (hand > 0) {
+      return (uint16_t)std::max<int>(1, hand + (int)(noiseAt(timeUs, 2) % 7) - 3);
+    }
+  }
+  return spikeAt(timeUs);
+}
+
+// Return signal: most stray readings are weak, a quarter look as strong as a hand
+static uint16_t signal(int64_t timeUs) {
+  uint16_t distance = scene(timeUs);
+  if (distance == 0) {
+    return 0;
+  }
+  bool stray = spikeAt(timeUs) == distance;
+  return stray && noiseAt(timeUs, 3) % 4 != 0 ? 12 : 1280;
+}
+
+// Legacy trigger times over a span
+static std::vector<int64_t> legacyTriggers(int64_t start, int64_t end) {
+  std::vector<int64_t> triggers;
+  int64_t lastTrigger = start - LEGACY_DEBOUNCE;
+  for (int64_t t = start; t < end; t += LEGACY_PERIOD) {
+    uint16_t distance = scene(t);
+    if (distance > 0 && distance < TOF_THRESHOLD && t - lastTrigger >= LEGACY_DEBOUNCE) {
+      triggers.push_back(t);
+      lastTrigger = t;
+    }
+  }
+  return triggers;
+}
+
+// Run the task set, letting every started move arrive at once
+static void runUntil(int64_t end) {
+  bool moving = false;
+  while (clockMonotonic() < end) {
+    runTasks();
+    // The I2C task outranks the loop on the device, let it finish before the clock jumps
+    hostSettle();
+    int command = hostMotorCommand();
+    if (command != 0 && !moving) {
+      motorStarts.push_back(clockMonotonic());
+      hostMotorSetPosition(hostMotorPosition() < (OPEN_POS + CLOSE_POS) / 2 ? OPEN_POS : CLOSE_POS);
+    }
+    moving = command != 0;
+  }
+}
+
+// Per-tap detection and latency from the touch, counting triggers outside any tap as false
+struct Detection {
+  int detected;
+  int falseTriggers;
+  int64_t latencySum;
+  int64_t latencyWorst;
+};
+
+static Detection matchTaps(const std::vector<int64_t> &triggers) {
+  Detection result = {0, 0, 0, 0};
+  std::vector<bool> matched(TAPS, false);
+  for (int64_t trigger : triggers) {
+    int64_t t = trigger - traceStart - TOUCH_START;
+    int tap = (int)((t + TAP_SPACING / 2) / TAP_SPACING);
+    int64_t latency = t - tap * TAP_SPACING;
+    if (tap >= 0 && tap < TAPS && !matched[tap] && latency >= -100000 && latency < 1000000) {
+      matched[tap] = true;
+      result.detected++;
+      result.latencySum += latency;
+      result.latencyWorst = std::max(result.latencyWorst, latency);
+    } else {
+      result.falseTriggers++;
+    }
+  }
+  return result;
+}
+
+// Replay taps with a touch of the given length through both pipelines
+static void replayTaps(const char *name, int64_t touch, Detection &filtered, Detection &legacy) {
+  touchTime = touch;
+  tapping = true;
+  motorStarts.clear();
+  traceStart = clockMonotonic() + 1000000;
+  int64_t end = traceStart + TAPS * TAP_SPACING;
+  runUntil(end);
+  filtered = matchTaps(motorStarts);
+  legacy = matchTaps(legacyTriggers(traceStart, end));
+  tapping = false;
+  printf("%s taps (%lld ms touch): filtered %d/%d, mean %lld ms, worst %lld ms, %d false; "
+         "legacy %d/%d, mean %lld ms, worst %lld ms, %d false\n",
+         name, (long long)touch / 1000, filtered.detected, TAPS,
+         (long long)(filtered.latencySum / std::max(filtered.detected, 1) / 1000),
+         (long long)filtered.latencyWorst / 1000, filtered.falseTriggers, legacy.detected, TAPS,
+         (long long)(legacy.latencySum / std::max(legacy.detected, 1) / 1000), (long long)legacy.latencyWorst / 1000,
+         legacy.falseTriggers);
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Stray close readings with nobody there never move the blind
+static void test_noise_false_triggers() {
+  motorStarts.clear();
+  int64_t start = clockMonotonic();
+  runUntil(start + 2 * HOUR);
+  size_t legacy = legacyTriggers(start, start + 2 * HOUR).size();
+  printf("noise only: filtered %.1f false triggers/h, legacy %.1f false triggers/h\n", motorStarts.size() / 2.0,
+         legacy / 2.0);
+  TEST_ASSERT_EQUAL(0, motorStarts.size());
+  TEST_ASSERT_GREATER_THAN(0, legacy);
+}
+
+// Deliberate taps are found through the same noise
+static void test_taps_detected() {
+  Detection filtered, legacy;
+  replayTaps("normal", 150000, filtered, legacy);
+  TEST_ASSERT_EQUAL(TAPS, filtered.detected);
+  TEST_ASSERT_EQUAL(0, filtered.falseTriggers);
+}
+
+// Brief touches still register once ranging is fast
+static void test_fast_taps() {
+  Detection filtered, legacy;
+  replayTaps("fast", 100000, filtered, legacy);
+  TEST_ASSERT_GREATER_OR_EQUAL(legacy.detected, filtered.detected);
+  TEST_ASSERT_EQUAL(0, filtered.falseTriggers);
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  int sensor = hostTofAdd(PIN_TOF_XSHUT[0]);
+  hostTofSetScene(sensor, scene);
+  hostTofSetSignal(sensor, signal);
+
+  hostBootDevice(CLOSE_POS, [] {
+    setupI2c();
+    setupTof();
+  });
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("tof", updateTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_noise_false_triggers);
+  RUN_TEST(test_taps_detected);
+  RUN_TEST(test_fast_taps);
+  return hostExit(UNITY_END());
+}
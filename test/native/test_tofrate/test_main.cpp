@@ -0,0 +1,184 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "config.h"
+#include "clock.h"
+#include "i2c.h"
+#include "tof.h"
+#include "states.h"
+#include "tasks.h"
+#include "host.h"
+
+static constexpr int64_t DAY = 86400000000LL;
+static constexpr int64_t HOUR = 3600000000LL;
+static constexpr int VISITS = 24;
+static constexpr int64_t TAP_END = 620000;      // Hand gone, tap complete (us into the tap)
+static constexpr int64_t TAP_REPEAT = 2000000;  // Second tap of a visit
+
+// Something in front of the sensor (times in us from the start of the day)
+struct Visit {
+  int64_t start;
+  bool passerBy;       // Walks past in the interest zone without a gesture
+};
+
+static int64_t dayStart = 0;
+static std::vector<Visit> visits;
+static bool alwaysNear = false;
+static std::vector<int64_t> motorStarts;
+
+// Hand coming in through the interest zone, touching, and pulled out again
+static uint16_t tapDistance(int64_t t) {
+  if (t < 250000) {
+    return (uint16_t)(550 - t / 1000);
+  }
+  if (t < 370000) {
+    return (uint16_t)(300 - (t - 250000) * 290 / 120000);
+  }
+  if (t < 520000) {
+    return 10;
+  }
+  return t < TAP_END ? (uint16_t)(10 + (t - 520000) * 3 / 1000) : 0;
+}
+
+// Distance seen by the sensor at a monotonic time
+static uint16_t scene(int64_t timeUs) {
+  if (alwaysNear) {
+    return 450;
+  }
+  int64_t t = timeUs - dayStart;
+  for (const Visit &visit : visits) {
+    int64_t offset = t - visit.start;
+    if (offset < 0 || offset >= 3000000) {
+      continue;
+    }
+    if (visit.passerBy) {
+      return 500;
+    }
+    // Second tap after the first has moved the blind
+    return offset < TAP_REPEAT ? tapDistance(offset) : tapDistance(offset - TAP_REPEAT);
+  }
+  return 0;
+}
+
+// Run the task set, letting every started move arrive at once
+static void runUntil(int64_t end) {
+  bool moving = false;
+  while (clockMonotonic() < end) {
+    runTasks();
+    // The I2C task outranks the loop on the device, let it finish before the clock jumps
+    hostSettle();
+    int command = hostMotorCommand();
+    if (command != 0 && !moving) {
+      motorStarts.push_back(clockMonotonic());
+      hostMotorSetPosition(hostMotorPosition() < (OPEN_POS + CLOSE_POS) / 2 ? OPEN_POS : CLOSE_POS);
+    }
+    moving = command != 0;
+  }
+}
+
+// First motor start after a time (-1 if none within a second)
+static int64_t startAfter(int64_t time) {
+  for (int64_t start : motorStarts) {
+    if (start >= time && start < time + 1000000) {
+      return start - time;
+    }
+  }
+  return -1;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// A day with a tap visit and a passer-by every hour keeps the sensor and bus mostly idle
+static void test_day_of_activity() {
+  hostI2cResetStats();
+  hostTofResetStats();
+  dayStart = clockMonotonic();
+  runUntil(dayStart + DAY);
+
+  HostI2cStats bus = hostI2cStats();
+  HostTofStats sensor = hostTofStats(0);
+  double seconds = DAY / 1e6;
+  double duty = sensor.rangingUs / DAY * 100;
+  printf("day: %.2f transfers/s, bus busy %.3f %%, sensor ranging %.1f %%, %.2f measurements/s\n",
+         bus.transfers / seconds, bus.busTimeUs / DAY * 100, duty, sensor.measurements / seconds);
+
+  // Latency from the hand leaving, which completes the tap
+  int64_t idleWorst = 0, activeWorst = 0, idleSum = 0, activeSum = 0;
+  int taps = 0;
+  for (const Visit &visit : visits) {
+    if (visit.passerBy) {
+      continue;
+    }
+    int64_t first = startAfter(dayStart + visit.start + TAP_END);
+    int64_t second = startAfter(dayStart + visit.start + TAP_REPEAT + TAP_END);
+    TEST_ASSERT_TRUE(first >= 0);
+    TEST_ASSERT_TRUE(second >= 0);
+    idleWorst = std::max(idleWorst, first);
+    activeWorst = std::max(activeWorst, second);
+    idleSum += first;
+    activeSum += second;
+    taps++;
+  }
+  printf("tap to motor start: from idle ranging mean %lld ms, worst %lld ms; while active mean %lld ms, worst %lld ms\n",
+         (long long)idleSum / taps / 1000, (long long)idleWorst / 1000, (long long)activeSum / taps / 1000,
+         (long long)activeWorst / 1000);
+  TEST_ASSERT_EQUAL(2 * taps, (int)motorStarts.size());
+  // Idle ranging only delays noticing the hand, not the tap it completes
+  TEST_ASSERT_LESS_OR_EQUAL(activeWorst + TOF_IDLE_PERIOD * 1000, idleWorst);
+  TEST_ASSERT_LESS_THAN(15.0, duty);
+}
+
+// Someone constantly in the interest zone keeps it ranging back to back, the cost the idle mode saves
+static void test_constant_interest() {
+  alwaysNear = true;
+  runUntil(clockMonotonic() + 10000000);
+  hostI2cResetStats();
+  hostTofResetStats();
+  int64_t start = clockMonotonic();
+  runUntil(start + HOUR);
+  HostI2cStats bus = hostI2cStats();
+  HostTofStats sensor = hostTofStats(0);
+  double seconds = HOUR / 1e6;
+  double duty = sensor.rangingUs / HOUR * 100;
+  printf("active: %.2f transfers/s, bus busy %.3f %%, sensor ranging %.1f %%, %.2f measurements/s\n",
+         bus.transfers / seconds, bus.busTimeUs / HOUR * 100, duty, sensor.measurements / seconds);
+  TEST_ASSERT_EQUAL(TofMode::ACTIVE, getTofMode());
+  TEST_ASSERT_GREATER_THAN(95.0, duty);
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  // One tap visit and one passer-by in every hour, at seeded minutes
+  uint32_t seed = 42;
+  for (int hour = 0; hour < VISITS; ++hour) {
+    seed = seed * 1103515245u + 12345u;
+    int64_t minute = 1 + (seed >> 16) % 28;
+    visits.push_back({hour * HOUR + minute * 60000000LL, false});
+    visits.push_back({hour * HOUR + (minute + 30) * 60000000LL, true});
+  }
+  hostTofSetScene(hostTofAdd(PIN_TOF_XSHUT[0]), scene);
+
+  hostBootDevice(CLOSE_POS, [] {
+    setupI2c();
+    setupTof();
+  });
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("tof", updateTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_day_of_activity);
+  RUN_TEST(test_constant_interest);
+  return hostExit(UNITY_END());
+}
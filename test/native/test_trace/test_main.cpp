@@ -0,0 +1,207 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+#include "clock.h"
+#include "i2c.h"
+#include "tof.h"
+#include "states.h"
+#include "trace.h"
+#include "tasks.h"
+#include "host.h"
+
+static constexpr int64_t MINUTE = 60000000;
+static constexpr int64_t SESSION_LENGTH = 30000000;
+
+// Scripted button press (times in us from the session start)
+struct Press {
+  int64_t start;
+  int64_t length;
+  uint8_t pin;
+};
+
+static AsyncWebServer server(80);
+static int64_t sceneStart = 0;
+static uint16_t (*sceneShape)(int64_t t) = nullptr;
+
+static uint16_t scene(int64_t timeUs) {
+  return sceneShape != nullptr ? sceneShape(timeUs - sceneStart) : 0;
+}
+
+static uint16_t nobody(int64_t t) {
+  return 0;
+}
+
+// Someone moving about in the interest zone
+static uint16_t nearby(int64_t t) {
+  return (uint16_t)(450 + 40 * std::sin(t / 700000.0) + (t / 1000 * 7919) % 7);
+}
+
+// Tap at 8 s, hand held at 150 mm from 16 s to 18.5 s
+static uint16_t session(int64_t t) {
+  if (t >= 8000000 && t < 8620000) {
+    t -= 8000000;
+    if (t < 250000) {
+      return (uint16_t)(550 - t / 1000);
+    }
+    if (t < 370000) {
+      return (uint16_t)(300 - (t - 250000) * 290 / 120000);
+    }
+    return t < 520000 ? 10 : (uint16_t)(10 + (t - 520000) * 3 / 1000);
+  }
+  if (t >= 16000000 && t < 18500000) {
+    return 150;
+  }
+  return 0;
+}
+
+static const Press sessionPresses[] = {
+  {1000000, 200000, PIN_BTN_OPEN},
+  {22000000, 150000, PIN_BTN_MODE},
+  {25000000, 150000, PIN_BTN_MODE},
+};
+
+// One loop pass, the I2C task outranks the loop on the device
+static void step() {
+  runTasks();
+  hostSettle();
+}
+
+// Run the firmware with button presses at their times
+static void runWithPresses(int64_t start, int64_t span, const std::vector<Press> &presses) {
+  while (clockMonotonic() < start + span) {
+    int64_t t = clockMonotonic() - start;
+    for (uint8_t pin : {PIN_BTN_OPEN, PIN_BTN_CLOSE, PIN_BTN_MODE}) {
+      bool level = false;
+      for (const Press &press : presses) {
+        level |= press.pin == pin && t >= press.start && t < press.start + press.length;
+      }
+      hostSetInput(pin, level);
+    }
+    step();
+  }
+}
+
+// Start from the closed, idle blind with an empty trace
+static void resetSession() {
+  sceneShape = nobody;
+  enterState(SystemState::TOGGLE_IDLE);
+  hostMotorSetPosition(CLOSE_POS);
+  runWithPresses(clockMonotonic(), 2000000, {});
+  hostRequest("GET", "/setTrace?clear=1");
+}
+
+static std::vector<HostTraceRecord> download(size_t *bytes = nullptr) {
+  HostResponse response = hostRequest("GET", "/trace");
+  TEST_ASSERT_EQUAL(200, response.status);
+  return hostTraceDecode(response.body, bytes);
+}
+
+// Recorded minute of a kind of activity
+static size_t bytesPerMinute(const char *name, uint16_t (*shape)(int64_t), const std::vector<Press> &presses) {
+  resetSession();
+  sceneShape = shape;
+  sceneStart = clockMonotonic();
+  runWithPresses(sceneStart, MINUTE, presses);
+  size_t bytes = 0;
+  std::vector<HostTraceRecord> records = download(&bytes);
+  int counts[(size_t)TraceType::COUNT] = {};
+  for (const HostTraceRecord &record : records) {
+    counts[record.type]++;
+  }
+  printf("%-8s %6zu bytes/min, %5.2f bytes/record (%d ToF, %d button, %d position, %d state), ring holds %.1f min\n",
+         name, bytes, (double)bytes / records.size(), counts[(int)TraceType::TOF], counts[(int)TraceType::BUTTON],
+         counts[(int)TraceType::POSITION], counts[(int)TraceType::STATE],
+         (double)TRACE_BLOCK_COUNT * TRACE_BLOCK_SIZE / bytes);
+  return bytes;
+}
+
+// State records as (ms from the first record, state)
+static std::vector<std::pair<uint32_t, int32_t>> states(const std::vector<HostTraceRecord> &records) {
+  std::vector<std::pair<uint32_t, int32_t>> found;
+  for (const HostTraceRecord &record : records) {
+    if (record.type == (uint8_t)TraceType::STATE) {
+      found.push_back({record.time - records.front().time, record.value});
+    }
+  }
+  return found;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Trace size for an idle minute, a minute with someone near, and a minute of moves
+static void test_bytes_per_minute() {
+  size_t idle = bytesPerMinute("idle", nobody, {});
+  size_t near = bytesPerMinute("near", nearby, {});
+  std::vector<Press> moves;
+  for (int64_t t = 0; t < MINUTE; t += 20000000) {
+    moves.push_back({t + 500000, 150000, PIN_BTN_OPEN});
+    moves.push_back({t + 10500000, 150000, PIN_BTN_CLOSE});
+  }
+  size_t moving = bytesPerMinute("moving", nobody, moves);
+  TEST_ASSERT_LESS_THAN(near, idle);
+  TEST_ASSERT_LESS_THAN(near, moving);
+}
+
+// Replaying a recorded session through buttons, gestures and the state machine gives the same states
+static void test_replay_reproduces_states() {
+  resetSession();
+  sceneShape = session;
+  sceneStart = clockMonotonic();
+  runWithPresses(sceneStart, SESSION_LENGTH,
+                 std::vector<Press>(std::begin(sessionPresses), std::end(sessionPresses)));
+  std::vector<HostTraceRecord> recorded = download();
+  std::vector<std::pair<uint32_t, int32_t>> recordedStates = states(recorded);
+
+  resetSession();
+  sceneShape = nullptr;
+  int64_t virtualStart = clockMonotonic();
+  int64_t realStart = hostMicros();
+  hostTraceReplay(recorded, step);
+  int64_t realSpan = hostMicros() - realStart;
+  std::vector<std::pair<uint32_t, int32_t>> replayedStates = states(download());
+
+  printf("session of %zu records, %zu state changes, replayed %.1f s in %.3f s (x%.0f)\n", recorded.size(),
+         recordedStates.size(), (clockMonotonic() - virtualStart) / 1e6, realSpan / 1e6,
+         (double)(clockMonotonic() - virtualStart) / realSpan);
+  // Open, close, hold, and the mode round trip
+  TEST_ASSERT_GREATER_OR_EQUAL(8, recordedStates.size());
+  TEST_ASSERT_EQUAL(recordedStates.size(), replayedStates.size());
+  for (size_t i = 0; i < recordedStates.size(); ++i) {
+    TEST_ASSERT_EQUAL(recordedStates[i].second, replayedStates[i].second);
+    TEST_ASSERT_INT_WITHIN(50, recordedStates[i].first, replayedStates[i].first);
+  }
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  hostTofSetScene(hostTofAdd(PIN_TOF_XSHUT[0]), scene);
+
+  hostBootDevice(CLOSE_POS, [] {
+    setupI2c();
+    setupTof();
+  });
+  setupTrace(server);
+  setupTasks();
+  addTask("control", updateStateMachine, CONTROL_PERIOD, TaskPriority::CONTROL);
+  addTask("buttons", updateButtonInput, BUTTON_PERIOD, TaskPriority::SENSOR);
+  addTask("tof", updateTofInput, TOF_PERIOD / TOF_SENSOR_COUNT, TaskPriority::SENSOR);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_bytes_per_minute);
+  RUN_TEST(test_replay_reproduces_states);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,222 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "buttons.h"
+#include "motor.h"
+#include "states.h"
+#include "host.h"
+
+using S = SystemState;
+using E = StateEvent;
+
+static constexpr size_t NUM_STATES = (size_t)S::ERROR + 1;
+static constexpr size_t NUM_EVENTS = (size_t)E::COUNT;
+
+// Start position of every case (nearer the close limit than the open limit)
+static constexpr int64_t START_POS = 400;
+
+// State after each event from each state with no buttons down and the clock stopped
+static const S expected[NUM_STATES][NUM_EVENTS] = {
+  // OPEN_PRESS, OPEN_HOLD, OPEN_RELEASE, CLOSE_PRESS, CLOSE_HOLD, CLOSE_RELEASE,
+  // MODE_PRESS, MODE_HOLD, MODE_RELEASE, TOF_TAP, TOF_APPROACH, TOF_RETREAT, TOF_HOLD,
+  // OPEN_CLICK, CLOSE_CLICK, GESTURE_STOP, GESTURE_PRESET (preset 0 closes), GESTURE_CALIBRATE, GESTURE_PROVISION, TICK
+  {S::TOGGLE_IDLE, S::TOGGLE_IDLE, S::TOGGLE_IDLE, S::TOGGLE_IDLE, S::TOGGLE_IDLE, S::TOGGLE_IDLE,
+   S::TOGGLE_IDLE, S::CONFIG_OPEN, S::MANUAL_IDLE, S::TOGGLE_OPEN, S::TOGGLE_OPEN, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE,
+   S::TOGGLE_OPEN, S::TOGGLE_CLOSE, S::TOGGLE_IDLE, S::TOGGLE_CLOSE, S::CONFIG_OPEN, S::TOGGLE_IDLE, S::TOGGLE_IDLE},
+  {S::TOGGLE_OPEN, S::TOGGLE_OPEN, S::TOGGLE_OPEN, S::TOGGLE_IDLE, S::TOGGLE_OPEN, S::TOGGLE_OPEN,
+   S::MANUAL_IDLE, S::TOGGLE_OPEN, S::TOGGLE_OPEN, S::TOGGLE_IDLE, S::TOGGLE_OPEN, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE,
+   S::TOGGLE_OPEN, S::TOGGLE_OPEN, S::TOGGLE_IDLE, S::TOGGLE_CLOSE, S::CONFIG_OPEN, S::TOGGLE_OPEN, S::TOGGLE_OPEN},
+  {S::TOGGLE_IDLE, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE,
+   S::MANUAL_IDLE, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE, S::TOGGLE_IDLE, S::TOGGLE_OPEN, S::TOGGLE_CLOSE, S::TOGGLE_CLOSE,
+   S::TOGGLE_CLOSE, S::TOGGLE_CLOSE, S::TOGGLE_IDLE, S::TOGGLE_CLOSE, S::CONFIG_OPEN, S::TOGGLE_CLOSE,
+   S::TOGGLE_CLOSE},
+  {S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE,
+   S::MANUAL_IDLE, S::MANUAL_IDLE, S::TOGGLE_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE,
+   S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::CONFIG_OPEN, S::MANUAL_IDLE, S::MANUAL_IDLE},
+  {S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE, S::MANUAL_IDLE,
+   S::MANUAL_MOVE, S::MANUAL_MOVE, S::TOGGLE_IDLE, S::MANUAL_MOVE, S::MANUAL_MOVE, S::MANUAL_MOVE, S::MANUAL_MOVE,
+   S::MANUAL_MOVE, S::MANUAL_MOVE, S::MANUAL_MOVE, S::MANUAL_MOVE, S::MANUAL_MOVE, S::MANUAL_MOVE, S::MANUAL_MOVE},
+  {S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN,
+   S::CONFIG_OPEN, S::TOGGLE_IDLE, S::CONFIG_CLOSE, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN,
+   S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN, S::CONFIG_OPEN},
+  {S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE,
+   S::CONFIG_CLOSE, S::TOGGLE_IDLE, S::CONFIG_SAVE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE,
+   S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE, S::CONFIG_CLOSE,
+   S::CONFIG_CLOSE},
+  {S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE,
+   S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE,
+   S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::CONFIG_SAVE, S::TOGGLE_IDLE},
+  {S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR,
+   S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR,
+   S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR, S::ERROR},
+};
+
+static const char *const stateNames[NUM_STATES] = {"TOGGLE_IDLE", "TOGGLE_OPEN", "TOGGLE_CLOSE",
+                                                   "MANUAL_IDLE", "MANUAL_MOVE", "CONFIG_OPEN",
+                                                   "CONFIG_CLOSE", "CONFIG_SAVE", "ERROR"};
+static const char *const eventNames[NUM_EVENTS] = {"OPEN_PRESS", "OPEN_HOLD", "OPEN_RELEASE", "CLOSE_PRESS",
+                                                   "CLOSE_HOLD", "CLOSE_RELEASE", "MODE_PRESS", "MODE_HOLD",
+                                                   "MODE_RELEASE", "TOF_TAP", "TOF_APPROACH", "TOF_RETREAT",
+                                                   "TOF_HOLD", "OPEN_CLICK", "CLOSE_CLICK", "GESTURE_STOP",
+                                                   "GESTURE_PRESET", "GESTURE_CALIBRATE", "GESTURE_PROVISION",
+                                                   "TICK"};
+
+// Return to idle with known limits, position, and previous state
+static void resetMachine() {
+  enterState(S::ERROR);
+  enterState(S::TOGGLE_IDLE);
+  savePositions(OPEN_POS, CLOSE_POS);
+  saveLastPosition(START_POS);
+  setupStates();
+}
+
+// Reach a state the way the firmware does (moves through their triggers)
+static void reachState(S state) {
+  resetMachine();
+  switch (state) {
+    case S::TOGGLE_IDLE:
+      break;
+    case S::TOGGLE_OPEN:
+      triggerOpen();
+      break;
+    case S::TOGGLE_CLOSE:
+      triggerClose();
+      break;
+    default:
+      enterState(state);
+      break;
+  }
+  TEST_ASSERT_EQUAL((int)state, (int)getState());
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Every state x event pair against the expected table
+static void test_every_state_event_pair() {
+  for (size_t state = 0; state < NUM_STATES; ++state) {
+    for (size_t event = 0; event < NUM_EVENTS; ++event) {
+      reachState((S)state);
+      dispatchStateEvent((E)event);
+      char message[64];
+      snprintf(message, sizeof(message), "%s + %s", stateNames[state], eventNames[event]);
+      TEST_ASSERT_EQUAL_MESSAGE((int)expected[state][event], (int)getState(), message);
+    }
+  }
+}
+
+// Ignored events leave the motor alone
+static void test_ignored_events_do_not_drive_motor() {
+  for (size_t state = 0; state < NUM_STATES; ++state) {
+    for (size_t event = 0; event < NUM_EVENTS; ++event) {
+      if (expected[state][event] != (S)state || (S)state == S::TOGGLE_OPEN || (S)state == S::TOGGLE_CLOSE) {
+        continue;
+      }
+      reachState((S)state);
+      int command = hostMotorCommand();
+      dispatchStateEvent((E)event);
+      TEST_ASSERT_EQUAL_MESSAGE(command, hostMotorCommand(), eventNames[event]);
+    }
+  }
+}
+
+// Inactivity timeouts return to Toggle mode
+static void test_timeouts() {
+  reachState(S::MANUAL_IDLE);
+  advanceVirtualClock((int64_t)MANUAL_TIMEOUT * 1000);
+  dispatchStateEvent(E::TICK);
+  TEST_ASSERT_EQUAL((int)S::MANUAL_IDLE, (int)getState());
+  advanceVirtualClock(1000);
+  dispatchStateEvent(E::TICK);
+  TEST_ASSERT_EQUAL((int)S::TOGGLE_IDLE, (int)getState());
+
+  reachState(S::CONFIG_OPEN);
+  advanceVirtualClock((int64_t)CONFIG_TIMEOUT * 1000 + 1000);
+  dispatchStateEvent(E::TICK);
+  TEST_ASSERT_EQUAL((int)S::TOGGLE_IDLE, (int)getState());
+}
+
+// A move ends on the TICK that sees the target
+static void test_arrival() {
+  reachState(S::TOGGLE_OPEN);
+  TEST_ASSERT_GREATER_THAN(0, hostMotorCommand());
+  hostMotorSetPosition(OPEN_POS - POS_TOLERANCE);
+  dispatchStateEvent(E::TICK);
+  TEST_ASSERT_EQUAL((int)S::TOGGLE_IDLE, (int)getState());
+  TEST_ASSERT_EQUAL(0, hostMotorCommand());
+}
+
+// Config walk stores the jogged limits
+static void test_config_saves_limits() {
+  reachState(S::CONFIG_OPEN);
+  hostMotorSetPosition(1200);
+  dispatchStateEvent(E::MODE_RELEASE);
+  hostMotorSetPosition(-100);
+  dispatchStateEvent(E::MODE_RELEASE);
+  dispatchStateEvent(E::TICK);
+  TEST_ASSERT_EQUAL((int)S::TOGGLE_IDLE, (int)getState());
+  int64_t openPos = 0;
+  int64_t closePos = 0;
+  loadPositions(openPos, closePos);
+  TEST_ASSERT_EQUAL_INT64(1200, openPos);
+  TEST_ASSERT_EQUAL_INT64(-100, closePos);
+}
+
+// Dispatch cost of ignored, self, and changing transitions
+static void test_dispatch_benchmark() {
+  constexpr int rounds = 200000;
+  reachState(S::TOGGLE_IDLE);
+  int64_t start = hostMicros();
+  for (int i = 0; i < rounds; ++i) {
+    dispatchStateEvent(E::OPEN_HOLD);
+  }
+  double ignoredNs = (hostMicros() - start) * 1000.0 / rounds;
+
+  reachState(S::MANUAL_IDLE);
+  start = hostMicros();
+  for (int i = 0; i < rounds; ++i) {
+    dispatchStateEvent(E::TICK);
+  }
+  double tickNs = (hostMicros() - start) * 1000.0 / rounds;
+
+  reachState(S::CONFIG_OPEN);
+  start = hostMicros();
+  for (int i = 0; i < rounds / 2; ++i) {
+    dispatchStateEvent(E::MODE_RELEASE);
+    dispatchStateEvent(E::MODE_HOLD);
+    enterState(S::CONFIG_OPEN);
+  }
+  double changeNs = (hostMicros() - start) * 1000.0 / rounds;
+
+  char message[128];
+  snprintf(message, sizeof(message), "dispatch ns: ignored %.1f, tick %.1f, transition %.1f", ignoredNs, tickNs,
+           changeNs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(1000, (int)ignoredNs);
+}
+
+int main() {
+  // Time only moves when a test advances it
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, false);
+  setupMemory();
+  setupMotor();
+  setupButtons();
+  UNITY_BEGIN();
+  RUN_TEST(test_every_state_event_pair);
+  RUN_TEST(test_ignored_events_do_not_drive_motor);
+  RUN_TEST(test_timeouts);
+  RUN_TEST(test_arrival);
+  RUN_TEST(test_config_saves_limits);
+  RUN_TEST(test_dispatch_benchmark);
+  return hostExit(UNITY_END());
+}
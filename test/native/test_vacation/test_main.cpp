@@ -0,0 +1,146 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <set>
+#include <vector>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "states.h"
+#include "schedule.h"
+#include "host.h"
+
+// Below every partial move target, so each one starts the motor
+static constexpr int64_t PARK_POS = 100;
+
+// Local time of a scheduled move start
+struct Fired {
+  time_t time;
+  int dateKey;     // Local date of the start
+  int minute;      // Local minute of day
+};
+
+// Stop a started move and park the blind again (false if nothing started)
+static bool takeMoveStart() {
+  if (hostMotorCommand() == 0) {
+    return false;
+  }
+  triggerStop();
+  hostMotorSetPosition(PARK_POS);
+  return true;
+}
+
+// Step the schedule a minute at a time over a span, recording move starts
+static std::vector<Fired> runSchedule(int64_t spanSeconds) {
+  std::vector<Fired> fired;
+  for (int64_t t = 0; t < spanSeconds; t += 60) {
+    advanceVirtualClock(60000000LL);
+    checkSchedule();
+    if (takeMoveStart()) {
+      time_t now = (time_t)(clockWall() / 1000000);
+      struct tm local;
+      localtime_r(&now, &local);
+      fired.push_back({now, local.tm_year * 366 + local.tm_yday, local.tm_hour * 60 + local.tm_min});
+    }
+  }
+  return fired;
+}
+
+// Run the schedule to the next local midnight
+static void runToMidnight() {
+  time_t now = (time_t)(clockWall() / 1000000);
+  struct tm local;
+  localtime_r(&now, &local);
+  runSchedule(86400 - (local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec));
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// Shifted events stay in their window, vary from day to day and run once per day
+static void test_daily_shifts() {
+  hostRequest("GET", "/setVacation?enabled=1&partial=1&offset=60&seed=1234");
+  runToMidnight();
+  std::vector<Fired> fired = runSchedule(56LL * 86400);
+
+  std::map<int, std::vector<int>> days;
+  for (const Fired &event : fired) {
+    days[event.dateKey].push_back(event.minute);
+  }
+  TEST_ASSERT_EQUAL(56, days.size());
+
+  std::set<int> openMinutes;
+  int openSum = 0, openMin = 1440, openMax = 0;
+  for (const auto &day : days) {
+    TEST_ASSERT_EQUAL(3, day.second.size());
+    int open = day.second[0];
+    int partial = day.second[1];
+    int close = day.second[2];
+    TEST_ASSERT_INT_WITHIN(60, 7 * 60 + 30, open);
+    TEST_ASSERT_TRUE(partial >= VACATION_PARTIAL_START && partial < VACATION_PARTIAL_START + VACATION_PARTIAL_WINDOW);
+    TEST_ASSERT_INT_WITHIN(60, 20 * 60, close);
+    openMinutes.insert(open);
+    openSum += open - (7 * 60 + 30);
+    openMin = std::min(openMin, open - (7 * 60 + 30));
+    openMax = std::max(openMax, open - (7 * 60 + 30));
+  }
+  printf("open shift over 56 days: %zu distinct, mean %.1f, range %d..%d min\n", openMinutes.size(),
+         (double)openSum / days.size(), openMin, openMax);
+  TEST_ASSERT_GREATER_THAN(30, openMinutes.size());
+  TEST_ASSERT_INT_WITHIN(20, 0, openSum / (int)days.size());
+}
+
+// Disabling vacation mode returns to the plain table
+static void test_disabled_runs_on_time() {
+  hostRequest("GET", "/setVacation?offset=60&seed=1234");
+  runToMidnight();
+  std::vector<Fired> fired = runSchedule(7LL * 86400);
+  TEST_ASSERT_EQUAL(14, fired.size());
+  for (size_t i = 0; i < fired.size(); ++i) {
+    TEST_ASSERT_EQUAL(i % 2 == 0 ? 7 * 60 + 30 : 20 * 60, fired[i].minute);
+  }
+}
+
+// Offsets that push events across midnight neither drop nor repeat them
+static void test_shift_across_midnight() {
+  hostRequest("GET", "/setSchedule?w0_0&w0_1&w0_2&w0_3&w0_4&w0_5&w0_6&t0=00:30&a0=0"
+                     "&w1_0&w1_1&w1_2&w1_3&w1_4&w1_5&w1_6&t1=23:30&a1=1");
+  hostRequest("GET", "/setVacation?enabled=1&offset=120&seed=1234");
+  runToMidnight();
+  // Skip the first day, whose early event may already have run the day before
+  runSchedule(86400);
+  std::vector<Fired> fired = runSchedule(28LL * 86400);
+  printf("%zu moves over 28 days with events shifted across midnight\n", fired.size());
+  TEST_ASSERT_INT_WITHIN(1, 56, fired.size());
+  for (size_t i = 1; i < fired.size(); ++i) {
+    TEST_ASSERT_GREATER_THAN(60, fired[i].time - fired[i - 1].time);
+  }
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, false);
+  hostBootDevice(PARK_POS, [] {
+    const ScheduleEntry entries[] = {
+      {0x7F, 7 * 60 + 30, ScheduleAction::OPEN, 0, ScheduleBase::TIME},
+      {0x7F, 20 * 60, ScheduleAction::CLOSE, 0, ScheduleBase::TIME},
+    };
+    saveSchedule(entries, 2);
+    setupScheduler();
+  });
+
+  UNITY_BEGIN();
+  RUN_TEST(test_daily_shifts);
+  RUN_TEST(test_disabled_runs_on_time);
+  RUN_TEST(test_shift_across_midnight);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "config.h"
+#include "clock.h"
+#include "states.h"
+#include "host.h"
+
+static constexpr uint32_t WAKE_DURATION = 60000;
+
+// Slow geared blind that sticks hard at the start and turns freely after it
+static constexpr HostMotorModel STICKY_MODEL = {0.5, 30, 110, 0.5};
+static constexpr HostMotorModel FREE_MODEL = {0.5, 30, 60, 0.5};
+
+// Tracking of the position curve against the linear ramp
+struct WakeRun {
+  double worstLag;      // Counts behind the ramp
+  double worstLead;     // Counts ahead of the ramp
+  int lateCommand;      // Highest PWM in the second half
+  int starts;           // Times the motor broke away
+  bool arrived;
+};
+
+// Step the control task through a wake and record the position curve
+static WakeRun runWake() {
+  WakeRun run = {0, 0, 0, 0, false};
+  hostMotorSetModel(STICKY_MODEL);
+  hostMotorSetPosition(CLOSE_POS);
+  triggerWake(WAKE_DURATION);
+  bool turning = false;
+  for (uint32_t t = 1; t <= WAKE_DURATION + 5000; ++t) {
+    advanceVirtualClock(1000);
+    updateStateMachine();
+    if (hostMotorTurning() && !turning) {
+      run.starts++;
+      // Past the sticky spot
+      hostMotorSetModel(FREE_MODEL);
+    }
+    turning = hostMotorTurning();
+    if (t >= WAKE_DURATION / 2 && t <= WAKE_DURATION) {
+      run.lateCommand = std::max(run.lateCommand, std::abs(hostMotorCommand()));
+    }
+    if (t <= WAKE_DURATION) {
+      double setpoint = CLOSE_POS + (double)(OPEN_POS - CLOSE_POS) * t / WAKE_DURATION;
+      double error = hostMotorPosition() - setpoint;
+      run.worstLead = std::max(run.worstLead, error);
+      run.worstLag = std::max(run.worstLag, -error);
+    }
+    if (getState() == SystemState::TOGGLE_IDLE) {
+      run.arrived = true;
+      break;
+    }
+  }
+  return run;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// A boost raised to break away at the start does not keep driving the rest of the ramp
+static void test_boost_decays_after_breakaway() {
+  WakeRun run = runWake();
+  printf("wake over %u s: worst lag %.0f, worst lead %.0f counts, late peak PWM %d, %d starts\n",
+         WAKE_DURATION / 1000, run.worstLag, run.worstLead, run.lateCommand, run.starts);
+  TEST_ASSERT_TRUE(run.arrived);
+  // Free running speed to keep up with the ramp is well below the sticky breakaway
+  TEST_ASSERT_LESS_THAN(FREE_MODEL.breakawayPwm + WAKE_KICK_STEP * 2, run.lateCommand);
+  TEST_ASSERT_LESS_THAN(20, (int)run.worstLead);
+  TEST_ASSERT_LESS_THAN(50, (int)run.worstLag);
+}
+
+int main() {
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, false);
+  hostBootDevice(CLOSE_POS);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_boost_decays_after_breakaway);
+  return hostExit(UNITY_END());
+}
@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ * SPDX-FileCopyrightText: Copyright 2025 Alexander Hool
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+#include "clock.h"
+#include "memory.h"
+#include "states.h"
+#include "schedule.h"
+#include "light.h"
+#include "tasks.h"
+#include "host.h"
+
+static constexpr int64_t DAY = 86400LL * 1000000;
+static constexpr int DAYS = 365;
+
+static AsyncWebServer server(80);
+static uint32_t moves = 0;
+static uint32_t arrivals = 0;
+static int64_t moveUs = 0;
+
+// Same task as main.cpp
+static void scheduleTask() {
+  syncRTC();
+  checkSchedule();
+}
+
+// Run the control loop at its period while a move is under way (idle ticks only look for arrival)
+static void followMove() {
+  if (hostMotorCommand() == 0) {
+    return;
+  }
+  moves++;
+  int64_t start = clockMonotonic();
+  while (getState() == SystemState::TOGGLE_OPEN || getState() == SystemState::TOGGLE_CLOSE) {
+    advanceVirtualClock(CONTROL_PERIOD);
+    updateStateMachine();
+  }
+  moveUs += clockMonotonic() - start;
+  arrivals += getState() == SystemState::TOGGLE_IDLE;
+}
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+// A year of daily opens and closes on the fast virtual clock, reported as simulated seconds per real second
+static void test_year_benchmark() {
+  int64_t virtualStart = clockMonotonic();
+  int64_t realStart = hostMicros();
+  while (clockMonotonic() - virtualStart < DAYS * DAY) {
+    runTasks();
+    followMove();
+  }
+  int64_t realSpan = hostMicros() - realStart;
+  double simulated = (clockMonotonic() - virtualStart) / 1e6;
+  printf("%d days: %u moves (%.1f s moving), simulated %.0f s in %.2f s real, %.0f simulated s per real s\n", DAYS,
+         moves, moveUs / 1e6, simulated, realSpan / 1e6, simulated * 1e6 / realSpan);
+  // Open at 07:00 and close at 20:00 every day, the first close (an hour after the start) finds the blind closed
+  TEST_ASSERT_EQUAL(2 * DAYS - 1, moves);
+  TEST_ASSERT_EQUAL(moves, arrivals);
+  TEST_ASSERT_GREATER_THAN(3600.0, simulated * 1e6 / realSpan);
+}
+
+int main() {
+  // Fast virtual clock, as with CLOCK_VIRTUAL and CLOCK_VIRTUAL_FAST
+  startVirtualClock(CLOCK_VIRTUAL_START * 1000000LL, true);
+  hostBootDevice(CLOSE_POS, [] {
+    const ScheduleEntry entries[] = {
+      {0x7F, 420, ScheduleAction::OPEN, 0, ScheduleBase::TIME},
+      {0x7F, 1200, ScheduleAction::CLOSE, 0, ScheduleBase::TIME},
+    };
+    saveSchedule(entries, 2);
+    setupScheduler();
+  });
+  setupLight(server);
+  setupTasks();
+  // Day-scale tasks at their firmware periods, the control loop is stepped through each move
+  addTask("schedule", scheduleTask, SCHEDULE_PERIOD, TaskPriority::BACKGROUND);
+  addTask("light", updateLight, LIGHT_PERIOD, TaskPriority::BACKGROUND);
+  hostSettle();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_year_benchmark);
+  return hostExit(UNITY_END());
+}